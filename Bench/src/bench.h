@@ -0,0 +1,74 @@
+#pragma once
+
+#include <defines.h>
+
+/*
+* A benchmark run from the command line as: Bench <name> [arguments]
+* Timings are logged, the result tells whether what was measured also came out right.
+*
+* @param argc - Amount of arguments after the name
+* @param argv - The arguments after the name
+* @return b8 - TRUE if the benchmark ran and its checks passed, FALSE otherwise
+*/
+typedef b8 (*pfn_bench)(i32 argc, char** argv);
+
+struct render_packet;
+
+// Runs on the main thread at the start of every frame, see game.prepare_frame
+typedef b8 (*pfn_bench_prepare_frame)(f64 delta_time);
+// Fills the packet of the frame on a job thread, see game.render
+typedef b8 (*pfn_bench_render)(struct render_packet* packet);
+// Runs once the main loop ended, while the renderer is still up
+typedef void (*pfn_bench_shutdown)();
+
+/*
+* Runs a 1280x720 headless application until the bench calls bench_quit().
+*
+* @param name - Name of the application
+* @param worker_count - Job worker threads besides the main thread, 0 for one per remaining core
+* @param prepare_frame - Called every frame
+* @param render - Optional, 0 renders empty frames
+* @param shutdown - Optional, the place to destroy renderer resources
+* @return b8 - TRUE if the application started and ran until it quit, FALSE otherwise
+*/
+b8 bench_run_headless(const char* name, u32 worker_count, pfn_bench_prepare_frame prepare_frame,
+    pfn_bench_render render, pfn_bench_shutdown shutdown);
+
+// Ends the application run by bench_run_headless after the current frame
+void bench_quit();
+
+// Mutexes, semaphores, condition variables and atomics contended by 16 threads
+b8 bench_contention(i32 argc, char** argv);
+
+// Empty job throughput and the speedup of a synthetic workload at 1, 2, 4, 8 and 16 threads
+b8 bench_jobs(i32 argc, char** argv);
+
+// Scaling of parallel_for and parallel_reduce over 10M elements at 1, 2, 4, 8 and 16 threads
+b8 bench_parallel(i32 argc, char** argv);
+
+// Deep dependency trees on the fiber and the thread backend: fibers [worker count, 0 for one per core]
+b8 bench_fibers(i32 argc, char** argv);
+
+// Reads a file with buffered fread and through a mapping: file_map <path> [size in MiB, 1024]
+b8 bench_file_map(i32 argc, char** argv);
+
+// Reads many small and a few large files through async I/O: async_io <directory> [small file count, 10000]
+b8 bench_async_io(i32 argc, char** argv);
+
+// Allocation, split and merge, dedicated and defragmentation patterns against the GPU memory allocator of a headless renderer.
+// Needs the DEBUG configuration, the check is compiled out of the other ones
+b8 bench_memory(i32 argc, char** argv);
+
+// Dispatches a kernel filling a buffer shared with the graphics queue, lets the frames wait on it and checks the read back values.
+// Needs the DEBUG configuration, the check is compiled out of the other ones
+b8 bench_compute(i32 argc, char** argv);
+
+// Checks the timeline semaphore pacing the frames against the submitted frame numbers of a headless renderer.
+// Needs the DEBUG configuration, the check is compiled out of the other ones
+b8 bench_timeline(i32 argc, char** argv);
+
+// Replaces 10K geometries of 64 bytes every frame of a headless renderer and a 1 MiB one through the transfer queue: staging [frame count, 200]
+b8 bench_staging(i32 argc, char** argv);
+
+// Records 100K draws per frame of a headless renderer on 1, 4 and 8 threads: draws [frame count, 100]
+b8 bench_draws(i32 argc, char** argv);
@@ -0,0 +1,152 @@
+#include "bench.h"
+#include <core/async_io.h>
+#include <core/logger.h>
+#include <core/vmemory.h>
+#include <platform/platform.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ASYNC_IO_DEFAULT_SMALL_FILE_COUNT 10000
+#define ASYNC_IO_SMALL_FILE_SIZE 4096
+#define ASYNC_IO_LARGE_FILE_COUNT 4
+#define ASYNC_IO_LARGE_FILE_SIZE (64ull * 1024 * 1024)
+#define ASYNC_IO_MAX_PATH 512
+
+// Filled by the callbacks, which async_io_update runs on this thread
+typedef struct async_io_tally {
+    u32 finished;
+    u32 failed;
+    u32 wrong;
+    u64 bytes;
+    u64 expected_size;
+} async_io_tally;
+
+static async_io_tally tally;
+
+// Every byte of a file holds the same value, derived from its index
+static u8 file_value(u32 index) {
+    return (u8)(index * 31 + 7);
+}
+
+static void file_path(char* buffer, const char* directory, const char* kind, u32 index) {
+    snprintf(buffer, ASYNC_IO_MAX_PATH, "%s/async_io_%s_%u.bin", directory, kind, index);
+}
+
+static b8 write_files(const char* directory, const char* kind, u32 count, u64 size) {
+    u8* data = vallocate(size, MEMORY_TAG_IO);
+    char path[ASYNC_IO_MAX_PATH];
+    b8 success = TRUE;
+    for (u32 idx = 0; idx != count && success; ++idx) {
+        vset_memory(data, file_value(idx), size);
+        file_path(path, directory, kind, idx);
+        FILE* file = fopen(path, "wb");
+        success = file && fwrite(data, 1, size, file) == size;
+        if (file && fclose(file) != 0)
+            success = FALSE;
+        if (!success) {
+            VERROR("Could not write '%s'", path);
+        }
+    }
+    vfree(data, size, MEMORY_TAG_IO);
+    return success;
+}
+
+static void remove_files(const char* directory, const char* kind, u32 count) {
+    char path[ASYNC_IO_MAX_PATH];
+    for (u32 idx = 0; idx != count; ++idx) {
+        file_path(path, directory, kind, idx);
+        remove(path);
+    }
+}
+
+static void on_read(const async_io_result* result) {
+    tally.finished++;
+    if (result->status != ASYNC_IO_STATUS_COMPLETE) {
+        tally.failed++;
+        return;
+    }
+
+    tally.bytes += result->bytes_read;
+    const u8* data = (const u8*)result->buffer;
+    u8 expected = file_value((u32)(u64)result->user_data);
+    if (result->bytes_read != tally.expected_size || data[0] != expected || data[result->bytes_read - 1] != expected)
+        tally.wrong++;
+}
+
+// Reads count files of size bytes in one batch and waits for all of them on this thread
+static b8 read_files(const char* directory, const char* kind, u32 count, u64 size) {
+    u8* buffers = vallocate(size * count, MEMORY_TAG_IO);
+    async_io_read* reads = vallocate(sizeof(async_io_read) * count, MEMORY_TAG_IO);
+    char* paths = vallocate((u64)ASYNC_IO_MAX_PATH * count, MEMORY_TAG_IO);
+    for (u32 idx = 0; idx != count; ++idx) {
+        char* path = paths + (u64)idx * ASYNC_IO_MAX_PATH;
+        file_path(path, directory, kind, idx);
+        reads[idx].path = path;
+        reads[idx].offset = 0;
+        reads[idx].size = size;
+        reads[idx].buffer = buffers + size * idx;
+        reads[idx].priority = ASYNC_IO_PRIORITY_NORMAL;
+        reads[idx].callback = on_read;
+        reads[idx].user_data = (void*)(u64)idx;
+    }
+
+    vzero_memory(&tally, sizeof(tally));
+    tally.expected_size = size;
+    f64 start_time = platform_get_absolute_time();
+    async_io_submit(reads, count, 0);
+    while (tally.finished != count) {
+        if (async_io_update() == 0)
+            platform_sleep(0);
+    }
+    f64 elapsed = platform_get_absolute_time() - start_time;
+
+    VINFO("%5u x %8llu bytes in %8.2f ms, %9.1f files/s, %8.1f MiB/s", count, size, elapsed * 1000.0,
+        count / elapsed, (f64)tally.bytes / (1024.0 * 1024.0) / elapsed);
+
+    vfree(paths, (u64)ASYNC_IO_MAX_PATH * count, MEMORY_TAG_IO);
+    vfree(reads, sizeof(async_io_read) * count, MEMORY_TAG_IO);
+    vfree(buffers, size * count, MEMORY_TAG_IO);
+
+    if (tally.failed || tally.wrong) {
+        VERROR("%u of %u reads failed and %u read wrong data", tally.failed, count, tally.wrong);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+b8 bench_async_io(i32 argc, char** argv) {
+    if (argc < 1) {
+        VERROR("async_io needs a directory for its scratch files");
+        return FALSE;
+    }
+
+    const char* directory = argv[0];
+    u32 small_count = argc > 1 ? (u32)strtoul(argv[1], 0, 10) : ASYNC_IO_DEFAULT_SMALL_FILE_COUNT;
+    if (small_count == 0) {
+        VERROR("async_io needs at least one small file");
+        return FALSE;
+    }
+
+    VINFO("Writing %u small and %u large files to '%s'", small_count, ASYNC_IO_LARGE_FILE_COUNT, directory);
+    b8 success = write_files(directory, "small", small_count, ASYNC_IO_SMALL_FILE_SIZE) &&
+        write_files(directory, "large", ASYNC_IO_LARGE_FILE_COUNT, ASYNC_IO_LARGE_FILE_SIZE);
+
+    // The system queue first, it falls back to the threads by itself where it is missing
+    for (u32 force_fallback = 0; force_fallback != 2 && success; ++force_fallback) {
+        async_io_config config = { 0 };
+        config.force_fallback = (b8)force_fallback;
+        if (!async_io_initialize(&config)) {
+            success = FALSE;
+            break;
+        }
+
+        success = read_files(directory, "small", small_count, ASYNC_IO_SMALL_FILE_SIZE) &&
+            read_files(directory, "large", ASYNC_IO_LARGE_FILE_COUNT, ASYNC_IO_LARGE_FILE_SIZE);
+        async_io_shutdown();
+    }
+
+    remove_files(directory, "small", small_count);
+    remove_files(directory, "large", ASYNC_IO_LARGE_FILE_COUNT);
+    return success;
+}
@@ -0,0 +1,337 @@
+#include "bench.h"
+#include <core/logger.h>
+#include <core/vatomic.h>
+#include <core/vmemory.h>
+#include <platform/platform.h>
+#include <platform/platform_thread.h>
+
+#include <stdio.h>
+
+#define CONTENTION_THREAD_COUNT 16
+#define CONTENTION_ITERATIONS 100000
+// Capacity of the queue the producers and consumers of the condition variable case share
+#define CONTENTION_QUEUE_CAPACITY 64
+// Threads the counting semaphore case lets in at once
+#define CONTENTION_SEMAPHORE_SLOTS 4
+// A condition variable wait that times out while its condition already holds missed its wake up
+#define CONTENTION_WAKEUP_TIMEOUT_MS 1000
+
+typedef enum contention_kind {
+    // Counter incremented under a mutex
+    CONTENTION_KIND_MUTEX,
+    // Counter incremented under a semaphore with a count of one
+    CONTENTION_KIND_SEMAPHORE,
+    // Threads pass through a semaphore with a count of CONTENTION_SEMAPHORE_SLOTS
+    CONTENTION_KIND_SEMAPHORE_SLOTS,
+    CONTENTION_KIND_ATOMIC_ADD,
+    // Counter incremented with a compare exchange loop
+    CONTENTION_KIND_ATOMIC_CAS,
+    // Half the threads produce into a bounded queue, the other half consume from it
+    CONTENTION_KIND_CONDVAR,
+    CONTENTION_KIND_COUNT
+} contention_kind;
+
+static const char* kind_names[CONTENTION_KIND_COUNT] = {
+    "mutex",
+    "semaphore",
+    "sem slots",
+    "atomic add",
+    "atomic cas",
+    "condvar"
+};
+
+typedef struct contention_state {
+    contention_kind kind;
+    // Threads wait at the start line so all of them contend from the first iteration
+    volatile u32 ready_count;
+    volatile u32 go;
+
+    platform_mutex mutex;
+    platform_semaphore semaphore;
+    platform_condvar not_empty;
+    platform_condvar not_full;
+
+    // Guarded by the mutex or the semaphore
+    u64 counter;
+    volatile u64 atomic_counter;
+
+    // Threads inside the guarded section and the most that were ever inside at once
+    volatile u32 holders;
+    volatile u32 max_holders;
+
+    // Guarded by the mutex
+    u64 queue[CONTENTION_QUEUE_CAPACITY];
+    u32 queue_head;
+    u32 queue_count;
+    u64 consumed_sum;
+    u64 consumed_count;
+    u32 lost_wakeups;
+} contention_state;
+
+typedef struct contention_thread {
+    contention_state* state;
+    u32 index;
+    platform_thread thread;
+} contention_thread;
+
+static void holders_enter(contention_state* state) {
+    u32 holders = vatomic_fetch_add_u32(&state->holders, 1, VMEMORY_ORDER_ACQ_REL) + 1;
+    u32 max_holders = vatomic_load_u32(&state->max_holders, VMEMORY_ORDER_RELAXED);
+    while (holders > max_holders && !vatomic_compare_exchange_u32(&state->max_holders, &max_holders, holders, VMEMORY_ORDER_ACQ_REL))
+        ;
+}
+
+static void holders_leave(contention_state* state) {
+    vatomic_fetch_sub_u32(&state->holders, 1, VMEMORY_ORDER_ACQ_REL);
+}
+
+// Waits on the condition variable with a timeout so a missed wake up is counted instead of hanging
+static void queue_wait(contention_state* state, platform_condvar* condvar, b8 for_items) {
+    if (!platform_condvar_wait(condvar, &state->mutex, CONTENTION_WAKEUP_TIMEOUT_MS)) {
+        b8 ready = for_items ? state->queue_count != 0 : state->queue_count != CONTENTION_QUEUE_CAPACITY;
+        if (ready)
+            state->lost_wakeups++;
+    }
+}
+
+static void queue_produce(contention_state* state) {
+    for (u64 value = 1; value <= CONTENTION_ITERATIONS; ++value) {
+        platform_mutex_lock(&state->mutex);
+        while (state->queue_count == CONTENTION_QUEUE_CAPACITY)
+            queue_wait(state, &state->not_full, FALSE);
+        state->queue[(state->queue_head + state->queue_count) % CONTENTION_QUEUE_CAPACITY] = value;
+        state->queue_count++;
+        platform_condvar_signal(&state->not_empty);
+        platform_mutex_unlock(&state->mutex);
+    }
+}
+
+static void queue_consume(contention_state* state) {
+    for (u32 iteration = 0; iteration != CONTENTION_ITERATIONS; ++iteration) {
+        platform_mutex_lock(&state->mutex);
+        while (state->queue_count == 0)
+            queue_wait(state, &state->not_empty, TRUE);
+        state->consumed_sum += state->queue[state->queue_head];
+        state->consumed_count++;
+        state->queue_head = (state->queue_head + 1) % CONTENTION_QUEUE_CAPACITY;
+        state->queue_count--;
+        platform_condvar_signal(&state->not_full);
+        platform_mutex_unlock(&state->mutex);
+    }
+}
+
+static u32 contention_thread_main(void* params) {
+    contention_thread* self = (contention_thread*)params;
+    contention_state* state = self->state;
+
+    vatomic_fetch_add_u32(&state->ready_count, 1, VMEMORY_ORDER_RELEASE);
+    while (!vatomic_load_u32(&state->go, VMEMORY_ORDER_ACQUIRE))
+        platform_thread_yield();
+
+    switch (state->kind) {
+        case CONTENTION_KIND_MUTEX:
+            for (u32 iteration = 0; iteration != CONTENTION_ITERATIONS; ++iteration) {
+                platform_mutex_lock(&state->mutex);
+                holders_enter(state);
+                state->counter++;
+                holders_leave(state);
+                platform_mutex_unlock(&state->mutex);
+            }
+            break;
+        case CONTENTION_KIND_SEMAPHORE:
+            for (u32 iteration = 0; iteration != CONTENTION_ITERATIONS; ++iteration) {
+                platform_semaphore_wait(&state->semaphore, PLATFORM_WAIT_INFINITE);
+                holders_enter(state);
+                state->counter++;
+                holders_leave(state);
+                platform_semaphore_signal(&state->semaphore, 1);
+            }
+            break;
+        case CONTENTION_KIND_SEMAPHORE_SLOTS:
+            for (u32 iteration = 0; iteration != CONTENTION_ITERATIONS; ++iteration) {
+                platform_semaphore_wait(&state->semaphore, PLATFORM_WAIT_INFINITE);
+                holders_enter(state);
+                vatomic_fetch_add_u64(&state->atomic_counter, 1, VMEMORY_ORDER_RELAXED);
+                holders_leave(state);
+                platform_semaphore_signal(&state->semaphore, 1);
+            }
+            break;
+        case CONTENTION_KIND_ATOMIC_ADD:
+            for (u32 iteration = 0; iteration != CONTENTION_ITERATIONS; ++iteration) {
+                vatomic_fetch_add_u64(&state->atomic_counter, 1, VMEMORY_ORDER_RELAXED);
+            }
+            break;
+        case CONTENTION_KIND_ATOMIC_CAS:
+            for (u32 iteration = 0; iteration != CONTENTION_ITERATIONS; ++iteration) {
+                u64 expected = vatomic_load_u64(&state->atomic_counter, VMEMORY_ORDER_RELAXED);
+                while (!vatomic_compare_exchange_u64(&state->atomic_counter, &expected, expected + 1, VMEMORY_ORDER_ACQ_REL))
+                    vatomic_pause();
+            }
+            break;
+        case CONTENTION_KIND_CONDVAR:
+            if (self->index % 2 == 0)
+                queue_produce(state);
+            else
+                queue_consume(state);
+            break;
+        default:
+            break;
+    }
+
+    return self->index;
+}
+
+// Takes every count left in the semaphore, which has to be exactly what it was created with
+static b8 semaphore_check_balance(contention_state* state, u32 expected_count) {
+    u32 count = 0;
+    while (count <= expected_count && platform_semaphore_wait(&state->semaphore, 0))
+        ++count;
+    platform_semaphore_signal(&state->semaphore, count);
+
+    if (count != expected_count) {
+        VERROR("%s: semaphore count is %u after the run, expected %u", kind_names[state->kind], count, expected_count);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static b8 holders_check(const contention_state* state, u32 allowed) {
+    if (state->max_holders > allowed) {
+        VERROR("%s: %u threads were inside at once, at most %u are allowed", kind_names[state->kind], state->max_holders, allowed);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static b8 contention_check(contention_state* state) {
+    const u64 total = (u64)CONTENTION_THREAD_COUNT * CONTENTION_ITERATIONS;
+    switch (state->kind) {
+        case CONTENTION_KIND_MUTEX:
+        case CONTENTION_KIND_SEMAPHORE:
+            if (state->counter != total) {
+                VERROR("%s: counter is %llu, expected %llu", kind_names[state->kind], state->counter, total);
+                return FALSE;
+            }
+            if (!holders_check(state, 1))
+                return FALSE;
+            return state->kind == CONTENTION_KIND_MUTEX || semaphore_check_balance(state, 1);
+        case CONTENTION_KIND_SEMAPHORE_SLOTS:
+            if (state->atomic_counter != total) {
+                VERROR("%s: counter is %llu, expected %llu", kind_names[state->kind], state->atomic_counter, total);
+                return FALSE;
+            }
+            if (!holders_check(state, CONTENTION_SEMAPHORE_SLOTS))
+                return FALSE;
+            return semaphore_check_balance(state, CONTENTION_SEMAPHORE_SLOTS);
+        case CONTENTION_KIND_ATOMIC_ADD:
+        case CONTENTION_KIND_ATOMIC_CAS:
+            if (state->atomic_counter != total) {
+                VERROR("%s: counter is %llu, expected %llu", kind_names[state->kind], state->atomic_counter, total);
+                return FALSE;
+            }
+            return TRUE;
+        case CONTENTION_KIND_CONDVAR: {
+            // Every producer pushes 1..ITERATIONS once
+            const u64 producers = CONTENTION_THREAD_COUNT / 2;
+            const u64 expected_sum = producers * ((u64)CONTENTION_ITERATIONS * (CONTENTION_ITERATIONS + 1) / 2);
+            if (state->consumed_count != producers * CONTENTION_ITERATIONS || state->consumed_sum != expected_sum || state->queue_count != 0) {
+                VERROR("%s: consumed %llu values summing to %llu, expected %llu summing to %llu",
+                    kind_names[state->kind], state->consumed_count, state->consumed_sum, producers * CONTENTION_ITERATIONS, expected_sum);
+                return FALSE;
+            }
+            if (state->lost_wakeups != 0) {
+                VERROR("%s: %u waits timed out although their condition held, wake ups were lost", kind_names[state->kind], state->lost_wakeups);
+                return FALSE;
+            }
+            return TRUE;
+        }
+        default:
+            return FALSE;
+    }
+}
+
+static b8 contention_run(contention_state* state, contention_kind kind) {
+    vzero_memory(state, sizeof(contention_state));
+    state->kind = kind;
+    const u32 semaphore_count = kind == CONTENTION_KIND_SEMAPHORE_SLOTS ? CONTENTION_SEMAPHORE_SLOTS : 1;
+    if (!platform_mutex_create(&state->mutex) ||
+        !platform_semaphore_create(semaphore_count, semaphore_count, &state->semaphore) ||
+        !platform_condvar_create(&state->not_empty) ||
+        !platform_condvar_create(&state->not_full)) {
+        VERROR("%s: could not create the synchronization objects", kind_names[kind]);
+        return FALSE;
+    }
+
+    contention_thread threads[CONTENTION_THREAD_COUNT];
+    u32 started = 0;
+    for (; started != CONTENTION_THREAD_COUNT; ++started) {
+        char name[32];
+        snprintf(name, sizeof(name), "contention_%u", started);
+        threads[started].state = state;
+        threads[started].index = started;
+        if (!platform_thread_create(contention_thread_main, &threads[started], name, &threads[started].thread)) {
+            VERROR("%s: could not create thread %u", kind_names[kind], started);
+            break;
+        }
+    }
+
+    while (vatomic_load_u32(&state->ready_count, VMEMORY_ORDER_ACQUIRE) != started)
+        platform_thread_yield();
+
+    // A thread that could not be created leaves its queue partner waiting, nothing runs then
+    b8 success = started == CONTENTION_THREAD_COUNT;
+    if (!success)
+        state->kind = CONTENTION_KIND_COUNT;
+
+    f64 start_time = platform_get_absolute_time();
+    vatomic_store_u32(&state->go, TRUE, VMEMORY_ORDER_RELEASE);
+
+    for (u32 idx = 0; idx != started; ++idx) {
+        if (platform_thread_join(&threads[idx].thread) != idx) {
+            VERROR("%s: thread %u returned a wrong exit code", kind_names[kind], idx);
+            success = FALSE;
+        }
+    }
+    f64 elapsed = platform_get_absolute_time() - start_time;
+
+    if (success) {
+        const u64 operations = (u64)CONTENTION_THREAD_COUNT * CONTENTION_ITERATIONS;
+        VINFO("%-10s %u threads x %u: %8.2f ms, %7.1f ns per operation",
+            kind_names[kind], CONTENTION_THREAD_COUNT, CONTENTION_ITERATIONS, elapsed * 1000.0, elapsed * 1000000000.0 / (f64)operations);
+        success = contention_check(state);
+    }
+
+    platform_condvar_destroy(&state->not_full);
+    platform_condvar_destroy(&state->not_empty);
+    platform_semaphore_destroy(&state->semaphore);
+    platform_mutex_destroy(&state->mutex);
+    return success;
+}
+
+b8 bench_contention(i32 argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    VINFO("Contention of %u threads on %u logical processors", CONTENTION_THREAD_COUNT, platform_get_processor_count());
+
+    static contention_state state;
+    b8 success = TRUE;
+    for (u32 kind = 0; kind != CONTENTION_KIND_COUNT; ++kind) {
+        if (!contention_run(&state, (contention_kind)kind))
+            success = FALSE;
+    }
+
+    // The semaphore has to refuse waits once its count is used up
+    platform_semaphore semaphore;
+    if (!platform_semaphore_create(0, CONTENTION_THREAD_COUNT, &semaphore)) {
+        VERROR("semaphore: could not create the semaphore");
+        return FALSE;
+    }
+    platform_semaphore_signal(&semaphore, 1);
+    if (!platform_semaphore_wait(&semaphore, 0) || platform_semaphore_wait(&semaphore, 10)) {
+        VERROR("semaphore: count did not match the signals");
+        success = FALSE;
+    }
+    platform_semaphore_destroy(&semaphore);
+
+    return success;
+}
@@ -0,0 +1,172 @@
+#include "bench.h"
+#include <core/frame_stats.h>
+#include <core/logger.h>
+#include <core/vmemory.h>
+#include <containers/darray.h>
+#include <renderer/renderer_frontend.h>
+
+#include <stdlib.h>
+
+#define DRAWS_DRAW_COUNT 100000
+// Geometry slots are limited, the draws cycle through a grid of small triangles
+#define DRAWS_GRID_WIDTH 40
+#define DRAWS_GRID_HEIGHT 25
+#define DRAWS_GEOMETRY_COUNT (DRAWS_GRID_WIDTH * DRAWS_GRID_HEIGHT)
+// Warmup of each phase, counted once every geometry is uploaded. Covers the frame counters lagging behind by the frames in flight
+#define DRAWS_WARMUP_FRAMES 10
+// Frames the uploads of the geometry may take before the bench gives up
+#define DRAWS_UPLOAD_TIMEOUT_FRAMES 1000
+#define DRAWS_DEFAULT_FRAME_COUNT 100
+// 7 workers and the main thread
+#define DRAWS_WORKER_COUNT 7
+
+static const u32 thread_counts[] = { 1, 4, 8 };
+#define DRAWS_PHASE_COUNT (sizeof(thread_counts) / sizeof(thread_counts[0]))
+
+typedef struct draws_phase_result {
+    frame_stats_summary recording;
+    frame_stats_summary frame;
+    u32 draw_calls;
+} draws_phase_result;
+
+typedef struct draws_state {
+    u32 frame_count;
+    geometry geometries[DRAWS_GEOMETRY_COUNT];
+    b8 created;
+    b8 failed;
+    // Geometry whose upload completed, checked in order, and the frames the uploads took
+    u32 ready_count;
+    u32 upload_frames;
+    // Phase being run and the frames it ran so far, warmup included
+    u32 phase;
+    u32 phase_frame;
+    draws_phase_result results[DRAWS_PHASE_COUNT];
+} draws_state;
+
+static draws_state* state;
+
+static b8 create_geometries() {
+    const f32 cell_width = 2.0f / DRAWS_GRID_WIDTH;
+    const f32 cell_height = 2.0f / DRAWS_GRID_HEIGHT;
+    for (u32 idx = 0; idx != DRAWS_GEOMETRY_COUNT; ++idx) {
+        f32 x = -1.0f + (idx % DRAWS_GRID_WIDTH) * cell_width;
+        f32 y = -1.0f + (idx / DRAWS_GRID_WIDTH) * cell_height;
+        f32 z = 0.5f;
+        const f32 vertices[] = {
+            x, y, z,
+            x + cell_width, y, z,
+            x + cell_width * 0.5f, y + cell_height, z
+        };
+        if (!renderer_create_geometry(sizeof(f32) * 3, 3, vertices, 0, 0, &state->geometries[idx])) {
+            VERROR("Could not create geometry %u", idx);
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// Draws skip geometry that is still uploading, so the phases wait until every geometry is ready
+static b8 wait_for_uploads() {
+    while (state->ready_count != DRAWS_GEOMETRY_COUNT && renderer_geometry_is_ready(&state->geometries[state->ready_count]))
+        ++state->ready_count;
+
+    if (state->ready_count == DRAWS_GEOMETRY_COUNT)
+        return TRUE;
+
+    if (++state->upload_frames == DRAWS_UPLOAD_TIMEOUT_FRAMES) {
+        VERROR("Only %u of %u geometries were uploaded after %u frames", state->ready_count, DRAWS_GEOMETRY_COUNT, state->upload_frames);
+        state->failed = TRUE;
+        bench_quit();
+    }
+    return FALSE;
+}
+
+// Moves through the phases once the geometry is uploaded, the samples of a phase start after its warmup
+static b8 draws_prepare_frame(f64 delta_time) {
+    if (state->failed || state->phase == DRAWS_PHASE_COUNT)
+        return TRUE;
+
+    if (!state->created) {
+        if (!create_geometries()) {
+            state->failed = TRUE;
+            bench_quit();
+            return TRUE;
+        }
+        state->created = TRUE;
+    }
+
+    if (!wait_for_uploads())
+        return TRUE;
+
+    if (state->phase_frame == DRAWS_WARMUP_FRAMES)
+        frame_stats_reset();
+
+    if (state->phase_frame == DRAWS_WARMUP_FRAMES + state->frame_count) {
+        draws_phase_result* result = &state->results[state->phase];
+        frame_stats_get(FRAME_STAT_ZONE_DRAW_RECORDING, &result->recording);
+        frame_stats_get(FRAME_STAT_ZONE_FRAME, &result->frame);
+        renderer_frame_counters counters;
+        renderer_get_frame_counters(&counters);
+        result->draw_calls = counters.draw_calls;
+
+        state->phase_frame = 0;
+        if (++state->phase == DRAWS_PHASE_COUNT) {
+            bench_quit();
+            return TRUE;
+        }
+    }
+
+    ++state->phase_frame;
+    return TRUE;
+}
+
+static b8 draws_render(render_packet* packet) {
+    if (!state->created || state->phase == DRAWS_PHASE_COUNT)
+        return TRUE;
+
+    packet->max_draw_threads = thread_counts[state->phase];
+    for (u32 idx = 0; idx != DRAWS_DRAW_COUNT; ++idx) {
+        geometry_render_data draw = { &state->geometries[idx % DRAWS_GEOMETRY_COUNT] };
+        darray_push(packet->geometries, draw);
+    }
+    return TRUE;
+}
+
+static void draws_shutdown() {
+    if (!state->created)
+        return;
+
+    for (u32 idx = 0; idx != DRAWS_GEOMETRY_COUNT; ++idx)
+        renderer_destroy_geometry(&state->geometries[idx]);
+    state->created = FALSE;
+}
+
+b8 bench_draws(i32 argc, char** argv) {
+    state = vallocate(sizeof(draws_state), MEMORY_TAG_GAME);
+    state->frame_count = argc > 0 ? (u32)strtoul(argv[0], 0, 10) : DRAWS_DEFAULT_FRAME_COUNT;
+    if (state->frame_count == 0)
+        state->frame_count = DRAWS_DEFAULT_FRAME_COUNT;
+
+    b8 success = bench_run_headless("Bench draws", DRAWS_WORKER_COUNT, draws_prepare_frame, draws_render, draws_shutdown) &&
+        !state->failed;
+    if (success) {
+        VINFO("Geometry uploaded after %u frames", state->upload_frames);
+        VINFO("%u draws per frame cycling over %u one triangle geometries, %u frames per thread count", DRAWS_DRAW_COUNT, DRAWS_GEOMETRY_COUNT, state->frame_count);
+        for (u32 idx = 0; idx != DRAWS_PHASE_COUNT; ++idx) {
+            const draws_phase_result* result = &state->results[idx];
+            VINFO("%u threads: recording p50 %7.2f ms (%5.2fx), frame p50 %7.2f ms", thread_counts[idx],
+                result->recording.p50 * 1000.0, state->results[0].recording.p50 / result->recording.p50,
+                result->frame.p50 * 1000.0);
+
+            // The secondaries have to hold the draws, their counters add up in the primary
+            if (result->draw_calls != DRAWS_DRAW_COUNT) {
+                VERROR("%u threads: a frame recorded %u draws, expected %u", thread_counts[idx], result->draw_calls, DRAWS_DRAW_COUNT);
+                success = FALSE;
+            }
+        }
+    }
+
+    vfree(state, sizeof(draws_state), MEMORY_TAG_GAME);
+    state = 0;
+    return success;
+}
@@ -0,0 +1,88 @@
+#include "bench.h"
+#include <core/job_system.h>
+#include <core/logger.h>
+#include <core/vatomic.h>
+#include <platform/platform.h>
+
+#include <stdlib.h>
+
+// Every job below the leaves forks two children and waits for them
+#define FIBERS_TREE_DEPTH 16
+#define FIBERS_TREE_COUNT 8
+// Arithmetic done by a leaf, so the tree is not only scheduling
+#define FIBERS_LEAF_ITERATIONS 2000
+
+static volatile u64 leaf_sum;
+
+// Nodes are numbered like a binary heap, the leaves are the last level
+#define FIBERS_FIRST_LEAF ((1ull << FIBERS_TREE_DEPTH) - 1)
+#define FIBERS_NODE_COUNT ((2ull << FIBERS_TREE_DEPTH) - 1)
+
+static u64 leaf_value(u64 node) {
+    u64 value = node;
+    for (u32 idx = 0; idx != FIBERS_LEAF_ITERATIONS; ++idx)
+        value = value * 6364136223846793005ull + 1442695040888963407ull;
+    return value;
+}
+
+static void tree_job(void* data) {
+    u64 node = (u64)data;
+    if (node >= FIBERS_FIRST_LEAF) {
+        vatomic_fetch_add_u64(&leaf_sum, leaf_value(node), VMEMORY_ORDER_RELAXED);
+        return;
+    }
+
+    // The wait parks this job's fiber, or runs other jobs on top of this stack without fibers
+    job_decl children[2] = {
+        { tree_job, (void*)(node * 2 + 1) },
+        { tree_job, (void*)(node * 2 + 2) }
+    };
+    job_counter counter = { 0 };
+    job_system_run(children, 2, &counter);
+    job_system_wait(&counter);
+}
+
+static b8 run_trees(b8 use_fibers, u32 worker_count) {
+    job_system_config config = { 0 };
+    config.worker_count = worker_count;
+    config.use_fibers = use_fibers;
+    if (!job_system_initialize(&config))
+        return FALSE;
+
+    vatomic_store_u64(&leaf_sum, 0, VMEMORY_ORDER_RELAXED);
+    job_decl roots[FIBERS_TREE_COUNT];
+    for (u32 idx = 0; idx != FIBERS_TREE_COUNT; ++idx) {
+        roots[idx].entry = tree_job;
+        roots[idx].data = 0;
+    }
+
+    f64 start_time = platform_get_absolute_time();
+    job_counter counter = { 0 };
+    job_system_run(roots, FIBERS_TREE_COUNT, &counter);
+    job_system_wait(&counter);
+    f64 elapsed = platform_get_absolute_time() - start_time;
+    u32 thread_count = job_system_thread_count();
+    job_system_shutdown();
+
+    const u64 job_count = FIBERS_TREE_COUNT * FIBERS_NODE_COUNT;
+    VINFO("%-7s %2u threads: %llu jobs in %8.2f ms, %10.0f jobs/s", use_fibers ? "fibers" : "threads",
+        thread_count, job_count, elapsed * 1000.0, job_count / elapsed);
+
+    // Every leaf has to have run exactly once
+    u64 expected_sum = 0;
+    for (u64 node = FIBERS_FIRST_LEAF; node != FIBERS_NODE_COUNT; ++node)
+        expected_sum += FIBERS_TREE_COUNT * leaf_value(node);
+    if (vatomic_load_u64(&leaf_sum, VMEMORY_ORDER_RELAXED) != expected_sum) {
+        VERROR("%s: the leaves of the trees did not all run once", use_fibers ? "fibers" : "threads");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+b8 bench_fibers(i32 argc, char** argv) {
+    u32 worker_count = argc > 0 ? (u32)strtoul(argv[0], 0, 10) : 0;
+    VINFO("%u dependency trees of depth %u, each job waits on its two children", FIBERS_TREE_COUNT, FIBERS_TREE_DEPTH);
+
+    b8 success = run_trees(FALSE, worker_count);
+    return run_trees(TRUE, worker_count) && success;
+}
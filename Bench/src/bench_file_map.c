@@ -0,0 +1,133 @@
+#include "bench.h"
+#include <core/logger.h>
+#include <core/vmemory.h>
+#include <platform/platform.h>
+#include <platform/platform_file.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define FILE_MAP_DEFAULT_SIZE_MIB 1024
+// Buffer size of the buffered reads, a typical asset loader chunk
+#define FILE_MAP_READ_CHUNK_SIZE (1024 * 1024)
+
+// Sums the data as 64 bit words, so every byte has to be read
+static u64 checksum(const u8* data, u64 size) {
+    const u64* words = (const u64*)data;
+    u64 sum = 0;
+    for (u64 idx = 0; idx != size / sizeof(u64); ++idx)
+        sum += words[idx];
+    return sum;
+}
+
+static b8 write_file(const char* path, u64 size) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        VERROR("Could not create '%s'", path);
+        return FALSE;
+    }
+
+    u64* chunk = vallocate(FILE_MAP_READ_CHUNK_SIZE, MEMORY_TAG_ARRAY);
+    u64 state = 0x9E3779B97F4A7C15ull;
+    b8 success = TRUE;
+    for (u64 written = 0; written < size && success; written += FILE_MAP_READ_CHUNK_SIZE) {
+        for (u32 idx = 0; idx != FILE_MAP_READ_CHUNK_SIZE / sizeof(u64); ++idx) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            chunk[idx] = state;
+        }
+        success = fwrite(chunk, 1, FILE_MAP_READ_CHUNK_SIZE, file) == FILE_MAP_READ_CHUNK_SIZE;
+    }
+    vfree(chunk, FILE_MAP_READ_CHUNK_SIZE, MEMORY_TAG_ARRAY);
+
+    if (fclose(file) != 0 || !success) {
+        VERROR("Could not write %llu bytes to '%s'", size, path);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static b8 read_buffered(const char* path, u64* out_size, u64* out_checksum) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        VERROR("Could not open '%s'", path);
+        return FALSE;
+    }
+
+    u8* chunk = vallocate(FILE_MAP_READ_CHUNK_SIZE, MEMORY_TAG_ARRAY);
+    u64 size = 0;
+    u64 sum = 0;
+    u64 read;
+    while ((read = fread(chunk, 1, FILE_MAP_READ_CHUNK_SIZE, file)) > 0) {
+        sum += checksum(chunk, read);
+        size += read;
+    }
+    vfree(chunk, FILE_MAP_READ_CHUNK_SIZE, MEMORY_TAG_ARRAY);
+    fclose(file);
+
+    *out_size = size;
+    *out_checksum = sum;
+    return TRUE;
+}
+
+static b8 read_mapped(const char* path, u64* out_size, u64* out_checksum) {
+    platform_file_mapping mapping;
+    if (!platform_file_map(path, PLATFORM_FILE_MAP_READ_ONLY, &mapping)) {
+        VERROR("Could not map '%s'", path);
+        return FALSE;
+    }
+
+    platform_file_prefetch(&mapping, 0, mapping.size);
+    *out_size = mapping.size;
+    *out_checksum = checksum((const u8*)mapping.data, mapping.size);
+    platform_file_unmap(&mapping);
+    return TRUE;
+}
+
+static void log_result(const char* name, u64 size, f64 seconds) {
+    VINFO("%-8s %llu MiB in %8.2f ms, %8.1f MiB/s", name, size / (1024 * 1024), seconds * 1000.0,
+        (f64)size / (1024.0 * 1024.0) / seconds);
+}
+
+b8 bench_file_map(i32 argc, char** argv) {
+    if (argc < 1) {
+        VERROR("file_map needs the path of the file to read");
+        return FALSE;
+    }
+
+    const char* path = argv[0];
+    u64 size_mib = argc > 1 ? strtoull(argv[1], 0, 10) : FILE_MAP_DEFAULT_SIZE_MIB;
+    u64 size = size_mib * 1024 * 1024;
+    if (size == 0) {
+        VERROR("file_map needs a size of at least 1 MiB");
+        return FALSE;
+    }
+
+    VINFO("Writing %llu MiB to '%s'", size_mib, path);
+    if (!write_file(path, size))
+        return FALSE;
+
+    // The file was just written, both reads come from the page cache and measure the copy
+    // through the read buffer against reading the pages in place
+    u64 buffered_size, buffered_checksum;
+    u64 mapped_size, mapped_checksum;
+    f64 start_time = platform_get_absolute_time();
+    b8 success = read_buffered(path, &buffered_size, &buffered_checksum);
+    f64 buffered_time = platform_get_absolute_time() - start_time;
+
+    start_time = platform_get_absolute_time();
+    success = read_mapped(path, &mapped_size, &mapped_checksum) && success;
+    f64 mapped_time = platform_get_absolute_time() - start_time;
+
+    remove(path);
+    if (!success)
+        return FALSE;
+
+    log_result("fread", buffered_size, buffered_time);
+    log_result("mapped", mapped_size, mapped_time);
+    if (buffered_size != size || mapped_size != size || buffered_checksum != mapped_checksum) {
+        VERROR("Reads differ: fread %llu bytes (checksum %llx), mapped %llu bytes (checksum %llx)",
+            buffered_size, buffered_checksum, mapped_size, mapped_checksum);
+        return FALSE;
+    }
+    return TRUE;
+}
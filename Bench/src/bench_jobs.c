@@ -0,0 +1,111 @@
+#include "bench.h"
+#include <core/job_system.h>
+#include <core/logger.h>
+#include <core/vmemory.h>
+#include <platform/platform.h>
+#include <platform/platform_thread.h>
+
+// Empty jobs are queued in batches, a deque only holds so many jobs before they run inline
+#define JOBS_EMPTY_BATCH_SIZE 1024
+#define JOBS_EMPTY_BATCH_COUNT 1000
+// The synthetic workload: independent jobs that each spin through some arithmetic
+#define JOBS_WORK_JOB_COUNT 2048
+#define JOBS_WORK_ITERATIONS 20000
+
+static const u32 thread_counts[] = { 1, 2, 4, 8, 16 };
+#define JOBS_THREAD_COUNT_COUNT (sizeof(thread_counts) / sizeof(thread_counts[0]))
+
+static void empty_job(void* data) {
+    (void)data;
+}
+
+// Results of the workload, each job writes the slot of its index
+static u64* work_results;
+
+static u64 work_value(u64 seed) {
+    u64 value = seed;
+    for (u32 idx = 0; idx != JOBS_WORK_ITERATIONS; ++idx)
+        value = value * 6364136223846793005ull + 1442695040888963407ull;
+    return value;
+}
+
+static void work_job(void* data) {
+    u64 index = (u64)data;
+    work_results[index] = work_value(index);
+}
+
+static f64 run_empty_jobs(job_decl* jobs) {
+    f64 start_time = platform_get_absolute_time();
+    for (u32 batch = 0; batch != JOBS_EMPTY_BATCH_COUNT; ++batch) {
+        job_counter counter = { 0 };
+        job_system_run(jobs, JOBS_EMPTY_BATCH_SIZE, &counter);
+        job_system_wait(&counter);
+    }
+    return platform_get_absolute_time() - start_time;
+}
+
+static f64 run_work_jobs(job_decl* jobs) {
+    f64 start_time = platform_get_absolute_time();
+    job_counter counter = { 0 };
+    job_system_run(jobs, JOBS_WORK_JOB_COUNT, &counter);
+    job_system_wait(&counter);
+    return platform_get_absolute_time() - start_time;
+}
+
+b8 bench_jobs(i32 argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    VINFO("Job system on %u logical processors, %u empty jobs and %u jobs of %u iterations per thread count",
+        platform_get_processor_count(), JOBS_EMPTY_BATCH_SIZE * JOBS_EMPTY_BATCH_COUNT, JOBS_WORK_JOB_COUNT, JOBS_WORK_ITERATIONS);
+
+    job_decl* empty_jobs = vallocate(sizeof(job_decl) * JOBS_EMPTY_BATCH_SIZE, MEMORY_TAG_JOB);
+    for (u32 idx = 0; idx != JOBS_EMPTY_BATCH_SIZE; ++idx) {
+        empty_jobs[idx].entry = empty_job;
+        empty_jobs[idx].data = 0;
+    }
+
+    work_results = vallocate(sizeof(u64) * JOBS_WORK_JOB_COUNT, MEMORY_TAG_JOB);
+    job_decl* work_jobs = vallocate(sizeof(job_decl) * JOBS_WORK_JOB_COUNT, MEMORY_TAG_JOB);
+    for (u32 idx = 0; idx != JOBS_WORK_JOB_COUNT; ++idx) {
+        work_jobs[idx].entry = work_job;
+        work_jobs[idx].data = (void*)(u64)idx;
+    }
+
+    b8 success = TRUE;
+    f64 single_thread_time = 0;
+    for (u32 idx = 0; idx != JOBS_THREAD_COUNT_COUNT && success; ++idx) {
+        // One thread runs without workers, job_system_run then runs the jobs on the caller
+        u32 thread_count = thread_counts[idx];
+        if (thread_count > 1) {
+            job_system_config config = { 0 };
+            config.worker_count = thread_count - 1;
+            if (!job_system_initialize(&config)) {
+                success = FALSE;
+                break;
+            }
+        }
+
+        f64 empty_time = run_empty_jobs(empty_jobs);
+        vzero_memory(work_results, sizeof(u64) * JOBS_WORK_JOB_COUNT);
+        f64 work_time = run_work_jobs(work_jobs);
+        job_system_shutdown();
+
+        if (thread_count == 1)
+            single_thread_time = work_time;
+        VINFO("%2u threads: %10.0f empty jobs/s, workload in %8.2f ms, speedup %5.2fx", thread_count,
+            JOBS_EMPTY_BATCH_SIZE * JOBS_EMPTY_BATCH_COUNT / empty_time, work_time * 1000.0, single_thread_time / work_time);
+
+        for (u32 job = 0; job != JOBS_WORK_JOB_COUNT; ++job) {
+            if (work_results[job] != work_value((u64)job)) {
+                VERROR("%u threads: job %u produced a wrong result", thread_count, job);
+                success = FALSE;
+                break;
+            }
+        }
+    }
+
+    vfree(work_jobs, sizeof(job_decl) * JOBS_WORK_JOB_COUNT, MEMORY_TAG_JOB);
+    vfree(work_results, sizeof(u64) * JOBS_WORK_JOB_COUNT, MEMORY_TAG_JOB);
+    vfree(empty_jobs, sizeof(job_decl) * JOBS_EMPTY_BATCH_SIZE, MEMORY_TAG_JOB);
+    return success;
+}
@@ -0,0 +1,54 @@
+#include "bench.h"
+#include <core/logger.h>
+#include <core/vmemory.h>
+#include <platform/platform.h>
+#include <renderer/renderer_frontend.h>
+
+// The allocator check is a test hook of the DEBUG renderer
+#if defined(VKR_ENABLE_CHECKS)
+
+typedef struct memory_state {
+    renderer_check_status status;
+    u32 frames;
+    f64 start_time;
+} memory_state;
+
+static memory_state* state;
+
+// Steps the check once per frame, the defragmentation part waits for frames to complete
+static b8 memory_prepare_frame(f64 delta_time) {
+    if (state->status != RENDERER_CHECK_RUNNING)
+        return TRUE;
+
+    if (state->frames++ == 0)
+        state->start_time = platform_get_absolute_time();
+
+    state->status = renderer_check_memory_step();
+    if (state->status != RENDERER_CHECK_RUNNING) {
+        VINFO("Memory allocator check %s after %u frames in %.2f ms", state->status == RENDERER_CHECK_PASSED ? "passed" : "failed",
+            state->frames, (platform_get_absolute_time() - state->start_time) * 1000.0);
+        bench_quit();
+    }
+    return TRUE;
+}
+
+b8 bench_memory(i32 argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    state = vallocate(sizeof(memory_state), MEMORY_TAG_GAME);
+    state->status = RENDERER_CHECK_RUNNING;
+
+    b8 success = bench_run_headless("Bench memory", 0, memory_prepare_frame, 0, 0);
+    success = success && state->status == RENDERER_CHECK_PASSED;
+    vfree(state, sizeof(memory_state), MEMORY_TAG_GAME);
+    state = 0;
+    return success;
+}
+#else
+b8 bench_memory(i32 argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    VERROR("Bench memory needs the DEBUG configuration, the renderer was built without VKR_ENABLE_CHECKS");
+    return FALSE;
+}
+#endif
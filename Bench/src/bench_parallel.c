@@ -0,0 +1,118 @@
+#include "bench.h"
+#include <core/job_system.h>
+#include <core/logger.h>
+#include <core/parallel.h>
+#include <core/vmemory.h>
+#include <platform/platform.h>
+#include <platform/platform_thread.h>
+
+#define PARALLEL_ELEMENT_COUNT 10000000ull
+// Each pass is repeated and the fastest run is kept, the first touches pages in
+#define PARALLEL_REPEAT_COUNT 5
+
+static const u32 thread_counts[] = { 1, 2, 4, 8, 16 };
+#define PARALLEL_THREAD_COUNT_COUNT (sizeof(thread_counts) / sizeof(thread_counts[0]))
+
+typedef struct parallel_arrays {
+    const f32* input;
+    f32* output;
+} parallel_arrays;
+
+// Stands in for a transform update: a few dependent multiply adds per element
+static void transform_range(u64 begin, u64 end, void* user_data) {
+    parallel_arrays* arrays = (parallel_arrays*)user_data;
+    for (u64 idx = begin; idx != end; ++idx) {
+        f32 value = arrays->input[idx];
+        arrays->output[idx] = (value * 1.5f + 2.0f) * value - 0.5f;
+    }
+}
+
+static void sum_range(u64 begin, u64 end, void* partial_result, void* user_data) {
+    const f32* input = (const f32*)user_data;
+    f64 sum = *(f64*)partial_result;
+    for (u64 idx = begin; idx != end; ++idx)
+        sum += input[idx];
+    *(f64*)partial_result = sum;
+}
+
+static void sum_combine(void* accumulated, const void* partial_result, void* user_data) {
+    (void)user_data;
+    *(f64*)accumulated += *(const f64*)partial_result;
+}
+
+static f64 best_time(f64 best, f64 start_time) {
+    f64 elapsed = platform_get_absolute_time() - start_time;
+    return best == 0 || elapsed < best ? elapsed : best;
+}
+
+b8 bench_parallel(i32 argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    VINFO("parallel_for and parallel_reduce over %llu elements on %u logical processors",
+        PARALLEL_ELEMENT_COUNT, platform_get_processor_count());
+
+    // Small integers stay exact in the sums, so every thread count has to reach the same result
+    f32* input = vallocate(sizeof(f32) * PARALLEL_ELEMENT_COUNT, MEMORY_TAG_ARRAY);
+    f32* output = vallocate(sizeof(f32) * PARALLEL_ELEMENT_COUNT, MEMORY_TAG_ARRAY);
+    f64 expected_sum = 0;
+    for (u64 idx = 0; idx != PARALLEL_ELEMENT_COUNT; ++idx) {
+        input[idx] = (f32)(idx % 7);
+        expected_sum += input[idx];
+    }
+    parallel_arrays arrays = { input, output };
+
+    b8 success = TRUE;
+    f64 single_for_time = 0;
+    f64 single_reduce_time = 0;
+    for (u32 idx = 0; idx != PARALLEL_THREAD_COUNT_COUNT && success; ++idx) {
+        // One thread runs without workers, the helpers then run serially on the caller
+        u32 thread_count = thread_counts[idx];
+        if (thread_count > 1) {
+            job_system_config config = { 0 };
+            config.worker_count = thread_count - 1;
+            if (!job_system_initialize(&config)) {
+                success = FALSE;
+                break;
+            }
+        }
+
+        f64 for_time = 0;
+        f64 reduce_time = 0;
+        f64 sum = 0;
+        for (u32 repeat = 0; repeat != PARALLEL_REPEAT_COUNT; ++repeat) {
+            f64 start_time = platform_get_absolute_time();
+            parallel_for(PARALLEL_ELEMENT_COUNT, PARALLEL_AUTO_GRAIN, transform_range, &arrays);
+            for_time = best_time(for_time, start_time);
+
+            f64 identity = 0;
+            start_time = platform_get_absolute_time();
+            parallel_reduce(PARALLEL_ELEMENT_COUNT, PARALLEL_AUTO_GRAIN, sizeof(f64), &identity, &sum, sum_range, sum_combine, input);
+            reduce_time = best_time(reduce_time, start_time);
+        }
+        job_system_shutdown();
+
+        if (thread_count == 1) {
+            single_for_time = for_time;
+            single_reduce_time = reduce_time;
+        }
+        VINFO("%2u threads: parallel_for %7.2f ms (%5.2fx), parallel_reduce %7.2f ms (%5.2fx)", thread_count,
+            for_time * 1000.0, single_for_time / for_time, reduce_time * 1000.0, single_reduce_time / reduce_time);
+
+        if (sum != expected_sum) {
+            VERROR("%u threads: parallel_reduce summed to %f, expected %f", thread_count, sum, expected_sum);
+            success = FALSE;
+        }
+        for (u64 element = 0; element != PARALLEL_ELEMENT_COUNT && success; element += PARALLEL_ELEMENT_COUNT / 1000) {
+            f32 value = input[element];
+            if (output[element] != (value * 1.5f + 2.0f) * value - 0.5f) {
+                VERROR("%u threads: parallel_for wrote a wrong value at %llu", thread_count, element);
+                success = FALSE;
+            }
+        }
+        vzero_memory(output, sizeof(f32) * PARALLEL_ELEMENT_COUNT);
+    }
+
+    vfree(output, sizeof(f32) * PARALLEL_ELEMENT_COUNT, MEMORY_TAG_ARRAY);
+    vfree(input, sizeof(f32) * PARALLEL_ELEMENT_COUNT, MEMORY_TAG_ARRAY);
+    return success;
+}
@@ -0,0 +1,155 @@
+#include "bench.h"
+#include <core/frame_stats.h>
+#include <core/logger.h>
+#include <core/vmemory.h>
+#include <platform/platform.h>
+#include <renderer/renderer_frontend.h>
+
+#include <stdlib.h>
+
+#define STAGING_GEOMETRY_COUNT 10000
+#define STAGING_DEFAULT_FRAME_COUNT 200
+// 4 vertices of a vec3 position and one more float, 64 bytes per upload
+#define STAGING_VERTEX_SIZE (sizeof(f32) * 4)
+#define STAGING_VERTEX_COUNT 4
+// A 1 MiB mesh, above the size the renderer hands to the transfer queue, replaced once it is ready
+#define STAGING_LARGE_VERTEX_COUNT (64 * 1024)
+// Frames a large upload may take until it is ready
+#define STAGING_LARGE_MAX_FRAMES 16
+
+typedef struct staging_state {
+    u32 frame_count;
+    u32 frame;
+    geometry geometries[STAGING_GEOMETRY_COUNT];
+    b8 created;
+    geometry large;
+    f32* large_vertices;
+    b8 large_created;
+    u32 large_frame;
+    u32 large_count;
+    u32 large_max_frames;
+    b8 failed;
+    f64 start_time;
+    renderer_upload_stats start_stats;
+    f64 elapsed;
+    renderer_upload_stats stats;
+    frame_stats_summary frame_summary;
+} staging_state;
+
+static staging_state* state;
+
+// Replaces every geometry each frame, so each frame uploads all of them again
+static b8 staging_prepare_frame(f64 delta_time) {
+    if (state->failed)
+        return TRUE;
+
+    // The first frame creates the geometry, timing starts with the first replacement
+    if (state->frame == 1) {
+        state->start_time = platform_get_absolute_time();
+        renderer_get_upload_stats(&state->start_stats);
+    }
+
+    if (state->frame == state->frame_count + 1) {
+        state->elapsed = platform_get_absolute_time() - state->start_time;
+        renderer_get_upload_stats(&state->stats);
+        frame_stats_get(FRAME_STAT_ZONE_FRAME, &state->frame_summary);
+        bench_quit();
+        return TRUE;
+    }
+
+    f32 vertices[STAGING_VERTEX_COUNT * 4];
+    for (u32 idx = 0; idx != STAGING_GEOMETRY_COUNT; ++idx) {
+        if (state->created)
+            renderer_destroy_geometry(&state->geometries[idx]);
+
+        for (u32 value = 0; value != STAGING_VERTEX_COUNT * 4; ++value)
+            vertices[value] = (f32)(idx + value + state->frame);
+        if (!renderer_create_geometry(STAGING_VERTEX_SIZE, STAGING_VERTEX_COUNT, vertices, 0, 0, &state->geometries[idx])) {
+            VERROR("Frame %u: could not create geometry %u", state->frame, idx);
+            state->failed = TRUE;
+            bench_quit();
+            return TRUE;
+        }
+    }
+
+    state->created = TRUE;
+
+    // The large mesh goes through the transfer queue alongside, a new one once the last is ready
+    if (state->large_created && !renderer_geometry_is_ready(&state->large)) {
+        if (state->frame - state->large_frame > STAGING_LARGE_MAX_FRAMES) {
+            VERROR("Frame %u: the large geometry is not ready after %u frames", state->frame, STAGING_LARGE_MAX_FRAMES);
+            state->failed = TRUE;
+            bench_quit();
+            return TRUE;
+        }
+    } else {
+        if (state->large_created) {
+            u32 frames = state->frame - state->large_frame;
+            if (frames > state->large_max_frames)
+                state->large_max_frames = frames;
+            ++state->large_count;
+            renderer_destroy_geometry(&state->large);
+            state->large_created = FALSE;
+        }
+
+        for (u32 value = 0; value != STAGING_LARGE_VERTEX_COUNT * 4; ++value)
+            state->large_vertices[value] = (f32)(value + state->frame);
+        if (!renderer_create_geometry(STAGING_VERTEX_SIZE, STAGING_LARGE_VERTEX_COUNT, state->large_vertices, 0, 0, &state->large)) {
+            VERROR("Frame %u: could not create the large geometry", state->frame);
+            state->failed = TRUE;
+            bench_quit();
+            return TRUE;
+        }
+        state->large_created = TRUE;
+        state->large_frame = state->frame;
+    }
+
+    ++state->frame;
+    return TRUE;
+}
+
+static void staging_shutdown() {
+    if (state->large_created) {
+        renderer_destroy_geometry(&state->large);
+        state->large_created = FALSE;
+    }
+    if (!state->created)
+        return;
+
+    for (u32 idx = 0; idx != STAGING_GEOMETRY_COUNT; ++idx)
+        renderer_destroy_geometry(&state->geometries[idx]);
+    state->created = FALSE;
+}
+
+b8 bench_staging(i32 argc, char** argv) {
+    state = vallocate(sizeof(staging_state), MEMORY_TAG_GAME);
+    state->frame_count = argc > 0 ? (u32)strtoul(argv[0], 0, 10) : STAGING_DEFAULT_FRAME_COUNT;
+    if (state->frame_count == 0)
+        state->frame_count = STAGING_DEFAULT_FRAME_COUNT;
+    state->large_vertices = vallocate(STAGING_VERTEX_SIZE * STAGING_LARGE_VERTEX_COUNT, MEMORY_TAG_GAME);
+
+    b8 success = bench_run_headless("Bench staging", 0, staging_prepare_frame, 0, staging_shutdown);
+    if (success && !state->failed) {
+        u64 upload_count = state->stats.upload_count - state->start_stats.upload_count;
+        u64 upload_bytes = state->stats.upload_bytes - state->start_stats.upload_bytes;
+        u32 stall_count = state->stats.stall_count - state->start_stats.stall_count;
+        VINFO("%u frames of %u uploads of %u bytes: %10.0f uploads/s, %7.2f MiB/s, frame p50 %6.2f ms, %u stalls",
+            state->frame_count, STAGING_GEOMETRY_COUNT, (u32)(STAGING_VERTEX_SIZE * STAGING_VERTEX_COUNT),
+            upload_count / state->elapsed, upload_bytes / state->elapsed / 1024.0 / 1024.0,
+            state->frame_summary.p50 * 1000.0, stall_count);
+        VINFO("%u large uploads of %u KiB, ready after at most %u frames", state->large_count,
+            (u32)(STAGING_VERTEX_SIZE * STAGING_LARGE_VERTEX_COUNT / 1024), state->large_max_frames);
+
+        // Every upload of a frame has to fit the staging ring without waiting for the queue
+        if (stall_count != 0) {
+            VERROR("Uploads waited for the queue %u times", stall_count);
+            success = FALSE;
+        }
+    }
+
+    success = success && !state->failed;
+    vfree(state->large_vertices, STAGING_VERTEX_SIZE * STAGING_LARGE_VERTEX_COUNT, MEMORY_TAG_GAME);
+    vfree(state, sizeof(staging_state), MEMORY_TAG_GAME);
+    state = 0;
+    return success;
+}
@@ -0,0 +1,133 @@
+#include "bench.h"
+#include <core/application.h>
+#include <core/event.h>
+#include <core/logger.h>
+#include <core/vmemory.h>
+#include <core/vstring.h>
+#include <game_types.h>
+
+typedef struct bench_entry {
+    const char* name;
+    const char* usage;
+    pfn_bench run;
+    // Run when no name is given, only benchmarks that need no arguments
+    b8 run_by_default;
+} bench_entry;
+
+static const bench_entry benches[] = {
+    { "contention", "contention", bench_contention, TRUE },
+    { "jobs", "jobs", bench_jobs, TRUE },
+    { "parallel", "parallel", bench_parallel, TRUE },
+    { "fibers", "fibers [worker count]", bench_fibers, TRUE },
+    { "file_map", "file_map <path of a scratch file> [size in MiB]", bench_file_map, FALSE },
+    { "async_io", "async_io <directory for scratch files> [small file count]", bench_async_io, FALSE },
+    { "memory", "memory (DEBUG builds only)", bench_memory, FALSE },
+    { "compute", "compute (DEBUG builds only)", bench_compute, FALSE },
+    { "timeline", "timeline (DEBUG builds only)", bench_timeline, FALSE },
+    { "staging", "staging [frame count]", bench_staging, FALSE },
+    { "draws", "draws [frame count per thread count]", bench_draws, FALSE },
+};
+
+#define BENCH_COUNT (sizeof(benches) / sizeof(benches[0]))
+
+// Callbacks of the bench run by bench_run_headless
+static pfn_bench_prepare_frame headless_prepare_frame;
+static pfn_bench_render headless_render;
+static pfn_bench_shutdown headless_shutdown;
+
+static b8 headless_game_initialize(game* game_inst) {
+    return TRUE;
+}
+
+static b8 headless_game_prepare_frame(game* game_inst, f64 delta_time) {
+    return headless_prepare_frame(delta_time);
+}
+
+static b8 headless_game_update(game* game_inst, f64 delta_time) {
+    return TRUE;
+}
+
+static b8 headless_game_render(game* game_inst, f64 delta_time, f64 interpolation_alpha, render_packet* packet) {
+    return headless_render ? headless_render(packet) : TRUE;
+}
+
+static void headless_game_on_resize(game* game_inst, i32 new_width, i32 new_height) {
+}
+
+static void headless_game_shutdown(game* game_inst) {
+    if (headless_shutdown)
+        headless_shutdown();
+}
+
+b8 bench_run_headless(const char* name, u32 worker_count, pfn_bench_prepare_frame prepare_frame,
+    pfn_bench_render render, pfn_bench_shutdown shutdown) {
+    headless_prepare_frame = prepare_frame;
+    headless_render = render;
+    headless_shutdown = shutdown;
+
+    game game_inst;
+    vzero_memory(&game_inst, sizeof(game));
+    game_inst.app_config.name = name;
+    game_inst.app_config.start_width = 1280;
+    game_inst.app_config.start_height = 720;
+    game_inst.app_config.headless = TRUE;
+    game_inst.app_config.job_worker_count = worker_count;
+    game_inst.initialize = headless_game_initialize;
+    game_inst.prepare_frame = headless_game_prepare_frame;
+    game_inst.update = headless_game_update;
+    game_inst.render = headless_game_render;
+    game_inst.on_resize = headless_game_on_resize;
+    game_inst.shutdown = headless_game_shutdown;
+
+    b8 success = application_create(&game_inst) && application_run();
+    headless_prepare_frame = 0;
+    headless_render = 0;
+    headless_shutdown = 0;
+    return success;
+}
+
+void bench_quit() {
+    event_context event = { 0 };
+    event_fire(EVENT_CODE_APPLICATION_QUIT, 0, event);
+}
+
+static void print_usage() {
+    VINFO("Usage: Bench [name] [arguments], without a name the benchmarks that take no arguments run");
+    for (u32 idx = 0; idx != BENCH_COUNT; ++idx) {
+        VINFO("  Bench %s", benches[idx].usage);
+    }
+}
+
+int main(int argc, char** argv) {
+    initialize_memory();
+
+    b8 success = TRUE;
+    if (argc < 2) {
+        for (u32 idx = 0; idx != BENCH_COUNT; ++idx) {
+            if (benches[idx].run_by_default && !benches[idx].run(0, 0)) {
+                VERROR("Benchmark %s failed", benches[idx].name);
+                success = FALSE;
+            }
+        }
+    }
+    else {
+        const bench_entry* entry = 0;
+        for (u32 idx = 0; idx != BENCH_COUNT; ++idx) {
+            if (strings_equal(argv[1], benches[idx].name))
+                entry = &benches[idx];
+        }
+
+        if (!entry) {
+            VERROR("Unknown benchmark '%s'", argv[1]);
+            print_usage();
+            return 2;
+        }
+        if (!entry->run(argc - 2, argv + 2)) {
+            VERROR("Benchmark %s failed", entry->name);
+            success = FALSE;
+        }
+    }
+
+    shutdown_memory();
+    return success ? 0 : 1;
+}
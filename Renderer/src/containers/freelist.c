@@ -0,0 +1,137 @@
+#include "freelist.h"
+#include "darray.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+
+// Inserts a node before index, shifting the following nodes up
+static void insert_node(freelist* list, u64 index, u64 offset, u64 size) {
+    freelist_node node = { offset, size };
+    darray_push(list->nodes, node);
+
+    u64 length = darray_length(list->nodes);
+    for (u64 idx = length - 1; idx > index; --idx)
+        list->nodes[idx] = list->nodes[idx - 1];
+    list->nodes[index] = node;
+}
+
+static void remove_node(freelist* list, u64 index) {
+    u64 length = darray_length(list->nodes);
+    for (u64 idx = index; idx + 1 < length; ++idx)
+        list->nodes[idx] = list->nodes[idx + 1];
+    darray_length_set(list->nodes, length - 1);
+}
+
+void freelist_create(u64 total_size, freelist* out_list) {
+    out_list->total_size = total_size;
+    out_list->nodes = darray_create(freelist_node);
+    if (total_size) {
+        freelist_node whole = { 0, total_size };
+        darray_push(out_list->nodes, whole);
+    }
+}
+
+void freelist_destroy(freelist* list) {
+    if (list->nodes) {
+        darray_destroy(list->nodes);
+    }
+    list->nodes = 0;
+    list->total_size = 0;
+}
+
+b8 freelist_allocate_block(freelist* list, u64 size, u64 alignment, u64* out_offset) {
+    u64 length = darray_length(list->nodes);
+    for (u64 idx = 0; idx != length; ++idx) {
+        freelist_node* node = &list->nodes[idx];
+        u64 aligned = (node->offset + alignment - 1) / alignment * alignment;
+        u64 padding = aligned - node->offset;
+        if (padding > node->size || node->size - padding < size)
+            continue;
+
+        u64 end = node->offset + node->size;
+        u64 tail = end - (aligned + size);
+        if (padding != 0) {
+            // The space skipped for alignment stays free in front of the range
+            node->size = padding;
+            if (tail != 0)
+                insert_node(list, idx + 1, aligned + size, tail);
+        } else if (tail != 0) {
+            node->offset = aligned + size;
+            node->size = tail;
+        } else {
+            remove_node(list, idx);
+        }
+
+        *out_offset = aligned;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+b8 freelist_free_block(freelist* list, u64 size, u64 offset) {
+    if (size == 0 || offset + size > list->total_size) {
+        VERROR("freelist_free_block - range %llu+%llu is outside of the list of size %llu", offset, size, list->total_size);
+        return FALSE;
+    }
+
+    // First free range after the returned one
+    u64 length = darray_length(list->nodes);
+    u64 index = 0;
+    while (index != length && list->nodes[index].offset < offset)
+        ++index;
+
+    b8 overlaps_previous = index > 0 && list->nodes[index - 1].offset + list->nodes[index - 1].size > offset;
+    b8 overlaps_next = index != length && offset + size > list->nodes[index].offset;
+    if (overlaps_previous || overlaps_next) {
+        VERROR("freelist_free_block - range %llu+%llu is already free", offset, size);
+        return FALSE;
+    }
+
+    b8 merge_previous = index > 0 && list->nodes[index - 1].offset + list->nodes[index - 1].size == offset;
+    b8 merge_next = index != length && offset + size == list->nodes[index].offset;
+    if (merge_previous && merge_next) {
+        list->nodes[index - 1].size += size + list->nodes[index].size;
+        remove_node(list, index);
+    } else if (merge_previous) {
+        list->nodes[index - 1].size += size;
+    } else if (merge_next) {
+        list->nodes[index].offset = offset;
+        list->nodes[index].size += size;
+    } else {
+        insert_node(list, index, offset, size);
+    }
+
+    return TRUE;
+}
+
+void freelist_resize(freelist* list, u64 new_size) {
+    if (new_size <= list->total_size)
+        return;
+
+    u64 added = new_size - list->total_size;
+    u64 length = darray_length(list->nodes);
+    if (length != 0 && list->nodes[length - 1].offset + list->nodes[length - 1].size == list->total_size) {
+        list->nodes[length - 1].size += added;
+    } else {
+        freelist_node tail = { list->total_size, added };
+        darray_push(list->nodes, tail);
+    }
+
+    list->total_size = new_size;
+}
+
+void freelist_clear(freelist* list) {
+    darray_clear(list->nodes);
+    if (list->total_size) {
+        freelist_node whole = { 0, list->total_size };
+        darray_push(list->nodes, whole);
+    }
+}
+
+u64 freelist_free_space(freelist* list) {
+    u64 free_space = 0;
+    u64 length = darray_length(list->nodes);
+    for (u64 idx = 0; idx != length; ++idx)
+        free_space += list->nodes[idx].size;
+    return free_space;
+}
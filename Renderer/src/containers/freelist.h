@@ -0,0 +1,65 @@
+#pragma once
+#include "defines.h"
+
+// A free range of a freelist
+typedef struct freelist_node {
+    u64 offset;
+    u64 size;
+} freelist_node;
+
+/*
+* Tracks the free ranges of a linear address space, e.g. a GPU buffer that
+* many resources are placed in. Ranges are taken first fit and merged with
+* their neighbours when returned. The list only holds bookkeeping, the
+* memory it describes lives elsewhere.
+*/
+typedef struct freelist {
+    u64 total_size;
+    // Free ranges sorted by offset, never adjacent to each other (darray)
+    freelist_node* nodes;
+} freelist;
+
+/*
+* Creates a freelist with the whole range free.
+*
+* @param total_size - Size of the managed range
+* @param out_list - The created freelist
+*/
+VAPI void freelist_create(u64 total_size, freelist* out_list);
+
+VAPI void freelist_destroy(freelist* list);
+
+/*
+* Takes a range.
+*
+* @param list - The freelist
+* @param size - Size of the range
+* @param alignment - The offset is a multiple of it, any value but 0
+* @param out_offset - Offset of the range
+* @return b8 - TRUE if successful, FALSE if no free range is large enough
+*/
+VAPI b8 freelist_allocate_block(freelist* list, u64 size, u64 alignment, u64* out_offset);
+
+/*
+* Returns a range taken with freelist_allocate_block.
+*
+* @param list - The freelist
+* @param size - Size of the range
+* @param offset - Offset of the range
+* @return b8 - TRUE if successful, FALSE if the range overlaps free space
+*/
+VAPI b8 freelist_free_block(freelist* list, u64 size, u64 offset);
+
+/*
+* Grows the managed range, the new space at the end is free.
+*
+* @param list - The freelist
+* @param new_size - The new size, must not be smaller than the current one
+*/
+VAPI void freelist_resize(freelist* list, u64 new_size);
+
+// Makes the whole range free again
+VAPI void freelist_clear(freelist* list);
+
+// @return u64 - Sum of the free ranges
+VAPI u64 freelist_free_space(freelist* list);
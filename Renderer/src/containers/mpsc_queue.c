@@ -0,0 +1,50 @@
+#include "mpsc_queue.h"
+#include "core/vmemory.h"
+#include "core/vatomic.h"
+
+void mpsc_queue_create(mpsc_queue* out_queue) {
+    vzero_memory(out_queue, sizeof(mpsc_queue));
+    out_queue->head = &out_queue->stub;
+    out_queue->tail = &out_queue->stub;
+}
+
+void mpsc_queue_push(mpsc_queue* queue, mpsc_node* node) {
+    vatomic_store_ptr((void* volatile*)&node->next, 0, VMEMORY_ORDER_RELAXED);
+    mpsc_node* previous = vatomic_exchange_ptr((void* volatile*)&queue->head, node, VMEMORY_ORDER_ACQ_REL);
+    // Until this store the element is pushed but not reachable from the tail
+    vatomic_store_ptr((void* volatile*)&previous->next, node, VMEMORY_ORDER_RELEASE);
+}
+
+mpsc_node* mpsc_queue_pop(mpsc_queue* queue) {
+    mpsc_node* tail = queue->tail;
+    mpsc_node* next = vatomic_load_ptr((void* volatile*)&tail->next, VMEMORY_ORDER_ACQUIRE);
+
+    // Skip the stub, it only keeps the queue from ever being truly empty
+    if (tail == &queue->stub) {
+        if (!next)
+            return 0;
+        queue->tail = next;
+        tail = next;
+        next = vatomic_load_ptr((void* volatile*)&tail->next, VMEMORY_ORDER_ACQUIRE);
+    }
+
+    if (next) {
+        queue->tail = next;
+        return tail;
+    }
+
+    // A producer is between its exchange and its link
+    mpsc_node* head = vatomic_load_ptr((void* volatile*)&queue->head, VMEMORY_ORDER_ACQUIRE);
+    if (tail != head)
+        return 0;
+
+    // Tail is the last element. Push the stub behind it so it can be taken without losing the link
+    mpsc_queue_push(queue, &queue->stub);
+    next = vatomic_load_ptr((void* volatile*)&tail->next, VMEMORY_ORDER_ACQUIRE);
+    if (next) {
+        queue->tail = next;
+        return tail;
+    }
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "defines.h"
+
+/*
+* Link embedded in the elements of an mpsc_queue. An element can be in one queue at a time.
+*/
+typedef struct mpsc_node {
+    struct mpsc_node* volatile next;
+} mpsc_node;
+
+/*
+* Intrusive lock-free queue with many producers and a single consumer (Vyukov).
+* Pushing never waits and never allocates. Producers are serialized by a single
+* atomic exchange, so a pop can briefly miss an element whose push is in progress.
+*/
+typedef struct mpsc_queue {
+    mpsc_node* volatile head;
+    u8 head_padding[56];
+    // Consumer side
+    mpsc_node* tail;
+    mpsc_node stub;
+} mpsc_queue;
+
+/*
+* @param out_queue - The queue to initialize empty
+*/
+VAPI void mpsc_queue_create(mpsc_queue* out_queue);
+
+/*
+* Appends an element. Any thread.
+*
+* @param queue - The queue
+* @param node - The link of the element
+*/
+VAPI void mpsc_queue_push(mpsc_queue* queue, mpsc_node* node);
+
+/*
+* Removes the oldest element. Consumer thread only.
+*
+* @param queue - The queue
+* @return mpsc_node* - The link of the element, 0 if the queue is empty
+*/
+VAPI mpsc_node* mpsc_queue_pop(mpsc_queue* queue);
@@ -0,0 +1,85 @@
+#include "work_deque.h"
+#include "core/vmemory.h"
+#include "core/vatomic.h"
+
+// Indices only ever grow and are compared as signed so bottom can drop below top during a pop
+#define AS_SIGNED(value) ((i64)(value))
+
+void work_deque_create(u64 element_size, u64 capacity, work_deque* out_deque) {
+    u64 rounded = 1;
+    while (rounded < capacity)
+        rounded <<= 1;
+
+    vzero_memory(out_deque, sizeof(work_deque));
+    out_deque->element_size = element_size;
+    out_deque->capacity = rounded;
+    out_deque->mask = rounded - 1;
+    out_deque->buffer = vallocate(element_size * rounded, MEMORY_TAG_JOB);
+}
+
+void work_deque_destroy(work_deque* deque) {
+    if (deque->buffer) {
+        vfree(deque->buffer, deque->element_size * deque->capacity, MEMORY_TAG_JOB);
+    }
+    vzero_memory(deque, sizeof(work_deque));
+}
+
+static void* work_deque_slot(work_deque* deque, u64 index) {
+    return deque->buffer + (index & deque->mask) * deque->element_size;
+}
+
+b8 work_deque_push(work_deque* deque, const void* element) {
+    u64 bottom = vatomic_load_u64(&deque->bottom, VMEMORY_ORDER_RELAXED);
+    u64 top = vatomic_load_u64(&deque->top, VMEMORY_ORDER_ACQUIRE);
+    if (AS_SIGNED(bottom - top) >= AS_SIGNED(deque->capacity))
+        return FALSE;
+
+    vcopy_memory(work_deque_slot(deque, bottom), (void*)element, deque->element_size);
+    // Release publishes the element together with the new bottom
+    vatomic_store_u64(&deque->bottom, bottom + 1, VMEMORY_ORDER_RELEASE);
+    return TRUE;
+}
+
+b8 work_deque_pop(work_deque* deque, void* out_element) {
+    u64 bottom = vatomic_load_u64(&deque->bottom, VMEMORY_ORDER_RELAXED) - 1;
+    vatomic_store_u64(&deque->bottom, bottom, VMEMORY_ORDER_RELAXED);
+    // Thieves must see the reserved slot before we read top
+    vatomic_thread_fence(VMEMORY_ORDER_SEQ_CST);
+    u64 top = vatomic_load_u64(&deque->top, VMEMORY_ORDER_RELAXED);
+
+    if (AS_SIGNED(top) > AS_SIGNED(bottom)) {
+        // Empty
+        vatomic_store_u64(&deque->bottom, bottom + 1, VMEMORY_ORDER_RELAXED);
+        return FALSE;
+    }
+
+    b8 taken = TRUE;
+    vcopy_memory(out_element, work_deque_slot(deque, bottom), deque->element_size);
+    if (top == bottom) {
+        // Last element, race the thieves for it
+        taken = vatomic_compare_exchange_u64(&deque->top, &top, top + 1, VMEMORY_ORDER_SEQ_CST);
+        vatomic_store_u64(&deque->bottom, bottom + 1, VMEMORY_ORDER_RELAXED);
+    }
+
+    return taken;
+}
+
+b8 work_deque_steal(work_deque* deque, void* out_element) {
+    u64 top = vatomic_load_u64(&deque->top, VMEMORY_ORDER_ACQUIRE);
+    vatomic_thread_fence(VMEMORY_ORDER_SEQ_CST);
+    u64 bottom = vatomic_load_u64(&deque->bottom, VMEMORY_ORDER_ACQUIRE);
+
+    if (AS_SIGNED(top) >= AS_SIGNED(bottom))
+        return FALSE;
+
+    // Copy before claiming. The owner only overwrites the slot once top moved past it,
+    // in which case the claim below fails and the copy is thrown away
+    vcopy_memory(out_element, work_deque_slot(deque, top), deque->element_size);
+    return vatomic_compare_exchange_u64(&deque->top, &top, top + 1, VMEMORY_ORDER_SEQ_CST);
+}
+
+u64 work_deque_length(work_deque* deque) {
+    u64 bottom = vatomic_load_u64(&deque->bottom, VMEMORY_ORDER_RELAXED);
+    u64 top = vatomic_load_u64(&deque->top, VMEMORY_ORDER_RELAXED);
+    return AS_SIGNED(bottom - top) > 0 ? bottom - top : 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "defines.h"
+
+/*
+* Chase-Lev work stealing deque with a fixed capacity. Elements are stored by
+* value, so a slot is reused as soon as its element is taken.
+* The owning thread pushes and pops at the bottom (LIFO), any other thread
+* steals from the top (FIFO). Top and bottom live on separate cache lines
+* so thieves do not contend with the owner.
+*/
+typedef struct work_deque {
+    volatile u64 top;
+    u8 top_padding[56];
+    volatile u64 bottom;
+    u8 bottom_padding[56];
+    u8* buffer;
+    u64 element_size;
+    u64 capacity;
+    u64 mask;
+} work_deque;
+
+/*
+* Creates a deque.
+*
+* @param element_size - Size of an element in bytes
+* @param capacity - Maximum amount of elements, rounded up to a power of two
+* @param out_deque - The created deque
+*/
+VAPI void work_deque_create(u64 element_size, u64 capacity, work_deque* out_deque);
+
+VAPI void work_deque_destroy(work_deque* deque);
+
+/*
+* Pushes an element to the bottom. Owner thread only.
+*
+* @param deque - The deque
+* @param element - The element to copy in
+* @return b8 - TRUE if pushed, FALSE if the deque is full
+*/
+VAPI b8 work_deque_push(work_deque* deque, const void* element);
+
+/*
+* Pops the most recently pushed element. Owner thread only.
+*
+* @param deque - The deque
+* @param out_element - Receives a copy of the element
+* @return b8 - TRUE if an element was taken, FALSE if empty or lost to a thief
+*/
+VAPI b8 work_deque_pop(work_deque* deque, void* out_element);
+
+/*
+* Steals the oldest element. Any thread.
+*
+* @param deque - The deque
+* @param out_element - Receives a copy of the element
+* @return b8 - TRUE if an element was taken, FALSE if empty or lost to another thread
+*/
+VAPI b8 work_deque_steal(work_deque* deque, void* out_element);
+
+/*
+* @return u64 - Approximate amount of elements, exact only for the owner thread
+*/
+VAPI u64 work_deque_length(work_deque* deque);
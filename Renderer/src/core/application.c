@@ -5,11 +5,17 @@
 #include "vmemory.h"
 #include "event.h"
 #include "input.h"
+#include "frame_stats.h"
+#include "frame_pacer.h"
+#include "job_system.h"
+#include "task_graph.h"
+#include "async_io.h"
 
 // Resources
 #include "game_types.h"
 #include "clock.h"
 #include "vstring.h"
+#include "containers/darray.h"
 
 #include "platform/platform.h"
 
@@ -26,8 +32,42 @@ typedef struct application_state {
     i32 height;
     clock clock;
     f64 last_time;
+
+    // Fixed timestep
+    f64 fixed_time_step;
+    f64 fixed_accumulator;
+    u32 max_fixed_updates;
+
+    // Stages of a frame
+    task_graph frame_graph;
+    u32 prepare_frame_stage;
+    u32 fixed_update_stage;
+    u32 update_stage;
+    u32 render_stage;
+    u32 draw_stage;
+
+    // Inputs and outputs of the stages of the frame in flight
+    f64 frame_delta_time;
+    f64 interpolation_alpha;
+    // Double buffered so a pipelined draw reads the packet of the previous frame while the current one is built
+    render_packet packets[2];
+    b8 packet_valid[2];
+    u32 packet_index;
+    b8 pipelined_frames;
 } application_state;
 
+// Fixed updates allowed per frame when the game does not configure it
+#define DEFAULT_MAX_FIXED_UPDATES 5
+
+// What the frame stages read and write, the task graph orders stages by it
+typedef enum application_resource {
+    APPLICATION_RESOURCE_INPUT = 0x1,
+    APPLICATION_RESOURCE_GAME = 0x2,
+    APPLICATION_RESOURCE_RENDER_PACKET = 0x4,
+    APPLICATION_RESOURCE_PREVIOUS_RENDER_PACKET = 0x8,
+    APPLICATION_RESOURCE_GPU = 0x10
+} application_resource;
+
 static b8 initialized = FALSE;
 static application_state app_state;
 
@@ -36,6 +76,8 @@ b8 application_on_event(u16 code, void* sender, void* listener_inst, event_conte
 b8 application_on_key(u16 code, void* sender, void* listener_inst, event_context data);
 b8 application_on_resized(u16 code, void* sender, void* listener_inst, event_context data);
 
+static b8 application_build_frame_graph();
+
 b8 application_create(game* game_inst) {
     if (initialized) {
         VERROR("application_create called more than once.");
@@ -60,12 +102,48 @@ b8 application_create(game* game_inst) {
             VFATAL("Event system failed initialization. Application cannot continue");
             return FALSE;
         }
+
+        if (!frame_stats_initialize(game_inst->app_config.frame_stats_log_interval)) {
+            VFATAL("Frame stats system failed initialization. Application cannot continue");
+            return FALSE;
+        }
+
+        if (!frame_pacer_initialize(game_inst->app_config.target_frame_rate)) {
+            VFATAL("Frame pacer failed initialization. Application cannot continue");
+            return FALSE;
+        }
+
+        job_system_config job_config = { 0 };
+        job_config.worker_count = game_inst->app_config.job_worker_count;
+        job_config.use_fibers = game_inst->app_config.job_use_fibers;
+        job_config.pin_workers = game_inst->app_config.job_pin_workers;
+        job_config.reserve_main_core = game_inst->app_config.job_reserve_main_core;
+        job_config.avoid_smt_siblings = game_inst->app_config.job_avoid_smt_siblings;
+        if (!job_system_initialize(&job_config)) {
+            VFATAL("Job system failed initialization. Application cannot continue");
+            return FALSE;
+        }
+
+        async_io_config io_config = { 0 };
+        if (!async_io_initialize(&io_config)) {
+            VFATAL("Async I/O failed initialization. Application cannot continue");
+            return FALSE;
+        }
     }
 
     // Set app state
     {
         app_state.is_running = TRUE;
         app_state.is_suspended = FALSE;
+
+        const application_config* config = &game_inst->app_config;
+        app_state.fixed_time_step = config->fixed_update_rate > 0.0 ? 1.0 / config->fixed_update_rate : 0.0;
+        app_state.fixed_accumulator = 0.0;
+        app_state.max_fixed_updates = config->max_fixed_updates_per_frame != 0 ? config->max_fixed_updates_per_frame : DEFAULT_MAX_FIXED_UPDATES;
+        if (app_state.fixed_time_step > 0.0 && !game_inst->fixed_update) {
+            VWARN("fixed_update_rate is set but the game has no fixed_update. Ignoring it");
+            app_state.fixed_time_step = 0.0;
+        }
     }
 
     // Register for events
@@ -84,7 +162,8 @@ b8 application_create(game* game_inst) {
         game_inst->app_config.start_x,
         game_inst->app_config.start_y,
         game_inst->app_config.start_width,
-        game_inst->app_config.start_height))
+        game_inst->app_config.start_height,
+        game_inst->app_config.headless))
     {
         VFATAL("Could not initialize the platform")
         return FALSE;
@@ -107,6 +186,15 @@ b8 application_create(game* game_inst) {
         }
     }
 
+    // The game adds what a frame draws to these while it renders
+    for (u32 idx = 0; idx != 2; ++idx)
+        app_state.packets[idx].geometries = darray_create(geometry_render_data);
+
+    if (!application_build_frame_graph()) {
+        VFATAL("Could not build the frame task graph!");
+        return FALSE;
+    }
+
     // Hook up on resize callback for the game
     // TODO: implement window resizing
     app_state.game_inst->on_resize(app_state.game_inst, app_state.width, app_state.height);
@@ -119,13 +207,15 @@ b8 application_run() {
     clock_start(&app_state.clock);
     clock_update(&app_state.clock);
     app_state.last_time = app_state.clock.elapsed_time;
-    f64 running_time = 0;
-    u8 frame_count = 0;
-    f64 target_frame_time = 1.f / 60.f;
 
     char* memory_usage = get_memory_usage_str();
     VINFO(memory_usage); // HACK: leaks memory
 
+    char gpu_memory_usage[2048];
+    if (renderer_get_memory_usage_str(gpu_memory_usage, sizeof(gpu_memory_usage)) > 0) {
+        VINFO(gpu_memory_usage);
+    }
+
     while (app_state.is_running)
     {
         if (!platform_pump_message(&app_state.platform))
@@ -137,52 +227,45 @@ b8 application_run() {
             clock_update(&app_state.clock);
             f64 current_time = app_state.clock.elapsed_time;
             f64 delta_time = (current_time - app_state.last_time);
-            f64 frame_start_time = platform_get_absolute_time();
 
-            // Update game
-            if (!app_state.game_inst->update(app_state.game_inst, delta_time))
-            {
-                VFATAL("Could not update the game!");
-                app_state.is_running = FALSE;
-                break;
-            }
+            // The update stage runs on a job thread while the draw stage begins the next frame
+            renderer_capture_frame_counters();
 
-            // Render the game
-            if (!app_state.game_inst->render(app_state.game_inst, delta_time))
-            {
-                VFATAL("Could not render the game!");
+            // Finished reads report back on the main thread before the frame uses them
+            async_io_update();
+
+            app_state.frame_delta_time = delta_time;
+            app_state.interpolation_alpha = 1.0;
+            if (!task_graph_execute(&app_state.frame_graph)) {
                 app_state.is_running = FALSE;
                 break;
             }
 
-            // TODO: this should not be like this
-            render_packet packet;
-            packet.delta_time = delta_time;
-            if (!renderer_draw_frame(&packet)) {
-                VERROR("renderer_draw_frame returned false. Could not draw frame: %u", frame_count);
-            }
-
-            // Calculation to find how long the frame needed
+            // Stage timings are read back here, the stats are not thread safe
             {
-                f64 frame_end_time = platform_get_absolute_time();
-                f64 frame_elapsed_time = frame_end_time - frame_start_time;
-                running_time += frame_elapsed_time;
-                f64 remaining_seconds = target_frame_time - frame_elapsed_time;
+                task_graph* graph = &app_state.frame_graph;
+                f64 update_time = task_graph_stage_time(graph, app_state.update_stage);
+                if (app_state.fixed_update_stage != INVALID_ID)
+                    update_time += task_graph_stage_time(graph, app_state.fixed_update_stage);
+                if (app_state.prepare_frame_stage != INVALID_ID)
+                    update_time += task_graph_stage_time(graph, app_state.prepare_frame_stage);
+
+                frame_stats_record(FRAME_STAT_ZONE_UPDATE, update_time);
+                frame_stats_record(FRAME_STAT_ZONE_RENDER, task_graph_stage_time(graph, app_state.render_stage));
+                frame_stats_record(FRAME_STAT_ZONE_PRESENT, task_graph_stage_time(graph, app_state.draw_stage));
+                frame_stats_record(FRAME_STAT_ZONE_CRITICAL_PATH, task_graph_critical_path_time(graph));
+            }
 
-                // Give a bit back to system if we reached target frame time
-                if (remaining_seconds > 0.0000) {
-                    u64 remaining_ms = ((u64)remaining_seconds * 1000);
+            if (app_state.pipelined_frames)
+                app_state.packet_index ^= 1;
 
-                    b8 limit_frames = FALSE;// TODO: configurable
-                    if (remaining_ms > 0 && limit_frames) {
-                        platform_sleep(remaining_ms);
-                    }
+            // Give the rest of the frame back to the system if a frame rate is targeted
+            frame_pacer_wait();
 
-                    ++frame_count;
-                }
-            }
-            
-            input_update(delta_time);
+            // Wall time between this frame and the previous one
+            frame_stats_record(FRAME_STAT_ZONE_FRAME, delta_time);
+            if (frame_stats_end_frame(platform_get_absolute_time()))
+                task_graph_log(&app_state.frame_graph);
 
             // Update last time
             app_state.last_time = current_time;
@@ -190,6 +273,9 @@ b8 application_run() {
     }
 
     app_state.is_running = FALSE;
+
+    if (app_state.game_inst->shutdown)
+        app_state.game_inst->shutdown(app_state.game_inst);
     
     // Deregister from events
     {
@@ -201,6 +287,15 @@ b8 application_run() {
 
     // Shutdown systems
     {
+        task_graph_destroy(&app_state.frame_graph);
+        for (u32 idx = 0; idx != 2; ++idx) {
+            darray_destroy(app_state.packets[idx].geometries);
+            app_state.packets[idx].geometries = 0;
+        }
+        VINFO("Shutting down frame pacer...");
+        frame_pacer_shutdown();
+        VINFO("Shutting down frame stats system...");
+        frame_stats_shutdown();
         VINFO("Shutting down event system...");
         event_shutdown();
         VINFO("Shutting down input system...");
@@ -209,6 +304,10 @@ b8 application_run() {
         shutdown_logging(); // Logging after platform since we might want to log final stuff to platform
         VINFO("Shutting down renderer system...");
         renderer_shutdown();
+        VINFO("Shutting down async I/O...");
+        async_io_shutdown();
+        VINFO("Shutting down job system...");
+        job_system_shutdown();
         VINFO("Shutting down the platform...");
         platform_shutdown(&app_state.platform);
     }
@@ -285,6 +384,150 @@ b8 application_on_resized(u16 code, void* sender, void* listener_inst, event_con
     return FALSE;
 }
 
+// Fixed timestep simulation. Consumes the frame time in constant steps
+static b8 application_fixed_update_stage(void* user_data) {
+    app_state.fixed_accumulator += app_state.frame_delta_time;
+
+    u32 steps = 0;
+    while (app_state.fixed_accumulator >= app_state.fixed_time_step) {
+        // Drop the backlog instead of spiraling further behind on heavy frames
+        if (steps == app_state.max_fixed_updates) {
+            f64 backlog_steps = (f64)(u64)(app_state.fixed_accumulator / app_state.fixed_time_step);
+            app_state.fixed_accumulator -= backlog_steps * app_state.fixed_time_step;
+            break;
+        }
+
+        if (!app_state.game_inst->fixed_update(app_state.game_inst, app_state.fixed_time_step)) {
+            VFATAL("Could not run the fixed update of the game!");
+            return FALSE;
+        }
+
+        app_state.fixed_accumulator -= app_state.fixed_time_step;
+        ++steps;
+    }
+
+    app_state.interpolation_alpha = app_state.fixed_accumulator / app_state.fixed_time_step;
+    return TRUE;
+}
+
+static b8 application_prepare_frame_stage(void* user_data) {
+    if (!app_state.game_inst->prepare_frame(app_state.game_inst, app_state.frame_delta_time)) {
+        VFATAL("Could not prepare the frame of the game!");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static b8 application_update_stage(void* user_data) {
+    if (!app_state.game_inst->update(app_state.game_inst, app_state.frame_delta_time)) {
+        VFATAL("Could not update the game!");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static b8 application_render_stage(void* user_data) {
+    render_packet* packet = &app_state.packets[app_state.packet_index];
+    packet->delta_time = app_state.frame_delta_time;
+    darray_clear(packet->geometries);
+
+    if (!app_state.game_inst->render(app_state.game_inst, app_state.frame_delta_time, app_state.interpolation_alpha, packet)) {
+        VFATAL("Could not render the game!");
+        return FALSE;
+    }
+
+    packet->geometry_count = (u32)darray_length(packet->geometries);
+    app_state.packet_valid[app_state.packet_index] = TRUE;
+    return TRUE;
+}
+
+static b8 application_draw_stage(void* user_data) {
+    // Pipelined frames draw the packet the previous frame built
+    u32 index = app_state.pipelined_frames ? app_state.packet_index ^ 1 : app_state.packet_index;
+    if (!app_state.packet_valid[index])
+        return TRUE;
+
+    if (!renderer_draw_frame(&app_state.packets[index])) {
+        VERROR("renderer_draw_frame returned false. Could not draw frame: %llu", frame_stats_frame_count());
+    }
+    return TRUE;
+}
+
+static b8 application_input_stage(void* user_data) {
+    input_update(app_state.frame_delta_time);
+    return TRUE;
+}
+
+/*
+* Declares the stages of a frame. Drawing, the input state and the game's prepare_frame
+* stay on the main thread, the rest of the game runs on the job system. With pipelined frames the draw reads the previous
+* packet, so it no longer depends on this frame's update and render and overlaps them.
+*/
+static b8 application_build_frame_graph() {
+    task_graph* graph = &app_state.frame_graph;
+    task_graph_create(graph);
+    app_state.pipelined_frames = app_state.game_inst->app_config.pipelined_frames;
+
+    // Conflicts with every later stage, so it runs alone at the start of the frame
+    app_state.prepare_frame_stage = INVALID_ID;
+    if (app_state.game_inst->prepare_frame) {
+        task_stage_desc prepare_frame = {
+            .name = "prepare_frame",
+            .fn = application_prepare_frame_stage,
+            .reads = APPLICATION_RESOURCE_INPUT,
+            .writes = APPLICATION_RESOURCE_GAME | APPLICATION_RESOURCE_GPU,
+            .flags = TASK_STAGE_FLAG_MAIN_THREAD,
+        };
+        app_state.prepare_frame_stage = task_graph_add_stage(graph, &prepare_frame);
+    }
+
+    app_state.fixed_update_stage = INVALID_ID;
+    if (app_state.fixed_time_step > 0.0) {
+        task_stage_desc fixed_update = {
+            .name = "fixed_update",
+            .fn = application_fixed_update_stage,
+            .reads = APPLICATION_RESOURCE_INPUT,
+            .writes = APPLICATION_RESOURCE_GAME,
+        };
+        app_state.fixed_update_stage = task_graph_add_stage(graph, &fixed_update);
+    }
+
+    task_stage_desc update = {
+        .name = "update",
+        .fn = application_update_stage,
+        .reads = APPLICATION_RESOURCE_INPUT,
+        .writes = APPLICATION_RESOURCE_GAME,
+    };
+    app_state.update_stage = task_graph_add_stage(graph, &update);
+
+    task_stage_desc render = {
+        .name = "render",
+        .fn = application_render_stage,
+        .reads = APPLICATION_RESOURCE_GAME,
+        .writes = APPLICATION_RESOURCE_RENDER_PACKET,
+    };
+    app_state.render_stage = task_graph_add_stage(graph, &render);
+
+    task_stage_desc draw = {
+        .name = "draw_frame",
+        .fn = application_draw_stage,
+        .reads = app_state.pipelined_frames ? APPLICATION_RESOURCE_PREVIOUS_RENDER_PACKET : APPLICATION_RESOURCE_RENDER_PACKET,
+        .writes = APPLICATION_RESOURCE_GPU,
+        .flags = TASK_STAGE_FLAG_MAIN_THREAD,
+    };
+    app_state.draw_stage = task_graph_add_stage(graph, &draw);
+
+    task_stage_desc input = {
+        .name = "input_update",
+        .fn = application_input_stage,
+        .writes = APPLICATION_RESOURCE_INPUT,
+        .flags = TASK_STAGE_FLAG_MAIN_THREAD,
+    };
+    task_graph_add_stage(graph, &input);
+
+    return task_graph_compile(graph);
+}
+
 void application_get_framebuffer_size(u32* width, u32* height) {
     *width = app_state.width;
     *height = app_state.height;
@@ -2,6 +2,8 @@
 
 #include "defines.h"
 
+struct game;
+
 typedef struct application_config {
     // Position
     i32 start_x;
@@ -13,6 +15,36 @@ typedef struct application_config {
     
     // Name
     const char* name;
+
+    // Run without a window system (off screen surface). Can also be forced with VKR_HEADLESS=1
+    b8 headless;
+
+    // Seconds between periodic frame statistics log lines. 0 disables them
+    f64 frame_stats_log_interval;
+
+    // Frames per second the main loop is paced to. 0 runs unlimited
+    f64 target_frame_rate;
+
+    // Rate (in Hz) of the game's fixed_update. 0 disables the fixed timestep
+    f64 fixed_update_rate;
+
+    // Upper bound of fixed updates per frame. Time beyond it is dropped. 0 uses the default
+    u32 max_fixed_updates_per_frame;
+
+    // Job worker threads besides the main thread. 0 uses one per remaining core
+    u32 job_worker_count;
+
+    // Run jobs on fibers so waiting jobs park instead of blocking their worker
+    b8 job_use_fibers;
+
+    // Worker placement, see job_system_config
+    b8 job_pin_workers;
+    b8 job_reserve_main_core;
+    b8 job_avoid_smt_siblings;
+
+    // Draw the previous frame while the game updates and renders the current one. Adds a
+    // frame of latency, and the game's update and render then run next to renderer_draw_frame
+    b8 pipelined_frames;
 } application_config;
 
 VAPI b8 application_create(struct game* game_inst);
@@ -0,0 +1,444 @@
+#include "async_io.h"
+#include "logger.h"
+#include "vmemory.h"
+#include "vatomic.h"
+#include "vstring.h"
+
+#include "containers/mpsc_queue.h"
+#include "platform/platform_thread.h"
+#include "platform/platform_file.h"
+#include "platform/platform_io_queue.h"
+
+#include <stdio.h>
+
+#define ASYNC_IO_DEFAULT_QUEUE_DEPTH 64
+#define ASYNC_IO_DEFAULT_FALLBACK_THREADS 4
+// Reads are split into chunks this large, cancellation takes effect between them
+#define ASYNC_IO_CHUNK_SIZE (16ull * 1024 * 1024)
+// Completions taken from the system queue per wait
+#define ASYNC_IO_COMPLETION_BATCH 32
+
+typedef struct async_io_request {
+    // Link in the completion queue
+    mpsc_node completion_link;
+    // Link in the pending list of its priority
+    struct async_io_request* next;
+
+    u64 id;
+    async_io_read read;
+    u64 path_size;
+    platform_file file;
+    u64 bytes_read;
+    async_io_status status;
+    volatile u32 cancel_requested;
+    b8 cancel_issued;
+} async_io_request;
+
+typedef struct async_io_list {
+    async_io_request* first;
+    async_io_request* last;
+} async_io_list;
+
+typedef struct async_io_state {
+    b8 use_queue;
+    platform_io_queue queue;
+    u32 queue_depth;
+
+    // Guards the pending lists, the in flight requests and the id counter
+    platform_mutex lock;
+    // Fallback threads wait on it for pending requests
+    platform_condvar pending_available;
+    async_io_list pending[ASYNC_IO_PRIORITY_COUNT];
+    async_io_request** in_flight;
+    u32 in_flight_capacity;
+    u32 in_flight_count;
+    u64 next_id;
+
+    platform_thread* threads;
+    u32 thread_count;
+    u32 started_threads;
+    volatile u32 shutting_down;
+
+    // Finished requests, produced by the I/O threads and drained by async_io_update
+    mpsc_queue completions;
+} async_io_state;
+
+static b8 initialized = FALSE;
+static async_io_state state;
+
+static u32 async_io_dispatcher_main(void* params);
+static u32 async_io_worker_main(void* params);
+
+static void async_io_free_request(async_io_request* request) {
+    vfree((void*)request->read.path, request->path_size, MEMORY_TAG_IO);
+    vfree(request, sizeof(async_io_request), MEMORY_TAG_IO);
+}
+
+// Takes the oldest request of the highest priority. Lock held
+static async_io_request* async_io_take_pending() {
+    for (u32 priority = 0; priority < ASYNC_IO_PRIORITY_COUNT; ++priority) {
+        async_io_list* list = &state.pending[priority];
+        async_io_request* request = list->first;
+        if (!request)
+            continue;
+
+        list->first = request->next;
+        if (!list->first)
+            list->last = 0;
+        request->next = 0;
+        state.in_flight[state.in_flight_count++] = request;
+        return request;
+    }
+
+    return 0;
+}
+
+static void async_io_finish(async_io_request* request, async_io_status status) {
+    platform_mutex_lock(&state.lock);
+    // async_io_cancel only flags requests while they are in flight, under the lock.
+    // Checking here keeps its promise even when the cancel raced the last chunk
+    if (vatomic_load_u32(&request->cancel_requested, VMEMORY_ORDER_RELAXED))
+        status = ASYNC_IO_STATUS_CANCELLED;
+    for (u32 i = 0; i < state.in_flight_count; ++i) {
+        if (state.in_flight[i] == request) {
+            state.in_flight[i] = state.in_flight[--state.in_flight_count];
+            break;
+        }
+    }
+    platform_mutex_unlock(&state.lock);
+
+    if (request->file.is_valid)
+        platform_file_close(&request->file);
+
+    request->status = status;
+    mpsc_queue_push(&state.completions, &request->completion_link);
+}
+
+b8 async_io_initialize(const async_io_config* config) {
+    if (initialized) {
+        VERROR("Async I/O is already initialized");
+        return FALSE;
+    }
+
+    vzero_memory(&state, sizeof(state));
+    state.queue_depth = config->queue_depth ? config->queue_depth : ASYNC_IO_DEFAULT_QUEUE_DEPTH;
+    state.use_queue = !config->force_fallback && platform_io_queue_create(state.queue_depth, &state.queue);
+
+    if (state.use_queue) {
+        state.thread_count = 1;
+        state.in_flight_capacity = state.queue_depth;
+    }
+    else {
+        state.thread_count = config->fallback_thread_count ? config->fallback_thread_count : ASYNC_IO_DEFAULT_FALLBACK_THREADS;
+        state.in_flight_capacity = state.thread_count;
+    }
+
+    if (!platform_mutex_create(&state.lock) || !platform_condvar_create(&state.pending_available)) {
+        VERROR("Failed to create the async I/O locks");
+        return FALSE;
+    }
+
+    mpsc_queue_create(&state.completions);
+    state.in_flight = vallocate(sizeof(async_io_request*) * state.in_flight_capacity, MEMORY_TAG_IO);
+    state.threads = vallocate(sizeof(platform_thread) * state.thread_count, MEMORY_TAG_IO);
+    initialized = TRUE;
+
+    for (u32 i = 0; i < state.thread_count; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), state.use_queue ? "io_dispatch" : "io_worker_%u", i);
+        pfn_thread_start start = state.use_queue ? async_io_dispatcher_main : async_io_worker_main;
+        if (!platform_thread_create(start, 0, name, &state.threads[i])) {
+            VERROR("Failed to create async I/O thread %u", i);
+            async_io_shutdown();
+            return FALSE;
+        }
+        state.started_threads++;
+    }
+
+    if (state.use_queue) {
+        VINFO("Async I/O initialized on the system I/O queue with a depth of %u", state.queue_depth);
+    }
+    else {
+        VINFO("Async I/O initialized with %u blocking threads", state.thread_count);
+    }
+    return TRUE;
+}
+
+void async_io_shutdown() {
+    if (!initialized)
+        return;
+
+    platform_mutex_lock(&state.lock);
+    vatomic_store_u32(&state.shutting_down, TRUE, VMEMORY_ORDER_SEQ_CST);
+    platform_condvar_broadcast(&state.pending_available);
+    platform_mutex_unlock(&state.lock);
+    if (state.use_queue)
+        platform_io_queue_wake(&state.queue);
+
+    for (u32 i = 0; i < state.started_threads; ++i) {
+        platform_thread_join(&state.threads[i]);
+    }
+
+    // Nothing is in flight anymore, drop what is left
+    for (u32 priority = 0; priority < ASYNC_IO_PRIORITY_COUNT; ++priority) {
+        while (state.pending[priority].first) {
+            async_io_request* request = state.pending[priority].first;
+            state.pending[priority].first = request->next;
+            async_io_free_request(request);
+        }
+    }
+    mpsc_node* node;
+    while ((node = mpsc_queue_pop(&state.completions))) {
+        async_io_free_request((async_io_request*)node);
+    }
+
+    if (state.use_queue)
+        platform_io_queue_destroy(&state.queue);
+    platform_condvar_destroy(&state.pending_available);
+    platform_mutex_destroy(&state.lock);
+    vfree(state.in_flight, sizeof(async_io_request*) * state.in_flight_capacity, MEMORY_TAG_IO);
+    vfree(state.threads, sizeof(platform_thread) * state.thread_count, MEMORY_TAG_IO);
+    initialized = FALSE;
+}
+
+void async_io_submit(const async_io_read* reads, u32 count, u64* out_ids) {
+    if (!initialized) {
+        VERROR("async_io_submit called before async I/O was initialized");
+        return;
+    }
+
+    platform_mutex_lock(&state.lock);
+    for (u32 i = 0; i < count; ++i) {
+        async_io_request* request = vallocate(sizeof(async_io_request), MEMORY_TAG_IO);
+        vzero_memory(request, sizeof(async_io_request));
+        request->id = ++state.next_id;
+        request->read = reads[i];
+        if (request->read.priority >= ASYNC_IO_PRIORITY_COUNT)
+            request->read.priority = ASYNC_IO_PRIORITY_LOW;
+
+        request->path_size = string_length(reads[i].path) + 1;
+        char* path = vallocate(request->path_size, MEMORY_TAG_IO);
+        vcopy_memory(path, (void*)reads[i].path, request->path_size);
+        request->read.path = path;
+
+        async_io_list* list = &state.pending[request->read.priority];
+        if (list->last)
+            list->last->next = request;
+        else
+            list->first = request;
+        list->last = request;
+
+        if (out_ids)
+            out_ids[i] = request->id;
+    }
+    platform_condvar_broadcast(&state.pending_available);
+    platform_mutex_unlock(&state.lock);
+
+    if (state.use_queue)
+        platform_io_queue_wake(&state.queue);
+}
+
+b8 async_io_cancel(u64 id) {
+    if (!initialized)
+        return FALSE;
+
+    platform_mutex_lock(&state.lock);
+    for (u32 priority = 0; priority < ASYNC_IO_PRIORITY_COUNT; ++priority) {
+        async_io_list* list = &state.pending[priority];
+        async_io_request* previous = 0;
+        for (async_io_request* request = list->first; request; previous = request, request = request->next) {
+            if (request->id != id)
+                continue;
+
+            if (previous)
+                previous->next = request->next;
+            else
+                list->first = request->next;
+            if (list->last == request)
+                list->last = previous;
+            platform_mutex_unlock(&state.lock);
+
+            request->status = ASYNC_IO_STATUS_CANCELLED;
+            mpsc_queue_push(&state.completions, &request->completion_link);
+            return TRUE;
+        }
+    }
+
+    b8 found = FALSE;
+    for (u32 i = 0; i < state.in_flight_count; ++i) {
+        if (state.in_flight[i]->id == id) {
+            // The I/O thread passes it on to the system
+            vatomic_store_u32(&state.in_flight[i]->cancel_requested, TRUE, VMEMORY_ORDER_RELAXED);
+            found = TRUE;
+            break;
+        }
+    }
+    platform_mutex_unlock(&state.lock);
+
+    if (found && state.use_queue)
+        platform_io_queue_wake(&state.queue);
+    return found;
+}
+
+u32 async_io_update() {
+    if (!initialized)
+        return 0;
+
+    u32 count = 0;
+    mpsc_node* node;
+    while ((node = mpsc_queue_pop(&state.completions))) {
+        async_io_request* request = (async_io_request*)node;
+        if (request->read.callback) {
+            async_io_result result;
+            result.id = request->id;
+            result.status = request->status;
+            result.buffer = request->read.buffer;
+            result.bytes_read = request->bytes_read;
+            result.user_data = request->read.user_data;
+            request->read.callback(&result);
+        }
+
+        async_io_free_request(request);
+        ++count;
+    }
+
+    return count;
+}
+
+// ---------------------------------------------------------------- System queue backend
+
+static b8 async_io_queue_next_chunk(async_io_request* request) {
+    u64 remaining = request->read.size - request->bytes_read;
+    u64 chunk = remaining < ASYNC_IO_CHUNK_SIZE ? remaining : ASYNC_IO_CHUNK_SIZE;
+    return platform_io_queue_read(&state.queue, &request->file, request->read.offset + request->bytes_read,
+        chunk, (u8*)request->read.buffer + request->bytes_read, (u64)request);
+}
+
+// Starts pending requests while the system queue has room
+static void async_io_dispatch_pending() {
+    while (TRUE) {
+        platform_mutex_lock(&state.lock);
+        async_io_request* request = state.in_flight_count < state.in_flight_capacity ? async_io_take_pending() : 0;
+        platform_mutex_unlock(&state.lock);
+        if (!request)
+            return;
+
+        if (!platform_file_open_read(request->read.path, TRUE, &request->file)) {
+            VWARN("Async I/O could not open '%s'", request->read.path);
+            async_io_finish(request, ASYNC_IO_STATUS_FAILED);
+            continue;
+        }
+
+        if (request->read.size == 0) {
+            async_io_finish(request, ASYNC_IO_STATUS_COMPLETE);
+            continue;
+        }
+
+        if (!async_io_queue_next_chunk(request))
+            async_io_finish(request, ASYNC_IO_STATUS_FAILED);
+    }
+}
+
+static void async_io_on_chunk_done(const platform_io_completion* completion) {
+    async_io_request* request = (async_io_request*)completion->tag;
+    request->bytes_read += completion->bytes;
+
+    // A cancel that arrives later is caught by async_io_finish
+    if (completion->cancelled || vatomic_load_u32(&request->cancel_requested, VMEMORY_ORDER_RELAXED)) {
+        async_io_finish(request, ASYNC_IO_STATUS_CANCELLED);
+        return;
+    }
+    if (!completion->success) {
+        async_io_finish(request, ASYNC_IO_STATUS_FAILED);
+        return;
+    }
+
+    // A short read means the file ended
+    if (completion->bytes == 0 || request->bytes_read >= request->read.size) {
+        async_io_finish(request, ASYNC_IO_STATUS_COMPLETE);
+        return;
+    }
+
+    if (!async_io_queue_next_chunk(request))
+        async_io_finish(request, ASYNC_IO_STATUS_FAILED);
+}
+
+static u32 async_io_dispatcher_main(void* params) {
+    (void)params;
+    platform_io_completion completions[ASYNC_IO_COMPLETION_BATCH];
+
+    while (TRUE) {
+        b8 shutting_down = vatomic_load_u32(&state.shutting_down, VMEMORY_ORDER_ACQUIRE);
+        if (!shutting_down)
+            async_io_dispatch_pending();
+
+        // Pass cancels on, on shutdown everything in flight is cancelled
+        platform_mutex_lock(&state.lock);
+        for (u32 i = 0; i < state.in_flight_count; ++i) {
+            async_io_request* request = state.in_flight[i];
+            if (shutting_down)
+                vatomic_store_u32(&request->cancel_requested, TRUE, VMEMORY_ORDER_RELAXED);
+            // A cancel that found no room in the queue is issued again on the next pass
+            if (!request->cancel_issued && vatomic_load_u32(&request->cancel_requested, VMEMORY_ORDER_RELAXED))
+                request->cancel_issued = platform_io_queue_cancel(&state.queue, (u64)request);
+        }
+        u32 in_flight_count = state.in_flight_count;
+        platform_mutex_unlock(&state.lock);
+
+        if (shutting_down && in_flight_count == 0)
+            break;
+
+        platform_io_queue_submit(&state.queue);
+        u32 count = platform_io_queue_wait(&state.queue, completions, ASYNC_IO_COMPLETION_BATCH);
+        for (u32 i = 0; i < count; ++i) {
+            async_io_on_chunk_done(&completions[i]);
+        }
+    }
+
+    return 0;
+}
+
+// ---------------------------------------------------------------- Blocking fallback
+
+static u32 async_io_worker_main(void* params) {
+    (void)params;
+    while (TRUE) {
+        platform_mutex_lock(&state.lock);
+        async_io_request* request = 0;
+        while (!vatomic_load_u32(&state.shutting_down, VMEMORY_ORDER_RELAXED) && !(request = async_io_take_pending())) {
+            platform_condvar_wait(&state.pending_available, &state.lock, PLATFORM_WAIT_INFINITE);
+        }
+        platform_mutex_unlock(&state.lock);
+        if (!request)
+            return 0;
+
+        if (!platform_file_open_read(request->read.path, FALSE, &request->file)) {
+            VWARN("Async I/O could not open '%s'", request->read.path);
+            async_io_finish(request, ASYNC_IO_STATUS_FAILED);
+            continue;
+        }
+
+        async_io_status status = ASYNC_IO_STATUS_COMPLETE;
+        while (request->bytes_read < request->read.size) {
+            if (vatomic_load_u32(&request->cancel_requested, VMEMORY_ORDER_RELAXED)) {
+                status = ASYNC_IO_STATUS_CANCELLED;
+                break;
+            }
+
+            u64 remaining = request->read.size - request->bytes_read;
+            u64 chunk = remaining < ASYNC_IO_CHUNK_SIZE ? remaining : ASYNC_IO_CHUNK_SIZE;
+            u64 read = 0;
+            b8 success = platform_file_read_at(&request->file, request->read.offset + request->bytes_read,
+                chunk, (u8*)request->read.buffer + request->bytes_read, &read);
+            request->bytes_read += read;
+            if (!success) {
+                status = ASYNC_IO_STATUS_FAILED;
+                break;
+            }
+            if (read < chunk)
+                break;
+        }
+
+        async_io_finish(request, status);
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "defines.h"
+
+typedef enum async_io_priority {
+    ASYNC_IO_PRIORITY_HIGH,
+    ASYNC_IO_PRIORITY_NORMAL,
+    ASYNC_IO_PRIORITY_LOW,
+
+    ASYNC_IO_PRIORITY_COUNT
+} async_io_priority;
+
+typedef enum async_io_status {
+    ASYNC_IO_STATUS_COMPLETE,
+    ASYNC_IO_STATUS_FAILED,
+    ASYNC_IO_STATUS_CANCELLED
+} async_io_status;
+
+typedef struct async_io_result {
+    u64 id;
+    async_io_status status;
+    void* buffer;
+    // Fewer than requested when the file ended first
+    u64 bytes_read;
+    void* user_data;
+} async_io_result;
+
+/*
+* Called from async_io_update on the thread that calls it.
+*
+* @param result - The outcome of the read, only valid during the call
+*/
+typedef void (*pfn_async_io_callback)(const async_io_result* result);
+
+typedef struct async_io_read {
+    // Copied on submit
+    const char* path;
+    u64 offset;
+    u64 size;
+    // Owned by the caller, it must stay valid until the callback ran
+    void* buffer;
+    async_io_priority priority;
+    // May be 0
+    pfn_async_io_callback callback;
+    void* user_data;
+} async_io_read;
+
+typedef struct async_io_config {
+    // Reads the system queue keeps in flight, 0 uses the default
+    u32 queue_depth;
+    // Threads of the blocking fallback, 0 uses the default
+    u32 fallback_thread_count;
+    // Use the blocking fallback even if the system has asynchronous file I/O
+    b8 force_fallback;
+} async_io_config;
+
+/*
+* Initialize the async I/O service. Reads go through the system I/O queue
+* (io_uring, I/O completion ports) fed by one dispatcher thread, or through
+* a pool of threads doing blocking reads when the system has no such queue.
+*
+* @param config - The configuration of the service
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+VAPI b8 async_io_initialize(const async_io_config* config);
+
+/*
+* Shutdown the service. Cancels the reads in flight and waits for them,
+* reads that did not report their completion yet are dropped without callbacks.
+*/
+VAPI void async_io_shutdown();
+
+/*
+* Queues a batch of reads. Higher priorities are started first, reads of the
+* same priority in submission order. Any thread.
+*
+* @param reads - The reads
+* @param count - Amount of reads
+* @param out_ids - Receives the id of every read, may be 0
+*/
+VAPI void async_io_submit(const async_io_read* reads, u32 count, u64* out_ids);
+
+/*
+* Cancels a read. A read that has not started is reported as cancelled right
+* away, one in flight as soon as the system gives it up. Any thread.
+*
+* @param id - The id of the read
+* @return b8 - TRUE if the read was still pending and will be reported as cancelled,
+* FALSE if it already finished or is unknown
+*/
+VAPI b8 async_io_cancel(u64 id);
+
+/*
+* Reports the finished reads through their callbacks. Called once per frame by the application.
+*
+* @return u32 - Amount of reads reported
+*/
+VAPI u32 async_io_update();
@@ -0,0 +1,110 @@
+#include "frame_pacer.h"
+#include "logger.h"
+#include "vmemory.h"
+#include "frame_stats.h"
+
+#include "platform/platform.h"
+
+// Bounds of the time before the deadline that is spent spinning instead of sleeping
+#define MIN_SPIN_THRESHOLD 0.0005
+#define MAX_SPIN_THRESHOLD 0.004
+
+typedef struct frame_pacer_state {
+    f64 target_frame_time;
+    // Absolute time the current frame should end at, 0 when not yet known
+    f64 next_deadline;
+    // Seconds before the deadline at which sleeping stops and spinning begins.
+    // Grows with the worst observed sleep overshoot and slowly decays back
+    f64 spin_threshold;
+} frame_pacer_state;
+
+static b8 initialized = FALSE;
+static frame_pacer_state state;
+
+b8 frame_pacer_initialize(f64 target_frame_rate) {
+    if (initialized) {
+        VERROR("Frame pacer is already initialized");
+        return FALSE;
+    }
+
+    vzero_memory(&state, sizeof(state));
+    state.spin_threshold = MAX_SPIN_THRESHOLD;
+    initialized = TRUE;
+    frame_pacer_set_target(target_frame_rate);
+    return TRUE;
+}
+
+void frame_pacer_shutdown() {
+    initialized = FALSE;
+}
+
+void frame_pacer_set_target(f64 target_frame_rate) {
+    state.target_frame_time = target_frame_rate > 0.0 ? 1.0 / target_frame_rate : 0.0;
+    state.next_deadline = 0.0;
+
+    if (target_frame_rate > 0.0) {
+        VINFO("Frame pacing target: %.2f FPS", target_frame_rate);
+    }
+    else {
+        VINFO("Frame pacing disabled");
+    }
+}
+
+f64 frame_pacer_get_target() {
+    return state.target_frame_time > 0.0 ? 1.0 / state.target_frame_time : 0.0;
+}
+
+void frame_pacer_wait() {
+    if (!initialized || state.target_frame_time <= 0.0)
+        return;
+
+    f64 now = platform_get_absolute_time();
+
+    // First paced frame, nothing to measure against yet
+    if (state.next_deadline == 0.0) {
+        state.next_deadline = now + state.target_frame_time;
+        return;
+    }
+
+    f64 deadline = state.next_deadline;
+
+    // Coarse sleep while the deadline is further away than the spin threshold
+    while (deadline - now > state.spin_threshold) {
+        u64 sleep_ms = (u64)((deadline - now - state.spin_threshold) * 1000.0);
+        if (sleep_ms == 0)
+            break;
+
+        f64 sleep_start = now;
+        platform_sleep(sleep_ms);
+        now = platform_get_absolute_time();
+
+        // Adapt the threshold to how much the platform overshoots
+        f64 overshoot = (now - sleep_start) - (f64)sleep_ms / 1000.0;
+        if (overshoot + MIN_SPIN_THRESHOLD > state.spin_threshold) {
+            state.spin_threshold = overshoot + MIN_SPIN_THRESHOLD;
+            if (state.spin_threshold > MAX_SPIN_THRESHOLD)
+                state.spin_threshold = MAX_SPIN_THRESHOLD;
+        }
+        else {
+            state.spin_threshold *= 0.99;
+            if (state.spin_threshold < MIN_SPIN_THRESHOLD)
+                state.spin_threshold = MIN_SPIN_THRESHOLD;
+        }
+    }
+
+    // The next frame starts now if the sleep or the frame itself overran the
+    // deadline, otherwise the spin below starts it on the deadline. Sampling
+    // after the spin would only see its own wake up latency, which is ~0
+    frame_stats_record(FRAME_STAT_ZONE_PACING_ERROR, now - deadline);
+
+    // Spin for the rest on the high resolution clock
+    while (now < deadline)
+        now = platform_get_absolute_time();
+
+    // Deadlines advance by whole frames so pacing does not drift. If we fell
+    // behind by more than a frame, start over instead of rushing to catch up
+    if (now - deadline > state.target_frame_time)
+        state.next_deadline = now + state.target_frame_time;
+    else
+        state.next_deadline = deadline + state.target_frame_time;
+}
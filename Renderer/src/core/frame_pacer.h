@@ -0,0 +1,37 @@
+#pragma once
+#include "defines.h"
+
+/*
+* Initialize the frame pacer.
+*
+* @param target_frame_rate - Frames per second to pace to, 0 disables pacing
+* @return b8 - TRUE if successful, FALSE if the pacer was already initialized
+*/
+b8 frame_pacer_initialize(f64 target_frame_rate);
+
+/*
+* Shutdown the frame pacer.
+*/
+void frame_pacer_shutdown();
+
+/*
+* Changes the targeted frame rate at runtime.
+*
+* @param target_frame_rate - Frames per second to pace to, 0 disables pacing
+*/
+VAPI void frame_pacer_set_target(f64 target_frame_rate);
+
+/*
+* @return f64 - The targeted frame rate, 0 if pacing is disabled
+*/
+VAPI f64 frame_pacer_get_target();
+
+/*
+* Waits until the deadline of the current frame. Most of the wait is a
+* coarse sleep, the last part is spent spinning on the high resolution
+* clock since platform sleeps overshoot by up to several milliseconds.
+* How late the next frame starts relative to the deadline, because the
+* frame overran it or the sleep overshot it, is recorded as the pacing
+* error of the frame. It is sampled before the spin.
+*/
+void frame_pacer_wait();
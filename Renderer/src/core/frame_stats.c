@@ -0,0 +1,207 @@
+#include "frame_stats.h"
+#include "logger.h"
+#include "vmemory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Rolling window of a single zone. The histogram is kept in sync with the window
+typedef struct frame_stat_window {
+    f64 samples[FRAME_STATS_WINDOW_SIZE];
+    u32 head;
+    u32 count;
+    f64 sum;
+    u32 histogram[FRAME_STATS_HISTOGRAM_BUCKETS];
+} frame_stat_window;
+
+typedef struct frame_stats_state {
+    frame_stat_window zones[FRAME_STAT_ZONE_MAX];
+    u64 frame_count;
+    f64 log_interval;
+    f64 last_log_time;
+
+    // Scratch space used to sort a window when computing percentiles
+    f64 sorted[FRAME_STATS_WINDOW_SIZE];
+} frame_stats_state;
+
+static b8 initialized = FALSE;
+static frame_stats_state state;
+
+static const char* zone_names[FRAME_STAT_ZONE_MAX] = {
+    "FRAME",
+    "UPDATE",
+    "RENDER",
+    "PRESENT",
+    "GPU_FRAME",
+    "GPU_MAIN_PASS",
+    "PACING_ERROR",
+    "CRITICAL_PATH",
+    "DRAW_RECORDING",
+};
+
+static u32 bucket_for(f64 seconds) {
+    u32 bucket = 0;
+    f64 bound = FRAME_STATS_HISTOGRAM_BASE;
+    while (bucket < FRAME_STATS_HISTOGRAM_BUCKETS - 1 && seconds >= bound) {
+        bound *= 2.0;
+        ++bucket;
+    }
+    return bucket;
+}
+
+static int compare_f64(const void* a, const void* b) {
+    f64 lhs = *(const f64*)a;
+    f64 rhs = *(const f64*)b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+// Nearest-rank percentile of a sorted array
+static f64 percentile(const f64* sorted, u32 count, f64 fraction) {
+    u32 rank = (u32)(fraction * count + 0.999999);
+    if (rank == 0)
+        rank = 1;
+    if (rank > count)
+        rank = count;
+    return sorted[rank - 1];
+}
+
+b8 frame_stats_initialize(f64 log_interval) {
+    if (initialized) {
+        VERROR("Frame stats system is already initialized");
+        return FALSE;
+    }
+
+    vzero_memory(&state, sizeof(state));
+    state.log_interval = log_interval;
+    initialized = TRUE;
+    VINFO("Frame stats system initialized!");
+    return TRUE;
+}
+
+void frame_stats_shutdown() {
+    if (initialized && state.frame_count > 0)
+        frame_stats_log();
+
+    initialized = FALSE;
+}
+
+void frame_stats_record(frame_stat_zone zone, f64 seconds) {
+    if (!initialized || zone >= FRAME_STAT_ZONE_MAX)
+        return;
+
+    if (seconds < 0.0)
+        seconds = 0.0;
+
+    frame_stat_window* window = &state.zones[zone];
+
+    // Evict the oldest sample once the window is full
+    if (window->count == FRAME_STATS_WINDOW_SIZE) {
+        f64 evicted = window->samples[window->head];
+        window->sum -= evicted;
+        --window->histogram[bucket_for(evicted)];
+    }
+    else {
+        ++window->count;
+    }
+
+    window->samples[window->head] = seconds;
+    window->head = (window->head + 1) % FRAME_STATS_WINDOW_SIZE;
+    window->sum += seconds;
+    ++window->histogram[bucket_for(seconds)];
+}
+
+void frame_stats_reset() {
+    if (!initialized)
+        return;
+
+    vzero_memory(state.zones, sizeof(state.zones));
+}
+
+b8 frame_stats_end_frame(f64 current_time) {
+    if (!initialized)
+        return FALSE;
+
+    ++state.frame_count;
+
+    if (state.log_interval <= 0.0)
+        return FALSE;
+
+    if (state.last_log_time == 0.0) {
+        state.last_log_time = current_time;
+    }
+    else if (current_time - state.last_log_time >= state.log_interval) {
+        frame_stats_log();
+        state.last_log_time = current_time;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+b8 frame_stats_get(frame_stat_zone zone, frame_stats_summary* out_summary) {
+    vzero_memory(out_summary, sizeof(frame_stats_summary));
+    if (!initialized || zone >= FRAME_STAT_ZONE_MAX)
+        return FALSE;
+
+    frame_stat_window* window = &state.zones[zone];
+    if (window->count == 0)
+        return FALSE;
+
+    // Samples before head are the newest, the order does not matter for sorting
+    vcopy_memory(state.sorted, window->samples, sizeof(f64) * window->count);
+    qsort(state.sorted, window->count, sizeof(f64), compare_f64);
+
+    out_summary->sample_count = window->count;
+    out_summary->average = window->sum / (f64)window->count;
+    out_summary->min = state.sorted[0];
+    out_summary->p50 = percentile(state.sorted, window->count, 0.50);
+    out_summary->p95 = percentile(state.sorted, window->count, 0.95);
+    out_summary->p99 = percentile(state.sorted, window->count, 0.99);
+    out_summary->max = state.sorted[window->count - 1];
+    vcopy_memory(out_summary->histogram, window->histogram, sizeof(window->histogram));
+    return TRUE;
+}
+
+u64 frame_stats_frame_count() {
+    return state.frame_count;
+}
+
+const char* frame_stats_zone_name(frame_stat_zone zone) {
+    if (zone >= FRAME_STAT_ZONE_MAX)
+        return "UNKNOWN";
+    return zone_names[zone];
+}
+
+f64 frame_stats_bucket_upper_bound(u32 bucket) {
+    f64 bound = FRAME_STATS_HISTOGRAM_BASE;
+    for (u32 idx = 0; idx < bucket; ++idx)
+        bound *= 2.0;
+    return bound;
+}
+
+void frame_stats_log() {
+    if (!initialized)
+        return;
+
+    char buffer[1024];
+    i32 offset = snprintf(buffer, sizeof(buffer), "Frame stats (frame %llu):", state.frame_count);
+
+    for (u32 zone = 0; zone != FRAME_STAT_ZONE_MAX; ++zone) {
+        frame_stats_summary summary;
+        if (!frame_stats_get(zone, &summary))
+            continue;
+
+        i32 written = snprintf(buffer + offset, sizeof(buffer) - offset,
+            " %s p50 %.2fms p95 %.2fms p99 %.2fms max %.2fms |",
+            zone_names[zone],
+            summary.p50 * 1000.0,
+            summary.p95 * 1000.0,
+            summary.p99 * 1000.0,
+            summary.max * 1000.0);
+        if (written < 0 || offset + written >= (i32)sizeof(buffer))
+            break;
+        offset += written;
+    }
+
+    VINFO("%s", buffer);
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "defines.h"
+
+// Number of most recent samples kept per zone
+#define FRAME_STATS_WINDOW_SIZE 512
+
+// Number of log2 buckets in each zone histogram
+#define FRAME_STATS_HISTOGRAM_BUCKETS 16
+
+// Upper bound (in seconds) of the first histogram bucket. Each following bucket doubles it
+#define FRAME_STATS_HISTOGRAM_BASE 0.000125
+
+/*
+* The zones of a frame we keep timings for.
+* FRAME is the wall time between two consecutive frames,
+* the CPU zones are the parts of the frame that the application measures
+* and the GPU zones are read back from the renderer a few frames later.
+* PACING_ERROR is how late a paced frame started relative to its target start.
+* CRITICAL_PATH is the longest chain of dependent stages of the frame task graph.
+* DRAW_RECORDING is the wall time spent recording the draws of a frame, including
+* the jobs recording draw batches.
+*/
+typedef enum frame_stat_zone {
+    FRAME_STAT_ZONE_FRAME = 0,
+    FRAME_STAT_ZONE_UPDATE,
+    FRAME_STAT_ZONE_RENDER,
+    FRAME_STAT_ZONE_PRESENT,
+    FRAME_STAT_ZONE_GPU_FRAME,
+    FRAME_STAT_ZONE_GPU_MAIN_PASS,
+    FRAME_STAT_ZONE_PACING_ERROR,
+    FRAME_STAT_ZONE_CRITICAL_PATH,
+    FRAME_STAT_ZONE_DRAW_RECORDING,
+
+    FRAME_STAT_ZONE_MAX
+} frame_stat_zone;
+
+/*
+* Summary of the rolling window of a zone. All times are in seconds.
+* histogram[0] counts samples below FRAME_STATS_HISTOGRAM_BASE,
+* histogram[i] counts samples in [BASE * 2^(i-1), BASE * 2^i) and the
+* last bucket counts everything above.
+*/
+typedef struct frame_stats_summary {
+    u32 sample_count;
+    f64 average;
+    f64 min;
+    f64 p50;
+    f64 p95;
+    f64 p99;
+    f64 max;
+    u32 histogram[FRAME_STATS_HISTOGRAM_BUCKETS];
+} frame_stats_summary;
+
+/*
+* Initialize the frame statistics system. All of the storage is static
+* so recording a sample never allocates.
+*
+* @param log_interval - Seconds between periodic log lines, 0 disables logging
+* @return b8 - TRUE if successful, FALSE if the system was already initialized
+*/
+b8 frame_stats_initialize(f64 log_interval);
+
+/*
+* Shutdown the frame statistics system.
+*/
+void frame_stats_shutdown();
+
+/*
+* Adds a sample to the rolling window of a zone.
+*
+* @param zone - The zone the sample belongs to
+* @param seconds - The measured time in seconds
+*/
+VAPI void frame_stats_record(frame_stat_zone zone, f64 seconds);
+
+/*
+* Drops the samples of every zone, e.g. between the phases of a benchmark.
+* The frame count keeps counting.
+*/
+VAPI void frame_stats_reset();
+
+/*
+* Marks the end of a frame. Advances the frame counter and emits
+* the periodic log line if the log interval has passed.
+*
+* @param current_time - The absolute time of the end of the frame in seconds
+* @return b8 - TRUE if the periodic log line was emitted this frame, FALSE otherwise
+*/
+b8 frame_stats_end_frame(f64 current_time);
+
+/*
+* Computes the summary of the rolling window of a zone.
+*
+* @param zone - The zone to summarize
+* @param out_summary - Filled with the statistics of the zone
+* @return b8 - TRUE if the zone has at least one sample, FALSE otherwise
+*/
+VAPI b8 frame_stats_get(frame_stat_zone zone, frame_stats_summary* out_summary);
+
+/*
+* @return u64 - The amount of frames ended since initialization
+*/
+VAPI u64 frame_stats_frame_count();
+
+/*
+* @param zone - The zone to get the name of
+* @return const char* - Display name of the zone
+*/
+VAPI const char* frame_stats_zone_name(frame_stat_zone zone);
+
+/*
+* @param bucket - The index of the histogram bucket
+* @return f64 - The exclusive upper bound of the bucket in seconds
+*/
+VAPI f64 frame_stats_bucket_upper_bound(u32 bucket);
+
+/*
+* Logs the p50/p95/p99/max of every zone that has samples.
+*/
+VAPI void frame_stats_log();
@@ -0,0 +1,612 @@
+#include "job_system.h"
+#include "logger.h"
+#include "vmemory.h"
+#include "vatomic.h"
+
+#include "containers/work_deque.h"
+#include "platform/platform_thread.h"
+#include "platform/platform_fiber.h"
+
+#include <stdio.h>
+
+// Jobs a thread can have queued at once. Beyond that run executes them inline
+#define JOB_DEQUE_CAPACITY 4096
+// Failed searches for work before a worker goes to sleep
+#define JOB_WORKER_SPIN_COUNT 64
+// Failed searches for work before a waiting thread yields its time slice
+#define JOB_WAIT_SPIN_COUNT 256
+// Fiber backend defaults
+#define JOB_DEFAULT_FIBER_COUNT 128
+#define JOB_DEFAULT_FIBER_STACK_SIZE (64 * 1024)
+// Marks a thread that is running on its own stack instead of a pool fiber
+#define JOB_NO_FIBER -1
+
+typedef struct job {
+    pfn_job_entry entry;
+    void* data;
+    job_counter* counter;
+} job;
+
+// What the fiber that was switched to does for the fiber that was switched away from.
+// Done after the switch because only then is the old fiber's context saved and safe to resume elsewhere
+typedef enum job_fiber_action {
+    JOB_FIBER_ACTION_NONE,
+    JOB_FIBER_ACTION_FREE,
+    JOB_FIBER_ACTION_WAIT
+} job_fiber_action;
+
+typedef struct job_thread {
+    // Queued jobs, stored by value
+    work_deque deque;
+    // State of the xorshift used to pick steal victims
+    u32 random_state;
+    platform_thread thread;
+    // Logical processors the thread may run on, 0 leaves it to the scheduler
+    u64 affinity_mask;
+
+    // Fiber backend
+    platform_fiber thread_fiber;
+    i32 current_fiber;
+    job_fiber_action pending_action;
+    i32 pending_fiber;
+    job_counter* pending_counter;
+} job_thread;
+
+typedef struct job_waiting_fiber {
+    i32 fiber;
+    job_counter* counter;
+} job_waiting_fiber;
+
+typedef struct job_system_state {
+    u32 thread_count;
+    // Threads besides the main thread that are running
+    u32 started_workers;
+    job_thread* threads;
+    // Sleeping workers wait on it, run signals it when there are sleepers
+    platform_semaphore wake;
+    volatile u32 sleeping_workers;
+    volatile u32 shutting_down;
+
+    // Fiber backend. Free and waiting fibers are both guarded by fiber_lock
+    b8 use_fibers;
+    u32 fiber_count;
+    platform_fiber* fibers;
+    platform_mutex fiber_lock;
+    i32* free_fibers;
+    u32 free_fiber_count;
+    job_waiting_fiber* waiting_fibers;
+    volatile u32 waiting_fiber_count;
+} job_system_state;
+
+static b8 initialized = FALSE;
+static job_system_state state;
+static VTHREAD_LOCAL i32 thread_index = -1;
+
+static u32 job_worker_main(void* params);
+static void job_fiber_main(void* params);
+static b8 job_fibers_create(const job_system_config* config);
+static void job_fibers_destroy();
+static u32 job_place_threads(const job_system_config* config);
+
+// Fibers can resume on another thread. Reading the thread local through a
+// call that is never inlined keeps the compiler from caching its address across a switch
+static VNOINLINE i32 job_current_thread_index() {
+    return thread_index;
+}
+
+b8 job_system_initialize(const job_system_config* config) {
+    if (initialized) {
+        VERROR("Job system is already initialized");
+        return FALSE;
+    }
+
+    vzero_memory(&state, sizeof(state));
+
+    u32 worker_count = job_place_threads(config);
+    if (state.threads[0].affinity_mask && !platform_thread_set_affinity(0, state.threads[0].affinity_mask))
+        VWARN("Could not pin the main thread to its reserved core");
+
+    if (!platform_semaphore_create(0, 0x7FFFFFFF, &state.wake)) {
+        VERROR("Failed to create the job system wake semaphore");
+        return FALSE;
+    }
+
+    if (config->use_fibers && !job_fibers_create(config)) {
+        VERROR("Failed to create the job fiber pool");
+        return FALSE;
+    }
+
+    thread_index = 0;
+    initialized = TRUE;
+
+    for (u32 i = 1; i < state.thread_count; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "job_worker_%u", i);
+        if (!platform_thread_create(job_worker_main, (void*)(u64)i, name, &state.threads[i].thread)) {
+            VERROR("Failed to create job worker %u", i);
+            job_system_shutdown();
+            return FALSE;
+        }
+        state.started_workers++;
+    }
+
+    if (state.use_fibers) {
+        VINFO("Job system initialized with %u worker threads and %u fibers of %lluKiB",
+            worker_count, state.fiber_count, (config->fiber_stack_size ? config->fiber_stack_size : JOB_DEFAULT_FIBER_STACK_SIZE) / 1024);
+    }
+    else {
+        VINFO("Job system initialized with %u worker threads", worker_count);
+    }
+    return TRUE;
+}
+
+void job_system_shutdown() {
+    if (!initialized)
+        return;
+
+    vatomic_store_u32(&state.shutting_down, TRUE, VMEMORY_ORDER_SEQ_CST);
+    platform_semaphore_signal(&state.wake, state.thread_count);
+
+    for (u32 i = 1; i <= state.started_workers; ++i) {
+        platform_thread_join(&state.threads[i].thread);
+    }
+
+    if (state.use_fibers) {
+        if (state.waiting_fiber_count > 0)
+            VWARN("Job system shut down with %u jobs still waiting", state.waiting_fiber_count);
+        job_fibers_destroy();
+    }
+
+    for (u32 i = 0; i < state.thread_count; ++i) {
+        work_deque_destroy(&state.threads[i].deque);
+    }
+    vfree(state.threads, sizeof(job_thread) * state.thread_count, MEMORY_TAG_JOB);
+    platform_semaphore_destroy(&state.wake);
+
+    thread_index = -1;
+    initialized = FALSE;
+}
+
+/*
+* Sizes the worker pool from the processor topology, creates the per thread state and
+* decides where each thread may run. Workers are placed on the first hardware thread of
+* every core before any second one, so a partly used pool does not share cores.
+* Returns the amount of workers.
+*/
+static u32 job_place_threads(const job_system_config* config) {
+    platform_cpu_info cpu;
+    platform_get_cpu_info(&cpu);
+    VINFO("CPU: %u logical processors, %u cores, %u packages, %u NUMA nodes, L1d %lluKiB, L2 %lluKiB, L3 %lluKiB",
+        cpu.logical_processor_count, cpu.physical_core_count, cpu.package_count, cpu.numa_node_count,
+        cpu.l1_data_cache_size / 1024, cpu.l2_cache_size / 1024, cpu.l3_cache_size / 1024);
+
+    // The main thread keeps the core it is running on, alone when SMT siblings are avoided.
+    // The lowest usable processor stands in when the current one is unknown or outside the topology
+    u32 main_processor = platform_thread_current_processor();
+    if (main_processor >= PLATFORM_MAX_LOGICAL_PROCESSORS || !(cpu.logical_processor_mask & (1ull << main_processor))) {
+        main_processor = 0;
+        while (!(cpu.logical_processor_mask & (1ull << main_processor)))
+            ++main_processor;
+    }
+    u32 main_core = cpu.core[main_processor];
+
+    u64 main_mask = 0;
+    u8 candidates[PLATFORM_MAX_LOGICAL_PROCESSORS];
+    u32 candidate_count = 0;
+    u64 candidate_mask = 0;
+    for (u32 smt = 0; smt < PLATFORM_MAX_LOGICAL_PROCESSORS; ++smt) {
+        for (u32 i = 0; i < PLATFORM_MAX_LOGICAL_PROCESSORS; ++i) {
+            if (!(cpu.logical_processor_mask & (1ull << i)) || cpu.smt_index[i] != smt)
+                continue;
+
+            if (cpu.core[i] == main_core && (smt == 0 || !config->avoid_smt_siblings))
+                main_mask |= 1ull << i;
+            if (config->reserve_main_core && cpu.core[i] == main_core)
+                continue;
+            if (config->avoid_smt_siblings && smt != 0)
+                continue;
+
+            candidates[candidate_count++] = (u8)i;
+            candidate_mask |= 1ull << i;
+        }
+    }
+
+    // Without a reserved core the main thread shares its core with the pool, so that core leads the candidates
+    for (u32 i = 0; i < candidate_count; ++i) {
+        if (cpu.core[candidates[i]] != main_core)
+            continue;
+
+        u8 main_candidate = candidates[i];
+        for (u32 j = i; j > 0; --j)
+            candidates[j] = candidates[j - 1];
+        candidates[0] = main_candidate;
+        break;
+    }
+
+    u32 worker_count = config->worker_count;
+    if (worker_count == 0) {
+        // Without a reserved core the main thread takes one of the candidates
+        u32 shared = config->reserve_main_core ? 0 : 1;
+        worker_count = candidate_count > shared ? candidate_count - shared : 0;
+    }
+
+    state.thread_count = worker_count + 1;
+    state.threads = vallocate(sizeof(job_thread) * state.thread_count, MEMORY_TAG_JOB);
+    for (u32 i = 0; i < state.thread_count; ++i) {
+        job_thread* thread = &state.threads[i];
+        work_deque_create(sizeof(job), JOB_DEQUE_CAPACITY, &thread->deque);
+        thread->random_state = 0x9E3779B9u * (i + 1);
+        thread->current_fiber = JOB_NO_FIBER;
+    }
+
+    if (config->reserve_main_core)
+        state.threads[0].affinity_mask = main_mask;
+
+    if (candidate_count == 0)
+        return worker_count;
+
+    // Without a reserved core the main thread sits on the first candidate, so workers start after it
+    u32 offset = config->reserve_main_core ? 0 : 1;
+    for (u32 i = 1; i < state.thread_count; ++i) {
+        if (config->pin_workers)
+            state.threads[i].affinity_mask = 1ull << candidates[(i - 1 + offset) % candidate_count];
+        else if (candidate_mask != cpu.logical_processor_mask)
+            state.threads[i].affinity_mask = candidate_mask;
+    }
+
+    return worker_count;
+}
+
+static void job_wake_sleepers(u32 count) {
+    u32 sleeping = vatomic_load_u32(&state.sleeping_workers, VMEMORY_ORDER_RELAXED);
+    if (sleeping > 0)
+        platform_semaphore_signal(&state.wake, sleeping < count ? sleeping : count);
+}
+
+static void job_execute(const job* j) {
+    job_counter* counter = j->counter;
+
+    j->entry(j->data);
+
+    // Release so the waiter sees everything the job wrote
+    if (counter && vatomic_fetch_sub_u32(&counter->value, 1, VMEMORY_ORDER_ACQ_REL) == 1 && state.use_fibers) {
+        // A parked fiber may be waiting on it while every worker sleeps. Pairs with the
+        // sleeper count increment, which happens before workers look at the wait list
+        vatomic_thread_fence(VMEMORY_ORDER_SEQ_CST);
+        if (vatomic_load_u32(&state.waiting_fiber_count, VMEMORY_ORDER_RELAXED) > 0)
+            job_wake_sleepers(1);
+    }
+}
+
+static u32 job_random(job_thread* thread) {
+    u32 x = thread->random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    thread->random_state = x;
+    return x;
+}
+
+// Own work first (LIFO, cache warm), then steal the oldest work of a random victim
+static b8 job_find(u32 index, job* out_job) {
+    job_thread* self = &state.threads[index];
+    if (work_deque_pop(&self->deque, out_job))
+        return TRUE;
+
+    u32 count = state.thread_count;
+    if (count == 1)
+        return FALSE;
+
+    u32 start = job_random(self) % count;
+    for (u32 i = 0; i < count; ++i) {
+        u32 victim = (start + i) % count;
+        if (victim == index)
+            continue;
+
+        if (work_deque_steal(&state.threads[victim].deque, out_job))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+// ---------------------------------------------------------------- Fibers
+
+static b8 job_fibers_create(const job_system_config* config) {
+    state.fiber_count = config->fiber_count ? config->fiber_count : JOB_DEFAULT_FIBER_COUNT;
+    u64 stack_size = config->fiber_stack_size ? config->fiber_stack_size : JOB_DEFAULT_FIBER_STACK_SIZE;
+
+    // Every worker holds one fiber for its scheduler loop
+    if (state.fiber_count < state.thread_count) {
+        VWARN("fiber_count %u is below the thread count, using %u", state.fiber_count, state.thread_count * 2);
+        state.fiber_count = state.thread_count * 2;
+    }
+
+    if (!platform_mutex_create(&state.fiber_lock))
+        return FALSE;
+
+    state.fibers = vallocate(sizeof(platform_fiber) * state.fiber_count, MEMORY_TAG_JOB);
+    state.free_fibers = vallocate(sizeof(i32) * state.fiber_count, MEMORY_TAG_JOB);
+    state.waiting_fibers = vallocate(sizeof(job_waiting_fiber) * state.fiber_count, MEMORY_TAG_JOB);
+
+    for (u32 i = 0; i < state.fiber_count; ++i) {
+        if (!platform_fiber_create(stack_size, job_fiber_main, 0, &state.fibers[i])) {
+            // Fibers that were not created are still zeroed and skipped
+            job_fibers_destroy();
+            return FALSE;
+        }
+        // Hand out low indices first
+        state.free_fibers[state.fiber_count - 1 - i] = (i32)i;
+    }
+    state.free_fiber_count = state.fiber_count;
+    state.use_fibers = TRUE;
+    return TRUE;
+}
+
+static void job_fibers_destroy() {
+    for (u32 i = 0; i < state.fiber_count; ++i) {
+        platform_fiber_destroy(&state.fibers[i]);
+    }
+
+    if (state.fibers) {
+        vfree(state.fibers, sizeof(platform_fiber) * state.fiber_count, MEMORY_TAG_JOB);
+        vfree(state.free_fibers, sizeof(i32) * state.fiber_count, MEMORY_TAG_JOB);
+        vfree(state.waiting_fibers, sizeof(job_waiting_fiber) * state.fiber_count, MEMORY_TAG_JOB);
+    }
+
+    platform_mutex_destroy(&state.fiber_lock);
+    state.fibers = 0;
+    state.use_fibers = FALSE;
+}
+
+static i32 job_fiber_acquire() {
+    i32 fiber = JOB_NO_FIBER;
+    platform_mutex_lock(&state.fiber_lock);
+    if (state.free_fiber_count > 0)
+        fiber = state.free_fibers[--state.free_fiber_count];
+    platform_mutex_unlock(&state.fiber_lock);
+    return fiber;
+}
+
+// Removes a parked fiber whose counter reached zero from the wait list
+static i32 job_fiber_take_ready() {
+    if (vatomic_load_u32(&state.waiting_fiber_count, VMEMORY_ORDER_ACQUIRE) == 0)
+        return JOB_NO_FIBER;
+
+    i32 fiber = JOB_NO_FIBER;
+    platform_mutex_lock(&state.fiber_lock);
+    for (u32 i = 0; i < state.waiting_fiber_count; ++i) {
+        if (job_counter_is_done(state.waiting_fibers[i].counter)) {
+            fiber = state.waiting_fibers[i].fiber;
+            state.waiting_fibers[i] = state.waiting_fibers[state.waiting_fiber_count - 1];
+            vatomic_store_u32(&state.waiting_fiber_count, state.waiting_fiber_count - 1, VMEMORY_ORDER_RELEASE);
+            break;
+        }
+    }
+    platform_mutex_unlock(&state.fiber_lock);
+    return fiber;
+}
+
+// Runs the action the previous fiber on this thread left behind
+static void job_fiber_after_switch() {
+    job_thread* self = &state.threads[job_current_thread_index()];
+    job_fiber_action action = self->pending_action;
+    self->pending_action = JOB_FIBER_ACTION_NONE;
+
+    if (action == JOB_FIBER_ACTION_NONE)
+        return;
+
+    platform_mutex_lock(&state.fiber_lock);
+    if (action == JOB_FIBER_ACTION_FREE) {
+        state.free_fibers[state.free_fiber_count++] = self->pending_fiber;
+    }
+    else {
+        job_waiting_fiber* waiting = &state.waiting_fibers[state.waiting_fiber_count];
+        waiting->fiber = self->pending_fiber;
+        waiting->counter = self->pending_counter;
+        vatomic_store_u32(&state.waiting_fiber_count, state.waiting_fiber_count + 1, VMEMORY_ORDER_SEQ_CST);
+    }
+    platform_mutex_unlock(&state.fiber_lock);
+}
+
+// Switches this thread from its current fiber to another one, leaving an action for the new fiber
+static void job_fiber_switch(i32 to, job_fiber_action action, job_counter* counter) {
+    job_thread* self = &state.threads[job_current_thread_index()];
+    i32 from = self->current_fiber;
+    platform_fiber* from_fiber = from == JOB_NO_FIBER ? &self->thread_fiber : &state.fibers[from];
+    platform_fiber* to_fiber = to == JOB_NO_FIBER ? &self->thread_fiber : &state.fibers[to];
+
+    self->pending_action = action;
+    self->pending_fiber = from;
+    self->pending_counter = counter;
+    self->current_fiber = to;
+
+    platform_fiber_switch(from_fiber, to_fiber);
+
+    // Back on this fiber, possibly on another thread
+    job_fiber_after_switch();
+}
+
+/*
+* Scheduling loop of a worker. On the fiber backend it runs on a pool fiber and
+* prefers resuming parked jobs whose counters finished over starting new ones.
+*/
+static void job_worker_loop() {
+    u32 idle_spins = 0;
+    while (!vatomic_load_u32(&state.shutting_down, VMEMORY_ORDER_ACQUIRE)) {
+        u32 index = (u32)job_current_thread_index();
+
+        if (state.use_fibers) {
+            i32 ready = job_fiber_take_ready();
+            if (ready != JOB_NO_FIBER) {
+                job_fiber_switch(ready, JOB_FIBER_ACTION_FREE, 0);
+                idle_spins = 0;
+                continue;
+            }
+        }
+
+        job j;
+        if (job_find(index, &j)) {
+            job_execute(&j);
+            idle_spins = 0;
+            continue;
+        }
+
+        if (++idle_spins < JOB_WORKER_SPIN_COUNT) {
+            vatomic_pause();
+            continue;
+        }
+
+        // Announce the sleep before the last look, run checks the sleeper count after pushing
+        vatomic_fetch_add_u32(&state.sleeping_workers, 1, VMEMORY_ORDER_SEQ_CST);
+        i32 ready = state.use_fibers ? job_fiber_take_ready() : JOB_NO_FIBER;
+        b8 found = ready == JOB_NO_FIBER && job_find(index, &j);
+        if (ready != JOB_NO_FIBER || found) {
+            vatomic_fetch_sub_u32(&state.sleeping_workers, 1, VMEMORY_ORDER_SEQ_CST);
+            if (found)
+                job_execute(&j);
+            else
+                job_fiber_switch(ready, JOB_FIBER_ACTION_FREE, 0);
+            idle_spins = 0;
+            continue;
+        }
+
+        platform_semaphore_wait(&state.wake, PLATFORM_WAIT_INFINITE);
+        vatomic_fetch_sub_u32(&state.sleeping_workers, 1, VMEMORY_ORDER_SEQ_CST);
+        idle_spins = 0;
+    }
+}
+
+static void job_fiber_main(void* params) {
+    // Pool fibers all start the same way, they take no parameter
+    (void)params;
+    job_fiber_after_switch();
+    job_worker_loop();
+
+    // Shutting down, return to the stack of the thread that runs this fiber now
+    job_fiber_switch(JOB_NO_FIBER, JOB_FIBER_ACTION_FREE, 0);
+}
+
+static u32 job_worker_main(void* params) {
+    u32 index = (u32)(u64)params;
+    thread_index = (i32)index;
+
+    u64 affinity_mask = state.threads[index].affinity_mask;
+    if (affinity_mask && !platform_thread_set_affinity(0, affinity_mask))
+        VWARN("Could not set the affinity of job worker %u", index);
+
+    if (!state.use_fibers) {
+        job_worker_loop();
+        return 0;
+    }
+
+    job_thread* self = &state.threads[index];
+    if (!platform_fiber_convert_thread(&self->thread_fiber)) {
+        VERROR("Job worker %u could not convert to a fiber. Running without fibers", index);
+        job_worker_loop();
+        return 0;
+    }
+
+    i32 fiber = job_fiber_acquire();
+    if (fiber == JOB_NO_FIBER) {
+        VERROR("Job worker %u found no free fiber for its scheduler", index);
+        platform_fiber_convert_back(&self->thread_fiber);
+        return 0;
+    }
+
+    job_fiber_switch(fiber, JOB_FIBER_ACTION_NONE, 0);
+    platform_fiber_convert_back(&self->thread_fiber);
+    return 0;
+}
+
+// ---------------------------------------------------------------- API
+
+void job_system_run(const job_decl* jobs, u32 count, job_counter* counter) {
+    if (count == 0)
+        return;
+
+    if (counter)
+        vatomic_fetch_add_u32(&counter->value, count, VMEMORY_ORDER_RELAXED);
+
+    i32 index = job_current_thread_index();
+
+    // Without the job system everything runs on the caller
+    if (!initialized || index < 0) {
+        if (initialized)
+            VWARN("job_system_run called from a thread that is not a job thread. Running inline");
+
+        for (u32 i = 0; i < count; ++i) {
+            job inline_job = { jobs[i].entry, jobs[i].data, counter };
+            job_execute(&inline_job);
+        }
+        return;
+    }
+
+    job_thread* self = &state.threads[index];
+    for (u32 i = 0; i < count; ++i) {
+        job j = { jobs[i].entry, jobs[i].data, counter };
+        if (!work_deque_push(&self->deque, &j))
+            job_execute(&j);
+    }
+
+    // Pairs with the sleeper count increment of the workers
+    vatomic_thread_fence(VMEMORY_ORDER_SEQ_CST);
+    job_wake_sleepers(count);
+}
+
+void job_system_wait(job_counter* counter) {
+    if (job_counter_is_done(counter))
+        return;
+
+    // Jobs on pool fibers park instead of running other jobs on top of their stack
+    i32 index = job_current_thread_index();
+    if (initialized && state.use_fibers && index >= 0 && state.threads[index].current_fiber != JOB_NO_FIBER) {
+        i32 scheduler = job_fiber_acquire();
+        if (scheduler != JOB_NO_FIBER) {
+            job_fiber_switch(scheduler, JOB_FIBER_ACTION_WAIT, counter);
+            return;
+        }
+        // Pool exhausted, help like the thread backend does
+    }
+
+    u32 spins = 0;
+    while (!job_counter_is_done(counter)) {
+        index = job_current_thread_index();
+        job j;
+        if (initialized && index >= 0 && job_find((u32)index, &j)) {
+            job_execute(&j);
+            spins = 0;
+            continue;
+        }
+
+        if (++spins < JOB_WAIT_SPIN_COUNT) {
+            vatomic_pause();
+        }
+        else {
+            platform_thread_yield();
+            spins = 0;
+        }
+    }
+}
+
+b8 job_system_try_execute() {
+    i32 index = job_current_thread_index();
+    job j;
+    if (!initialized || index < 0 || !job_find((u32)index, &j))
+        return FALSE;
+
+    job_execute(&j);
+    return TRUE;
+}
+
+b8 job_counter_is_done(job_counter* counter) {
+    return vatomic_load_u32(&counter->value, VMEMORY_ORDER_ACQUIRE) == 0;
+}
+
+u32 job_system_thread_count() {
+    return initialized ? state.thread_count : 1;
+}
+
+i32 job_system_thread_index() {
+    return job_current_thread_index();
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include "defines.h"
+
+/*
+* Entry point of a job.
+*
+* @param data - The user data of the job
+*/
+typedef void (*pfn_job_entry)(void* data);
+
+typedef struct job_decl {
+    pfn_job_entry entry;
+    void* data;
+} job_decl;
+
+/*
+* Counts the unfinished jobs of one or more job_system_run calls.
+* Zero initialize it before use, it reaches zero again once all jobs are done.
+*/
+typedef struct job_counter {
+    volatile u32 value;
+} job_counter;
+
+typedef struct job_system_config {
+    // Worker threads besides the thread that initializes the system. 0 uses one per remaining
+    // logical processor, or per remaining physical core when avoiding SMT siblings
+    u32 worker_count;
+    // Run jobs on a pool of fibers. A job waiting on a counter then parks its fiber
+    // and the worker continues with other jobs instead of running them on top of its stack
+    b8 use_fibers;
+    // Size of the fiber pool, 0 uses the default. Bounds the amount of jobs waiting at once
+    u32 fiber_count;
+    // Stack size of each fiber in bytes, 0 uses the default
+    u64 fiber_stack_size;
+    // Pin each worker to its own logical processor, first threads of the physical cores first
+    b8 pin_workers;
+    // Keep the physical core of the main thread free of workers and pin the main thread to it
+    b8 reserve_main_core;
+    // Only place workers on the first hardware thread of each core, so they do not share a core
+    b8 avoid_smt_siblings;
+} job_system_config;
+
+/*
+* Initialize the job system. The calling thread becomes job thread 0 and
+* takes part in running jobs whenever it waits on a counter.
+*
+* @param config - The configuration of the job system
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+VAPI b8 job_system_initialize(const job_system_config* config);
+
+/*
+* Shutdown the job system. Waits for the workers to exit, queued jobs are dropped.
+*/
+VAPI void job_system_shutdown();
+
+/*
+* Queues jobs on the deque of the calling thread, idle workers steal them from there.
+* Must be called from a job thread (the main thread or inside a job).
+*
+* @param jobs - The jobs to run
+* @param count - Amount of jobs
+* @param counter - Incremented by count and decremented as jobs finish, may be 0
+*/
+VAPI void job_system_run(const job_decl* jobs, u32 count, job_counter* counter);
+
+/*
+* Waits until the counter reaches zero. The calling thread runs queued jobs
+* meanwhile, so waiting inside a job does not block a worker (fork-join).
+* With fibers a job running on a worker parks instead and is resumed, possibly
+* on another thread, once the counter is done. Thread locals read before the
+* wait must not be relied upon after it.
+*
+* @param counter - The counter to wait on
+*/
+VAPI void job_system_wait(job_counter* counter);
+
+/*
+* Runs one queued job on the calling job thread, if there is one. Lets a thread
+* that waits on something other than a counter help instead of idling.
+*
+* @return b8 - TRUE if a job was run, FALSE if none was found or not called from a job thread
+*/
+VAPI b8 job_system_try_execute();
+
+/*
+* @param counter - The counter to check
+* @return b8 - TRUE if all jobs counted by it have finished
+*/
+VAPI b8 job_counter_is_done(job_counter* counter);
+
+/*
+* @return u32 - Amount of threads running jobs, the main thread included. 1 if not initialized
+*/
+VAPI u32 job_system_thread_count();
+
+/*
+* @return i32 - Index of the calling job thread (0 is the main thread), -1 for other threads
+*/
+VAPI i32 job_system_thread_index();
@@ -0,0 +1,214 @@
+#include "parallel.h"
+#include "job_system.h"
+#include "vmemory.h"
+#include "vassert.h"
+#include "vatomic.h"
+
+// Ranges per thread the automatic grain aims for, more than one so stealing can balance uneven work
+#define PARALLEL_RANGES_PER_THREAD 4
+// Smallest automatic grain, below it the job overhead dominates
+#define PARALLEL_MIN_GRAIN 256
+// Element counts below this run serially when the grain is automatic
+#define PARALLEL_SERIAL_THRESHOLD 1024
+
+typedef struct parallel_for_range {
+    struct parallel_for_context* context;
+    u64 begin;
+    u64 end;
+} parallel_for_range;
+
+typedef struct parallel_for_context {
+    pfn_parallel_for fn;
+    void* user_data;
+    u64 grain;
+    // Split off ranges of the whole call, claimed in blocks by the splitting jobs
+    parallel_for_range* ranges;
+    volatile u64 next_range;
+} parallel_for_context;
+
+typedef struct parallel_reduce_range {
+    struct parallel_reduce_context* context;
+    u64 begin;
+    u64 end;
+    u64 partial[PARALLEL_REDUCE_MAX_RESULT_SIZE / sizeof(u64)];
+} parallel_reduce_range;
+
+typedef struct parallel_reduce_context {
+    pfn_parallel_reduce reduce_fn;
+    pfn_parallel_combine combine_fn;
+    void* user_data;
+    const void* identity;
+    u64 result_size;
+    u64 grain;
+    // Split off ranges of the whole call, claimed in blocks by the splitting jobs
+    parallel_reduce_range* ranges;
+    volatile u64 next_range;
+} parallel_reduce_context;
+
+static u64 parallel_grain(u64 count, u64 grain) {
+    if (grain != PARALLEL_AUTO_GRAIN)
+        return grain;
+
+    u64 ranges = (u64)job_system_thread_count() * PARALLEL_RANGES_PER_THREAD;
+    u64 automatic = (count + ranges - 1) / ranges;
+    return automatic < PARALLEL_MIN_GRAIN ? PARALLEL_MIN_GRAIN : automatic;
+}
+
+// Halvings until a range of count elements fits the grain, the local half keeps count / 2
+static u32 parallel_split_count(u64 count, u64 grain) {
+    u32 splits = 0;
+    while (count > grain) {
+        count /= 2;
+        ++splits;
+    }
+    return splits;
+}
+
+// Upper bound of the ranges split off from count elements. Every split adds one range and
+// every final range holds at least half a grain, rounded up
+static u64 parallel_split_capacity(u64 count, u64 grain) {
+    return count / ((grain + 1) / 2);
+}
+
+static b8 parallel_is_serial(u64 count, u64 grain) {
+    if (job_system_thread_count() == 1)
+        return TRUE;
+    if (grain == PARALLEL_AUTO_GRAIN)
+        return count < PARALLEL_SERIAL_THRESHOLD;
+    return count <= grain;
+}
+
+/*
+* Splits off the upper half of the range as a job until the rest fits the grain,
+* processes the rest and waits for the split off halves. The children come from
+* the pool of the call rather than this stack frame: waits help with other jobs
+* on the same stack, so split frames nest and fiber stacks are small.
+*/
+static void parallel_for_split(void* data) {
+    parallel_for_range* range = (parallel_for_range*)data;
+    parallel_for_context* context = range->context;
+    u64 begin = range->begin;
+    u64 end = range->end;
+
+    u32 split_count = parallel_split_count(end - begin, context->grain);
+    parallel_for_range* children = 0;
+    if (split_count)
+        children = &context->ranges[vatomic_fetch_add_u64(&context->next_range, split_count, VMEMORY_ORDER_RELAXED)];
+    u32 child_count = 0;
+    job_counter counter = { 0 };
+
+    while (end - begin > context->grain) {
+        u64 middle = begin + (end - begin) / 2;
+        parallel_for_range* child = &children[child_count++];
+        child->context = context;
+        child->begin = middle;
+        child->end = end;
+
+        job_decl job = { parallel_for_split, child };
+        job_system_run(&job, 1, &counter);
+        end = middle;
+    }
+
+    context->fn(begin, end, context->user_data);
+    job_system_wait(&counter);
+}
+
+void parallel_for(u64 count, u64 grain, pfn_parallel_for fn, void* user_data) {
+    if (count == 0)
+        return;
+
+    if (parallel_is_serial(count, grain)) {
+        fn(0, count, user_data);
+        return;
+    }
+
+    parallel_for_context context;
+    context.fn = fn;
+    context.user_data = user_data;
+    context.grain = parallel_grain(count, grain);
+    u64 capacity = parallel_split_capacity(count, context.grain);
+    context.ranges = vallocate(sizeof(parallel_for_range) * capacity, MEMORY_TAG_JOB);
+    context.next_range = 0;
+
+    parallel_for_range root = { &context, 0, count };
+    parallel_for_split(&root);
+
+    vfree(context.ranges, sizeof(parallel_for_range) * capacity, MEMORY_TAG_JOB);
+}
+
+// Same splitting as parallel_for. Children cover consecutive ranges to the right of the local
+// one, the last split being the closest, so they are folded in from last to first
+static void parallel_reduce_split(void* data) {
+    parallel_reduce_range* range = (parallel_reduce_range*)data;
+    parallel_reduce_context* context = range->context;
+    u64 begin = range->begin;
+    u64 end = range->end;
+
+    u32 split_count = parallel_split_count(end - begin, context->grain);
+    parallel_reduce_range* children = 0;
+    if (split_count)
+        children = &context->ranges[vatomic_fetch_add_u64(&context->next_range, split_count, VMEMORY_ORDER_RELAXED)];
+    u32 child_count = 0;
+    job_counter counter = { 0 };
+
+    while (end - begin > context->grain) {
+        u64 middle = begin + (end - begin) / 2;
+        parallel_reduce_range* child = &children[child_count++];
+        child->context = context;
+        child->begin = middle;
+        child->end = end;
+
+        job_decl job = { parallel_reduce_split, child };
+        job_system_run(&job, 1, &counter);
+        end = middle;
+    }
+
+    vcopy_memory(range->partial, (void*)context->identity, context->result_size);
+    context->reduce_fn(begin, end, range->partial, context->user_data);
+    job_system_wait(&counter);
+
+    for (u32 i = child_count; i > 0; --i) {
+        context->combine_fn(range->partial, children[i - 1].partial, context->user_data);
+    }
+}
+
+void parallel_reduce(
+    u64 count,
+    u64 grain,
+    u64 result_size,
+    const void* identity,
+    void* out_result,
+    pfn_parallel_reduce reduce_fn,
+    pfn_parallel_combine combine_fn,
+    void* user_data) {
+    VASSERT_MSG(result_size <= PARALLEL_REDUCE_MAX_RESULT_SIZE, "parallel_reduce result is larger than PARALLEL_REDUCE_MAX_RESULT_SIZE");
+
+    vcopy_memory(out_result, (void*)identity, result_size);
+    if (count == 0)
+        return;
+
+    if (parallel_is_serial(count, grain)) {
+        reduce_fn(0, count, out_result, user_data);
+        return;
+    }
+
+    parallel_reduce_context context;
+    context.reduce_fn = reduce_fn;
+    context.combine_fn = combine_fn;
+    context.user_data = user_data;
+    context.identity = identity;
+    context.result_size = result_size;
+    context.grain = parallel_grain(count, grain);
+    u64 capacity = parallel_split_capacity(count, context.grain);
+    context.ranges = vallocate(sizeof(parallel_reduce_range) * capacity, MEMORY_TAG_JOB);
+    context.next_range = 0;
+
+    parallel_reduce_range root;
+    root.context = &context;
+    root.begin = 0;
+    root.end = count;
+    parallel_reduce_split(&root);
+
+    vcopy_memory(out_result, root.partial, result_size);
+    vfree(context.ranges, sizeof(parallel_reduce_range) * capacity, MEMORY_TAG_JOB);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "defines.h"
+#include "containers/darray.h"
+
+// Grain size value that lets the helpers pick one from the element and thread count
+#define PARALLEL_AUTO_GRAIN 0
+// Largest result parallel_reduce can produce, partial results are kept inline with the ranges
+#define PARALLEL_REDUCE_MAX_RESULT_SIZE 64
+
+/*
+* Processes the elements [begin, end) of a parallel_for.
+*
+* @param begin - First element of the range
+* @param end - One past the last element of the range
+* @param user_data - The user data given to parallel_for
+*/
+typedef void (*pfn_parallel_for)(u64 begin, u64 end, void* user_data);
+
+/*
+* Accumulates the elements [begin, end) into partial_result, which starts out as the identity.
+*/
+typedef void (*pfn_parallel_reduce)(u64 begin, u64 end, void* partial_result, void* user_data);
+
+/*
+* Folds the partial result of the range to the right of accumulated into accumulated.
+* Ranges are always combined left to right, so the operation needs to be associative but not commutative.
+*/
+typedef void (*pfn_parallel_combine)(void* accumulated, const void* partial_result, void* user_data);
+
+/*
+* Calls fn over [0, count) split into ranges of at most grain elements, run on the job system.
+* The range is split in halves recursively so idle workers steal large chunks first.
+* Returns once all ranges are processed. Small counts run serially on the caller.
+*
+* @param count - Amount of elements
+* @param grain - Most elements per call of fn, PARALLEL_AUTO_GRAIN to pick one
+* @param fn - Function processing a range
+* @param user_data - Passed to fn
+*/
+VAPI void parallel_for(u64 count, u64 grain, pfn_parallel_for fn, void* user_data);
+
+/*
+* Reduces [0, count) in parallel. Every range starts from a copy of identity,
+* the partial results are then combined in element order into out_result.
+*
+* @param count - Amount of elements
+* @param grain - Most elements per call of reduce_fn, PARALLEL_AUTO_GRAIN to pick one
+* @param result_size - Size of the result in bytes, at most PARALLEL_REDUCE_MAX_RESULT_SIZE
+* @param identity - The neutral result
+* @param out_result - Receives the reduced result
+* @param reduce_fn - Accumulates a range into a partial result
+* @param combine_fn - Combines two adjacent partial results
+* @param user_data - Passed to reduce_fn and combine_fn
+*/
+VAPI void parallel_reduce(
+    u64 count,
+    u64 grain,
+    u64 result_size,
+    const void* identity,
+    void* out_result,
+    pfn_parallel_reduce reduce_fn,
+    pfn_parallel_combine combine_fn,
+    void* user_data);
+
+// Runs parallel_for over all elements of a darray
+#define parallel_for_darray(array, grain, fn, user_data) \
+    parallel_for(darray_length(array), grain, fn, user_data)
+
+// Runs parallel_reduce over all elements of a darray
+#define parallel_reduce_darray(array, grain, result_size, identity, out_result, reduce_fn, combine_fn, user_data) \
+    parallel_reduce(darray_length(array), grain, result_size, identity, out_result, reduce_fn, combine_fn, user_data)
@@ -0,0 +1,268 @@
+#include "task_graph.h"
+#include "logger.h"
+#include "vmemory.h"
+#include "vatomic.h"
+#include "vassert.h"
+
+#include "platform/platform.h"
+#include "platform/platform_thread.h"
+
+#include <stdio.h>
+
+// Failed looks for work before the executing thread yields its time slice
+#define TASK_GRAPH_SPIN_COUNT 256
+// Width in characters of the timeline bars
+#define TASK_GRAPH_TIMELINE_WIDTH 40
+
+void task_graph_create(task_graph* out_graph) {
+    vzero_memory(out_graph, sizeof(task_graph));
+}
+
+void task_graph_destroy(task_graph* graph) {
+    vzero_memory(graph, sizeof(task_graph));
+}
+
+u32 task_graph_add_stage(task_graph* graph, const task_stage_desc* desc) {
+    if (graph->compiled) {
+        VERROR("task_graph_add_stage called on a compiled graph");
+        return INVALID_ID;
+    }
+    if (graph->stage_count == TASK_GRAPH_MAX_STAGES) {
+        VERROR("Task graph is full, cannot add stage '%s'", desc->name);
+        return INVALID_ID;
+    }
+
+    u32 index = graph->stage_count++;
+    task_stage* stage = &graph->stages[index];
+    vzero_memory(stage, sizeof(task_stage));
+    stage->desc = *desc;
+    stage->graph = graph;
+    return index;
+}
+
+// Write after read, read after write and write after write all order two stages
+static b8 task_stages_conflict(const task_stage_desc* first, const task_stage_desc* second) {
+    return (first->writes & (second->reads | second->writes)) != 0 || (first->reads & second->writes) != 0;
+}
+
+b8 task_graph_compile(task_graph* graph) {
+    if (graph->stage_count == 0) {
+        VERROR("Cannot compile a task graph without stages");
+        return FALSE;
+    }
+
+    for (u32 i = 0; i < graph->stage_count; ++i) {
+        graph->stages[i].successor_count = 0;
+        graph->stages[i].predecessor_count = 0;
+    }
+
+    // Declaration order decides which of two conflicting stages goes first
+    for (u32 second = 1; second < graph->stage_count; ++second) {
+        task_stage* later = &graph->stages[second];
+        for (u32 first = 0; first < second; ++first) {
+            task_stage* earlier = &graph->stages[first];
+            if (!task_stages_conflict(&earlier->desc, &later->desc))
+                continue;
+
+            earlier->successors[earlier->successor_count++] = (u8)second;
+            later->predecessor_count++;
+        }
+    }
+
+    graph->compiled = TRUE;
+    return TRUE;
+}
+
+static void task_graph_stage_job(void* data);
+
+static void task_graph_run_stage(task_stage* stage) {
+    task_graph* graph = stage->graph;
+    u32 index = (u32)(stage - graph->stages);
+
+    stage->thread_index = job_system_thread_index();
+    stage->start_time = platform_get_absolute_time();
+    // After a failure the rest of the frame is skipped but still released, so the graph drains
+    if (!vatomic_load_u32(&graph->failed, VMEMORY_ORDER_RELAXED)) {
+        if (!stage->desc.fn(stage->desc.user_data)) {
+            VERROR("Task graph stage '%s' failed", stage->desc.name);
+            vatomic_store_u32(&graph->failed, TRUE, VMEMORY_ORDER_RELAXED);
+        }
+        stage->end_time = platform_get_absolute_time();
+    }
+    else {
+        stage->end_time = stage->start_time;
+    }
+
+    for (u32 i = 0; i < stage->successor_count; ++i) {
+        task_stage* successor = &graph->stages[stage->successors[i]];
+        // Acquire release so the successor sees everything its predecessors wrote
+        if (vatomic_fetch_sub_u32(&successor->remaining, 1, VMEMORY_ORDER_ACQ_REL) != 1)
+            continue;
+
+        successor->gated_by = index;
+        if (!(successor->desc.flags & TASK_STAGE_FLAG_MAIN_THREAD)) {
+            job_decl job = { task_graph_stage_job, successor };
+            job_system_run(&job, 1, &graph->jobs);
+        }
+    }
+
+    vatomic_fetch_add_u32(&graph->completed, 1, VMEMORY_ORDER_RELEASE);
+}
+
+static void task_graph_stage_job(void* data) {
+    task_graph_run_stage((task_stage*)data);
+}
+
+// Runs the first ready main thread stage, returns FALSE if there is none
+static b8 task_graph_run_main_stage(task_graph* graph) {
+    for (u32 i = 0; i < graph->stage_count; ++i) {
+        task_stage* stage = &graph->stages[i];
+        if (!(stage->desc.flags & TASK_STAGE_FLAG_MAIN_THREAD) || stage->started)
+            continue;
+        if (vatomic_load_u32(&stage->remaining, VMEMORY_ORDER_ACQUIRE) != 0)
+            continue;
+
+        stage->started = TRUE;
+        task_graph_run_stage(stage);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+// Walks back from the stage that finished last through the stages that released each other
+static void task_graph_find_critical_path(task_graph* graph) {
+    u32 last = 0;
+    for (u32 i = 1; i < graph->stage_count; ++i) {
+        if (graph->stages[i].end_time > graph->stages[last].end_time)
+            last = i;
+    }
+
+    u8 reversed[TASK_GRAPH_MAX_STAGES];
+    u32 length = 0;
+    for (u32 index = last; index != INVALID_ID; index = graph->stages[index].gated_by) {
+        reversed[length++] = (u8)index;
+    }
+
+    for (u32 i = 0; i < length; ++i) {
+        graph->critical_path[i] = reversed[length - 1 - i];
+    }
+    graph->critical_path_length = length;
+}
+
+b8 task_graph_execute(task_graph* graph) {
+    VASSERT_MSG(graph->compiled, "task_graph_execute called on a graph that is not compiled");
+
+    for (u32 i = 0; i < graph->stage_count; ++i) {
+        task_stage* stage = &graph->stages[i];
+        stage->remaining = stage->predecessor_count;
+        stage->started = FALSE;
+        stage->gated_by = INVALID_ID;
+        stage->thread_index = -1;
+        stage->start_time = 0.0;
+        stage->end_time = 0.0;
+    }
+    graph->completed = 0;
+    graph->failed = FALSE;
+    graph->start_time = platform_get_absolute_time();
+
+    for (u32 i = 0; i < graph->stage_count; ++i) {
+        task_stage* stage = &graph->stages[i];
+        if (stage->predecessor_count == 0 && !(stage->desc.flags & TASK_STAGE_FLAG_MAIN_THREAD)) {
+            job_decl job = { task_graph_stage_job, stage };
+            job_system_run(&job, 1, &graph->jobs);
+        }
+    }
+
+    u32 spins = 0;
+    while (vatomic_load_u32(&graph->completed, VMEMORY_ORDER_ACQUIRE) < graph->stage_count) {
+        if (task_graph_run_main_stage(graph) || job_system_try_execute()) {
+            spins = 0;
+            continue;
+        }
+
+        if (++spins < TASK_GRAPH_SPIN_COUNT) {
+            vatomic_pause();
+        }
+        else {
+            platform_thread_yield();
+            spins = 0;
+        }
+    }
+
+    // The last job may still be on its way out after counting itself complete
+    job_system_wait(&graph->jobs);
+    graph->end_time = platform_get_absolute_time();
+
+    task_graph_find_critical_path(graph);
+    return !graph->failed;
+}
+
+f64 task_graph_stage_time(const task_graph* graph, u32 stage) {
+    if (stage >= graph->stage_count)
+        return 0.0;
+    return graph->stages[stage].end_time - graph->stages[stage].start_time;
+}
+
+f64 task_graph_critical_path_time(const task_graph* graph) {
+    if (graph->critical_path_length == 0)
+        return 0.0;
+
+    u32 last = graph->critical_path[graph->critical_path_length - 1];
+    return graph->stages[last].end_time - graph->start_time;
+}
+
+void task_graph_log(const task_graph* graph) {
+    if (graph->critical_path_length == 0)
+        return;
+
+    char buffer[1024];
+    i32 offset = snprintf(buffer, sizeof(buffer), "Task graph critical path %.2fms of %.2fms:",
+        task_graph_critical_path_time(graph) * 1000.0,
+        (graph->end_time - graph->start_time) * 1000.0);
+
+    for (u32 i = 0; i < graph->critical_path_length; ++i) {
+        u32 index = graph->critical_path[i];
+        i32 written = snprintf(buffer + offset, sizeof(buffer) - offset, "%s %s %.2fms",
+            i == 0 ? "" : " >",
+            graph->stages[index].desc.name,
+            task_graph_stage_time(graph, index) * 1000.0);
+        if (written < 0 || offset + written >= (i32)sizeof(buffer))
+            break;
+        offset += written;
+    }
+    VINFO("%s", buffer);
+
+    // One bar per stage over the span of the execution, critical stages are marked with *
+    f64 span = graph->end_time - graph->start_time;
+    if (span <= 0.0)
+        return;
+
+    for (u32 i = 0; i < graph->stage_count; ++i) {
+        const task_stage* stage = &graph->stages[i];
+        b8 critical = FALSE;
+        for (u32 c = 0; c < graph->critical_path_length; ++c) {
+            if (graph->critical_path[c] == i)
+                critical = TRUE;
+        }
+
+        char bar[TASK_GRAPH_TIMELINE_WIDTH + 1];
+        u32 begin = (u32)((stage->start_time - graph->start_time) / span * TASK_GRAPH_TIMELINE_WIDTH);
+        u32 end = (u32)((stage->end_time - graph->start_time) / span * TASK_GRAPH_TIMELINE_WIDTH);
+        if (end >= TASK_GRAPH_TIMELINE_WIDTH)
+            end = TASK_GRAPH_TIMELINE_WIDTH - 1;
+        if (begin > end)
+            begin = end;
+        for (u32 c = 0; c < TASK_GRAPH_TIMELINE_WIDTH; ++c) {
+            bar[c] = (c >= begin && c <= end) ? (critical ? '#' : '=') : ' ';
+        }
+        bar[TASK_GRAPH_TIMELINE_WIDTH] = 0;
+
+        VINFO("  %-16s |%s| %.2fms thread %i%s",
+            stage->desc.name,
+            bar,
+            task_graph_stage_time(graph, i) * 1000.0,
+            stage->thread_index,
+            critical ? " *" : "");
+    }
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include "defines.h"
+#include "job_system.h"
+
+// Stages a graph can hold
+#define TASK_GRAPH_MAX_STAGES 32
+
+/*
+* Work of a stage.
+*
+* @param user_data - The user data of the stage
+* @return b8 - TRUE if successful. On FALSE the stages that did not start yet are skipped
+*/
+typedef b8 (*pfn_task_stage)(void* user_data);
+
+typedef enum task_stage_flag {
+    // Run on the thread that executes the graph, for work bound to it (window, graphics queue)
+    TASK_STAGE_FLAG_MAIN_THREAD = 0x1
+} task_stage_flag;
+
+/*
+* Declares a stage. Resources are bits the caller assigns meaning to.
+* A stage runs after every earlier added stage it conflicts with: one writes
+* what the other reads or writes. Stages that do not conflict may run concurrently.
+*/
+typedef struct task_stage_desc {
+    const char* name;
+    pfn_task_stage fn;
+    void* user_data;
+    u64 reads;
+    u64 writes;
+    u32 flags;
+} task_stage_desc;
+
+typedef struct task_stage {
+    task_stage_desc desc;
+    struct task_graph* graph;
+
+    // Stages that depend on this one
+    u8 successors[TASK_GRAPH_MAX_STAGES];
+    u32 successor_count;
+    u32 predecessor_count;
+
+    // Per execution
+    volatile u32 remaining;
+    b8 started;
+    // The predecessor that finished last and so released this stage, INVALID_ID for roots
+    u32 gated_by;
+    i32 thread_index;
+    f64 start_time;
+    f64 end_time;
+} task_stage;
+
+/*
+* Static graph of the stages of a frame. Built once, executed every frame.
+* All storage is inline so executing never allocates.
+*/
+typedef struct task_graph {
+    task_stage stages[TASK_GRAPH_MAX_STAGES];
+    u32 stage_count;
+    b8 compiled;
+
+    // Per execution
+    job_counter jobs;
+    volatile u32 completed;
+    volatile u32 failed;
+    f64 start_time;
+    f64 end_time;
+    u8 critical_path[TASK_GRAPH_MAX_STAGES];
+    u32 critical_path_length;
+} task_graph;
+
+/*
+* @param out_graph - The graph to initialize empty
+*/
+VAPI void task_graph_create(task_graph* out_graph);
+
+VAPI void task_graph_destroy(task_graph* graph);
+
+/*
+* Adds a stage. Only allowed before the graph is compiled.
+*
+* @param graph - The graph
+* @param desc - The stage, the name must outlive the graph
+* @return u32 - Index of the stage or INVALID_ID if the graph is full or compiled
+*/
+VAPI u32 task_graph_add_stage(task_graph* graph, const task_stage_desc* desc);
+
+/*
+* Derives the dependencies from the declared resources.
+*
+* @param graph - The graph
+* @return b8 - TRUE if successful, FALSE if the graph has no stages
+*/
+VAPI b8 task_graph_compile(task_graph* graph);
+
+/*
+* Runs every stage once. Stages without the main thread flag are queued on the job
+* system as soon as their dependencies finish, the calling thread runs the main
+* thread stages and helps with jobs in between. Must be called from a job thread.
+*
+* @param graph - A compiled graph
+* @return b8 - TRUE if every stage succeeded, FALSE otherwise
+*/
+VAPI b8 task_graph_execute(task_graph* graph);
+
+/*
+* @param graph - An executed graph
+* @param stage - Index of the stage
+* @return f64 - Time in seconds the stage ran during the last execution, 0 if it was skipped
+*/
+VAPI f64 task_graph_stage_time(const task_graph* graph, u32 stage);
+
+/*
+* The critical path is the chain of stages where each one was released by the one
+* before it finishing, ending in the stage that finished last. Shortening anything
+* off the path does not shorten the frame.
+*
+* @param graph - An executed graph
+* @return f64 - Time in seconds from the start of the execution to the end of the path
+*/
+VAPI f64 task_graph_critical_path_time(const task_graph* graph);
+
+/*
+* Logs the critical path of the last execution and a timeline of all stages.
+*
+* @param graph - An executed graph
+*/
+VAPI void task_graph_log(const task_graph* graph);
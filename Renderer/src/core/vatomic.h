@@ -0,0 +1,249 @@
+#pragma once
+#include "defines.h"
+
+/*
+* Atomic operations on naturally aligned 32 bit, 64 bit and pointer sized values.
+* Every operation takes an explicit memory order. MSVC targets x64 only, where
+* plain loads and stores already have acquire and release semantics, so only a
+* compiler barrier is needed for those and the interlocked intrinsics (full
+* barriers) cover everything else.
+*/
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+typedef enum vmemory_order {
+    VMEMORY_ORDER_RELAXED = 0,
+    VMEMORY_ORDER_ACQUIRE = 2,
+    VMEMORY_ORDER_RELEASE = 3,
+    VMEMORY_ORDER_ACQ_REL = 4,
+    VMEMORY_ORDER_SEQ_CST = 5
+} vmemory_order;
+
+#ifndef _MSC_VER
+static_assert(VMEMORY_ORDER_RELAXED == __ATOMIC_RELAXED && VMEMORY_ORDER_ACQUIRE == __ATOMIC_ACQUIRE &&
+    VMEMORY_ORDER_RELEASE == __ATOMIC_RELEASE && VMEMORY_ORDER_ACQ_REL == __ATOMIC_ACQ_REL &&
+    VMEMORY_ORDER_SEQ_CST == __ATOMIC_SEQ_CST, "Memory orders must match the compiler builtins");
+
+// A failed compare exchange is only a load, it cannot have release semantics
+VINLINE int vatomic_failure_order(vmemory_order order) {
+    if (order == VMEMORY_ORDER_RELEASE)
+        return __ATOMIC_RELAXED;
+    if (order == VMEMORY_ORDER_ACQ_REL)
+        return __ATOMIC_ACQUIRE;
+    return (int)order;
+}
+#endif
+
+// ---------------------------------------------------------------- 32 bit
+
+VINLINE u32 vatomic_load_u32(const volatile u32* ptr, vmemory_order order) {
+#ifdef _MSC_VER
+    u32 value = *ptr;
+    _ReadWriteBarrier();
+    return value;
+#else
+    return __atomic_load_n(ptr, (int)order);
+#endif
+}
+
+VINLINE void vatomic_store_u32(volatile u32* ptr, u32 value, vmemory_order order) {
+#ifdef _MSC_VER
+    if (order == VMEMORY_ORDER_SEQ_CST) {
+        _InterlockedExchange((volatile long*)ptr, (long)value);
+        return;
+    }
+    _ReadWriteBarrier();
+    *ptr = value;
+#else
+    __atomic_store_n(ptr, value, (int)order);
+#endif
+}
+
+VINLINE u32 vatomic_exchange_u32(volatile u32* ptr, u32 value, vmemory_order order) {
+#ifdef _MSC_VER
+    return (u32)_InterlockedExchange((volatile long*)ptr, (long)value);
+#else
+    return __atomic_exchange_n(ptr, value, (int)order);
+#endif
+}
+
+/*
+* Stores desired into ptr if it holds expected.
+*
+* @param ptr - The atomic value
+* @param expected - The expected value. Updated to the current value on failure
+* @param desired - The value to store
+* @param order - Memory order of the operation
+* @return b8 - TRUE if the value was swapped, FALSE otherwise
+*/
+VINLINE b8 vatomic_compare_exchange_u32(volatile u32* ptr, u32* expected, u32 desired, vmemory_order order) {
+#ifdef _MSC_VER
+    u32 previous = (u32)_InterlockedCompareExchange((volatile long*)ptr, (long)desired, (long)*expected);
+    if (previous == *expected)
+        return TRUE;
+    *expected = previous;
+    return FALSE;
+#else
+    return __atomic_compare_exchange_n(ptr, expected, desired, 0, (int)order, vatomic_failure_order(order)) ? TRUE : FALSE;
+#endif
+}
+
+/*
+* @return u32 - The value before the addition
+*/
+VINLINE u32 vatomic_fetch_add_u32(volatile u32* ptr, u32 value, vmemory_order order) {
+#ifdef _MSC_VER
+    return (u32)_InterlockedExchangeAdd((volatile long*)ptr, (long)value);
+#else
+    return __atomic_fetch_add(ptr, value, (int)order);
+#endif
+}
+
+/*
+* @return u32 - The value before the subtraction
+*/
+VINLINE u32 vatomic_fetch_sub_u32(volatile u32* ptr, u32 value, vmemory_order order) {
+#ifdef _MSC_VER
+    return (u32)_InterlockedExchangeAdd((volatile long*)ptr, -(long)value);
+#else
+    return __atomic_fetch_sub(ptr, value, (int)order);
+#endif
+}
+
+// ---------------------------------------------------------------- 64 bit
+
+VINLINE u64 vatomic_load_u64(const volatile u64* ptr, vmemory_order order) {
+#ifdef _MSC_VER
+    u64 value = *ptr;
+    _ReadWriteBarrier();
+    return value;
+#else
+    return __atomic_load_n(ptr, (int)order);
+#endif
+}
+
+VINLINE void vatomic_store_u64(volatile u64* ptr, u64 value, vmemory_order order) {
+#ifdef _MSC_VER
+    if (order == VMEMORY_ORDER_SEQ_CST) {
+        _InterlockedExchange64((volatile __int64*)ptr, (__int64)value);
+        return;
+    }
+    _ReadWriteBarrier();
+    *ptr = value;
+#else
+    __atomic_store_n(ptr, value, (int)order);
+#endif
+}
+
+VINLINE u64 vatomic_exchange_u64(volatile u64* ptr, u64 value, vmemory_order order) {
+#ifdef _MSC_VER
+    return (u64)_InterlockedExchange64((volatile __int64*)ptr, (__int64)value);
+#else
+    return __atomic_exchange_n(ptr, value, (int)order);
+#endif
+}
+
+VINLINE b8 vatomic_compare_exchange_u64(volatile u64* ptr, u64* expected, u64 desired, vmemory_order order) {
+#ifdef _MSC_VER
+    u64 previous = (u64)_InterlockedCompareExchange64((volatile __int64*)ptr, (__int64)desired, (__int64)*expected);
+    if (previous == *expected)
+        return TRUE;
+    *expected = previous;
+    return FALSE;
+#else
+    return __atomic_compare_exchange_n(ptr, expected, desired, 0, (int)order, vatomic_failure_order(order)) ? TRUE : FALSE;
+#endif
+}
+
+VINLINE u64 vatomic_fetch_add_u64(volatile u64* ptr, u64 value, vmemory_order order) {
+#ifdef _MSC_VER
+    return (u64)_InterlockedExchangeAdd64((volatile __int64*)ptr, (__int64)value);
+#else
+    return __atomic_fetch_add(ptr, value, (int)order);
+#endif
+}
+
+VINLINE u64 vatomic_fetch_sub_u64(volatile u64* ptr, u64 value, vmemory_order order) {
+#ifdef _MSC_VER
+    return (u64)_InterlockedExchangeAdd64((volatile __int64*)ptr, -(__int64)value);
+#else
+    return __atomic_fetch_sub(ptr, value, (int)order);
+#endif
+}
+
+// ---------------------------------------------------------------- Pointers
+
+VINLINE void* vatomic_load_ptr(void* const volatile* ptr, vmemory_order order) {
+#ifdef _MSC_VER
+    void* value = *ptr;
+    _ReadWriteBarrier();
+    return value;
+#else
+    return __atomic_load_n(ptr, (int)order);
+#endif
+}
+
+VINLINE void vatomic_store_ptr(void* volatile* ptr, void* value, vmemory_order order) {
+#ifdef _MSC_VER
+    if (order == VMEMORY_ORDER_SEQ_CST) {
+        _InterlockedExchangePointer(ptr, value);
+        return;
+    }
+    _ReadWriteBarrier();
+    *ptr = value;
+#else
+    __atomic_store_n(ptr, value, (int)order);
+#endif
+}
+
+VINLINE void* vatomic_exchange_ptr(void* volatile* ptr, void* value, vmemory_order order) {
+#ifdef _MSC_VER
+    return _InterlockedExchangePointer(ptr, value);
+#else
+    return __atomic_exchange_n(ptr, value, (int)order);
+#endif
+}
+
+VINLINE b8 vatomic_compare_exchange_ptr(void* volatile* ptr, void** expected, void* desired, vmemory_order order) {
+#ifdef _MSC_VER
+    void* previous = _InterlockedCompareExchangePointer(ptr, desired, *expected);
+    if (previous == *expected)
+        return TRUE;
+    *expected = previous;
+    return FALSE;
+#else
+    return __atomic_compare_exchange_n(ptr, expected, desired, 0, (int)order, vatomic_failure_order(order)) ? TRUE : FALSE;
+#endif
+}
+
+// ---------------------------------------------------------------- Fences
+
+/*
+* Orders memory accesses around the fence. Only a full (seq_cst) fence emits
+* an instruction on x64, the others just stop compiler reordering.
+*/
+VINLINE void vatomic_thread_fence(vmemory_order order) {
+#ifdef _MSC_VER
+    if (order == VMEMORY_ORDER_SEQ_CST)
+        _mm_mfence();
+    else
+        _ReadWriteBarrier();
+#else
+    __atomic_thread_fence((int)order);
+#endif
+}
+
+/*
+* Hint to the CPU that the calling thread is spinning.
+*/
+VINLINE void vatomic_pause() {
+#ifdef _MSC_VER
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
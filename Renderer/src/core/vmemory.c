@@ -2,9 +2,12 @@
 #include "platform/platform.h"
 #include "logger.h"
 #include "vstring.h"
+#include "vatomic.h"
+#include "vassert.h"
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 struct memory_stats {
     u64 total_allocated;
@@ -23,9 +26,11 @@ static const char* memory_tag_strings[MEMORY_TAG_MAXTAGS] = {
     "BST        ",
     "APPLICATION",
     "JOB        ",
+    "IO         ",
     "TEXTURE    ",
     "MAT_INST   ",
     "RENDERER   ",
+    "VULKAN     ",
     "GAME       ",
     "TRANSFORM  ",
     "ENTITY     ",
@@ -45,9 +50,9 @@ void* vallocate(u64 size, memory_tag tag) {
         VWARN("vallocate called using MEMORY_TAG_UNKNOWN. Re-class this allocation");
     }
 
-    // Update memory stats
-    stats.total_allocated += size;
-    stats.tagged_allocations[tag] += size;
+    // Update memory stats. Atomic since job threads allocate too
+    vatomic_fetch_add_u64(&stats.total_allocated, size, VMEMORY_ORDER_RELAXED);
+    vatomic_fetch_add_u64(&stats.tagged_allocations[tag], size, VMEMORY_ORDER_RELAXED);
 
     // TODO: Handle aligned memory
     void* block = platform_allocate(size, FALSE);
@@ -60,13 +65,49 @@ void vfree(void* block, u64 size, memory_tag tag) {
         VWARN("vfree called using MEMORY_TAG_UNKNOWN. Re-class this free");
     }
 
-    stats.total_allocated -= size;
-    stats.tagged_allocations[tag] -= size;
+    vatomic_fetch_sub_u64(&stats.total_allocated, size, VMEMORY_ORDER_RELAXED);
+    vatomic_fetch_sub_u64(&stats.tagged_allocations[tag], size, VMEMORY_ORDER_RELAXED);
 
     //TODO: Handle aligned memory
     platform_free(block, FALSE);
 }
 
+void* vallocate_aligned(u64 size, u64 alignment, memory_tag tag) {
+    if (tag == MEMORY_TAG_UNKNOWN) {
+        VWARN("vallocate_aligned called using MEMORY_TAG_UNKNOWN. Re-class this allocation");
+    }
+
+    // Over-allocate and keep the pointer of the underlying block right before the aligned one
+    if (alignment < sizeof(void*))
+        alignment = sizeof(void*);
+    u8* base = platform_allocate(size + alignment + sizeof(void*), TRUE);
+    if (!base)
+        return 0;
+
+    vatomic_fetch_add_u64(&stats.total_allocated, size, VMEMORY_ORDER_RELAXED);
+    vatomic_fetch_add_u64(&stats.tagged_allocations[tag], size, VMEMORY_ORDER_RELAXED);
+
+    u64 address = ((u64)(base + sizeof(void*)) + alignment - 1) & ~(alignment - 1);
+    void** block = (void**)address;
+    block[-1] = base;
+    return platform_zero_memory(block, size);
+}
+
+void vfree_aligned(void* block, u64 size, u64 alignment, memory_tag tag) {
+    if (tag == MEMORY_TAG_UNKNOWN) {
+        VWARN("vfree_aligned called using MEMORY_TAG_UNKNOWN. Re-class this free");
+    }
+
+    // A block that is not aligned did not come from vallocate_aligned
+    VASSERT(((u64)block & (alignment - 1)) == 0);
+    (void)alignment;
+
+    vatomic_fetch_sub_u64(&stats.total_allocated, size, VMEMORY_ORDER_RELAXED);
+    vatomic_fetch_sub_u64(&stats.tagged_allocations[tag], size, VMEMORY_ORDER_RELAXED);
+
+    platform_free(((void**)block)[-1], TRUE);
+}
+
 void* vzero_memory(void* block, u64 size) {
     return platform_zero_memory(block, size);
 }
@@ -90,30 +131,34 @@ char* get_memory_usage_str() {
     for (u32 idx = 0; idx != MEMORY_TAG_MAXTAGS; ++idx) {
         char unit[4] = "XiB";
         float amount = 1.f;
+        u64 allocated = vatomic_load_u64(&stats.tagged_allocations[idx], VMEMORY_ORDER_RELAXED);
 
-        if (stats.tagged_allocations[idx] >= gib) {
+        if (allocated >= gib) {
             unit[0] = 'G';
-            amount = stats.tagged_allocations[idx] / (float)gib;
+            amount = allocated / (float)gib;
         }
-        else if (stats.tagged_allocations[idx] >= mib) {
+        else if (allocated >= mib) {
             unit[0] = 'M';
-            amount = stats.tagged_allocations[idx] / (float)mib;
+            amount = allocated / (float)mib;
         }
-        else if (stats.tagged_allocations[idx] >= kib) {
+        else if (allocated >= kib) {
             unit[0] = 'K';
-            amount = stats.tagged_allocations[idx] / (float)kib;
+            amount = allocated / (float)kib;
         }
         else {
             unit[0] = 'B';
             unit[1] = 0;
-            amount = (float)stats.tagged_allocations[idx];
+            amount = (float)allocated;
         }
 
         i32 written = snprintf(buffer + offset, 5000 - offset, " %s: %.2f%s\n", memory_tag_strings[idx], amount, unit);
         offset += written;
     }
 
-    char* out_string = _strdup(buffer);
+    // Plain heap copy (strdup is not standard C) so the report does not show up in itself
+    u64 length = strlen(buffer);
+    char* out_string = malloc(length + 1);
+    memcpy(out_string, buffer, length + 1);
     return out_string;
 }
 
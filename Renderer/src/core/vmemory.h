@@ -12,9 +12,11 @@ typedef enum memory_tag {
     MEMORY_TAG_BST,
     MEMORY_TAG_APPLICATION,
     MEMORY_TAG_JOB,
+    MEMORY_TAG_IO,
     MEMORY_TAG_TEXTURE,
     MEMORY_TAG_MATERIAL_INSTANCE,
     MEMORY_TAG_RENDERER,
+    MEMORY_TAG_VULKAN,
     MEMORY_TAG_GAME,
     MEMORY_TAG_TRANSFORM,
     MEMORY_TAG_ENTITY,
@@ -51,6 +53,23 @@ VAPI void* vallocate(u64 size, memory_tag tag);
 */
 VAPI void vfree(void* block, u64 size, memory_tag tag);
 
+/**
+* Allocates a block aligned to a power of two.
+* @param size - The size of the memory block to allocate in bytes
+* @param alignment - The alignment of the block in bytes, a power of two
+* @param tag - The type of memory that the system will allocate
+*/
+VAPI void* vallocate_aligned(u64 size, u64 alignment, memory_tag tag);
+
+/**
+* Frees a block allocated with vallocate_aligned.
+* @param block - The block of memory that will be freed
+* @param size - The size it was allocated with (in bytes)
+* @param alignment - The alignment it was allocated with (in bytes)
+* @param tag - The type of the memory block
+*/
+VAPI void vfree_aligned(void* block, u64 size, u64 alignment, memory_tag tag);
+
 /**
 * Responsible for zeroing out a memory block.
 * @param block - The block of memory that will be set to 0
@@ -20,6 +20,11 @@ typedef double f64;
 typedef int b32;
 typedef char b8;
 
+// C11 only provides static_assert through assert.h, MSVC has it as a keyword
+#if !defined(_MSC_VER) && !defined(static_assert)
+#define static_assert _Static_assert
+#endif
+
 // Ensure all types are of correct size
 static_assert(sizeof(u8) == 1, "Expected u8 to be 1 byte");
 static_assert(sizeof(u16) == 2, "Expected u16 to be 2 bytes");
@@ -39,6 +44,9 @@ static_assert(sizeof(b8) == 1, "Expected b8 to be 1 bytes");
 
 #define TRUE 1
 #define FALSE 0
+
+// Marks an id or index that refers to nothing
+#define INVALID_ID 4294967295U
 #define VCLAMP(value,min,max) (value <= min) ? min : (value >= max) ? max : value;
 
 // Platform detection
@@ -72,4 +80,24 @@ static_assert(sizeof(b8) == 1, "Expected b8 to be 1 bytes");
 #else
 #define VAPI 
 #endif
-#endif
\ No newline at end of file
+#endif
+
+// Inlining
+#ifdef _MSC_VER
+#define VINLINE static __forceinline
+#else
+#define VINLINE static inline
+#endif
+
+#ifdef _MSC_VER
+#define VNOINLINE __declspec(noinline)
+#else
+#define VNOINLINE __attribute__((noinline))
+#endif
+
+// Thread local storage
+#ifdef _MSC_VER
+#define VTHREAD_LOCAL __declspec(thread)
+#else
+#define VTHREAD_LOCAL _Thread_local
+#endif
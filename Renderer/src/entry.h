@@ -16,6 +16,7 @@ int main(void)
     initialize_memory();
 
     game game_inst;// Create game
+    vzero_memory(&game_inst, sizeof(game)); // Unset configuration falls back to defaults
     if (!create_game(&game_inst))
     {
         VFATAL("Could not initialize game!");
@@ -1,5 +1,6 @@
 #pragma once
 #include "core/application.h"
+#include "renderer/renderer_types.inl"
 
 typedef struct game {
     // Configuration of the application
@@ -8,15 +9,33 @@ typedef struct game {
     // Initialization code of the game
     b8      (*initialize)(struct game* game_inst);
 
-    // Logic to update the game / simulation
+    /*
+    * Threading: update, fixed_update and render run on job threads, possibly while the
+    * main thread draws the previous frame. They must not call functions that are documented
+    * as main thread only, like most of the renderer. Those calls belong in prepare_frame.
+    */
+
+    // Optional. Runs on the main thread at the start of every frame, before the other stages and
+    // while none of them runs. The place for main thread only calls like creating renderer resources
+    b8      (*prepare_frame)(struct game* game_inst, f64 delta_time);
+
+    // Logic to update the game / simulation. Runs on a job thread
     b8      (*update)(struct game* game_inst, f64 delta_time);
 
-    // Logic to render the view of the game
-    b8      (*render)(struct game* game_inst, f64 delta_time);
+    // Optional. Simulation step called at app_config.fixed_update_rate with a constant delta time. Runs on a job thread
+    b8      (*fixed_update)(struct game* game_inst, f64 fixed_delta_time);
+
+    // Logic to render the view of the game. The interpolation alpha [0, 1) is how far the
+    // current time is between the last two fixed updates (1 without a fixed timestep). Runs on a job thread.
+    // Geometry the frame draws is pushed to packet->geometries (darray), it has to stay alive until that frame is drawn
+    b8      (*render)(struct game* game_inst, f64 delta_time, f64 interpolation_alpha, render_packet* packet);
 
     // Logic to handle window resize is window is a concept of the platform
     void    (*on_resize)(struct game* game_inst, i32 new_width, i32 new_height);
 
+    // Optional. Called once after the main loop ended, before the engine systems shut down
+    void    (*shutdown)(struct game* game_inst);
+
     // Internal game state. Created and managed by the game
     void*   state;
 } game;
\ No newline at end of file
@@ -16,6 +16,9 @@ typedef struct platform_state {
 * @param y - The Y origin on the screen of the window
 * @param width - The width of the window
 * @param height - The height of the window
+* @param headless - Run without a window system. The surface is created off screen
+* and the main loop is still driven normally. Platforms may also switch to it when
+* no window can be created
 * 
 * @return b8 - True of false depending on the state of initialization
 */
@@ -25,7 +28,8 @@ b8 platform_startup(
     i32 x,
     i32 y,
     i32 width,
-    i32 height);
+    i32 height,
+    b8 headless);
 
 /*
 * Responsible for shutting down the application. Remove all loggers, clear all queues. Close windows. Cleanup any state.
@@ -57,6 +61,67 @@ void*   platform_allocate(u64 size, b8 aligned);
 */
 void    platform_free(void* block, b8 aligned);
 
+typedef enum platform_page_flag {
+    // Back the range with large pages. Explicit huge pages when the system has them
+    // (MAP_HUGETLB, MEM_LARGE_PAGES), otherwise transparent huge pages on Linux.
+    // The size is rounded up to platform_large_page_size(), and with explicit huge pages
+    // on Linux commit and decommit work in whole large pages: their address and size
+    // have to be multiples of platform_large_page_size(). Linux only uses explicit huge
+    // pages when the pool can cover the whole range at reservation, other processes
+    // drawing from the pool before the pages are touched can still cause a SIGBUS
+    PLATFORM_PAGE_FLAG_LARGE = 0x1
+} platform_page_flag;
+
+/*
+* Reserves a range of address space without backing it with memory. The range
+* is inaccessible until committed. Large page reservations on Windows are
+* committed as a whole right away since the system cannot commit them later.
+*
+* @param size - Size in bytes, a multiple of platform_page_size(). Rounded up to
+* platform_large_page_size() with PLATFORM_PAGE_FLAG_LARGE
+* @param flags - Combination of platform_page_flag
+* @return void* - Start of the range, 0 on failure
+*/
+void*   platform_reserve(u64 size, u32 flags);
+
+/*
+* Backs pages of a reserved range with memory and makes them read and writable.
+* Newly committed memory reads as zero.
+*
+* @param address - Page aligned address inside a reserved range
+* @param size - Size in bytes, a multiple of the page size
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8      platform_commit(void* address, u64 size);
+
+/*
+* Gives the memory behind committed pages back to the system. The address
+* range stays reserved and inaccessible until committed again.
+*
+* @param address - Page aligned address inside a reserved range
+* @param size - Size in bytes, a multiple of the page size
+*/
+void    platform_decommit(void* address, u64 size);
+
+/*
+* Releases a whole range returned by platform_reserve.
+*
+* @param address - The address returned by platform_reserve
+* @param size - The size given to platform_reserve
+* @param flags - The flags given to platform_reserve
+*/
+void    platform_release(void* address, u64 size, u32 flags);
+
+/*
+* @return u64 - Size in bytes of a regular page
+*/
+u64     platform_page_size();
+
+/*
+* @return u64 - Size in bytes of a large page, 0 if the system has none
+*/
+u64     platform_large_page_size();
+
 /*
 * Perform a memset of 0 on a block of memory in a platform agnostic way.
 * 
@@ -109,7 +174,7 @@ void platform_console_write_error(const char* msg, u8 color);
 * Platform specific implementation of time. We will obtain the absolute time of the system.
 * @return f64 - Time time in milliseconds
 */
-f64 platform_get_absolute_time();
+VAPI f64 platform_get_absolute_time();
 
 /*
 * Platform specific implementation of thread sleep. The thread that calls this method will
@@ -117,4 +182,4 @@ f64 platform_get_absolute_time();
 * 
 * @param ms - The milliseconds you want the thread to sleep
 */
-void platform_sleep(u64 ms);
\ No newline at end of file
+VAPI void platform_sleep(u64 ms);
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+* Entry point of a fiber. It must never return, a fiber ends by switching
+* away for the last time and being destroyed from another fiber.
+*
+* @param params - The user data given at creation
+*/
+typedef void (*pfn_fiber_start)(void* params);
+
+typedef struct platform_fiber {
+    void* internal_data;
+} platform_fiber;
+
+/*
+* Turns the calling thread into a fiber so it can switch to other fibers.
+*
+* @param out_fiber - Fiber representing the original stack of the thread
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+VAPI b8 platform_fiber_convert_thread(platform_fiber* out_fiber);
+
+/*
+* Turns the calling thread back into a regular thread. Must be called while
+* running on the fiber returned by platform_fiber_convert_thread.
+*
+* @param thread_fiber - The fiber of the thread
+*/
+VAPI void platform_fiber_convert_back(platform_fiber* thread_fiber);
+
+/*
+* Creates a fiber with its own stack. The lowest page of the stack is a guard
+* page, so overflowing it faults instead of corrupting other memory.
+*
+* @param stack_size - Usable stack size in bytes, rounded up to whole pages
+* @param start_function - The function the fiber runs when first switched to
+* @param params - User data passed to start_function
+* @param out_fiber - The created fiber
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+VAPI b8 platform_fiber_create(u64 stack_size, pfn_fiber_start start_function, void* params, platform_fiber* out_fiber);
+
+/*
+* Destroys a fiber and its stack. Must not be the running fiber.
+*
+* @param fiber - The fiber to destroy
+*/
+VAPI void platform_fiber_destroy(platform_fiber* fiber);
+
+/*
+* Saves the running fiber into from and continues running to. Returns when
+* another switch targets from again, possibly on a different thread.
+*
+* @param from - The fiber that is running now
+* @param to - The fiber to run
+*/
+VAPI void platform_fiber_switch(platform_fiber* from, platform_fiber* to);
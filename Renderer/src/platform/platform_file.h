@@ -0,0 +1,82 @@
+#pragma once
+
+#include "defines.h"
+
+typedef enum platform_file_map_mode {
+    // Pages can only be read
+    PLATFORM_FILE_MAP_READ_ONLY,
+    // Pages can be written, written pages become private copies and never reach the file
+    PLATFORM_FILE_MAP_COPY_ON_WRITE
+} platform_file_map_mode;
+
+/*
+* A file mapped into memory. Pages are read from disk on first access and
+* shared with the page cache, so consuming the data needs no read buffer.
+*/
+typedef struct platform_file_mapping {
+    void* data;
+    u64 size;
+    void* internal_data;
+} platform_file_mapping;
+
+/*
+* Maps a whole file. The file can be moved or deleted while mapped, but
+* truncating it makes accesses past the new end fault.
+*
+* @param path - Path of the file
+* @param mode - How the mapped pages may be accessed
+* @param out_mapping - The mapping. Empty files map to data 0 and size 0
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+VAPI b8 platform_file_map(const char* path, platform_file_map_mode mode, platform_file_mapping* out_mapping);
+
+/*
+* Unmaps a file. Pointers into the mapping are invalid afterwards.
+*
+* @param mapping - The mapping to unmap
+*/
+VAPI void platform_file_unmap(platform_file_mapping* mapping);
+
+/*
+* Asks the system to start reading a range of the mapping from disk, so later
+* accesses do not stall on page faults. Only a hint, it does not wait.
+*
+* @param mapping - The mapping
+* @param offset - Start of the range in bytes
+* @param size - Size of the range in bytes, clamped to the end of the mapping
+*/
+VAPI void platform_file_prefetch(const platform_file_mapping* mapping, u64 offset, u64 size);
+
+/*
+* An open file. Opened for reading only.
+*/
+typedef struct platform_file {
+    void* handle;
+    b8 is_valid;
+} platform_file;
+
+/*
+* Opens a file for reading.
+*
+* @param path - Path of the file
+* @param async - Open it for platform_io_queue reads. On Windows such a handle
+* needs overlapped reads and cannot be used with platform_file_read_at
+* @param out_file - The opened file
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+VAPI b8 platform_file_open_read(const char* path, b8 async, platform_file* out_file);
+
+VAPI void platform_file_close(platform_file* file);
+
+/*
+* Reads from a position of the file without moving a file pointer, so
+* several threads can read the same file. Blocks until done.
+*
+* @param file - The file, not opened for async reads
+* @param offset - Position in the file in bytes
+* @param size - Amount of bytes to read
+* @param buffer - Receives the data, at least size bytes
+* @param out_bytes_read - Bytes read, less than size only at the end of the file
+* @return b8 - TRUE if successful, FALSE on a read error
+*/
+VAPI b8 platform_file_read_at(platform_file* file, u64 offset, u64 size, void* buffer, u64* out_bytes_read);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "defines.h"
+#include "platform_file.h"
+
+/*
+* Queue of asynchronous file reads handled by the system: io_uring on Linux
+* (kernel 5.6 or newer, creation fails on kernels without IORING_OP_READ)
+* and an I/O completion port on Windows.
+* Except for platform_io_queue_wake it must be used from a single thread.
+*/
+typedef struct platform_io_queue {
+    void* internal_data;
+} platform_io_queue;
+
+typedef struct platform_io_completion {
+    // Tag given to the read
+    u64 tag;
+    // Bytes read, fewer than requested at the end of the file
+    u64 bytes;
+    b8 success;
+    b8 cancelled;
+} platform_io_completion;
+
+/*
+* Creates a queue.
+*
+* @param depth - Reads that can be in flight at once
+* @param out_queue - The created queue
+* @return b8 - TRUE if successful, FALSE if the system offers no asynchronous file I/O
+*/
+VAPI b8 platform_io_queue_create(u32 depth, platform_io_queue* out_queue);
+
+VAPI void platform_io_queue_destroy(platform_io_queue* queue);
+
+/*
+* Queues a read. It may only start on the next platform_io_queue_submit.
+*
+* @param queue - The queue
+* @param file - A file opened for async reads, it must stay open until the read completes
+* @param offset - Position in the file in bytes
+* @param size - Amount of bytes to read, at most 2GiB
+* @param buffer - Receives the data
+* @param tag - Nonzero value identifying the read in its completion
+* @return b8 - TRUE if queued, FALSE if the queue is full or the read could not start
+*/
+VAPI b8 platform_io_queue_read(platform_io_queue* queue, platform_file* file, u64 offset, u64 size, void* buffer, u64 tag);
+
+/*
+* Asks the system to cancel a read. It still completes, flagged as cancelled if
+* the cancel arrived in time.
+*
+* @param queue - The queue
+* @param tag - The tag of the read
+* @return b8 - TRUE if the cancel was queued, FALSE if the queue had no room for it and it has to be retried
+*/
+VAPI b8 platform_io_queue_cancel(platform_io_queue* queue, u64 tag);
+
+/*
+* Hands the queued reads and cancels to the system.
+*/
+VAPI void platform_io_queue_submit(platform_io_queue* queue);
+
+/*
+* Submits and blocks until at least one read completed or the queue was woken.
+*
+* @param queue - The queue
+* @param out_completions - Receives the completions
+* @param max_count - Size of out_completions
+* @return u32 - Amount of completions, 0 if only woken
+*/
+VAPI u32 platform_io_queue_wait(platform_io_queue* queue, platform_io_completion* out_completions, u32 max_count);
+
+/*
+* Makes a current or the next platform_io_queue_wait return. Any thread.
+*/
+VAPI void platform_io_queue_wake(platform_io_queue* queue);
@@ -0,0 +1,1487 @@
+// sigaction, clock_gettime, nanosleep and the pthread_*_np calls are not declared under -std=c17
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "platform.h"
+#include "platform_thread.h"
+#include "platform_fiber.h"
+#include "platform_file.h"
+#include "platform_io_queue.h"
+
+// Conditional compilation
+#if R_PLATFORM_LINUX
+#include "core/logger.h"
+#include "core/input.h"
+#include "containers/darray.h"
+#include "core/vstring.h"
+#include "core/event.h"
+
+// Std libraries
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+
+// Posix
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <linux/io_uring.h>
+#include <ucontext.h>
+
+// X11 through xcb
+#include <xcb/xcb.h>
+#include <X11/keysym.h>
+
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_xcb.h>
+#include "renderer/vulkan/vulkan_types.inl"
+
+typedef struct internal_state {
+    // No window system, the surface is a VK_EXT_headless_surface
+    b8 headless;
+    u16 width;
+    u16 height;
+
+    xcb_connection_t* connection;
+    xcb_screen_t* screen;
+    xcb_window_t window;
+    xcb_atom_t wm_protocols;
+    xcb_atom_t wm_delete_window;
+
+    // Keyboard mapping fetched once at startup, used to translate key codes
+    xcb_keysym_t* keysyms;
+    u32 keysym_count;
+    u8 min_keycode;
+    u8 keysyms_per_keycode;
+
+    VkSurfaceKHR surface; // TODO: temporary
+}internal_state;
+
+// The required instance extensions depend on the mode, but the query has no platform state
+static b8 headless_mode = FALSE;
+
+// Set from the signal handler, turned into a quit event by the message pump
+static volatile sig_atomic_t quit_requested = 0;
+
+// Console colors are only emitted when writing to a terminal
+static b8 stdout_is_terminal = FALSE;
+static b8 stderr_is_terminal = FALSE;
+
+static void linux_signal_handler(int signal_number);
+static b8 linux_create_window(internal_state* state, const char* application_name, i32 x, i32 y, i32 width, i32 height);
+static void linux_process_event(internal_state* state, xcb_generic_event_t* event);
+static keys translate_keysym(xcb_keysym_t keysym);
+
+b8 platform_startup(
+    platform_state* plat_state,
+    const char* application_name,
+    i32 x,
+    i32 y,
+    i32 width,
+    i32 height,
+    b8 headless) {
+
+    plat_state->internal_state = malloc(sizeof(internal_state));
+    internal_state* state = (internal_state*)plat_state->internal_state;
+    memset(state, 0, sizeof(internal_state));
+
+    stdout_is_terminal = isatty(STDOUT_FILENO);
+    stderr_is_terminal = isatty(STDERR_FILENO);
+
+    // SIGINT / SIGTERM are how the headless fleet stops a run
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = linux_signal_handler;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, 0);
+    sigaction(SIGTERM, &action, 0);
+
+    const char* headless_env = getenv("VKR_HEADLESS");
+    if (headless_env && strings_equal(headless_env, "1")) {
+        headless = TRUE;
+    }
+
+    if (!headless && !linux_create_window(state, application_name, x, y, width, height)) {
+        VWARN("Could not create a window. Falling back to headless mode");
+        headless = TRUE;
+    }
+
+    state->headless = headless;
+    headless_mode = headless;
+    state->width = (u16)width;
+    state->height = (u16)height;
+
+    if (headless) {
+        VINFO("Platform running headless (%ix%i)", width, height);
+    }
+
+    // Report the initial size like a window system would before the first frame
+    event_context event;
+    event.data.u16[0] = state->width;
+    event.data.u16[1] = state->height;
+    event_fire(EVENT_CODE_RESIZED, 0, event);
+
+    return TRUE;
+}
+
+void platform_shutdown(platform_state* plat_state) {
+    internal_state* state = (internal_state*)plat_state->internal_state;
+    if (!state)
+        return;
+
+    if (state->keysyms) {
+        free(state->keysyms);
+        state->keysyms = 0;
+    }
+
+    if (state->connection) {
+        if (state->window) {
+            xcb_destroy_window(state->connection, state->window);
+            state->window = 0;
+        }
+
+        xcb_disconnect(state->connection);
+        state->connection = 0;
+    }
+
+    free(state);
+    plat_state->internal_state = 0;
+}
+
+b8 platform_pump_message(platform_state* plat_state) {
+    internal_state* state = (internal_state*)plat_state->internal_state;
+
+    if (quit_requested) {
+        quit_requested = 0;
+        event_context event = { 0 };
+        event_fire(EVENT_CODE_APPLICATION_QUIT, 0, event);
+    }
+
+    if (state && state->connection) {
+        xcb_generic_event_t* event;
+        while ((event = xcb_poll_for_event(state->connection)) != 0) {
+            linux_process_event(state, event);
+            free(event);
+        }
+
+        if (xcb_connection_has_error(state->connection)) {
+            VERROR("Lost the connection to the X server");
+            event_context event = { 0 };
+            event_fire(EVENT_CODE_APPLICATION_QUIT, 0, event);
+        }
+    }
+
+    return TRUE;
+}
+
+void* platform_allocate(u64 size, b8 aligned) {
+    return malloc(size); // Temporary solution
+}
+
+void platform_free(void* block, b8 aligned) {
+    free(block);
+}
+
+static u64 linux_page_size = 0;
+static u64 linux_large_page_size = 0;
+static b8 linux_large_page_size_read = FALSE;
+
+// Huge pages the hugetlb pool can still hand out: the free ones nobody has reserved,
+// plus the surplus pages the administrator allows on top of the pool
+static u64 linux_available_huge_pages() {
+    unsigned long long free_pages = 0, reserved_pages = 0, surplus_pages = 0, overcommit_pages = 0;
+
+    FILE* meminfo = fopen("/proc/meminfo", "r");
+    if (!meminfo)
+        return 0;
+
+    char line[128];
+    while (fgets(line, sizeof(line), meminfo)) {
+        sscanf(line, "HugePages_Free: %llu", &free_pages);
+        sscanf(line, "HugePages_Rsvd: %llu", &reserved_pages);
+        sscanf(line, "HugePages_Surp: %llu", &surplus_pages);
+    }
+    fclose(meminfo);
+
+    FILE* overcommit = fopen("/proc/sys/vm/nr_overcommit_hugepages", "r");
+    if (overcommit) {
+        if (fscanf(overcommit, "%llu", &overcommit_pages) != 1)
+            overcommit_pages = 0;
+        fclose(overcommit);
+    }
+
+    u64 available = free_pages > reserved_pages ? free_pages - reserved_pages : 0;
+    if (overcommit_pages > surplus_pages)
+        available += overcommit_pages - surplus_pages;
+    return available;
+}
+
+void* platform_reserve(u64 size, u32 flags) {
+    i32 map_flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+    u64 large_page_size = platform_large_page_size();
+
+    if ((flags & PLATFORM_PAGE_FLAG_LARGE) && large_page_size) {
+        // The kernel rejects hugetlb ranges that are not whole huge pages, so the size is rounded up
+        size = (size + large_page_size - 1) & ~(large_page_size - 1);
+
+        // Explicit huge pages only exist if the administrator set some aside. MAP_NORESERVE leaves
+        // the pool alone until pages are touched, like a regular reservation, but it also skips the
+        // kernel's pool check: the mmap succeeds on an empty pool and the first touch raises SIGBUS.
+        // Only take the hugetlb path when the pool covers the whole range right now
+        if (linux_available_huge_pages() >= size / large_page_size) {
+            void* block = mmap(0, size, PROT_NONE, map_flags | MAP_HUGETLB, -1, 0);
+            if (block != MAP_FAILED)
+                return block;
+        }
+
+        // Transparent huge pages need large page aligned ranges, so reserve
+        // a large page more and trim both ends
+        u64 padded_size = size + large_page_size;
+        u8* padded = mmap(0, padded_size, PROT_NONE, map_flags, -1, 0);
+        if (padded == MAP_FAILED)
+            return 0;
+
+        u8* aligned = (u8*)(((u64)padded + large_page_size - 1) & ~(large_page_size - 1));
+        if (aligned != padded)
+            munmap(padded, aligned - padded);
+        u64 tail = (padded + padded_size) - (aligned + size);
+        if (tail)
+            munmap(aligned + size, tail);
+
+        madvise(aligned, size, MADV_HUGEPAGE);
+        return aligned;
+    }
+
+    void* block = mmap(0, size, PROT_NONE, map_flags, -1, 0);
+    return block == MAP_FAILED ? 0 : block;
+}
+
+b8 platform_commit(void* address, u64 size) {
+    // The kernel backs pages on first touch, committing only makes them accessible
+    if (mprotect(address, size, PROT_READ | PROT_WRITE) != 0) {
+        VERROR("platform_commit: mprotect of %llu bytes at %p failed: %s", size, address, strerror(errno));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void platform_decommit(void* address, u64 size) {
+    if (madvise(address, size, MADV_DONTNEED) != 0 || mprotect(address, size, PROT_NONE) != 0)
+        VWARN("platform_decommit: %llu bytes at %p were not decommitted: %s", size, address, strerror(errno));
+}
+
+void platform_release(void* address, u64 size, u32 flags) {
+    if (!address)
+        return;
+
+    // platform_reserve rounded large page ranges up, both the hugetlb and the transparent huge page ones
+    u64 large_page_size = platform_large_page_size();
+    if ((flags & PLATFORM_PAGE_FLAG_LARGE) && large_page_size)
+        size = (size + large_page_size - 1) & ~(large_page_size - 1);
+
+    if (munmap(address, size) != 0)
+        VWARN("platform_release: %llu bytes at %p were not released: %s", size, address, strerror(errno));
+}
+
+u64 platform_page_size() {
+    if (!linux_page_size)
+        linux_page_size = (u64)sysconf(_SC_PAGESIZE);
+    return linux_page_size;
+}
+
+u64 platform_large_page_size() {
+    if (linux_large_page_size_read)
+        return linux_large_page_size;
+
+    FILE* meminfo = fopen("/proc/meminfo", "r");
+    if (meminfo) {
+        char line[128];
+        unsigned long long kib = 0;
+        while (fgets(line, sizeof(line), meminfo)) {
+            if (sscanf(line, "Hugepagesize: %llu kB", &kib) == 1) {
+                linux_large_page_size = (u64)kib * 1024;
+                break;
+            }
+        }
+        fclose(meminfo);
+    }
+
+    linux_large_page_size_read = TRUE;
+    return linux_large_page_size;
+}
+
+void* platform_zero_memory(void* block, u64 size) {
+    return memset(block, 0, size);
+}
+
+void* platform_copy_memory(void* dest, void* src, u64 size) {
+    return memcpy(dest, src, size);
+}
+
+void* platform_set_memory(void* block, i32 value, u64 size) {
+    return memset(block, value, size);
+}
+
+// TRACE, DEBUG, INFO, WARN, ERROR, FATAL as ANSI color codes
+static const char* console_colors[6] = { "1;30", "1;34", "1;32", "1;33", "1;31", "0;41" };
+
+void platform_console_write(const char* msg, u8 color) {
+    if (stdout_is_terminal)
+        fprintf(stdout, "\033[%sm%s\033[0m", console_colors[color], msg);
+    else
+        fputs(msg, stdout);
+}
+
+void platform_console_write_error(const char* msg, u8 color) {
+    if (stderr_is_terminal)
+        fprintf(stderr, "\033[%sm%s\033[0m", console_colors[color], msg);
+    else
+        fputs(msg, stderr);
+}
+
+f64 platform_get_absolute_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (f64)now.tv_sec + (f64)now.tv_nsec * 0.000000001;
+}
+
+void platform_sleep(u64 ms) {
+    struct timespec remaining;
+    remaining.tv_sec = ms / 1000;
+    remaining.tv_nsec = (ms % 1000) * 1000 * 1000;
+
+    // Signals interrupt the sleep, continue with what is left
+    while (nanosleep(&remaining, &remaining) == -1 && errno == EINTR) {
+    }
+}
+
+void platform_get_required_extensions_names(char*** names_darray) {
+    if (headless_mode) {
+        const char* headless_surface_ext_name = VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME;
+        darray_push(*names_darray, headless_surface_ext_name);
+    }
+    else {
+        const char* xcb_surface_ext_name = "VK_KHR_xcb_surface";
+        darray_push(*names_darray, xcb_surface_ext_name);
+    }
+}
+
+b8 platform_create_vulkan_surface(struct platform_state* plat_state, struct vulkan_context* context) {
+    internal_state* state = (internal_state*)plat_state->internal_state;
+
+    VkResult result;
+    if (state->headless) {
+        // Extension entry points are not exported by the loader
+        PFN_vkCreateHeadlessSurfaceEXT create_headless_surface =
+            (PFN_vkCreateHeadlessSurfaceEXT)vkGetInstanceProcAddr(context->instance, "vkCreateHeadlessSurfaceEXT");
+        if (!create_headless_surface) {
+            VFATAL("vkCreateHeadlessSurfaceEXT is not available");
+            return FALSE;
+        }
+
+        VkHeadlessSurfaceCreateInfoEXT create_info = { VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT };
+        create_info.pNext = 0;
+        result = create_headless_surface(context->instance, &create_info, context->allocator, &state->surface);
+    }
+    else {
+        VkXcbSurfaceCreateInfoKHR create_info = { VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR };
+        create_info.connection = state->connection;
+        create_info.window = state->window;
+        create_info.pNext = 0;
+        result = vkCreateXcbSurfaceKHR(context->instance, &create_info, context->allocator, &state->surface);
+    }
+
+    if (result != VK_SUCCESS) {
+        VFATAL("Vulkan surface failed creation");
+        return FALSE;
+    }
+
+    context->surface = state->surface;
+    return TRUE;
+}
+
+// Threads hand their id back before the creator returns, so priorities can be set right away
+typedef struct linux_thread {
+    pthread_t handle;
+    pid_t tid;
+    pfn_thread_start start_function;
+    void* params;
+    char name[16];
+    sem_t started;
+    u32 exit_code;
+} linux_thread;
+
+static void* linux_thread_start(void* arg) {
+    linux_thread* thread = (linux_thread*)arg;
+    thread->tid = (pid_t)syscall(SYS_gettid);
+    if (thread->name[0])
+        pthread_setname_np(pthread_self(), thread->name);
+
+    sem_post(&thread->started);
+    thread->exit_code = thread->start_function(thread->params);
+    return 0;
+}
+
+// Absolute time timeout_ms from now on the given clock
+static void linux_deadline(clockid_t clock, u64 timeout_ms, struct timespec* out_deadline) {
+    clock_gettime(clock, out_deadline);
+    out_deadline->tv_sec += (time_t)(timeout_ms / 1000);
+    out_deadline->tv_nsec += (long)((timeout_ms % 1000) * 1000 * 1000);
+    if (out_deadline->tv_nsec >= 1000 * 1000 * 1000) {
+        out_deadline->tv_sec += 1;
+        out_deadline->tv_nsec -= 1000 * 1000 * 1000;
+    }
+}
+
+b8 platform_thread_create(pfn_thread_start start_function, void* params, const char* name, platform_thread* out_thread) {
+    linux_thread* thread = malloc(sizeof(linux_thread));
+    memset(thread, 0, sizeof(linux_thread));
+    thread->start_function = start_function;
+    thread->params = params;
+    if (name) {
+        // The kernel limits thread names to 15 characters
+        strncpy(thread->name, name, sizeof(thread->name) - 1);
+    }
+
+    sem_init(&thread->started, 0, 0);
+    if (pthread_create(&thread->handle, 0, linux_thread_start, thread) != 0) {
+        VERROR("Failed to create thread '%s'", name ? name : "");
+        sem_destroy(&thread->started);
+        free(thread);
+        return FALSE;
+    }
+
+    while (sem_wait(&thread->started) == -1 && errno == EINTR) {
+    }
+    sem_destroy(&thread->started);
+
+    out_thread->internal_data = thread;
+    out_thread->thread_id = (u64)thread->tid;
+    return TRUE;
+}
+
+u32 platform_thread_join(platform_thread* thread) {
+    linux_thread* internal = (linux_thread*)thread->internal_data;
+    if (!internal)
+        return 0;
+
+    pthread_join(internal->handle, 0);
+    u32 exit_code = internal->exit_code;
+    free(internal);
+    thread->internal_data = 0;
+    thread->thread_id = 0;
+    return exit_code;
+}
+
+b8 platform_thread_set_affinity(platform_thread* thread, u64 affinity_mask) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (u32 i = 0; i < 64 && i < CPU_SETSIZE; ++i) {
+        if (affinity_mask & (1ull << i))
+            CPU_SET(i, &set);
+    }
+
+    pthread_t handle = thread ? ((linux_thread*)thread->internal_data)->handle : pthread_self();
+    return pthread_setaffinity_np(handle, sizeof(cpu_set_t), &set) == 0;
+}
+
+b8 platform_thread_set_priority(platform_thread* thread, platform_thread_priority priority) {
+    // Normal threads all share SCHED_OTHER, the nice value of the thread is what differs
+    static const i32 nice_values[] = { 10, 0, -5, -15 };
+    pid_t tid = thread ? ((linux_thread*)thread->internal_data)->tid : (pid_t)syscall(SYS_gettid);
+    return setpriority(PRIO_PROCESS, (id_t)tid, nice_values[priority]) == 0;
+}
+
+void platform_thread_set_current_name(const char* name) {
+    char truncated[16];
+    strncpy(truncated, name, sizeof(truncated) - 1);
+    truncated[sizeof(truncated) - 1] = 0;
+    pthread_setname_np(pthread_self(), truncated);
+}
+
+u64 platform_thread_current_id() {
+    return (u64)syscall(SYS_gettid);
+}
+
+u32 platform_thread_current_processor() {
+    int cpu = sched_getcpu();
+    return cpu >= 0 && cpu < PLATFORM_MAX_LOGICAL_PROCESSORS ? (u32)cpu : PLATFORM_MAX_LOGICAL_PROCESSORS;
+}
+
+void platform_thread_yield() {
+    sched_yield();
+}
+
+u32 platform_get_processor_count() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32)count : 1;
+}
+
+static b8 linux_read_sysfs(const char* path, char* buffer, u64 size) {
+    FILE* file = fopen(path, "r");
+    if (!file)
+        return FALSE;
+
+    b8 result = fgets(buffer, (int)size, file) != 0;
+    fclose(file);
+    return result;
+}
+
+static b8 linux_read_sysfs_u32(const char* path, u32* out_value) {
+    char buffer[32];
+    if (!linux_read_sysfs(path, buffer, sizeof(buffer)))
+        return FALSE;
+    return sscanf(buffer, "%u", out_value) == 1;
+}
+
+// Sizes look like "48K" or "30720K"
+static u64 linux_parse_cache_size(const char* text) {
+    unsigned long long size = 0;
+    char unit = 0;
+    if (sscanf(text, "%llu%c", &size, &unit) < 1)
+        return 0;
+    if (unit == 'K')
+        size *= 1024;
+    else if (unit == 'M')
+        size *= 1024 * 1024;
+    return size;
+}
+
+// Lists look like "0-3,8-11"
+static void linux_apply_cpu_list(const char* list, u8 node, platform_cpu_info* info) {
+    const char* cursor = list;
+    while (*cursor >= '0' && *cursor <= '9') {
+        char* end;
+        u32 first = (u32)strtoul(cursor, &end, 10);
+        u32 last = first;
+        if (*end == '-')
+            last = (u32)strtoul(end + 1, &end, 10);
+
+        for (u32 cpu = first; cpu <= last && cpu < PLATFORM_MAX_LOGICAL_PROCESSORS; ++cpu) {
+            info->numa_node[cpu] = node;
+        }
+
+        cursor = *end == ',' ? end + 1 : end;
+    }
+}
+
+b8 platform_get_cpu_info(platform_cpu_info* out_info) {
+    memset(out_info, 0, sizeof(platform_cpu_info));
+
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        CPU_ZERO(&allowed);
+        for (u32 cpu = 0; cpu < platform_get_processor_count() && cpu < PLATFORM_MAX_LOGICAL_PROCESSORS; ++cpu)
+            CPU_SET(cpu, &allowed);
+    }
+
+    // Cores are identified by package and core id, the core id alone repeats across packages
+    u32 core_packages[PLATFORM_MAX_LOGICAL_PROCESSORS];
+    u32 core_ids[PLATFORM_MAX_LOGICAL_PROCESSORS];
+    u32 core_threads[PLATFORM_MAX_LOGICAL_PROCESSORS];
+    u32 packages[PLATFORM_MAX_LOGICAL_PROCESSORS];
+    b8 topology_read = TRUE;
+    char path[128];
+
+    for (u32 cpu = 0; cpu < PLATFORM_MAX_LOGICAL_PROCESSORS; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed))
+            continue;
+
+        u32 package_id = 0;
+        u32 core_id = cpu;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", cpu);
+        b8 has_core = linux_read_sysfs_u32(path, &core_id);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", cpu);
+        b8 has_package = linux_read_sysfs_u32(path, &package_id);
+        if (!has_core || !has_package) {
+            topology_read = FALSE;
+            package_id = 0;
+            core_id = cpu;
+        }
+
+        u32 core = 0;
+        while (core < out_info->physical_core_count && (core_packages[core] != package_id || core_ids[core] != core_id))
+            ++core;
+        if (core == out_info->physical_core_count) {
+            core_packages[core] = package_id;
+            core_ids[core] = core_id;
+            core_threads[core] = 0;
+            out_info->physical_core_count++;
+        }
+
+        u32 package = 0;
+        while (package < out_info->package_count && packages[package] != package_id)
+            ++package;
+        if (package == out_info->package_count)
+            packages[out_info->package_count++] = package_id;
+
+        out_info->core[cpu] = (u8)core;
+        out_info->smt_index[cpu] = (u8)core_threads[core]++;
+        out_info->logical_processor_mask |= 1ull << cpu;
+        out_info->logical_processor_count++;
+    }
+
+    if (out_info->logical_processor_count == 0) {
+        out_info->logical_processor_mask = 1;
+        out_info->logical_processor_count = 1;
+        out_info->physical_core_count = 1;
+        out_info->package_count = 1;
+        topology_read = FALSE;
+    }
+
+    char buffer[256];
+    for (u32 node = 0; node < PLATFORM_MAX_LOGICAL_PROCESSORS; ++node) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+        if (!linux_read_sysfs(path, buffer, sizeof(buffer)))
+            continue;
+
+        linux_apply_cpu_list(buffer, (u8)node, out_info);
+        out_info->numa_node_count = node + 1;
+    }
+    if (out_info->numa_node_count == 0)
+        out_info->numa_node_count = 1;
+
+    // Caches of the first usable processor, the others are the same
+    u32 first_cpu = 0;
+    while (!(out_info->logical_processor_mask & (1ull << first_cpu)))
+        ++first_cpu;
+
+    for (u32 index = 0;; ++index) {
+        u32 level = 0;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/level", first_cpu, index);
+        if (!linux_read_sysfs_u32(path, &level))
+            break;
+
+        char type[32];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/type", first_cpu, index);
+        if (!linux_read_sysfs(path, type, sizeof(type)) || strncmp(type, "Instruction", 11) == 0)
+            continue;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/size", first_cpu, index);
+        u64 size = linux_read_sysfs(path, buffer, sizeof(buffer)) ? linux_parse_cache_size(buffer) : 0;
+        if (level == 1)
+            out_info->l1_data_cache_size = size;
+        else if (level == 2)
+            out_info->l2_cache_size = size;
+        else if (level == 3)
+            out_info->l3_cache_size = size;
+
+        u32 line_size = 0;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/coherency_line_size", first_cpu, index);
+        if (out_info->cache_line_size == 0 && linux_read_sysfs_u32(path, &line_size))
+            out_info->cache_line_size = line_size;
+    }
+
+    return topology_read;
+}
+
+b8 platform_mutex_create(platform_mutex* out_mutex) {
+    pthread_mutex_t* mutex = malloc(sizeof(pthread_mutex_t));
+    if (pthread_mutex_init(mutex, 0) != 0) {
+        VERROR("Failed to create mutex");
+        free(mutex);
+        return FALSE;
+    }
+
+    out_mutex->internal_data = mutex;
+    return TRUE;
+}
+
+void platform_mutex_destroy(platform_mutex* mutex) {
+    if (!mutex->internal_data)
+        return;
+
+    pthread_mutex_destroy((pthread_mutex_t*)mutex->internal_data);
+    free(mutex->internal_data);
+    mutex->internal_data = 0;
+}
+
+void platform_mutex_lock(platform_mutex* mutex) {
+    pthread_mutex_lock((pthread_mutex_t*)mutex->internal_data);
+}
+
+b8 platform_mutex_try_lock(platform_mutex* mutex) {
+    return pthread_mutex_trylock((pthread_mutex_t*)mutex->internal_data) == 0;
+}
+
+void platform_mutex_unlock(platform_mutex* mutex) {
+    pthread_mutex_unlock((pthread_mutex_t*)mutex->internal_data);
+}
+
+b8 platform_semaphore_create(u32 initial_count, u32 max_count, platform_semaphore* out_semaphore) {
+    // POSIX semaphores have no maximum, only reject what CreateSemaphore rejects as well
+    if (initial_count > max_count || max_count > SEM_VALUE_MAX) {
+        VERROR("platform_semaphore_create - invalid counts: initial %u, max %u", initial_count, max_count);
+        return FALSE;
+    }
+
+    sem_t* semaphore = malloc(sizeof(sem_t));
+    if (sem_init(semaphore, 0, initial_count) != 0) {
+        VERROR("Failed to create semaphore");
+        free(semaphore);
+        return FALSE;
+    }
+
+    out_semaphore->internal_data = semaphore;
+    return TRUE;
+}
+
+void platform_semaphore_destroy(platform_semaphore* semaphore) {
+    if (!semaphore->internal_data)
+        return;
+
+    sem_destroy((sem_t*)semaphore->internal_data);
+    free(semaphore->internal_data);
+    semaphore->internal_data = 0;
+}
+
+void platform_semaphore_signal(platform_semaphore* semaphore, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        sem_post((sem_t*)semaphore->internal_data);
+    }
+}
+
+b8 platform_semaphore_wait(platform_semaphore* semaphore, u64 timeout_ms) {
+    sem_t* handle = (sem_t*)semaphore->internal_data;
+    i32 result;
+
+    if (timeout_ms == PLATFORM_WAIT_INFINITE) {
+        while ((result = sem_wait(handle)) == -1 && errno == EINTR) {
+        }
+    }
+    else if (timeout_ms == 0) {
+        result = sem_trywait(handle);
+    }
+    else {
+        // sem_timedwait only takes CLOCK_REALTIME deadlines
+        struct timespec deadline;
+        linux_deadline(CLOCK_REALTIME, timeout_ms, &deadline);
+        while ((result = sem_timedwait(handle, &deadline)) == -1 && errno == EINTR) {
+        }
+    }
+
+    return result == 0;
+}
+
+b8 platform_condvar_create(platform_condvar* out_condvar) {
+    pthread_cond_t* condvar = malloc(sizeof(pthread_cond_t));
+
+    // Timed waits measure against the monotonic clock so wall clock changes do not matter
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    i32 result = pthread_cond_init(condvar, &attributes);
+    pthread_condattr_destroy(&attributes);
+
+    if (result != 0) {
+        VERROR("Failed to create condition variable");
+        free(condvar);
+        return FALSE;
+    }
+
+    out_condvar->internal_data = condvar;
+    return TRUE;
+}
+
+void platform_condvar_destroy(platform_condvar* condvar) {
+    if (!condvar->internal_data)
+        return;
+
+    pthread_cond_destroy((pthread_cond_t*)condvar->internal_data);
+    free(condvar->internal_data);
+    condvar->internal_data = 0;
+}
+
+b8 platform_condvar_wait(platform_condvar* condvar, platform_mutex* mutex, u64 timeout_ms) {
+    pthread_cond_t* cond = (pthread_cond_t*)condvar->internal_data;
+    pthread_mutex_t* lock = (pthread_mutex_t*)mutex->internal_data;
+
+    if (timeout_ms == PLATFORM_WAIT_INFINITE)
+        return pthread_cond_wait(cond, lock) == 0;
+
+    struct timespec deadline;
+    linux_deadline(CLOCK_MONOTONIC, timeout_ms, &deadline);
+    return pthread_cond_timedwait(cond, lock, &deadline) == 0;
+}
+
+void platform_condvar_signal(platform_condvar* condvar) {
+    pthread_cond_signal((pthread_cond_t*)condvar->internal_data);
+}
+
+void platform_condvar_broadcast(platform_condvar* condvar) {
+    pthread_cond_broadcast((pthread_cond_t*)condvar->internal_data);
+}
+
+typedef struct linux_fiber {
+    ucontext_t context;
+    // Whole mapping, the guard page included. 0 for converted threads
+    void* mapping;
+    u64 mapping_size;
+    pfn_fiber_start start_function;
+    void* params;
+} linux_fiber;
+
+// makecontext only passes int arguments, so the fiber pointer is split in halves
+static void linux_fiber_entry(u32 low, u32 high) {
+    linux_fiber* fiber = (linux_fiber*)(((u64)high << 32) | (u64)low);
+    fiber->start_function(fiber->params);
+
+    VFATAL("Fiber start function returned");
+    abort();
+}
+
+b8 platform_fiber_convert_thread(platform_fiber* out_fiber) {
+    // The context is filled in by the first switch away from the thread
+    linux_fiber* fiber = malloc(sizeof(linux_fiber));
+    memset(fiber, 0, sizeof(linux_fiber));
+    out_fiber->internal_data = fiber;
+    return TRUE;
+}
+
+void platform_fiber_convert_back(platform_fiber* thread_fiber) {
+    free(thread_fiber->internal_data);
+    thread_fiber->internal_data = 0;
+}
+
+b8 platform_fiber_create(u64 stack_size, pfn_fiber_start start_function, void* params, platform_fiber* out_fiber) {
+    u64 page_size = platform_page_size();
+    u64 usable_size = (stack_size + page_size - 1) & ~(page_size - 1);
+    u64 mapping_size = usable_size + page_size;
+
+    void* mapping = platform_reserve(mapping_size, 0);
+    if (!mapping) {
+        VERROR("Failed to reserve a fiber stack of %llu bytes", mapping_size);
+        return FALSE;
+    }
+
+    // Stacks grow down, the lowest page stays reserved only and is the guard page
+    if (!platform_commit((u8*)mapping + page_size, usable_size)) {
+        VERROR("Failed to commit a fiber stack of %llu bytes", usable_size);
+        platform_release(mapping, mapping_size, 0);
+        return FALSE;
+    }
+
+    linux_fiber* fiber = malloc(sizeof(linux_fiber));
+    memset(fiber, 0, sizeof(linux_fiber));
+    fiber->mapping = mapping;
+    fiber->mapping_size = mapping_size;
+    fiber->start_function = start_function;
+    fiber->params = params;
+
+    getcontext(&fiber->context);
+    fiber->context.uc_stack.ss_sp = (u8*)mapping + page_size;
+    fiber->context.uc_stack.ss_size = usable_size;
+    fiber->context.uc_link = 0;
+    makecontext(&fiber->context, (void (*)(void))linux_fiber_entry, 2,
+        (u32)((u64)fiber & 0xFFFFFFFF), (u32)((u64)fiber >> 32));
+
+    out_fiber->internal_data = fiber;
+    return TRUE;
+}
+
+void platform_fiber_destroy(platform_fiber* fiber) {
+    linux_fiber* internal = (linux_fiber*)fiber->internal_data;
+    if (!internal)
+        return;
+
+    if (internal->mapping)
+        platform_release(internal->mapping, internal->mapping_size, 0);
+    free(internal);
+    fiber->internal_data = 0;
+}
+
+void platform_fiber_switch(platform_fiber* from, platform_fiber* to) {
+    swapcontext(&((linux_fiber*)from->internal_data)->context, &((linux_fiber*)to->internal_data)->context);
+}
+
+b8 platform_file_map(const char* path, platform_file_map_mode mode, platform_file_mapping* out_mapping) {
+    memset(out_mapping, 0, sizeof(platform_file_mapping));
+
+    i32 fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        VERROR("Failed to open '%s' for mapping: %s", path, strerror(errno));
+        return FALSE;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        VERROR("Failed to query the size of '%s': %s", path, strerror(errno));
+        close(fd);
+        return FALSE;
+    }
+
+    if (info.st_size == 0) {
+        close(fd);
+        return TRUE;
+    }
+
+    i32 protection = mode == PLATFORM_FILE_MAP_COPY_ON_WRITE ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* data = mmap(0, (size_t)info.st_size, protection, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file
+    close(fd);
+    if (data == MAP_FAILED) {
+        VERROR("Failed to map '%s': %s", path, strerror(errno));
+        return FALSE;
+    }
+
+    out_mapping->data = data;
+    out_mapping->size = (u64)info.st_size;
+    return TRUE;
+}
+
+void platform_file_unmap(platform_file_mapping* mapping) {
+    if (mapping->data)
+        munmap(mapping->data, mapping->size);
+    memset(mapping, 0, sizeof(platform_file_mapping));
+}
+
+void platform_file_prefetch(const platform_file_mapping* mapping, u64 offset, u64 size) {
+    if (!mapping->data || offset >= mapping->size)
+        return;
+    if (size > mapping->size - offset)
+        size = mapping->size - offset;
+
+    // madvise wants a page aligned start
+    u64 page_offset = offset & ~(platform_page_size() - 1);
+    madvise((u8*)mapping->data + page_offset, size + (offset - page_offset), MADV_WILLNEED);
+}
+
+// Descriptors are stored biased by one so a zeroed handle is never a valid descriptor
+#define LINUX_FILE_FD(file) ((i32)((i64)(file)->handle - 1))
+
+b8 platform_file_open_read(const char* path, b8 async, platform_file* out_file) {
+    // io_uring reads plain descriptors, queue and blocking reads open the same way
+    (void)async;
+    i32 fd = open(path, O_RDONLY | O_CLOEXEC);
+    out_file->handle = (void*)(i64)(fd + 1);
+    out_file->is_valid = fd >= 0;
+    return out_file->is_valid;
+}
+
+void platform_file_close(platform_file* file) {
+    if (file->is_valid)
+        close(LINUX_FILE_FD(file));
+    file->handle = 0;
+    file->is_valid = FALSE;
+}
+
+b8 platform_file_read_at(platform_file* file, u64 offset, u64 size, void* buffer, u64* out_bytes_read) {
+    u64 total = 0;
+    while (total < size) {
+        ssize_t result = pread(LINUX_FILE_FD(file), (u8*)buffer + total, (size_t)(size - total), (off_t)(offset + total));
+        if (result < 0) {
+            if (errno == EINTR)
+                continue;
+            *out_bytes_read = total;
+            return FALSE;
+        }
+        if (result == 0)
+            break;
+        total += (u64)result;
+    }
+
+    *out_bytes_read = total;
+    return TRUE;
+}
+
+// user_data of the internal operations, reads use their nonzero tags
+#define LINUX_IO_WAKE_TAG 0xFFFFFFFFFFFFFFFFull
+#define LINUX_IO_CANCEL_TAG 0xFFFFFFFFFFFFFFFEull
+
+typedef struct linux_io_queue {
+    i32 ring_fd;
+    // Written to wake the queue, a poll on it is always in flight
+    i32 wake_fd;
+
+    void* sq_mapping;
+    u64 sq_mapping_size;
+    void* cq_mapping;
+    u64 cq_mapping_size;
+    struct io_uring_sqe* sqes;
+    u64 sqes_size;
+
+    volatile u32* sq_head;
+    volatile u32* sq_tail;
+    u32 sq_mask;
+    u32 sq_entries;
+    u32* sq_array;
+    // Entries handed out, published to the kernel through sq_tail once they are filled in
+    u32 sq_local_tail;
+    u32 sq_unsubmitted;
+
+    volatile u32* cq_head;
+    volatile u32* cq_tail;
+    u32 cq_mask;
+    struct io_uring_cqe* cqes;
+} linux_io_queue;
+
+static i32 linux_io_uring_enter(i32 ring_fd, u32 to_submit, u32 min_complete, u32 flags) {
+    return (i32)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, 0, 0);
+}
+
+// Next free submission entry, 0 if the ring is full. The kernel only sees it after linux_io_publish
+static struct io_uring_sqe* linux_io_get_sqe(linux_io_queue* queue) {
+    u32 tail = queue->sq_local_tail;
+    u32 head = __atomic_load_n(queue->sq_head, __ATOMIC_ACQUIRE);
+    if (tail - head >= queue->sq_entries)
+        return 0;
+
+    u32 index = tail & queue->sq_mask;
+    struct io_uring_sqe* sqe = &queue->sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    queue->sq_array[index] = index;
+    queue->sq_local_tail = tail + 1;
+    queue->sq_unsubmitted++;
+    return sqe;
+}
+
+// The kernel reads entries up to the tail once it sees it, so the tail only moves after they are filled in
+static void linux_io_publish(linux_io_queue* queue) {
+    __atomic_store_n(queue->sq_tail, queue->sq_local_tail, __ATOMIC_RELEASE);
+}
+
+// Older kernels set up a ring but reject the opcodes they predate. The probe itself needs 5.6, like IORING_OP_READ
+static b8 linux_io_supports_opcodes(i32 ring_fd) {
+    const u8 required[] = { IORING_OP_READ, IORING_OP_ASYNC_CANCEL, IORING_OP_POLL_ADD };
+    const u32 op_count = 256;
+    u64 probe_size = sizeof(struct io_uring_probe) + op_count * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe* probe = malloc(probe_size);
+    memset(probe, 0, probe_size);
+
+    b8 supported = syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, op_count) == 0;
+    for (u32 i = 0; supported && i < sizeof(required); ++i) {
+        supported = required[i] <= probe->last_op && required[i] < probe->ops_len &&
+            (probe->ops[required[i]].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    free(probe);
+    return supported;
+}
+
+static b8 linux_io_arm_wake(linux_io_queue* queue) {
+    struct io_uring_sqe* sqe = linux_io_get_sqe(queue);
+    if (!sqe)
+        return FALSE;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = queue->wake_fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = LINUX_IO_WAKE_TAG;
+    return TRUE;
+}
+
+b8 platform_io_queue_create(u32 depth, platform_io_queue* out_queue) {
+    out_queue->internal_data = 0;
+
+    // Room for a cancel per read and the wake poll
+    u32 entries = depth * 2 + 1;
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    i32 ring_fd = (i32)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring_fd < 0) {
+        VWARN("io_uring is unavailable: %s", strerror(errno));
+        return FALSE;
+    }
+    if (!linux_io_supports_opcodes(ring_fd)) {
+        VWARN("io_uring lacks the read, cancel or poll operations, a kernel of 5.6 or newer is needed");
+        close(ring_fd);
+        return FALSE;
+    }
+
+    linux_io_queue* queue = malloc(sizeof(linux_io_queue));
+    memset(queue, 0, sizeof(linux_io_queue));
+    queue->ring_fd = ring_fd;
+    queue->wake_fd = -1;
+
+    queue->sq_mapping_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+    queue->cq_mapping_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    b8 single_mapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mapping) {
+        if (queue->cq_mapping_size > queue->sq_mapping_size)
+            queue->sq_mapping_size = queue->cq_mapping_size;
+        queue->cq_mapping_size = queue->sq_mapping_size;
+    }
+
+    queue->sq_mapping = mmap(0, queue->sq_mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    queue->cq_mapping = single_mapping ? queue->sq_mapping
+        : mmap(0, queue->cq_mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    queue->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    queue->sqes = mmap(0, queue->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    queue->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    out_queue->internal_data = queue;
+    if (queue->sq_mapping == MAP_FAILED || queue->cq_mapping == MAP_FAILED || queue->sqes == MAP_FAILED || queue->wake_fd < 0) {
+        VERROR("Failed to set up the io_uring queue: %s", strerror(errno));
+        platform_io_queue_destroy(out_queue);
+        return FALSE;
+    }
+
+    u8* sq = queue->sq_mapping;
+    queue->sq_head = (volatile u32*)(sq + params.sq_off.head);
+    queue->sq_tail = (volatile u32*)(sq + params.sq_off.tail);
+    queue->sq_mask = *(u32*)(sq + params.sq_off.ring_mask);
+    queue->sq_entries = *(u32*)(sq + params.sq_off.ring_entries);
+    queue->sq_array = (u32*)(sq + params.sq_off.array);
+    queue->sq_local_tail = *queue->sq_tail;
+
+    u8* cq = queue->cq_mapping;
+    queue->cq_head = (volatile u32*)(cq + params.cq_off.head);
+    queue->cq_tail = (volatile u32*)(cq + params.cq_off.tail);
+    queue->cq_mask = *(u32*)(cq + params.cq_off.ring_mask);
+    queue->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    linux_io_arm_wake(queue);
+    platform_io_queue_submit(out_queue);
+    return TRUE;
+}
+
+void platform_io_queue_destroy(platform_io_queue* queue) {
+    linux_io_queue* internal = (linux_io_queue*)queue->internal_data;
+    if (!internal)
+        return;
+
+    if (internal->sqes && internal->sqes != MAP_FAILED)
+        munmap(internal->sqes, internal->sqes_size);
+    if (internal->cq_mapping && internal->cq_mapping != MAP_FAILED && internal->cq_mapping != internal->sq_mapping)
+        munmap(internal->cq_mapping, internal->cq_mapping_size);
+    if (internal->sq_mapping && internal->sq_mapping != MAP_FAILED)
+        munmap(internal->sq_mapping, internal->sq_mapping_size);
+    if (internal->wake_fd >= 0)
+        close(internal->wake_fd);
+    close(internal->ring_fd);
+
+    free(internal);
+    queue->internal_data = 0;
+}
+
+b8 platform_io_queue_read(platform_io_queue* queue, platform_file* file, u64 offset, u64 size, void* buffer, u64 tag) {
+    struct io_uring_sqe* sqe = linux_io_get_sqe((linux_io_queue*)queue->internal_data);
+    if (!sqe)
+        return FALSE;
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = LINUX_FILE_FD(file);
+    sqe->off = offset;
+    sqe->addr = (u64)buffer;
+    sqe->len = (u32)size;
+    sqe->user_data = tag;
+    return TRUE;
+}
+
+b8 platform_io_queue_cancel(platform_io_queue* queue, u64 tag) {
+    linux_io_queue* internal = (linux_io_queue*)queue->internal_data;
+    struct io_uring_sqe* sqe = linux_io_get_sqe(internal);
+    if (!sqe) {
+        // Handing the queued entries to the kernel frees their slots
+        platform_io_queue_submit(queue);
+        sqe = linux_io_get_sqe(internal);
+        if (!sqe)
+            return FALSE;
+    }
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = tag;
+    sqe->user_data = LINUX_IO_CANCEL_TAG;
+    return TRUE;
+}
+
+void platform_io_queue_submit(platform_io_queue* queue) {
+    linux_io_queue* internal = (linux_io_queue*)queue->internal_data;
+    linux_io_publish(internal);
+    while (internal->sq_unsubmitted > 0) {
+        i32 submitted = linux_io_uring_enter(internal->ring_fd, internal->sq_unsubmitted, 0, 0);
+        if (submitted < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                continue;
+            VERROR("io_uring submission failed: %s", strerror(errno));
+            return;
+        }
+        internal->sq_unsubmitted -= (u32)submitted;
+    }
+}
+
+u32 platform_io_queue_wait(platform_io_queue* queue, platform_io_completion* out_completions, u32 max_count) {
+    linux_io_queue* internal = (linux_io_queue*)queue->internal_data;
+
+    u32 head = *internal->cq_head;
+    if (head == __atomic_load_n(internal->cq_tail, __ATOMIC_ACQUIRE)) {
+        linux_io_publish(internal);
+        i32 result = linux_io_uring_enter(internal->ring_fd, internal->sq_unsubmitted, 1, IORING_ENTER_GETEVENTS);
+        if (result >= 0)
+            internal->sq_unsubmitted -= (u32)result;
+        else if (errno != EINTR)
+            VERROR("io_uring wait failed: %s", strerror(errno));
+    }
+
+    u32 count = 0;
+    u32 tail = __atomic_load_n(internal->cq_tail, __ATOMIC_ACQUIRE);
+    b8 rearm_wake = FALSE;
+    while (head != tail && count < max_count) {
+        struct io_uring_cqe* cqe = &internal->cqes[head & internal->cq_mask];
+        ++head;
+
+        if (cqe->user_data == LINUX_IO_CANCEL_TAG)
+            continue;
+
+        if (cqe->user_data == LINUX_IO_WAKE_TAG) {
+            // Reset the counter, the poll fired once and has to be armed again
+            u64 value;
+            while (read(internal->wake_fd, &value, sizeof(value)) > 0) {
+            }
+            rearm_wake = TRUE;
+            continue;
+        }
+
+        platform_io_completion* completion = &out_completions[count++];
+        completion->tag = cqe->user_data;
+        completion->bytes = cqe->res > 0 ? (u64)cqe->res : 0;
+        completion->success = cqe->res >= 0;
+        completion->cancelled = cqe->res == -ECANCELED || cqe->res == -EINTR;
+    }
+    // Hands the entries back to the kernel
+    __atomic_store_n(internal->cq_head, head, __ATOMIC_RELEASE);
+
+    if (rearm_wake)
+        linux_io_arm_wake(internal);
+
+    return count;
+}
+
+void platform_io_queue_wake(platform_io_queue* queue) {
+    linux_io_queue* internal = (linux_io_queue*)queue->internal_data;
+    u64 value = 1;
+    ssize_t written = write(internal->wake_fd, &value, sizeof(value));
+    (void)written;
+}
+
+static void linux_signal_handler(int signal_number) {
+    // SIGINT and SIGTERM both ask to quit
+    (void)signal_number;
+    quit_requested = 1;
+}
+
+static xcb_atom_t linux_intern_atom(xcb_connection_t* connection, const char* name) {
+    xcb_intern_atom_cookie_t cookie = xcb_intern_atom(connection, 0, (u16)string_length(name), name);
+    xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply(connection, cookie, 0);
+    if (!reply)
+        return XCB_ATOM_NONE;
+
+    xcb_atom_t atom = reply->atom;
+    free(reply);
+    return atom;
+}
+
+static b8 linux_create_window(internal_state* state, const char* application_name, i32 x, i32 y, i32 width, i32 height) {
+    i32 screen_index = 0;
+    state->connection = xcb_connect(0, &screen_index);
+    if (xcb_connection_has_error(state->connection)) {
+        xcb_disconnect(state->connection);
+        state->connection = 0;
+        return FALSE;
+    }
+
+    const xcb_setup_t* setup = xcb_get_setup(state->connection);
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(setup);
+    for (i32 i = screen_index; i > 0; --i) {
+        xcb_screen_next(&it);
+    }
+    state->screen = it.data;
+
+    // Keyboard mapping, keysym of a key code is the first (unshifted) column of its row
+    state->min_keycode = setup->min_keycode;
+    xcb_get_keyboard_mapping_cookie_t mapping_cookie = xcb_get_keyboard_mapping(
+        state->connection, setup->min_keycode, setup->max_keycode - setup->min_keycode + 1);
+    xcb_get_keyboard_mapping_reply_t* mapping = xcb_get_keyboard_mapping_reply(state->connection, mapping_cookie, 0);
+    if (mapping) {
+        state->keysyms_per_keycode = mapping->keysyms_per_keycode;
+        state->keysym_count = (u32)xcb_get_keyboard_mapping_keysyms_length(mapping);
+        state->keysyms = malloc(sizeof(xcb_keysym_t) * state->keysym_count);
+        memcpy(state->keysyms, xcb_get_keyboard_mapping_keysyms(mapping), sizeof(xcb_keysym_t) * state->keysym_count);
+        free(mapping);
+    }
+
+    state->window = xcb_generate_id(state->connection);
+
+    u32 event_mask = XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK;
+    u32 event_values =
+        XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE |
+        XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE |
+        XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_POINTER_MOTION |
+        XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+    u32 value_list[] = { state->screen->black_pixel, event_values };
+
+    xcb_create_window(
+        state->connection, XCB_COPY_FROM_PARENT, state->window, state->screen->root,
+        (i16)x, (i16)y, (u16)width, (u16)height, 0,
+        XCB_WINDOW_CLASS_INPUT_OUTPUT, state->screen->root_visual,
+        event_mask, value_list);
+
+    xcb_change_property(
+        state->connection, XCB_PROP_MODE_REPLACE, state->window,
+        XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8,
+        (u32)string_length(application_name), application_name);
+
+    // Ask the window manager to send a message instead of killing the connection on close
+    state->wm_protocols = linux_intern_atom(state->connection, "WM_PROTOCOLS");
+    state->wm_delete_window = linux_intern_atom(state->connection, "WM_DELETE_WINDOW");
+    xcb_change_property(
+        state->connection, XCB_PROP_MODE_REPLACE, state->window,
+        state->wm_protocols, XCB_ATOM_ATOM, 32, 1, &state->wm_delete_window);
+
+    xcb_map_window(state->connection, state->window);
+
+    if (xcb_flush(state->connection) <= 0) {
+        VERROR("Failed to flush the xcb connection");
+        xcb_destroy_window(state->connection, state->window);
+        xcb_disconnect(state->connection);
+        state->window = 0;
+        state->connection = 0;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void linux_process_event(internal_state* state, xcb_generic_event_t* event) {
+    // The high bit marks events sent by other clients
+    switch (event->response_type & ~0x80) {
+    case XCB_KEY_PRESS:
+    case XCB_KEY_RELEASE: {
+        xcb_key_press_event_t* key_event = (xcb_key_press_event_t*)event;
+        b8 pressed = (event->response_type & ~0x80) == XCB_KEY_PRESS;
+
+        u32 index = (u32)(key_event->detail - state->min_keycode) * state->keysyms_per_keycode;
+        if (!state->keysyms || index >= state->keysym_count)
+            break;
+
+        keys key = translate_keysym(state->keysyms[index]);
+        if (key != 0)
+            input_process_key(key, pressed);
+    } break;
+    case XCB_BUTTON_PRESS:
+    case XCB_BUTTON_RELEASE: {
+        xcb_button_press_event_t* button_event = (xcb_button_press_event_t*)event;
+        b8 pressed = (event->response_type & ~0x80) == XCB_BUTTON_PRESS;
+
+        switch (button_event->detail) {
+        case XCB_BUTTON_INDEX_1:
+            input_process_button(MB_LEFT, pressed);
+            break;
+        case XCB_BUTTON_INDEX_2:
+            input_process_button(MB_MIDDLE, pressed);
+            break;
+        case XCB_BUTTON_INDEX_3:
+            input_process_button(MB_RIGHT, pressed);
+            break;
+        // X11 reports the wheel as buttons 4 and 5
+        case XCB_BUTTON_INDEX_4:
+            if (pressed)
+                input_process_mouse_wheel(1);
+            break;
+        case XCB_BUTTON_INDEX_5:
+            if (pressed)
+                input_process_mouse_wheel(-1);
+            break;
+        }
+    } break;
+    case XCB_MOTION_NOTIFY: {
+        xcb_motion_notify_event_t* motion_event = (xcb_motion_notify_event_t*)event;
+        input_process_mouse_move(motion_event->event_x, motion_event->event_y);
+    } break;
+    case XCB_CONFIGURE_NOTIFY: {
+        // Also sent on moves, only forward actual size changes
+        xcb_configure_notify_event_t* configure_event = (xcb_configure_notify_event_t*)event;
+        if (configure_event->width != state->width || configure_event->height != state->height) {
+            state->width = configure_event->width;
+            state->height = configure_event->height;
+
+            event_context context;
+            context.data.u16[0] = state->width;
+            context.data.u16[1] = state->height;
+            event_fire(EVENT_CODE_RESIZED, 0, context);
+        }
+    } break;
+    case XCB_CLIENT_MESSAGE: {
+        xcb_client_message_event_t* client_message = (xcb_client_message_event_t*)event;
+        if (client_message->data.data32[0] == state->wm_delete_window) {
+            event_context context = { 0 };
+            event_fire(EVENT_CODE_APPLICATION_QUIT, 0, context);
+        }
+    } break;
+    default:
+        break;
+    }
+}
+
+static keys translate_keysym(xcb_keysym_t keysym) {
+    // Letters and digits share their ASCII values with the key codes
+    if (keysym >= XK_a && keysym <= XK_z)
+        return (keys)(KEY_A + (keysym - XK_a));
+    if (keysym >= XK_A && keysym <= XK_Z)
+        return (keys)(KEY_A + (keysym - XK_A));
+    if (keysym >= XK_0 && keysym <= XK_9)
+        return (keys)(KEY_ZERO + (keysym - XK_0));
+    if (keysym >= XK_F1 && keysym <= XK_F24)
+        return (keys)(KEY_F1 + (keysym - XK_F1));
+    if (keysym >= XK_KP_0 && keysym <= XK_KP_9)
+        return (keys)(KEY_NUMPAD_ZERO + (keysym - XK_KP_0));
+
+    switch (keysym) {
+    case XK_BackSpace: return KEY_BACK;
+    case XK_Tab: return KEY_TAB;
+    case XK_Clear: return KEY_CLEAR;
+    case XK_Return: return KEY_ENTER;
+    case XK_KP_Enter: return KEY_ENTER;
+    case XK_Pause: return KEY_PAUSE;
+    case XK_Caps_Lock: return KEY_CAPS;
+    case XK_Escape: return KEY_ESCAPE;
+    case XK_space: return KEY_SPACE;
+    case XK_Prior: return KEY_PAGE_UP;
+    case XK_Next: return KEY_PAGE_DOWN;
+    case XK_End: return KEY_END;
+    case XK_Home: return KEY_HOME;
+    case XK_Left: return KEY_LEFT_ARR;
+    case XK_Up: return KEY_UP_ARR;
+    case XK_Right: return KEY_RIGHT_ARR;
+    case XK_Down: return KEY_DOWN_ARR;
+    case XK_Select: return KEY_SELECT;
+    case XK_Print: return KEY_PRINT;
+    case XK_Insert: return KEY_INSERT;
+    case XK_Delete: return KEY_DELETE;
+    case XK_Super_L: return KEY_LWIN;
+    case XK_Super_R: return KEY_RWIN;
+    case XK_Menu: return KEY_APPS;
+    case XK_KP_Multiply: return KEY_MULTIPLY;
+    case XK_KP_Add: return KEY_ADD;
+    case XK_KP_Separator: return KEY_SEPARATOR;
+    case XK_KP_Subtract: return KEY_SUBTRACT;
+    case XK_KP_Decimal: return KEY_DECIMAL;
+    case XK_KP_Divide: return KEY_DIVIDE;
+    case XK_Num_Lock: return KEY_NUMLOCK;
+    case XK_Scroll_Lock: return KEY_SCROLL;
+    case XK_Shift_L: return KEY_LSHIFT;
+    case XK_Shift_R: return KEY_RSHIFT;
+    case XK_Control_L: return KEY_LCONTROL;
+    case XK_Control_R: return KEY_RCONTROL;
+    case XK_Alt_L: return KEY_ALT;
+    case XK_Alt_R: return KEY_ALT;
+    // Not mapped, no key code is 0
+    default: return 0;
+    }
+}
+
+#endif
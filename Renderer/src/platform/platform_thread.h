@@ -0,0 +1,217 @@
+#pragma once
+
+#include "defines.h"
+
+// Timeout value that waits until the object is signaled
+#define PLATFORM_WAIT_INFINITE 0xFFFFFFFFFFFFFFFFull
+
+// Logical processors described by platform_cpu_info, matches the width of the affinity masks
+#define PLATFORM_MAX_LOGICAL_PROCESSORS 64
+
+/*
+* Entry point of a thread.
+*
+* @param params - The user data given at creation
+* @return u32 - The exit code of the thread
+*/
+typedef u32 (*pfn_thread_start)(void* params);
+
+typedef enum platform_thread_priority {
+    PLATFORM_THREAD_PRIORITY_LOW,
+    PLATFORM_THREAD_PRIORITY_NORMAL,
+    PLATFORM_THREAD_PRIORITY_HIGH,
+    PLATFORM_THREAD_PRIORITY_TIME_CRITICAL
+} platform_thread_priority;
+
+// Handles wrap platform specific objects that are allocated by the create functions
+typedef struct platform_thread {
+    void* internal_data;
+    u64 thread_id;
+} platform_thread;
+
+typedef struct platform_mutex {
+    void* internal_data;
+} platform_mutex;
+
+typedef struct platform_semaphore {
+    void* internal_data;
+} platform_semaphore;
+
+typedef struct platform_condvar {
+    void* internal_data;
+} platform_condvar;
+
+/*
+* Creates and starts a thread.
+*
+* @param start_function - The function the thread runs
+* @param params - User data passed to start_function
+* @param name - Name shown in debuggers and profilers, may be 0. Truncated to 15 characters on Linux
+* @param out_thread - The created thread
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+VAPI b8 platform_thread_create(pfn_thread_start start_function, void* params, const char* name, platform_thread* out_thread);
+
+/*
+* Waits for the thread to finish and releases its resources.
+*
+* @param thread - The thread to join
+* @return u32 - The exit code of the thread
+*/
+VAPI u32 platform_thread_join(platform_thread* thread);
+
+/*
+* Restricts the thread to a set of logical processors.
+*
+* @param thread - The thread, 0 for the calling thread
+* @param affinity_mask - Bit i allows logical processor i
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+VAPI b8 platform_thread_set_affinity(platform_thread* thread, u64 affinity_mask);
+
+/*
+* Changes the scheduling priority of the thread. On Linux this adjusts the nice
+* value of the thread, raising it above normal usually requires privileges.
+*
+* @param thread - The thread, 0 for the calling thread
+* @param priority - The new priority
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+VAPI b8 platform_thread_set_priority(platform_thread* thread, platform_thread_priority priority);
+
+/*
+* Names the calling thread. Used for the main thread, which is not created through platform_thread_create.
+*
+* @param name - The name of the thread
+*/
+VAPI void platform_thread_set_current_name(const char* name);
+
+/*
+* @return u64 - Platform identifier of the calling thread
+*/
+VAPI u64 platform_thread_current_id();
+
+/*
+* @return u32 - Index of the logical processor the calling thread runs on right now,
+* as used by platform_cpu_info, or PLATFORM_MAX_LOGICAL_PROCESSORS if it is not known
+*/
+VAPI u32 platform_thread_current_processor();
+
+/*
+* Gives up the rest of the time slice of the calling thread.
+*/
+VAPI void platform_thread_yield();
+
+/*
+* @return u32 - The amount of logical processors available
+*/
+VAPI u32 platform_get_processor_count();
+
+/*
+* Topology of the processors the process may run on.
+* Logical processors beyond PLATFORM_MAX_LOGICAL_PROCESSORS are left out.
+* Cache sizes are in bytes, 0 if unknown.
+*/
+typedef struct platform_cpu_info {
+    // Bit i is set for every logical processor i the process may run on
+    u64 logical_processor_mask;
+    u32 logical_processor_count;
+    u32 physical_core_count;
+    u32 package_count;
+    u32 numa_node_count;
+
+    u32 cache_line_size;
+    u64 l1_data_cache_size;
+    u64 l2_cache_size;
+    u64 l3_cache_size;
+
+    // Per logical processor: its dense physical core index, which hardware thread of
+    // the core it is (0 for the first) and its NUMA node
+    u8 core[PLATFORM_MAX_LOGICAL_PROCESSORS];
+    u8 smt_index[PLATFORM_MAX_LOGICAL_PROCESSORS];
+    u8 numa_node[PLATFORM_MAX_LOGICAL_PROCESSORS];
+} platform_cpu_info;
+
+/*
+* Reads the processor topology. Read from sysfs on Linux and from
+* GetLogicalProcessorInformationEx (processor group 0) on Windows.
+* If the topology is not available every logical processor is reported as its own core.
+*
+* @param out_info - The topology
+* @return b8 - TRUE if the topology was read, FALSE if the fallback was used
+*/
+VAPI b8 platform_get_cpu_info(platform_cpu_info* out_info);
+
+/*
+* Creates a non recursive mutex.
+*
+* @param out_mutex - The created mutex
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+VAPI b8 platform_mutex_create(platform_mutex* out_mutex);
+
+VAPI void platform_mutex_destroy(platform_mutex* mutex);
+
+VAPI void platform_mutex_lock(platform_mutex* mutex);
+
+/*
+* @return b8 - TRUE if the mutex was acquired, FALSE if it is held by another thread
+*/
+VAPI b8 platform_mutex_try_lock(platform_mutex* mutex);
+
+VAPI void platform_mutex_unlock(platform_mutex* mutex);
+
+/*
+* Creates a counting semaphore.
+*
+* @param initial_count - The count the semaphore starts with
+* @param max_count - The highest count the semaphore can reach (only enforced on Windows)
+* @param out_semaphore - The created semaphore
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+VAPI b8 platform_semaphore_create(u32 initial_count, u32 max_count, platform_semaphore* out_semaphore);
+
+VAPI void platform_semaphore_destroy(platform_semaphore* semaphore);
+
+/*
+* Increments the count of the semaphore, waking up to count waiting threads.
+*
+* @param semaphore - The semaphore
+* @param count - Amount to add to the count
+*/
+VAPI void platform_semaphore_signal(platform_semaphore* semaphore, u32 count);
+
+/*
+* Waits until the count is above zero and decrements it.
+*
+* @param semaphore - The semaphore
+* @param timeout_ms - Milliseconds to wait at most, PLATFORM_WAIT_INFINITE to wait forever
+* @return b8 - TRUE if the semaphore was acquired, FALSE on timeout
+*/
+VAPI b8 platform_semaphore_wait(platform_semaphore* semaphore, u64 timeout_ms);
+
+VAPI b8 platform_condvar_create(platform_condvar* out_condvar);
+
+VAPI void platform_condvar_destroy(platform_condvar* condvar);
+
+/*
+* Atomically unlocks the mutex and waits for the condition variable to be signaled.
+* The mutex is locked again before returning. Wake ups can be spurious, so the
+* condition has to be checked in a loop.
+*
+* @param condvar - The condition variable
+* @param mutex - The mutex held by the calling thread
+* @param timeout_ms - Milliseconds to wait at most, PLATFORM_WAIT_INFINITE to wait forever
+* @return b8 - TRUE if woken up, FALSE on timeout
+*/
+VAPI b8 platform_condvar_wait(platform_condvar* condvar, platform_mutex* mutex, u64 timeout_ms);
+
+/*
+* Wakes up one waiting thread.
+*/
+VAPI void platform_condvar_signal(platform_condvar* condvar);
+
+/*
+* Wakes up all waiting threads.
+*/
+VAPI void platform_condvar_broadcast(platform_condvar* condvar);
@@ -1,4 +1,8 @@
 #include "platform.h"
+#include "platform_thread.h"
+#include "platform_fiber.h"
+#include "platform_file.h"
+#include "platform_io_queue.h"
 
 // Conditional compilation
 #if R_PLATFORM_WINDOWS
@@ -37,7 +41,12 @@ b8 platform_startup(
     i32 x,
     i32 y,
     i32 width,
-    i32 height) {
+    i32 height,
+    b8 headless) {
+
+    if (headless) {
+        VWARN("Headless mode is not supported on Windows. Creating a window instead");
+    }
 
     plat_state->internal_state = malloc(sizeof(internal_state));
     internal_state* state = (internal_state*)plat_state->internal_state;
@@ -153,6 +162,75 @@ void platform_free(void* block, b8 aligned) {
     free(block);
 }
 
+// Large pages need SeLockMemoryPrivilege, which has to be enabled on the process token once
+static b8 win32_enable_large_pages() {
+    static b8 tried = FALSE;
+    static b8 enabled = FALSE;
+    if (tried)
+        return enabled;
+    tried = TRUE;
+
+    HANDLE token;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+        return FALSE;
+
+    TOKEN_PRIVILEGES privileges;
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    if (LookupPrivilegeValueA(0, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid)) {
+        // Succeeds without assigning anything when the account lacks the privilege
+        AdjustTokenPrivileges(token, FALSE, &privileges, 0, 0, 0);
+        enabled = GetLastError() == ERROR_SUCCESS;
+    }
+
+    CloseHandle(token);
+    if (!enabled)
+        VWARN("Large pages are unavailable, the account lacks the 'Lock pages in memory' right");
+    return enabled;
+}
+
+void* platform_reserve(u64 size, u32 flags) {
+    u64 large_page_size = platform_large_page_size();
+    if ((flags & PLATFORM_PAGE_FLAG_LARGE) && large_page_size && win32_enable_large_pages()) {
+        // MEM_LARGE_PAGES needs a whole number of large pages
+        size = (size + large_page_size - 1) & ~(large_page_size - 1);
+        void* block = VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (block)
+            return block;
+    }
+
+    return VirtualAlloc(0, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+b8 platform_commit(void* address, u64 size) {
+    if (VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE))
+        return TRUE;
+
+    // Large page ranges are committed at reservation
+    MEMORY_BASIC_INFORMATION info;
+    return VirtualQuery(address, &info, sizeof(info)) && info.State == MEM_COMMIT;
+}
+
+void platform_decommit(void* address, u64 size) {
+    // Fails for large page ranges, they stay committed until released
+    VirtualFree(address, size, MEM_DECOMMIT);
+}
+
+void platform_release(void* address, u64 size, u32 flags) {
+    if (address)
+        VirtualFree(address, 0, MEM_RELEASE);
+}
+
+u64 platform_page_size() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (u64)info.dwPageSize;
+}
+
+u64 platform_large_page_size() {
+    return (u64)GetLargePageMinimum();
+}
+
 void* platform_zero_memory(void* block, u64 size) {
     return memset(block, 0, size);
 }
@@ -226,6 +304,638 @@ b8 platform_create_vulkan_surface(struct platform_state* plat_state, struct vulk
     return TRUE;
 }
 
+typedef struct win32_thread {
+    HANDLE handle;
+    pfn_thread_start start_function;
+    void* params;
+} win32_thread;
+
+b8 platform_file_map(const char* path, platform_file_map_mode mode, platform_file_mapping* out_mapping) {
+    memset(out_mapping, 0, sizeof(platform_file_mapping));
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE) {
+        VERROR("Failed to open '%s' for mapping (error %lu)", path, GetLastError());
+        return FALSE;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        VERROR("Failed to query the size of '%s' (error %lu)", path, GetLastError());
+        CloseHandle(file);
+        return FALSE;
+    }
+
+    if (size.QuadPart == 0) {
+        CloseHandle(file);
+        return TRUE;
+    }
+
+    b8 copy_on_write = mode == PLATFORM_FILE_MAP_COPY_ON_WRITE;
+    HANDLE section = CreateFileMappingA(file, 0, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, 0);
+    CloseHandle(file);
+    if (!section) {
+        VERROR("Failed to create a mapping of '%s' (error %lu)", path, GetLastError());
+        return FALSE;
+    }
+
+    // The view keeps the section and the file alive
+    void* data = MapViewOfFile(section, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(section);
+    if (!data) {
+        VERROR("Failed to map '%s' (error %lu)", path, GetLastError());
+        return FALSE;
+    }
+
+    out_mapping->data = data;
+    out_mapping->size = (u64)size.QuadPart;
+    return TRUE;
+}
+
+void platform_file_unmap(platform_file_mapping* mapping) {
+    if (mapping->data)
+        UnmapViewOfFile(mapping->data);
+    memset(mapping, 0, sizeof(platform_file_mapping));
+}
+
+// PrefetchVirtualMemory only exists since Windows 8, so it is looked up at runtime
+typedef struct win32_memory_range {
+    PVOID address;
+    SIZE_T size;
+} win32_memory_range;
+typedef BOOL(WINAPI* pfn_prefetch_virtual_memory)(HANDLE process, ULONG_PTR count, win32_memory_range* ranges, ULONG flags);
+
+void platform_file_prefetch(const platform_file_mapping* mapping, u64 offset, u64 size) {
+    static pfn_prefetch_virtual_memory prefetch_virtual_memory = 0;
+    static b8 looked_up = FALSE;
+    if (!looked_up) {
+        prefetch_virtual_memory = (pfn_prefetch_virtual_memory)GetProcAddress(GetModuleHandleA("kernel32.dll"), "PrefetchVirtualMemory");
+        looked_up = TRUE;
+    }
+
+    if (!prefetch_virtual_memory || !mapping->data || offset >= mapping->size)
+        return;
+    if (size > mapping->size - offset)
+        size = mapping->size - offset;
+
+    win32_memory_range range = { (u8*)mapping->data + offset, (SIZE_T)size };
+    prefetch_virtual_memory(GetCurrentProcess(), 1, &range, 0);
+}
+
+b8 platform_file_open_read(const char* path, b8 async, platform_file* out_file) {
+    DWORD flags = FILE_ATTRIBUTE_NORMAL | (async ? FILE_FLAG_OVERLAPPED : 0);
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, flags, 0);
+    out_file->handle = file;
+    out_file->is_valid = file != INVALID_HANDLE_VALUE;
+    return out_file->is_valid;
+}
+
+void platform_file_close(platform_file* file) {
+    if (file->is_valid)
+        CloseHandle((HANDLE)file->handle);
+    file->handle = 0;
+    file->is_valid = FALSE;
+}
+
+b8 platform_file_read_at(platform_file* file, u64 offset, u64 size, void* buffer, u64* out_bytes_read) {
+    u64 total = 0;
+    while (total < size) {
+        u64 remaining = size - total;
+        DWORD chunk = remaining > 0x40000000ull ? 0x40000000u : (DWORD)remaining;
+
+        // The offset of a synchronous read can be given through an OVERLAPPED as well
+        OVERLAPPED overlapped;
+        memset(&overlapped, 0, sizeof(overlapped));
+        overlapped.Offset = (DWORD)(offset + total);
+        overlapped.OffsetHigh = (DWORD)((offset + total) >> 32);
+
+        DWORD read = 0;
+        if (!ReadFile((HANDLE)file->handle, (u8*)buffer + total, chunk, &read, &overlapped)) {
+            if (GetLastError() == ERROR_HANDLE_EOF)
+                break;
+            *out_bytes_read = total;
+            return FALSE;
+        }
+        if (read == 0)
+            break;
+        total += read;
+    }
+
+    *out_bytes_read = total;
+    return TRUE;
+}
+
+// Completion key of the packets posted to wake the queue
+#define WIN32_IO_WAKE_KEY 1
+// NTSTATUS values found in OVERLAPPED_ENTRY::Internal
+#define WIN32_STATUS_END_OF_FILE 0xC0000011L
+#define WIN32_STATUS_CANCELLED 0xC0000120L
+
+typedef struct win32_io_operation {
+    OVERLAPPED overlapped;
+    u64 tag;
+    HANDLE file;
+    // Set when ReadFile failed right away, the completion is posted by hand
+    DWORD error;
+    struct win32_io_operation* next;
+} win32_io_operation;
+
+typedef struct win32_io_queue {
+    HANDLE port;
+    // Reads in flight, so cancels can find them by tag
+    win32_io_operation* operations;
+} win32_io_queue;
+
+b8 platform_io_queue_create(u32 depth, platform_io_queue* out_queue) {
+    HANDLE port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, 0, 0, 1);
+    if (!port) {
+        VWARN("Failed to create an I/O completion port (error %lu)", GetLastError());
+        out_queue->internal_data = 0;
+        return FALSE;
+    }
+
+    win32_io_queue* queue = malloc(sizeof(win32_io_queue));
+    memset(queue, 0, sizeof(win32_io_queue));
+    queue->port = port;
+    out_queue->internal_data = queue;
+    return TRUE;
+}
+
+void platform_io_queue_destroy(platform_io_queue* queue) {
+    win32_io_queue* internal = (win32_io_queue*)queue->internal_data;
+    if (!internal)
+        return;
+
+    while (internal->operations) {
+        win32_io_operation* operation = internal->operations;
+        internal->operations = operation->next;
+        free(operation);
+    }
+    CloseHandle(internal->port);
+    free(internal);
+    queue->internal_data = 0;
+}
+
+b8 platform_io_queue_read(platform_io_queue* queue, platform_file* file, u64 offset, u64 size, void* buffer, u64 tag) {
+    win32_io_queue* internal = (win32_io_queue*)queue->internal_data;
+    HANDLE handle = (HANDLE)file->handle;
+
+    // A handle can only be bound to a port once, later reads of the same file fail with ERROR_INVALID_PARAMETER
+    if (!CreateIoCompletionPort(handle, internal->port, 0, 0) && GetLastError() != ERROR_INVALID_PARAMETER)
+        return FALSE;
+
+    win32_io_operation* operation = malloc(sizeof(win32_io_operation));
+    memset(operation, 0, sizeof(win32_io_operation));
+    operation->overlapped.Offset = (DWORD)offset;
+    operation->overlapped.OffsetHigh = (DWORD)(offset >> 32);
+    operation->tag = tag;
+    operation->file = handle;
+
+    if (!ReadFile(handle, buffer, (DWORD)size, 0, &operation->overlapped)) {
+        DWORD error = GetLastError();
+        if (error != ERROR_IO_PENDING) {
+            // No packet is queued for reads that fail immediately
+            operation->error = error;
+            PostQueuedCompletionStatus(internal->port, 0, 0, &operation->overlapped);
+        }
+    }
+
+    operation->next = internal->operations;
+    internal->operations = operation;
+    return TRUE;
+}
+
+b8 platform_io_queue_cancel(platform_io_queue* queue, u64 tag) {
+    win32_io_queue* internal = (win32_io_queue*)queue->internal_data;
+    for (win32_io_operation* operation = internal->operations; operation; operation = operation->next) {
+        if (operation->tag == tag) {
+            CancelIoEx(operation->file, &operation->overlapped);
+            return TRUE;
+        }
+    }
+    return TRUE;
+}
+
+void platform_io_queue_submit(platform_io_queue* queue) {
+    // ReadFile already started the reads
+}
+
+u32 platform_io_queue_wait(platform_io_queue* queue, platform_io_completion* out_completions, u32 max_count) {
+    win32_io_queue* internal = (win32_io_queue*)queue->internal_data;
+
+    OVERLAPPED_ENTRY entries[64];
+    ULONG entry_count = 0;
+    if (max_count > 64)
+        max_count = 64;
+    if (!GetQueuedCompletionStatusEx(internal->port, entries, max_count, &entry_count, INFINITE, FALSE))
+        return 0;
+
+    u32 count = 0;
+    for (ULONG i = 0; i < entry_count; ++i) {
+        if (entries[i].lpCompletionKey == WIN32_IO_WAKE_KEY)
+            continue;
+
+        win32_io_operation* operation = CONTAINING_RECORD(entries[i].lpOverlapped, win32_io_operation, overlapped);
+        LONG status = (LONG)entries[i].Internal;
+
+        platform_io_completion* completion = &out_completions[count++];
+        completion->tag = operation->tag;
+        completion->bytes = entries[i].dwNumberOfBytesTransferred;
+        completion->cancelled = status == WIN32_STATUS_CANCELLED;
+        // Reading at or past the end is not an error, it reads nothing
+        completion->success = operation->error == 0 && (status >= 0 || status == WIN32_STATUS_END_OF_FILE);
+        if (operation->error == ERROR_HANDLE_EOF)
+            completion->success = TRUE;
+
+        win32_io_operation** link = &internal->operations;
+        while (*link != operation)
+            link = &(*link)->next;
+        *link = operation->next;
+        free(operation);
+    }
+
+    return count;
+}
+
+void platform_io_queue_wake(platform_io_queue* queue) {
+    win32_io_queue* internal = (win32_io_queue*)queue->internal_data;
+    PostQueuedCompletionStatus(internal->port, 0, WIN32_IO_WAKE_KEY, 0);
+}
+
+// SetThreadDescription only exists since Windows 10 1607, so it is looked up at runtime
+typedef HRESULT(WINAPI* pfn_set_thread_description)(HANDLE thread, PCWSTR description);
+
+static void win32_set_thread_name(HANDLE thread, const char* name) {
+    static pfn_set_thread_description set_thread_description = 0;
+    static b8 looked_up = FALSE;
+    if (!looked_up) {
+        set_thread_description = (pfn_set_thread_description)GetProcAddress(GetModuleHandleA("kernel32.dll"), "SetThreadDescription");
+        looked_up = TRUE;
+    }
+
+    if (!set_thread_description || !name)
+        return;
+
+    WCHAR wide_name[64];
+    if (MultiByteToWideChar(CP_UTF8, 0, name, -1, wide_name, 64) > 0)
+        set_thread_description(thread, wide_name);
+}
+
+static DWORD WINAPI win32_thread_start(LPVOID arg) {
+    win32_thread* thread = (win32_thread*)arg;
+    return (DWORD)thread->start_function(thread->params);
+}
+
+// Waits longer than 49 days are treated as infinite
+static DWORD win32_timeout(u64 timeout_ms) {
+    if (timeout_ms >= INFINITE)
+        return INFINITE;
+    return (DWORD)timeout_ms;
+}
+
+b8 platform_thread_create(pfn_thread_start start_function, void* params, const char* name, platform_thread* out_thread) {
+    win32_thread* thread = malloc(sizeof(win32_thread));
+    thread->start_function = start_function;
+    thread->params = params;
+
+    DWORD thread_id = 0;
+    thread->handle = CreateThread(0, 0, win32_thread_start, thread, 0, &thread_id);
+    if (!thread->handle) {
+        VERROR("Failed to create thread '%s'", name ? name : "");
+        free(thread);
+        return FALSE;
+    }
+
+    win32_set_thread_name(thread->handle, name);
+
+    out_thread->internal_data = thread;
+    out_thread->thread_id = (u64)thread_id;
+    return TRUE;
+}
+
+u32 platform_thread_join(platform_thread* thread) {
+    win32_thread* internal = (win32_thread*)thread->internal_data;
+    if (!internal)
+        return 0;
+
+    WaitForSingleObject(internal->handle, INFINITE);
+    DWORD exit_code = 0;
+    GetExitCodeThread(internal->handle, &exit_code);
+    CloseHandle(internal->handle);
+    free(internal);
+    thread->internal_data = 0;
+    thread->thread_id = 0;
+    return (u32)exit_code;
+}
+
+b8 platform_thread_set_affinity(platform_thread* thread, u64 affinity_mask) {
+    HANDLE handle = thread ? ((win32_thread*)thread->internal_data)->handle : GetCurrentThread();
+    return SetThreadAffinityMask(handle, (DWORD_PTR)affinity_mask) != 0;
+}
+
+b8 platform_thread_set_priority(platform_thread* thread, platform_thread_priority priority) {
+    static const i32 priorities[] = {
+        THREAD_PRIORITY_BELOW_NORMAL,
+        THREAD_PRIORITY_NORMAL,
+        THREAD_PRIORITY_HIGHEST,
+        THREAD_PRIORITY_TIME_CRITICAL
+    };
+    HANDLE handle = thread ? ((win32_thread*)thread->internal_data)->handle : GetCurrentThread();
+    return SetThreadPriority(handle, priorities[priority]) != 0;
+}
+
+void platform_thread_set_current_name(const char* name) {
+    win32_set_thread_name(GetCurrentThread(), name);
+}
+
+u64 platform_thread_current_id() {
+    return (u64)GetCurrentThreadId();
+}
+
+u32 platform_thread_current_processor() {
+    // The topology only covers processor group 0
+    PROCESSOR_NUMBER number;
+    GetCurrentProcessorNumberEx(&number);
+    return number.Group == 0 && number.Number < PLATFORM_MAX_LOGICAL_PROCESSORS ? (u32)number.Number : PLATFORM_MAX_LOGICAL_PROCESSORS;
+}
+
+void platform_thread_yield() {
+    SwitchToThread();
+}
+
+u32 platform_get_processor_count() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (u32)info.dwNumberOfProcessors;
+}
+
+// Every usable logical processor as its own core, used when the topology cannot be read
+static void win32_cpu_info_fallback(platform_cpu_info* out_info) {
+    memset(out_info, 0, sizeof(platform_cpu_info));
+    u32 count = platform_get_processor_count();
+    if (count > PLATFORM_MAX_LOGICAL_PROCESSORS)
+        count = PLATFORM_MAX_LOGICAL_PROCESSORS;
+
+    for (u32 i = 0; i < count; ++i) {
+        out_info->core[i] = (u8)i;
+        out_info->logical_processor_mask |= 1ull << i;
+    }
+    out_info->logical_processor_count = count;
+    out_info->physical_core_count = count;
+    out_info->package_count = 1;
+    out_info->numa_node_count = 1;
+}
+
+b8 platform_get_cpu_info(platform_cpu_info* out_info) {
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, 0, &length);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || length == 0) {
+        win32_cpu_info_fallback(out_info);
+        return FALSE;
+    }
+
+    u8* buffer = malloc(length);
+    if (!GetLogicalProcessorInformationEx(RelationAll, (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)buffer, &length)) {
+        free(buffer);
+        win32_cpu_info_fallback(out_info);
+        return FALSE;
+    }
+
+    DWORD_PTR process_mask = 0;
+    DWORD_PTR system_mask = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask))
+        process_mask = (DWORD_PTR)-1;
+
+    memset(out_info, 0, sizeof(platform_cpu_info));
+
+    // Only processor group 0 is described, its masks fit the 64 bit affinity masks
+    for (DWORD offset = 0; offset < length;) {
+        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* entry = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)(buffer + offset);
+        offset += entry->Size;
+
+        switch (entry->Relationship) {
+        case RelationProcessorCore: {
+            if (entry->Processor.GroupMask[0].Group != 0)
+                break;
+
+            u64 mask = (u64)(entry->Processor.GroupMask[0].Mask & process_mask);
+            if (mask == 0)
+                break;
+
+            u32 core = out_info->physical_core_count++;
+            u32 smt_index = 0;
+            for (u32 i = 0; i < PLATFORM_MAX_LOGICAL_PROCESSORS; ++i) {
+                if (!(mask & (1ull << i)))
+                    continue;
+                out_info->core[i] = (u8)core;
+                out_info->smt_index[i] = (u8)smt_index++;
+            }
+            out_info->logical_processor_mask |= mask;
+        } break;
+
+        case RelationProcessorPackage:
+            out_info->package_count++;
+            break;
+
+        case RelationNumaNode: {
+            if (entry->NumaNode.GroupMask.Group != 0)
+                break;
+
+            u64 mask = (u64)entry->NumaNode.GroupMask.Mask;
+            for (u32 i = 0; i < PLATFORM_MAX_LOGICAL_PROCESSORS; ++i) {
+                if (mask & (1ull << i))
+                    out_info->numa_node[i] = (u8)entry->NumaNode.NodeNumber;
+            }
+            if (entry->NumaNode.NodeNumber + 1 > out_info->numa_node_count)
+                out_info->numa_node_count = entry->NumaNode.NodeNumber + 1;
+        } break;
+
+        case RelationCache: {
+            CACHE_RELATIONSHIP* cache = &entry->Cache;
+            if (cache->Type != CacheData && cache->Type != CacheUnified)
+                break;
+
+            // Every core reports its own caches, they are all the same size
+            if (cache->Level == 1 && out_info->l1_data_cache_size == 0)
+                out_info->l1_data_cache_size = cache->CacheSize;
+            else if (cache->Level == 2 && out_info->l2_cache_size == 0)
+                out_info->l2_cache_size = cache->CacheSize;
+            else if (cache->Level == 3 && out_info->l3_cache_size == 0)
+                out_info->l3_cache_size = cache->CacheSize;
+
+            if (out_info->cache_line_size == 0)
+                out_info->cache_line_size = cache->LineSize;
+        } break;
+
+        default:
+            break;
+        }
+    }
+
+    free(buffer);
+
+    if (out_info->logical_processor_mask == 0) {
+        win32_cpu_info_fallback(out_info);
+        return FALSE;
+    }
+
+    for (u32 i = 0; i < PLATFORM_MAX_LOGICAL_PROCESSORS; ++i) {
+        if (out_info->logical_processor_mask & (1ull << i))
+            out_info->logical_processor_count++;
+    }
+    if (out_info->package_count == 0)
+        out_info->package_count = 1;
+    if (out_info->numa_node_count == 0)
+        out_info->numa_node_count = 1;
+
+    return TRUE;
+}
+
+b8 platform_mutex_create(platform_mutex* out_mutex) {
+    SRWLOCK* lock = malloc(sizeof(SRWLOCK));
+    InitializeSRWLock(lock);
+    out_mutex->internal_data = lock;
+    return TRUE;
+}
+
+void platform_mutex_destroy(platform_mutex* mutex) {
+    // SRW locks need no cleanup
+    free(mutex->internal_data);
+    mutex->internal_data = 0;
+}
+
+void platform_mutex_lock(platform_mutex* mutex) {
+    AcquireSRWLockExclusive((SRWLOCK*)mutex->internal_data);
+}
+
+b8 platform_mutex_try_lock(platform_mutex* mutex) {
+    return TryAcquireSRWLockExclusive((SRWLOCK*)mutex->internal_data) != 0;
+}
+
+void platform_mutex_unlock(platform_mutex* mutex) {
+    ReleaseSRWLockExclusive((SRWLOCK*)mutex->internal_data);
+}
+
+b8 platform_semaphore_create(u32 initial_count, u32 max_count, platform_semaphore* out_semaphore) {
+    HANDLE handle = CreateSemaphoreA(0, (LONG)initial_count, (LONG)max_count, 0);
+    if (!handle) {
+        VERROR("Failed to create semaphore");
+        return FALSE;
+    }
+
+    out_semaphore->internal_data = handle;
+    return TRUE;
+}
+
+void platform_semaphore_destroy(platform_semaphore* semaphore) {
+    if (!semaphore->internal_data)
+        return;
+
+    CloseHandle((HANDLE)semaphore->internal_data);
+    semaphore->internal_data = 0;
+}
+
+void platform_semaphore_signal(platform_semaphore* semaphore, u32 count) {
+    ReleaseSemaphore((HANDLE)semaphore->internal_data, (LONG)count, 0);
+}
+
+b8 platform_semaphore_wait(platform_semaphore* semaphore, u64 timeout_ms) {
+    return WaitForSingleObject((HANDLE)semaphore->internal_data, win32_timeout(timeout_ms)) == WAIT_OBJECT_0;
+}
+
+b8 platform_condvar_create(platform_condvar* out_condvar) {
+    CONDITION_VARIABLE* condvar = malloc(sizeof(CONDITION_VARIABLE));
+    InitializeConditionVariable(condvar);
+    out_condvar->internal_data = condvar;
+    return TRUE;
+}
+
+void platform_condvar_destroy(platform_condvar* condvar) {
+    free(condvar->internal_data);
+    condvar->internal_data = 0;
+}
+
+b8 platform_condvar_wait(platform_condvar* condvar, platform_mutex* mutex, u64 timeout_ms) {
+    return SleepConditionVariableSRW(
+        (CONDITION_VARIABLE*)condvar->internal_data,
+        (SRWLOCK*)mutex->internal_data,
+        win32_timeout(timeout_ms),
+        0) != 0;
+}
+
+void platform_condvar_signal(platform_condvar* condvar) {
+    WakeConditionVariable((CONDITION_VARIABLE*)condvar->internal_data);
+}
+
+void platform_condvar_broadcast(platform_condvar* condvar) {
+    WakeAllConditionVariable((CONDITION_VARIABLE*)condvar->internal_data);
+}
+
+typedef struct win32_fiber {
+    LPVOID handle;
+    pfn_fiber_start start_function;
+    void* params;
+} win32_fiber;
+
+static VOID WINAPI win32_fiber_entry(LPVOID arg) {
+    win32_fiber* fiber = (win32_fiber*)arg;
+    fiber->start_function(fiber->params);
+
+    VFATAL("Fiber start function returned");
+    abort();
+}
+
+b8 platform_fiber_convert_thread(platform_fiber* out_fiber) {
+    win32_fiber* fiber = malloc(sizeof(win32_fiber));
+    memset(fiber, 0, sizeof(win32_fiber));
+    fiber->handle = ConvertThreadToFiberEx(0, FIBER_FLAG_FLOAT_SWITCH);
+    if (!fiber->handle) {
+        VERROR("ConvertThreadToFiberEx failed");
+        free(fiber);
+        return FALSE;
+    }
+
+    out_fiber->internal_data = fiber;
+    return TRUE;
+}
+
+void platform_fiber_convert_back(platform_fiber* thread_fiber) {
+    ConvertFiberToThread();
+    free(thread_fiber->internal_data);
+    thread_fiber->internal_data = 0;
+}
+
+b8 platform_fiber_create(u64 stack_size, pfn_fiber_start start_function, void* params, platform_fiber* out_fiber) {
+    win32_fiber* fiber = malloc(sizeof(win32_fiber));
+    fiber->start_function = start_function;
+    fiber->params = params;
+
+    // Fiber stacks are reserved up front and committed on demand behind a guard page
+    fiber->handle = CreateFiberEx(0, (SIZE_T)stack_size, FIBER_FLAG_FLOAT_SWITCH, win32_fiber_entry, fiber);
+    if (!fiber->handle) {
+        VERROR("CreateFiberEx failed for a stack of %llu bytes", stack_size);
+        free(fiber);
+        return FALSE;
+    }
+
+    out_fiber->internal_data = fiber;
+    return TRUE;
+}
+
+void platform_fiber_destroy(platform_fiber* fiber) {
+    win32_fiber* internal = (win32_fiber*)fiber->internal_data;
+    if (!internal)
+        return;
+
+    DeleteFiber(internal->handle);
+    free(internal);
+    fiber->internal_data = 0;
+}
+
+void platform_fiber_switch(platform_fiber* from, platform_fiber* to) {
+    SwitchToFiber(((win32_fiber*)to->internal_data)->handle);
+}
+
 LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARAM l_param) {
     switch (msg) {
     case WM_QUIT: {
@@ -12,6 +12,22 @@ b8 renderer_backend_create(renderer_backend_type backend_type, struct platform_s
         out_backend->begin_frame = vulkan_renderer_backend_begin_frame;
         out_backend->end_frame = vulkan_renderer_backend_end_frame;
         out_backend->resized = vulkan_renderer_backend_resized;
+        out_backend->get_frame_counters = vulkan_renderer_backend_get_frame_counters;
+        out_backend->get_memory_usage = vulkan_renderer_backend_get_memory_usage;
+        out_backend->get_upload_stats = vulkan_renderer_backend_get_upload_stats;
+#if defined(VKR_ENABLE_CHECKS)
+        out_backend->check_memory_step = vulkan_renderer_backend_check_memory_step;
+        out_backend->check_compute_step = vulkan_renderer_backend_check_compute_step;
+        out_backend->check_timeline_step = vulkan_renderer_backend_check_timeline_step;
+#endif
+        out_backend->create_geometry = vulkan_renderer_backend_create_geometry;
+        out_backend->destroy_geometry = vulkan_renderer_backend_destroy_geometry;
+        out_backend->geometry_is_ready = vulkan_renderer_backend_geometry_is_ready;
+        out_backend->draw_geometry = vulkan_renderer_backend_draw_geometry;
+        out_backend->begin_draw_batch = vulkan_renderer_backend_begin_draw_batch;
+        out_backend->draw_geometry_batch = vulkan_renderer_backend_draw_geometry_batch;
+        out_backend->end_draw_batch = vulkan_renderer_backend_end_draw_batch;
+        out_backend->execute_draw_batches = vulkan_renderer_backend_execute_draw_batches;
         return TRUE;
     case RENDERER_BACKEND_DIRECTX:
         VFATAL("DirectX is not supported currently");
@@ -32,4 +48,20 @@ void renderer_backend_destroy(renderer_backend* backend) {
     backend->initialize = 0;
     backend->plat_state = 0;
     backend->resized = 0;
+    backend->get_frame_counters = 0;
+    backend->get_memory_usage = 0;
+    backend->get_upload_stats = 0;
+#if defined(VKR_ENABLE_CHECKS)
+    backend->check_memory_step = 0;
+    backend->check_compute_step = 0;
+    backend->check_timeline_step = 0;
+#endif
+    backend->create_geometry = 0;
+    backend->destroy_geometry = 0;
+    backend->geometry_is_ready = 0;
+    backend->draw_geometry = 0;
+    backend->begin_draw_batch = 0;
+    backend->draw_geometry_batch = 0;
+    backend->end_draw_batch = 0;
+    backend->execute_draw_batches = 0;
 }
\ No newline at end of file
@@ -2,12 +2,106 @@
 #include "renderer_backend.h"
 #include "core/vmemory.h"
 #include "core/logger.h"
+#include "platform/platform_thread.h"
+#include "core/job_system.h"
+#include "core/frame_stats.h"
+#include "platform/platform.h"
 
+#include <stdio.h>
+
+// Fewest draws worth a batch of their own, smaller packets are drawn on the calling thread
+#define RENDERER_MIN_DRAWS_PER_BATCH 512
+// Most draw batches recorded in a frame
+#define RENDERER_MAX_DRAW_BATCHES 64
+
+// A contiguous range of the packet's draw list, recorded by one job
+typedef struct draw_batch_job {
+    const geometry_render_data* geometries;
+    u32 geometry_count;
+    void* batch;
+} draw_batch_job;
 
 // Backend render context
 static renderer_backend* backend = 0;
+// Counters copied on the main thread while no frame stage runs, the stages read this copy
+static renderer_frame_counters frame_counters_snapshot;
+// Thread the renderer was initialized on, resources are created and destroyed there
+static u64 main_thread_id;
+
+// Geometry lives in backend state that only the main thread touches. Game stages on job threads must not get here
+static b8 renderer_is_main_thread(const char* function) {
+    if (platform_thread_current_id() != main_thread_id) {
+        VERROR("%s - called from another thread than the main thread", function);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void record_draw_batch(void* data) {
+    draw_batch_job* job = (draw_batch_job*)data;
+    // Must not wait on jobs, the batch belongs to the command pool of this thread
+    job->batch = backend->begin_draw_batch(backend);
+    if (!job->batch)
+        return;
+
+    for (u32 idx = 0; idx != job->geometry_count; ++idx)
+        backend->draw_geometry_batch(backend, job->batch, &job->geometries[idx]);
+    backend->end_draw_batch(backend, job->batch);
+}
+
+static u32 draw_batch_count(u32 geometry_count, u32 max_threads) {
+    if (!backend->begin_draw_batch)
+        return 1;
+
+    u32 count = geometry_count / RENDERER_MIN_DRAWS_PER_BATCH;
+    u32 thread_count = job_system_thread_count();
+    if (max_threads && thread_count > max_threads)
+        thread_count = max_threads;
+    if (count > thread_count)
+        count = thread_count;
+    return count > RENDERER_MAX_DRAW_BATCHES ? RENDERER_MAX_DRAW_BATCHES : count;
+}
+
+static void draw_geometries(render_packet* packet) {
+    u32 batch_count = draw_batch_count(packet->geometry_count, packet->max_draw_threads);
+    if (batch_count < 2) {
+        for (u32 idx = 0; idx != packet->geometry_count; ++idx)
+            backend->draw_geometry(backend, &packet->geometries[idx]);
+        return;
+    }
+
+    // Ranges keep the order of the draw list, the batches are executed in the same order
+    draw_batch_job batches[RENDERER_MAX_DRAW_BATCHES];
+    job_decl jobs[RENDERER_MAX_DRAW_BATCHES];
+    u32 first = 0;
+    for (u32 idx = 0; idx != batch_count; ++idx) {
+        u32 end = (u32)(((u64)packet->geometry_count * (idx + 1)) / batch_count);
+        batches[idx].geometries = &packet->geometries[first];
+        batches[idx].geometry_count = end - first;
+        batches[idx].batch = 0;
+        jobs[idx].entry = record_draw_batch;
+        jobs[idx].data = &batches[idx];
+        first = end;
+    }
+
+    job_counter counter = { 0 };
+    job_system_run(jobs, batch_count, &counter);
+    job_system_wait(&counter);
+
+    void* recorded[RENDERER_MAX_DRAW_BATCHES];
+    u32 recorded_count = 0;
+    for (u32 idx = 0; idx != batch_count; ++idx) {
+        if (batches[idx].batch)
+            recorded[recorded_count++] = batches[idx].batch;
+    }
+    if (recorded_count != batch_count) {
+        VERROR("renderer_draw_frame - %u of %u draw batches could not be recorded", batch_count - recorded_count, batch_count);
+    }
+    backend->execute_draw_batches(backend, recorded_count, recorded);
+}
 
 b8 renderer_initialize(const char* application_name, struct platform_state* plat_state) {
+    main_thread_id = platform_thread_current_id();
     backend = vallocate(sizeof(renderer_backend), MEMORY_TAG_RENDERER);
 
     // TODO: type should be configurable
@@ -37,6 +131,10 @@ b8 renderer_end_frame(f64 delta_time) {
 
 b8 renderer_draw_frame(render_packet* packet) {
     if (renderer_begin_frame(packet->delta_time)) {
+        f64 start_time = platform_get_absolute_time();
+        draw_geometries(packet);
+        frame_stats_record(FRAME_STAT_ZONE_DRAW_RECORDING, platform_get_absolute_time() - start_time);
+
         b8 result = renderer_end_frame(packet->delta_time);
         if (!result) {
             VFATAL("renderer_end_frame failed. Application shutting down...");
@@ -55,3 +153,114 @@ void renderer_on_resize(u16 width, u16 height) {
         VERROR("renderer_on_resize - > Backend does not exist!");
     }
 }
+
+b8 renderer_create_geometry(u32 vertex_size, u32 vertex_count, const void* vertices,
+    u32 index_count, const u32* indices, geometry* out_geometry) {
+    out_geometry->internal_id = INVALID_ID;
+    out_geometry->generation = INVALID_ID;
+    if (!renderer_is_main_thread("renderer_create_geometry"))
+        return FALSE;
+    if (!backend || !backend->create_geometry) {
+        VERROR("renderer_create_geometry - the backend does not support geometry");
+        return FALSE;
+    }
+
+    return backend->create_geometry(backend, vertex_size, vertex_count, vertices, index_count, indices, out_geometry);
+}
+
+void renderer_destroy_geometry(geometry* geometry) {
+    if (!renderer_is_main_thread("renderer_destroy_geometry"))
+        return;
+    if (backend && backend->destroy_geometry)
+        backend->destroy_geometry(backend, geometry);
+}
+
+b8 renderer_geometry_is_ready(const geometry* geometry) {
+    if (!renderer_is_main_thread("renderer_geometry_is_ready"))
+        return FALSE;
+    return backend && backend->geometry_is_ready && backend->geometry_is_ready(backend, geometry);
+}
+
+void renderer_capture_frame_counters() {
+    vzero_memory(&frame_counters_snapshot, sizeof(renderer_frame_counters));
+    if (backend && backend->get_frame_counters) {
+        backend->get_frame_counters(backend, &frame_counters_snapshot);
+    }
+}
+
+void renderer_get_frame_counters(renderer_frame_counters* out_counters) {
+    vcopy_memory(out_counters, &frame_counters_snapshot, sizeof(renderer_frame_counters));
+}
+
+i32 renderer_get_memory_usage_str(char* buffer, u64 size) {
+    if (size)
+        buffer[0] = 0;
+    if (backend && backend->get_memory_usage)
+        return backend->get_memory_usage(backend, buffer, size);
+    return 0;
+}
+
+void renderer_get_upload_stats(renderer_upload_stats* out_stats) {
+    vzero_memory(out_stats, sizeof(renderer_upload_stats));
+    if (backend && backend->get_upload_stats)
+        backend->get_upload_stats(backend, out_stats);
+}
+
+#if defined(VKR_ENABLE_CHECKS)
+renderer_check_status renderer_check_memory_step() {
+    if (!backend || !backend->check_memory_step) {
+        VERROR("The renderer backend has no memory check");
+        return RENDERER_CHECK_FAILED;
+    }
+    return backend->check_memory_step(backend);
+}
+
+renderer_check_status renderer_check_compute_step() {
+    if (!backend || !backend->check_compute_step) {
+        VERROR("The renderer backend has no compute check");
+        return RENDERER_CHECK_FAILED;
+    }
+    return backend->check_compute_step(backend);
+}
+
+renderer_check_status renderer_check_timeline_step() {
+    if (!backend || !backend->check_timeline_step) {
+        VERROR("The renderer backend has no timeline check");
+        return RENDERER_CHECK_FAILED;
+    }
+    return backend->check_timeline_step(backend);
+}
+#endif
+
+const char* renderer_frame_counters_csv_header() {
+    return "frame,draw_calls,triangles,render_passes,barriers,descriptor_binds,pipeline_binds,"
+        "input_vertices,input_primitives,vertex_invocations,clipping_primitives,fragment_invocations";
+}
+
+i32 renderer_frame_counters_to_csv(const renderer_frame_counters* counters, char* buffer, u64 size) {
+    // Pipeline statistics are left empty when the device does not provide them
+    if (!counters->pipeline_statistics_valid) {
+        return snprintf(buffer, size, "%llu,%u,%llu,%u,%u,%u,%u,,,,,",
+            counters->frame_number,
+            counters->draw_calls,
+            counters->triangles,
+            counters->render_passes,
+            counters->barriers,
+            counters->descriptor_binds,
+            counters->pipeline_binds);
+    }
+
+    return snprintf(buffer, size, "%llu,%u,%llu,%u,%u,%u,%u,%llu,%llu,%llu,%llu,%llu",
+        counters->frame_number,
+        counters->draw_calls,
+        counters->triangles,
+        counters->render_passes,
+        counters->barriers,
+        counters->descriptor_binds,
+        counters->pipeline_binds,
+        counters->input_vertices,
+        counters->input_primitives,
+        counters->vertex_invocations,
+        counters->clipping_primitives,
+        counters->fragment_invocations);
+}
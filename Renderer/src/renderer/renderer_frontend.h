@@ -23,7 +23,8 @@ b8 renderer_initialize(const char* application_name, struct platform_state* plat
 void renderer_shutdown();
 
 /**
-* Draws the current frame using the renderer backend.
+* Draws the current frame using the renderer backend. Large draw lists are split
+* into batches that job threads record in parallel, they are drawn in list order.
 * 
 * @param packet - The information needed to draw the frame
 * @return b8 - TRUE if the frame was renderer successfully, FALSE otherwise
@@ -36,4 +37,116 @@ b8 renderer_draw_frame(render_packet* packet);
 * @param width - The new width of the screen / window
 * @param height - The new height of the screen / window
 */
-void renderer_on_resize(u16 width, u16 height);
\ No newline at end of file
+void renderer_on_resize(u16 width, u16 height);
+
+/**
+* Uploads geometry to the GPU. The upload is batched with the other geometry
+* created before the next frame. Main thread only, calls from other threads fail,
+* games create geometry in prepare_frame.
+* 
+* @param vertex_size - Size of a vertex in bytes
+* @param vertex_count - Amount of vertices
+* @param vertices - The vertices, copied before returning
+* @param index_count - Amount of indices, 0 for non indexed geometry
+* @param indices - The indices, copied before returning
+* @param out_geometry - The handle of the geometry
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+VAPI b8 renderer_create_geometry(u32 vertex_size, u32 vertex_count, const void* vertices,
+    u32 index_count, const u32* indices, geometry* out_geometry);
+
+/**
+* Destroys geometry. Its memory is reused once frames in flight that might draw it are done.
+* Main thread only, calls from other threads are ignored.
+* 
+* @param geometry - The handle of the geometry, invalidated
+*/
+VAPI void renderer_destroy_geometry(geometry* geometry);
+
+/**
+* Checks whether the upload of geometry completed. Draws of geometry still being
+* uploaded are skipped. Main thread only, calls from other threads return FALSE.
+* 
+* @param geometry - The handle of the geometry
+* @return b8 - TRUE if the geometry is drawn, FALSE if it is still uploading or was destroyed
+*/
+VAPI b8 renderer_geometry_is_ready(const geometry* geometry);
+
+/**
+* Copies the workload counters of the most recent completed frame for the frame stages.
+* Call from the main thread while no frame stage runs, begin_frame updates the counters.
+*/
+void renderer_capture_frame_counters();
+
+/**
+* Gets the workload counters captured before the current frame's stages started.
+* Safe to call from any frame stage.
+* 
+* @param out_counters - Filled with the counters of the frame
+*/
+VAPI void renderer_get_frame_counters(renderer_frame_counters* out_counters);
+
+/**
+* Formats the GPU memory use of the backend, the counterpart of get_memory_usage_str.
+* 
+* @param buffer - The buffer that will hold the text
+* @param size - The size of the buffer in bytes
+* @return i32 - The amount of characters written, 0 if the backend does not report memory use
+*/
+VAPI i32 renderer_get_memory_usage_str(char* buffer, u64 size);
+
+/**
+* Gets the totals of the uploads to GPU buffers, like geometry created with renderer_create_geometry.
+* Main thread only.
+* 
+* @param out_stats - Filled with the totals since the renderer started
+*/
+VAPI void renderer_get_upload_stats(renderer_upload_stats* out_stats);
+
+#if defined(VKR_ENABLE_CHECKS)
+/**
+* Runs the next step of the self check of the GPU memory allocator. It allocates, frees
+* and defragments test allocations and checks the allocator's bookkeeping after each.
+* Call once per frame from prepare_frame while it returns RENDERER_CHECK_RUNNING.
+* Main thread only. Only built with VKR_ENABLE_CHECKS, the DEBUG configuration.
+* 
+* @return renderer_check_status - RUNNING while it waits for frames to complete, then PASSED or FAILED
+*/
+VAPI renderer_check_status renderer_check_memory_step();
+
+/**
+* Runs the next step of the self check of async compute. It dispatches a kernel filling a
+* buffer shared with the graphics queue, lets the frame wait on the compute work and reads
+* the buffer back once the frame completed. Call once per frame from prepare_frame while it
+* returns RENDERER_CHECK_RUNNING. Main thread only. Only built with VKR_ENABLE_CHECKS.
+* 
+* @return renderer_check_status - RUNNING while dispatches are in flight, then PASSED or FAILED
+*/
+VAPI renderer_check_status renderer_check_compute_step();
+
+/**
+* Runs the next step of the self check of the frame timeline. It checks the counter of the
+* timeline semaphore against the submitted frames, the frame numbers of the frame slots and
+* that a frame is complete once its slot came around again. Call once per frame from
+* prepare_frame while it returns RENDERER_CHECK_RUNNING. Main thread only. Only built with
+* VKR_ENABLE_CHECKS.
+* 
+* @return renderer_check_status - RUNNING until enough frames were checked, then PASSED or FAILED
+*/
+VAPI renderer_check_status renderer_check_timeline_step();
+#endif
+
+/**
+* @return const char* - The CSV header line matching renderer_frame_counters_to_csv (without new line)
+*/
+VAPI const char* renderer_frame_counters_csv_header();
+
+/**
+* Formats frame counters as a single CSV line (without new line).
+* 
+* @param counters - The counters to format
+* @param buffer - The buffer that will hold the line
+* @param size - The size of the buffer in bytes
+* @return i32 - The amount of characters written, negative on failure
+*/
+VAPI i32 renderer_frame_counters_to_csv(const renderer_frame_counters* counters, char* buffer, u64 size);
\ No newline at end of file
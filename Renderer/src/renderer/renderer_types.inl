@@ -7,6 +7,63 @@ typedef enum renderer_backend_type {
     RENDERER_BACKEND_DIRECTX
 } renderer_backend_type;
 
+/*
+* Workload counters of a single frame. The CPU counters are gathered
+* while the commands are recorded, the pipeline statistics come from
+* GPU queries and are only filled when the device supports them.
+*/
+typedef struct renderer_frame_counters {
+    // The frame the counters belong to
+    u64 frame_number;
+
+    // CPU side counters of recorded commands
+    u32 draw_calls;
+    u64 triangles;
+    u32 render_passes;
+    u32 barriers;
+    u32 descriptor_binds;
+    u32 pipeline_binds;
+
+    // GPU pipeline statistics
+    b8 pipeline_statistics_valid;
+    u64 input_vertices;
+    u64 input_primitives;
+    u64 vertex_invocations;
+    u64 clipping_primitives;
+    u64 fragment_invocations;
+} renderer_frame_counters;
+
+// Totals of the uploads to GPU buffers since the renderer started
+typedef struct renderer_upload_stats {
+    u64 upload_count;
+    u64 upload_bytes;
+    // Uploads that found the staging space full and had to wait for the GPU
+    u32 stall_count;
+} renderer_upload_stats;
+
+#if defined(VKR_ENABLE_CHECKS)
+// Progress of a backend self check that runs over several frames
+typedef enum renderer_check_status {
+    RENDERER_CHECK_RUNNING,
+    RENDERER_CHECK_PASSED,
+    RENDERER_CHECK_FAILED
+} renderer_check_status;
+#endif
+
+/*
+* Handle of geometry whose vertices and indices live in the backend.
+* A handle of destroyed geometry is recognized by its generation.
+*/
+typedef struct geometry {
+    u32 internal_id;
+    u32 generation;
+} geometry;
+
+// A geometry to draw in a frame
+typedef struct geometry_render_data {
+    geometry* geometry;
+} geometry_render_data;
+
 // Interface to a renderer backend
 typedef struct renderer_backend {
     struct platform_state* plat_state;
@@ -17,6 +74,28 @@ typedef struct renderer_backend {
     void (*resized)(struct renderer_backend* backend, u32 width, u32 height);
     b8(*begin_frame)(struct renderer_backend* backend, f64 delta_time);
     b8(*end_frame)(struct renderer_backend* backend, f64 delta_time);
+    void (*get_frame_counters)(struct renderer_backend* backend, renderer_frame_counters* out_counters);
+    i32 (*get_memory_usage)(struct renderer_backend* backend, char* buffer, u64 size);
+    void (*get_upload_stats)(struct renderer_backend* backend, renderer_upload_stats* out_stats);
+#if defined(VKR_ENABLE_CHECKS)
+    // Test hooks, left out of the RELEASE and DIST renderer
+    renderer_check_status (*check_memory_step)(struct renderer_backend* backend);
+    renderer_check_status (*check_compute_step)(struct renderer_backend* backend);
+    renderer_check_status (*check_timeline_step)(struct renderer_backend* backend);
+#endif
+
+    b8 (*create_geometry)(struct renderer_backend* backend, u32 vertex_size, u32 vertex_count, const void* vertices,
+        u32 index_count, const u32* indices, geometry* out_geometry);
+    void (*destroy_geometry)(struct renderer_backend* backend, geometry* geometry);
+    b8 (*geometry_is_ready)(struct renderer_backend* backend, const geometry* geometry);
+    void (*draw_geometry)(struct renderer_backend* backend, const geometry_render_data* data);
+
+    // Draw batches are recorded on job threads between begin_frame and end_frame, then executed
+    // in order on the thread of the frame. A frame either draws inline or with batches
+    void* (*begin_draw_batch)(struct renderer_backend* backend);
+    void (*draw_geometry_batch)(struct renderer_backend* backend, void* batch, const geometry_render_data* data);
+    void (*end_draw_batch)(struct renderer_backend* backend, void* batch);
+    void (*execute_draw_batches)(struct renderer_backend* backend, u32 count, void* const* batches);
 } renderer_backend;
 
 // TODO: Will eventually have many more things
@@ -31,4 +110,11 @@ typedef struct renderer_backend {
 */
 typedef struct render_packet {
     f64 delta_time;
+
+    u32 geometry_count;
+    // Owned by the application, cleared before the game renders into it (darray)
+    geometry_render_data* geometries;
+
+    // Most job threads recording the draws, 0 for all of them. Kept between frames
+    u32 max_draw_threads;
 } render_packet;
\ No newline at end of file
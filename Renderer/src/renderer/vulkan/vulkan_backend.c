@@ -6,7 +6,20 @@
 #include "vulkan_renderpass.h" 
 #include "vulkan_command_buffer.h"
 #include "vulkan_framebuffer.h"
-#include "vulkan_fence.h"
+#include "vulkan_timeline.h"
+#include "vulkan_gpu_timer.h"
+#include "vulkan_frame_counters.h"
+#include "vulkan_memory_allocator.h"
+#include "vulkan_memory_check.h"
+#include "vulkan_compute_check.h"
+#include "vulkan_timeline_check.h"
+#include "vulkan_host_allocator.h"
+#include "vulkan_buffer.h"
+#include "vulkan_pipeline.h"
+#include "vulkan_staging.h"
+#include "vulkan_transfer.h"
+#include "vulkan_compute.h"
+#include "vulkan_frame_pool.h"
 #include "vulkan_utils.h"
 
 // General includes
@@ -22,6 +35,49 @@ static vulkan_context context;
 static u32 cached_framebuffer_width = 0;
 static u32 cached_framebuffer_height = 0;
 
+/*
+* SPIR-V of the default pipeline, until shaders are loaded as assets:
+*
+*   #version 450
+*   layout(location = 0) in vec3 in_position;
+*   void main() { gl_Position = vec4(in_position, 1.0); }
+*/
+static const u32 default_vertex_spirv[] = {
+    0x07230203, 0x00010000, 0x00000000, 0x0000000f, 0x00000000, 0x00020011,
+    0x00000001, 0x0003000e, 0x00000000, 0x00000001, 0x0007000f, 0x00000000,
+    0x00000001, 0x6e69616d, 0x00000000, 0x00000009, 0x0000000a, 0x00040047,
+    0x00000009, 0x0000001e, 0x00000000, 0x00040047, 0x0000000a, 0x0000000b,
+    0x00000000, 0x00020013, 0x00000002, 0x00030021, 0x00000003, 0x00000002,
+    0x00030016, 0x00000004, 0x00000020, 0x00040017, 0x00000005, 0x00000004,
+    0x00000003, 0x00040017, 0x00000006, 0x00000004, 0x00000004, 0x00040020,
+    0x00000007, 0x00000001, 0x00000005, 0x00040020, 0x00000008, 0x00000003,
+    0x00000006, 0x0004003b, 0x00000007, 0x00000009, 0x00000001, 0x0004003b,
+    0x00000008, 0x0000000a, 0x00000003, 0x0004002b, 0x00000004, 0x0000000b,
+    0x3f800000, 0x00050036, 0x00000002, 0x00000001, 0x00000000, 0x00000003,
+    0x000200f8, 0x0000000c, 0x0004003d, 0x00000005, 0x0000000d, 0x00000009,
+    0x00050050, 0x00000006, 0x0000000e, 0x0000000d, 0x0000000b, 0x0003003e,
+    0x0000000a, 0x0000000e, 0x000100fd, 0x00010038
+};
+
+/*
+*   #version 450
+*   layout(location = 0) out vec4 out_color;
+*   void main() { out_color = vec4(1.0); }
+*/
+static const u32 default_fragment_spirv[] = {
+    0x07230203, 0x00010000, 0x00000000, 0x0000000b, 0x00000000, 0x00020011,
+    0x00000001, 0x0003000e, 0x00000000, 0x00000001, 0x0006000f, 0x00000004,
+    0x00000001, 0x6e69616d, 0x00000000, 0x00000007, 0x00030010, 0x00000001,
+    0x00000007, 0x00040047, 0x00000007, 0x0000001e, 0x00000000, 0x00020013,
+    0x00000002, 0x00030021, 0x00000003, 0x00000002, 0x00030016, 0x00000004,
+    0x00000020, 0x00040017, 0x00000005, 0x00000004, 0x00000004, 0x00040020,
+    0x00000006, 0x00000003, 0x00000005, 0x0004003b, 0x00000006, 0x00000007,
+    0x00000003, 0x0004002b, 0x00000004, 0x00000008, 0x3f800000, 0x0007002c,
+    0x00000005, 0x00000009, 0x00000008, 0x00000008, 0x00000008, 0x00000008,
+    0x00050036, 0x00000002, 0x00000001, 0x00000000, 0x00000003, 0x000200f8,
+    0x0000000a, 0x0003003e, 0x00000007, 0x00000009, 0x000100fd, 0x00010038
+};
+
 #if defined(VKR_DEBUG)
 VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
     VkDebugUtilsMessageTypeFlagsEXT message_type,
@@ -29,17 +85,22 @@ VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityFlagBits
     void* puser_data);
 #endif
 
-i32 find_memory_index(u32 type_filter, u32 property_flags);
-
-void create_command_buffers(renderer_backend* backend);
 void regenerate_framebuffers(renderer_backend* backend, vulkan_swapchain* swapchain, vulkan_renderpass* renderpass);
 b8 recreate_swapchain(renderer_backend* backend);
+b8 create_buffers(vulkan_context* context);
+void destroy_buffers(vulkan_context* context);
+void release_geometries(vulkan_context* context);
+void set_draw_state(vulkan_command_buffer* command_buffer);
+void begin_main_pass(VkSubpassContents contents);
+void record_geometry(vulkan_command_buffer* command_buffer, const geometry_render_data* data);
 
 b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* application_name, struct platform_state* plat_state) {
-    context.find_memory_index = find_memory_index;
-
-    // TODO: custom allocator
-    context.allocator = 0;
+    // Host allocations of the driver go through the engine allocator. No budget for now
+    if (!vulkan_host_allocator_create(0, &context.host_allocator)) {
+        VFATAL("Failed to create the vulkan host allocator!");
+        return FALSE;
+    }
+    context.allocator = &context.host_allocator.callbacks;
 
     application_get_framebuffer_size(&cached_framebuffer_width, &cached_framebuffer_height);
     context.framebuffer_width = (cached_framebuffer_width != 0) ? cached_framebuffer_width : 1200;
@@ -179,6 +240,12 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
     }
     VINFO("Logical Device created!");
 
+    // Every image and buffer takes its memory from here, the depth attachment of the swapchain included
+    if (!vulkan_memory_allocator_create(&context)) {
+        VFATAL("Failed to create the vulkan memory allocator!");
+        return FALSE;
+    }
+
     // Swapchain creation
     VINFO("Creating swapchain...");
     vulkan_swapchain_create(&context, context.framebuffer_width, context.framebuffer_height, &context.swapchain);
@@ -194,18 +261,22 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
         0);
     VINFO("Main vulkan renderpass created!");
 
+    VINFO("Creating default pipeline...");
+    if (!vulkan_graphics_pipeline_create(&context, &context.main_renderpass,
+        sizeof(default_vertex_spirv), default_vertex_spirv,
+        sizeof(default_fragment_spirv), default_fragment_spirv, &context.default_pipeline)) {
+        VERROR("Failed to create the default pipeline");
+        return FALSE;
+    }
+    VINFO("Default pipeline created!");
+
     // Create swapchain buffers
     context.swapchain.framebuffers = (vulkan_framebuffer *)darray_reserve(vulkan_framebuffer, context.swapchain.image_count);
     regenerate_framebuffers(backend, &context.swapchain, &context.main_renderpass);
 
-    // Create command buffers
-    create_command_buffers(backend);
-
     // Create sync objects
-    context.in_flight_fence_count = context.swapchain.max_frames_in_flight;
-    context.image_available_semaphores = darray_reserve(VkSemaphore, context.in_flight_fence_count);
-    context.queue_complete_semaphore = darray_reserve(VkSemaphore, context.in_flight_fence_count);
-    context.in_flight_fences = darray_reserve(vulkan_fence, context.in_flight_fence_count);
+    context.image_available_semaphores = darray_reserve(VkSemaphore, context.swapchain.max_frames_in_flight);
+    context.queue_complete_semaphore = darray_reserve(VkSemaphore, context.swapchain.max_frames_in_flight);
 
     for (u8 idx = 0; idx != context.swapchain.max_frames_in_flight; ++idx) {
         VkSemaphoreCreateInfo semaphore_info = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
@@ -213,18 +284,47 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
         VK_CHECK(res);
         res = vkCreateSemaphore(context.device.logical_device, &semaphore_info, context.allocator, &context.queue_complete_semaphore[idx]);
         VK_CHECK(res);
+    }
 
-        // Create the fence in signaled state, indicating that the first frame has already been  "renderer"
-        // This will prevent the application from infinitely waiting for a frame to be rendered and to signal
-        // so. Since a frame cannot be rendered since a frame before it has been renderer
-        vulkan_fence_create(&context, TRUE, &context.in_flight_fences[idx]);
+    // Frames count up from 1 on the timeline, 0 stands for nothing submitted yet
+    if (!vulkan_timeline_create(&context, &context.frame_timeline)) {
+        VERROR("Failed to create the frame timeline");
+        return FALSE;
+    }
+    context.frame_number = 1;
+    context.frame_slot_numbers = vallocate(sizeof(u64) * context.swapchain.max_frames_in_flight, MEMORY_TAG_RENDERER);
+    vzero_memory(context.frame_slot_numbers, sizeof(u64) * context.swapchain.max_frames_in_flight);
+    context.image_frame_numbers = vallocate(sizeof(u64) * context.swapchain.image_count, MEMORY_TAG_RENDERER);
+    vzero_memory(context.image_frame_numbers, sizeof(u64) * context.swapchain.image_count);
+
+    // Vertex and index buffers shared by all geometry
+    if (!create_buffers(&context)) {
+        VERROR("Failed to create the geometry buffers");
+        return FALSE;
+    }
+
+    // Frames record into transient pools that are reset once the frame that used them completed
+    if (!vulkan_frame_pool_create(&context, context.device.graphics_queue_index, context.swapchain.max_frames_in_flight, &context.graphics_frame_pool)) {
+        VERROR("Failed to create the frame command pools");
+        return FALSE;
+    }
+
+    // Compute work that runs on its own queue, one command buffer per frame in flight
+    if (!vulkan_compute_create(&context, context.swapchain.max_frames_in_flight, &context.compute)) {
+        VERROR("Failed to create the async compute");
+        return FALSE;
+    }
+
+    // GPU timestamps, one query set per frame in flight
+    if (!vulkan_gpu_timer_create(&context, context.swapchain.max_frames_in_flight, &context.gpu_timer)) {
+        VERROR("Failed to create the GPU timer");
+        return FALSE;
+    }
+
+    if (!vulkan_frame_counters_create(&context, context.swapchain.max_frames_in_flight, &context.frame_counters)) {
+        VERROR("Failed to create the frame counters");
+        return FALSE;
     }
-    
-    // In flight fences should not exists until this point. Orignal pointers should be 0
-    // Actual owned fences are the in_flight_fences we point to them via an index
-    // of the current frame so we know which fence is for the current frame
-    context.images_in_flight = darray_reserve(vulkan_fence, context.swapchain.image_count);
-    vzero_memory(context.images_in_flight, sizeof(vulkan_fence) * context.swapchain.image_count);
 
     VINFO("Vulkan renderer intialized successfully.");
     return TRUE;
@@ -234,6 +334,18 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend) {
     VkResult res = vkDeviceWaitIdle(context.device.logical_device);
     VK_CHECK(res);
 
+    vulkan_gpu_timer_destroy(&context, &context.gpu_timer);
+    vulkan_frame_counters_destroy(&context, &context.frame_counters);
+#if defined(VKR_ENABLE_CHECKS)
+    vulkan_compute_check_destroy(&context);
+#endif
+    vulkan_compute_destroy(&context, &context.compute);
+    vulkan_frame_pool_destroy(&context, &context.graphics_frame_pool);
+    context.frame_command_buffer = 0;
+
+    VINFO("Destroying geometry buffers...");
+    destroy_buffers(&context);
+
     // Sync objects
     VINFO("Destroying synchronization objects...");
     for (u8 idx = 0; idx != context.swapchain.max_frames_in_flight; ++idx) {
@@ -243,31 +355,23 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend) {
         if (context.queue_complete_semaphore[idx]) {
             vkDestroySemaphore(context.device.logical_device, context.queue_complete_semaphore[idx], context.allocator);
         }
-        vulkan_fence_destroy(&context, &context.in_flight_fences[idx]);
     }
     darray_destroy(context.image_available_semaphores);
     context.image_available_semaphores = 0;
 
     darray_destroy(context.queue_complete_semaphore);
     context.queue_complete_semaphore = 0;
-    darray_destroy(context.in_flight_fences);
-    context.in_flight_fences = 0;
 
-    darray_destroy(context.images_in_flight);
-    context.images_in_flight = 0;
+    vulkan_timeline_destroy(&context, &context.frame_timeline);
+    vfree(context.frame_slot_numbers, sizeof(u64) * context.swapchain.max_frames_in_flight, MEMORY_TAG_RENDERER);
+    context.frame_slot_numbers = 0;
+    vfree(context.image_frame_numbers, sizeof(u64) * context.swapchain.image_count, MEMORY_TAG_RENDERER);
+    context.image_frame_numbers = 0;
     VINFO("Destroyed synchronization objects!");
 
-    // Destroy command buffers
-    VINFO("Destroying command buffers...");
-    for (u32 idx = 0; idx != context.swapchain.image_count; ++idx) {
-        if (context.graphics_command_buffers->handle) {
-            vulkan_command_buffer_free(&context, context.device.graphics_command_pool, &context.graphics_command_buffers[idx]);
-            context.graphics_command_buffers->handle = 0;
-        }
-    }
-    darray_destroy(context.graphics_command_buffers);
-    context.graphics_command_buffers = 0;
-    VINFO("Command buffers destroyed\n");
+    VINFO("Destroying default pipeline...");
+    vulkan_pipeline_destroy(&context, &context.default_pipeline);
+    VINFO("Destroyed default pipeline!\n");
 
     VINFO("Destroying main renderpass...");
     vulkan_renderpass_destroy(&context, &context.main_renderpass);
@@ -284,6 +388,10 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend) {
     vulkan_swapchain_destroy(&context, &context.swapchain);
     VINFO("Destroyed swapchain!\n");
 
+    VINFO("Destroying memory allocator...");
+    vulkan_memory_allocator_destroy(&context);
+    VINFO("Destroyed memory allocator!\n");
+
     // Destroy debugger
 #if defined(VKR_DEBUG)
     VDEBUG("Destroying Vulkan Debugger...");
@@ -308,6 +416,10 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend) {
     VINFO("Destroying Vulkan Instance...");
     vkDestroyInstance(context.instance, context.allocator);
     VINFO("Destroyed instance\n");
+
+    // Everything created with the callbacks is gone now
+    vulkan_host_allocator_destroy(&context.host_allocator);
+    context.allocator = 0;
 }
 
 void vulkan_renderer_backend_resized(renderer_backend* backend, u32 width, u32 height) {
@@ -349,11 +461,24 @@ b8 vulkan_renderer_backend_begin_frame(renderer_backend* backend, f64 delta_time
         return FALSE;
     }
 
-    if (!vulkan_fence_wait(&context, &context.in_flight_fences[context.current_frame], UINT64_MAX)) {
-        VWARN("In-flight fences wait failure");
+    // At most max_frames_in_flight frames are queued, wait for the one that last used this slot
+    if (!vulkan_frame_wait(&context, context.frame_slot_numbers[context.current_frame])) {
+        VWARN("Frame timeline wait failure");
         return FALSE;
     }
 
+    // The frame that last used this slot is done, its timestamps are available
+    vulkan_gpu_timer_collect(&context, &context.gpu_timer, context.current_frame);
+    vulkan_frame_counters_collect(&context, &context.frame_counters, context.current_frame);
+
+    // Memory defragmentation moved out of that no frame in flight reads anymore
+    vulkan_memory_release_retired(&context);
+
+    // Geometry no frame in flight draws anymore and staging space used while this slot was last recorded are free
+    release_geometries(&context);
+    vulkan_staging_ring_reclaim(&context.staging_ring, context.current_frame);
+    vulkan_frame_pool_reset(&context, &context.graphics_frame_pool, context.current_frame);
+
     if (!vulkan_swapchain_acquire_next_image_index(
         &context,&context.swapchain,
         UINT64_MAX, context.image_available_semaphores[context.current_frame],
@@ -362,86 +487,107 @@ b8 vulkan_renderer_backend_begin_frame(renderer_backend* backend, f64 delta_time
     }
 
     // Begin command recording
-    vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
-    vulkan_command_buffer_reset(command_buffer);
-    vulkan_command_buffer_begin_recording(command_buffer, FALSE, FALSE, FALSE);
-
-    // Dynamic state
-    VkViewport viewport;
-    viewport.x = 0.0f;
-    viewport.y = (f32)context.framebuffer_height; // Vulkan starts at top left we want to make sure we always strat bottom left like OpenGL
-    viewport.width = (f32)context.framebuffer_width;
-    viewport.height = - (f32)context.framebuffer_height; // Render botton up
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    // Scissor
-    VkRect2D scissor;
-    scissor.offset.x = scissor.offset.y = 0;
-    scissor.extent.width = context.framebuffer_width;
-    scissor.extent.height = context.framebuffer_height;
+    vulkan_command_buffer* command_buffer = vulkan_frame_pool_get_command_buffer(&context, &context.graphics_frame_pool, context.current_frame, TRUE);
+    if (!command_buffer)
+        return FALSE;
+    context.frame_command_buffer = command_buffer;
+    vulkan_command_buffer_begin_recording(command_buffer, TRUE, FALSE, FALSE);
+    vulkan_gpu_timer_begin_frame(&context.gpu_timer, command_buffer, context.current_frame);
+    vulkan_frame_counters_begin_frame(&context.frame_counters, command_buffer, context.current_frame);
 
-    // Set view port and clipping space
-    vkCmdSetViewport(command_buffer->handle, 0, 1, &viewport);
-    vkCmdSetScissor(command_buffer->handle, 0, 1, &scissor);
+    // Uploads the transfer queue finished are handed over to this queue before anything reads them
+    vulkan_transfer_acquire(&context, &context.transfer, command_buffer);
 
-    // Begin renderpass
+    // The main pass begins with the first draws, they decide whether it runs draw batches
     context.main_renderpass.w = (f32)context.framebuffer_width;
     context.main_renderpass.h = (f32)context.framebuffer_height;
-    vulkan_renderpass_begin(command_buffer, &context.main_renderpass, context.swapchain.framebuffers[context.image_index].handle);
+    context.main_pass_begun = FALSE;
 
     return TRUE;
 }
 
 b8 vulkan_renderer_backend_end_frame(renderer_backend* backend, f64 delta_time) {
-    vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
+    vulkan_command_buffer* command_buffer = context.frame_command_buffer;
+    // Nothing was drawn, the pass still clears the image
+    if (!context.main_pass_begun)
+        begin_main_pass(VK_SUBPASS_CONTENTS_INLINE);
     vulkan_renderpass_end(command_buffer, &context.main_renderpass);
+    context.main_pass_begun = FALSE;
+    vulkan_gpu_timer_write(&context.gpu_timer, command_buffer, context.current_frame,
+        VULKAN_GPU_TIMESTAMP_MAIN_PASS_END, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+    vulkan_frame_counters_end_frame(&context.frame_counters, command_buffer, context.current_frame, backend->frame_count);
+    vulkan_gpu_timer_end_frame(&context.gpu_timer, command_buffer, context.current_frame);
     vulkan_command_buffer_end_recording(command_buffer);
 
-    // Make sure previous frame is not using this imaghe (i.e it's fence is being waited on)
-    if (context.images_in_flight[context.image_index].handle != VK_NULL_HANDLE)
-        vulkan_fence_wait(&context, &context.in_flight_fences[context.image_index], UINT64_MAX);
+    // The image may come back while a frame of another slot still renders to it
+    if (!vulkan_frame_wait(&context, context.image_frame_numbers[context.image_index])) {
+        VWARN("Frame timeline wait failure");
+    }
 
-    // Make image fence as in-use by this frame TODO: fix it
-    context.images_in_flight[context.image_index] = context.in_flight_fences[context.current_frame];
-    
+    // Uploads on the transfer queue start right away and overlap this frame
+    vulkan_transfer_submit(&context, &context.transfer);
 
-    // Reset the fence
-    vulkan_fence_reset(&context, &context.in_flight_fences[context.current_frame]);
+    // Uploads recorded for this frame run first, the frame number signaled on the timeline covers them
+    VkCommandBuffer command_buffers[2];
+    u32 command_buffer_count = 0;
+    vulkan_command_buffer* upload_command_buffer = vulkan_staging_ring_end_frame(&context, &context.staging_ring);
+    if (upload_command_buffer)
+        command_buffers[command_buffer_count++] = upload_command_buffer->handle;
+    command_buffers[command_buffer_count++] = command_buffer->handle;
 
     VkSubmitInfo submit_info = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
-    submit_info.pNext = 0;
     // Buffers to execute
-    submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers = &command_buffer->handle;
+    submit_info.commandBufferCount = command_buffer_count;
+    submit_info.pCommandBuffers = command_buffers;
     
-    // Semaphores to be signaled on queue completion
-    submit_info.signalSemaphoreCount = 1;
-    submit_info.pSignalSemaphores = &context.queue_complete_semaphore[context.current_frame];
+    // Semaphores to be signaled on queue completion, the present waits on the first one.
+    // Values only matter for the timeline, those of binary semaphores are ignored
+    VkSemaphore signal_semaphores[2] = { context.queue_complete_semaphore[context.current_frame], context.frame_timeline.handle };
+    u64 signal_values[2] = { 0, context.frame_number };
+    submit_info.signalSemaphoreCount = 2;
+    submit_info.pSignalSemaphores = signal_semaphores;
+
+    VkTimelineSemaphoreSubmitInfo timeline_info = { VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+    timeline_info.signalSemaphoreValueCount = 2;
+    timeline_info.pSignalSemaphoreValues = signal_values;
+    submit_info.pNext = &timeline_info;
 
     // Wait semaphores to ensure the operation cannot begin until the image is available
+    VkSemaphore wait_semaphores[2];
+    wait_semaphores[0] = context.image_available_semaphores[context.current_frame];
     submit_info.waitSemaphoreCount = 1;
-    submit_info.pWaitSemaphores = &context.image_available_semaphores[context.current_frame];
+    submit_info.pWaitSemaphores = wait_semaphores;
 
     // each semaphore waits on the corresponding pipeline stage to complete: 1 to 1 ratio.
     // VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT prevents subsequent color attachments
     // writes from executing unitl semaphore signals (i.e one frame is presented at a time)
-    VkPipelineStageFlags flags[1] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+    VkPipelineStageFlags flags[2] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0 };
     submit_info.pWaitDstStageMask = flags;
 
-    VkResult res = vkQueueSubmit(
-        context.device.graphics_queue,
-        1,
-        &submit_info,
-        context.in_flight_fences[context.current_frame].handle);
+    // Async compute of this frame runs alongside the work before the first stage reading its results
+    VkSemaphore compute_semaphore = vulkan_compute_submit(&context, &context.compute);
+    if (compute_semaphore) {
+        wait_semaphores[submit_info.waitSemaphoreCount] = compute_semaphore;
+        flags[submit_info.waitSemaphoreCount++] = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    }
 
+    VkResult res = vkQueueSubmit(context.device.graphics_queue, 1, &submit_info, 0);
     if (res != VK_SUCCESS) {
         VERROR("vkQueueSubmit failed with resutl: %s", vulkan_result_string(res, TRUE));
         return FALSE;
     }
 
+    // The slot and the image are in use until the timeline reaches this frame
+    context.frame_slot_numbers[context.current_frame] = context.frame_number;
+    context.image_frame_numbers[context.image_index] = context.frame_number;
+    ++context.frame_number;
+    vulkan_gpu_timer_submitted(&context.gpu_timer, context.current_frame);
+
     // Update state of the comamnd buffer
     vulkan_command_buffer_update_submit(command_buffer);
+    if (upload_command_buffer)
+        vulkan_command_buffer_update_submit(upload_command_buffer);
 
     // Present stage (give image back to the swapchain
     vulkan_swapchain_present(
@@ -455,37 +601,351 @@ b8 vulkan_renderer_backend_end_frame(renderer_backend* backend, f64 delta_time)
     return TRUE;
 }
 
-i32 find_memory_index(u32 type_filter, u32 property_flags) {
-    VkPhysicalDeviceMemoryProperties memory_properties;
-    vkGetPhysicalDeviceMemoryProperties(context.device.physical_device, &memory_properties);
+void vulkan_renderer_backend_get_frame_counters(renderer_backend* backend, renderer_frame_counters* out_counters) {
+    *out_counters = context.frame_counters.last;
+}
+
+i32 vulkan_renderer_backend_get_memory_usage(renderer_backend* backend, char* buffer, u64 size) {
+    i32 offset = vulkan_memory_usage_str(&context, buffer, size);
+    if (offset >= 0 && (u64)offset < size)
+        offset += vulkan_host_allocator_usage_str(&context.host_allocator, buffer + offset, size - offset);
+    return offset;
+}
+
+void vulkan_renderer_backend_get_upload_stats(renderer_backend* backend, renderer_upload_stats* out_stats) {
+    out_stats->upload_count = context.staging_ring.upload_count;
+    out_stats->upload_bytes = context.staging_ring.upload_bytes;
+    out_stats->stall_count = context.staging_ring.stall_count;
+}
+
+#if defined(VKR_ENABLE_CHECKS)
+renderer_check_status vulkan_renderer_backend_check_memory_step(renderer_backend* backend) {
+    return vulkan_memory_check_step(&context);
+}
+
+renderer_check_status vulkan_renderer_backend_check_compute_step(renderer_backend* backend) {
+    return vulkan_compute_check_step(&context);
+}
+
+renderer_check_status vulkan_renderer_backend_check_timeline_step(renderer_backend* backend) {
+    return vulkan_timeline_check_step(&context);
+}
+#endif
+
+// Finds the geometry of a handle, 0 if it was destroyed
+static vulkan_geometry_data* find_geometry(const geometry* geometry) {
+    if (!geometry || geometry->internal_id >= VULKAN_MAX_GEOMETRY_COUNT)
+        return 0;
+
+    vulkan_geometry_data* data = &context.geometries[geometry->internal_id];
+    if (data->id != geometry->internal_id || data->generation != geometry->generation)
+        return 0;
+
+    return data;
+}
+
+// Takes a range of a geometry buffer, growing the buffer when it is full
+static b8 take_buffer_range(vulkan_buffer* buffer, u64 size, u64 alignment, u64* out_offset) {
+    if (vulkan_buffer_allocate(buffer, size, alignment, out_offset))
+        return TRUE;
+
+    u64 new_size = buffer->total_size * 2;
+    while (new_size < buffer->total_size + size + alignment)
+        new_size *= 2;
+
+    // Recorded uploads still point at the old buffer
+    vulkan_staging_ring_flush(&context, &context.staging_ring);
+    vulkan_transfer_flush(&context, &context.transfer);
+    VWARN("Geometry %s buffer full, growing it from %llu to %llu bytes",
+        buffer == &context.object_index_buffer ? "index" : "vertex", buffer->total_size, new_size);
+    if (!vulkan_buffer_resize(&context, new_size, buffer, context.device.graphics_command_pool, context.device.graphics_queue))
+        return FALSE;
+
+    return vulkan_buffer_allocate(buffer, size, alignment, out_offset);
+}
+
+b8 vulkan_renderer_backend_create_geometry(renderer_backend* backend, u32 vertex_size, u32 vertex_count, const void* vertices,
+    u32 index_count, const u32* indices, geometry* out_geometry) {
+    if (!vertex_size || !vertex_count || !vertices || (index_count && !indices)) {
+        VERROR("vulkan_renderer_backend_create_geometry - requires vertices and, for indexed geometry, indices");
+        return FALSE;
+    }
+
+    // The default pipeline reads a vec3 position from the start of each vertex
+    if (vertex_size < sizeof(f32) * 3 || vertex_size % sizeof(f32)) {
+        VERROR("vulkan_renderer_backend_create_geometry - vertex size %u is not a position followed by 4 byte components", vertex_size);
+        return FALSE;
+    }
+
+    // Searching on from the last slot taken keeps creating many geometries linear
+    vulkan_geometry_data* data = 0;
+    for (u32 count = 0; count != VULKAN_MAX_GEOMETRY_COUNT; ++count) {
+        u32 idx = (context.next_geometry_slot + count) % VULKAN_MAX_GEOMETRY_COUNT;
+        if (context.geometries[idx].id == INVALID_ID) {
+            data = &context.geometries[idx];
+            data->id = idx;
+            context.next_geometry_slot = (idx + 1) % VULKAN_MAX_GEOMETRY_COUNT;
+            break;
+        }
+    }
+
+    if (!data) {
+        VERROR("No free geometry slot, the maximum is %u", VULKAN_MAX_GEOMETRY_COUNT);
+        return FALSE;
+    }
+
+    // Offsets are multiples of the element size so draws can address them in elements
+    u64 vertex_bytes = (u64)vertex_size * vertex_count;
+    if (!take_buffer_range(&context.object_vertex_buffer, vertex_bytes, vertex_size, &data->vertex_buffer_offset)) {
+        VERROR("Failed to find room for %llu bytes of vertices", vertex_bytes);
+        data->id = INVALID_ID;
+        return FALSE;
+    }
+
+    u64 index_bytes = (u64)sizeof(u32) * index_count;
+    if (index_count && !take_buffer_range(&context.object_index_buffer, index_bytes, sizeof(u32), &data->index_buffer_offset)) {
+        VERROR("Failed to find room for %llu bytes of indices", index_bytes);
+        vulkan_buffer_free(&context.object_vertex_buffer, vertex_bytes, data->vertex_buffer_offset);
+        data->id = INVALID_ID;
+        return FALSE;
+    }
+
+    data->vertex_count = vertex_count;
+    data->vertex_element_size = vertex_size;
+    data->index_count = index_count;
+    data->index_element_size = sizeof(u32);
+
+    // Large meshes go through the transfer queue and show up once it is done with them,
+    // the staging ring takes whatever could not get a staging buffer there
+    u64 vertex_serial = 0;
+    u64 index_serial = 0;
+    if (vertex_bytes + index_bytes >= VULKAN_ASYNC_UPLOAD_THRESHOLD) {
+        vulkan_transfer_upload_buffer(&context, &context.transfer, &context.object_vertex_buffer,
+            data->vertex_buffer_offset, vertex_bytes, vertices, &vertex_serial);
+        if (index_count) {
+            vulkan_transfer_upload_buffer(&context, &context.transfer, &context.object_index_buffer,
+                data->index_buffer_offset, index_bytes, indices, &index_serial);
+        }
+    }
+
+    if (vertex_serial == 0)
+        vulkan_staging_upload_buffer(&context, &context.staging_ring, &context.object_vertex_buffer, data->vertex_buffer_offset, vertex_bytes, vertices);
+    if (index_count && index_serial == 0)
+        vulkan_staging_upload_buffer(&context, &context.staging_ring, &context.object_index_buffer, data->index_buffer_offset, index_bytes, indices);
+    data->upload_serial = vertex_serial > index_serial ? vertex_serial : index_serial;
+
+    out_geometry->internal_id = data->id;
+    out_geometry->generation = data->generation;
+    return TRUE;
+}
+
+void vulkan_renderer_backend_destroy_geometry(renderer_backend* backend, geometry* geometry) {
+    vulkan_geometry_data* data = find_geometry(geometry);
+    if (!data) {
+        VWARN("vulkan_renderer_backend_destroy_geometry - invalid or already destroyed geometry");
+        return;
+    }
 
-    for (u32 idx = 0; idx != memory_properties.memoryTypeCount; ++idx) {
-        if (type_filter & (1 << idx) && (memory_properties.memoryTypes[idx].propertyFlags & property_flags) == property_flags)
-            return idx;
+    // Frames in flight and the one being recorded may still draw it, the ranges are released once they completed.
+    // The slot alone is not enough, present already moved current_frame past the last submitted frame
+    vulkan_geometry_release release;
+    release.vertex_buffer_offset = data->vertex_buffer_offset;
+    release.vertex_size = (u64)data->vertex_element_size * data->vertex_count;
+    release.index_buffer_offset = data->index_buffer_offset;
+    release.index_size = (u64)data->index_element_size * data->index_count;
+    release.upload_serial = data->upload_serial;
+    release.frame_number = context.frame_number;
+    darray_push(context.geometry_releases, release);
+
+    data->id = INVALID_ID;
+    data->generation++;
+    geometry->internal_id = INVALID_ID;
+    geometry->generation = INVALID_ID;
+}
+
+b8 vulkan_renderer_backend_geometry_is_ready(renderer_backend* backend, const geometry* geometry) {
+    vulkan_geometry_data* data = find_geometry(geometry);
+    return data && vulkan_transfer_is_complete(&context.transfer, data->upload_serial);
+}
+
+void vulkan_renderer_backend_draw_geometry(renderer_backend* backend, const geometry_render_data* data) {
+    if (!context.main_pass_begun) {
+        begin_main_pass(VK_SUBPASS_CONTENTS_INLINE);
+    } else if (context.main_pass_contents != VK_SUBPASS_CONTENTS_INLINE) {
+        VERROR("vulkan_renderer_backend_draw_geometry - the frame already executed draw batches, draws cannot be recorded inline");
+        return;
     }
 
-    VWARN("Unable to find suitable memory type");
-    return -1;
+    record_geometry(context.frame_command_buffer, data);
+}
+
+void* vulkan_renderer_backend_begin_draw_batch(renderer_backend* backend) {
+    vulkan_command_buffer* command_buffer = vulkan_frame_pool_get_command_buffer(&context, &context.graphics_frame_pool, context.current_frame, FALSE);
+    if (!command_buffer)
+        return 0;
+
+    vulkan_command_buffer_begin_secondary(
+        command_buffer,
+        context.main_renderpass.handle,
+        0,
+        context.swapchain.framebuffers[context.image_index].handle,
+        vulkan_frame_counters_statistics(&context.frame_counters));
+
+    // Secondary command buffers inherit no state from the primary
+    set_draw_state(command_buffer);
+    return command_buffer;
 }
 
-void create_command_buffers(renderer_backend* backend) {
-    if (!context.graphics_command_buffers) {
-        context.graphics_command_buffers = darray_reserve(vulkan_command_buffer, context.swapchain.image_count);
-        for (u32 idx = 0; idx != context.swapchain.image_count; ++idx)
-            vzero_memory(&context.graphics_command_buffers[idx], sizeof(vulkan_command_buffer));   
+void vulkan_renderer_backend_draw_geometry_batch(renderer_backend* backend, void* batch, const geometry_render_data* data) {
+    record_geometry((vulkan_command_buffer*)batch, data);
+}
+
+void vulkan_renderer_backend_end_draw_batch(renderer_backend* backend, void* batch) {
+    vulkan_command_buffer_end_recording((vulkan_command_buffer*)batch);
+}
+
+void vulkan_renderer_backend_execute_draw_batches(renderer_backend* backend, u32 count, void* const* batches) {
+    if (!context.main_pass_begun) {
+        begin_main_pass(VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    } else if (context.main_pass_contents != VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS) {
+        VERROR("vulkan_renderer_backend_execute_draw_batches - the frame already recorded draws inline, %u batches dropped", count);
+        return;
     }
 
-    for (u32 idx = 0; idx != context.swapchain.image_count; ++idx) {
-        if (context.graphics_command_buffers[idx].handle)
-            vulkan_command_buffer_free(&context, context.device.graphics_command_pool, &context.graphics_command_buffers[idx]);
+    if (count)
+        vulkan_command_buffer_execute_commands(context.frame_command_buffer, count, (vulkan_command_buffer* const*)batches);
+}
+
+void set_draw_state(vulkan_command_buffer* command_buffer) {
+    // Dynamic state
+    VkViewport viewport;
+    viewport.x = 0.0f;
+    viewport.y = (f32)context.framebuffer_height; // Vulkan starts at top left we want to make sure we always strat bottom left like OpenGL
+    viewport.width = (f32)context.framebuffer_width;
+    viewport.height = - (f32)context.framebuffer_height; // Render botton up
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
 
-        vzero_memory(&context.graphics_command_buffers[idx], sizeof(vulkan_command_buffer));
-        vulkan_command_buffer_allocate(&context, 
-            context.device.graphics_command_pool, 
-            TRUE, 
-            &context.graphics_command_buffers[idx]);
+    // Scissor
+    VkRect2D scissor;
+    scissor.offset.x = scissor.offset.y = 0;
+    scissor.extent.width = context.framebuffer_width;
+    scissor.extent.height = context.framebuffer_height;
+
+    // Set view port and clipping space
+    vkCmdSetViewport(command_buffer->handle, 0, 1, &viewport);
+    vkCmdSetScissor(command_buffer->handle, 0, 1, &scissor);
+
+    // Bound once, draws pick their geometry with the vertex offset and the first index.
+    // The vertex buffer is bound by the first draw, with the stride of its geometry
+    vulkan_pipeline_bind(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, &context.default_pipeline);
+    vulkan_buffer_bind_index(command_buffer, &context.object_index_buffer, 0, VK_INDEX_TYPE_UINT32);
+}
+
+void begin_main_pass(VkSubpassContents contents) {
+    vulkan_command_buffer* command_buffer = context.frame_command_buffer;
+    vulkan_gpu_timer_write(&context.gpu_timer, command_buffer, context.current_frame,
+        VULKAN_GPU_TIMESTAMP_MAIN_PASS_BEGIN, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+    vulkan_renderpass_begin(command_buffer, &context.main_renderpass, context.swapchain.framebuffers[context.image_index].handle, contents);
+    context.main_pass_begun = TRUE;
+    context.main_pass_contents = contents;
+
+    // Only inline draws use the state of the primary
+    if (contents == VK_SUBPASS_CONTENTS_INLINE)
+        set_draw_state(command_buffer);
+}
+
+void record_geometry(vulkan_command_buffer* command_buffer, const geometry_render_data* data) {
+    vulkan_geometry_data* geometry = find_geometry(data->geometry);
+    if (!geometry) {
+        VWARN("vulkan_renderer_backend_draw_geometry - invalid or destroyed geometry");
+        return;
+    }
+
+    // Still being uploaded by the transfer queue
+    if (!vulkan_transfer_is_complete(&context.transfer, geometry->upload_serial))
+        return;
+
+    // Geometry is placed at multiples of its vertex size, rebinding only when the size changes
+    if (command_buffer->vertex_stride != geometry->vertex_element_size)
+        vulkan_buffer_bind_vertex_strided(command_buffer, &context.object_vertex_buffer, 0, geometry->vertex_element_size);
+
+    i32 vertex_offset = (i32)(geometry->vertex_buffer_offset / geometry->vertex_element_size);
+    if (geometry->index_count) {
+        u32 first_index = (u32)(geometry->index_buffer_offset / geometry->index_element_size);
+        vulkan_command_buffer_draw_indexed(command_buffer, geometry->index_count, 1, first_index, vertex_offset, 0);
+    } else {
+        vulkan_command_buffer_draw(command_buffer, geometry->vertex_count, 1, (u32)vertex_offset, 0);
+    }
+}
+
+b8 create_buffers(vulkan_context* context) {
+    const u64 vertex_buffer_size = 64ull * 1024 * 1024;
+    if (!vulkan_buffer_create(context, vertex_buffer_size,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VULKAN_MEMORY_USAGE_GPU_ONLY, &context->object_vertex_buffer)) {
+        VERROR("Error creating the vertex buffer");
+        return FALSE;
+    }
+
+    const u64 index_buffer_size = 16ull * 1024 * 1024;
+    if (!vulkan_buffer_create(context, index_buffer_size,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VULKAN_MEMORY_USAGE_GPU_ONLY, &context->object_index_buffer)) {
+        VERROR("Error creating the index buffer");
+        return FALSE;
+    }
+
+    // Upload space of each frame in flight, larger uploads are split up
+    const u64 staging_frame_size = 4ull * 1024 * 1024;
+    if (!vulkan_staging_ring_create(context, staging_frame_size, context->swapchain.max_frames_in_flight,
+        context->device.graphics_command_pool, context->device.graphics_queue, &context->staging_ring)) {
+        VERROR("Error creating the staging ring");
+        return FALSE;
+    }
+
+    if (!vulkan_transfer_create(context, &context->transfer)) {
+        VERROR("Error creating the transfer queue uploads");
+        return FALSE;
+    }
+
+    for (u32 idx = 0; idx != VULKAN_MAX_GEOMETRY_COUNT; ++idx) {
+        context->geometries[idx].id = INVALID_ID;
+        context->geometries[idx].generation = 0;
+    }
+
+    context->geometry_releases = darray_create(vulkan_geometry_release);
+
+    return TRUE;
+}
+
+void destroy_buffers(vulkan_context* context) {
+    if (context->geometry_releases) {
+        darray_destroy(context->geometry_releases);
+        context->geometry_releases = 0;
     }
-    VINFO("Vulkan command buffers created");
+
+    vulkan_transfer_destroy(context, &context->transfer);
+    vulkan_staging_ring_destroy(context, &context->staging_ring);
+    vulkan_buffer_destroy(context, &context->object_index_buffer);
+    vulkan_buffer_destroy(context, &context->object_vertex_buffer);
+}
+
+void release_geometries(vulkan_context* context) {
+    vulkan_geometry_release* releases = context->geometry_releases;
+    u32 count = (u32)darray_length(releases);
+    u32 kept = 0;
+    for (u32 idx = 0; idx != count; ++idx) {
+        // A frame may still draw from the ranges or the transfer queue still write into them, try again next frame
+        if (!vulkan_frame_is_complete(context, releases[idx].frame_number) ||
+            !vulkan_transfer_is_complete(&context->transfer, releases[idx].upload_serial)) {
+            releases[kept++] = releases[idx];
+            continue;
+        }
+
+        vulkan_buffer_free(&context->object_vertex_buffer, releases[idx].vertex_size, releases[idx].vertex_buffer_offset);
+        if (releases[idx].index_size)
+            vulkan_buffer_free(&context->object_index_buffer, releases[idx].index_size, releases[idx].index_buffer_offset);
+    }
+    darray_length_set(releases, kept);
 }
 
 void regenerate_framebuffers(renderer_backend* backend, vulkan_swapchain* swapchain, vulkan_renderpass* renderpass) {
@@ -526,9 +986,8 @@ b8 recreate_swapchain(renderer_backend* backend) {
     VkResult res = vkDeviceWaitIdle(context.device.logical_device);
     VK_CHECK(res);
 
-    // Clear out just in case
-    for (u32 idx = 0; idx != context.swapchain.image_count; ++idx)
-        context.images_in_flight[idx].handle = 0;
+    // The device is idle, no frame renders to the images anymore. Their count may change
+    vfree(context.image_frame_numbers, sizeof(u64) * context.swapchain.image_count, MEMORY_TAG_RENDERER);
 
 
     // Destroy Old FrameBuffers
@@ -537,6 +996,8 @@ b8 recreate_swapchain(renderer_backend* backend) {
 
     // Recreate
     vulkan_swapchain_recreate(&context, cached_framebuffer_width, cached_framebuffer_height, &context.swapchain);
+    context.image_frame_numbers = vallocate(sizeof(u64) * context.swapchain.image_count, MEMORY_TAG_RENDERER);
+    vzero_memory(context.image_frame_numbers, sizeof(u64) * context.swapchain.image_count);
 
     // Sync size
     context.framebuffer_width = cached_framebuffer_width;
@@ -555,9 +1016,8 @@ b8 recreate_swapchain(renderer_backend* backend) {
     context.main_renderpass.w = (f32)context.framebuffer_width;
     context.main_renderpass.h = (f32)context.framebuffer_height;
 
-    // Create new framebuffers + command buffers for the swapchain
+    // Create new framebuffers for the swapchain, command buffers are per frame in flight and stay
     regenerate_framebuffers(backend, &context.swapchain, &context.main_renderpass);
-    create_command_buffers(backend);
 
     // Flip flag
     context.recreating_swapchain = FALSE;
@@ -6,4 +6,21 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
 void vulkan_renderer_backend_shutdown (renderer_backend* backend);
 void vulkan_renderer_backend_resized (renderer_backend* backend, u32 width, u32 height);
 b8 vulkan_renderer_backend_begin_frame (renderer_backend* backend, f64 delta_time);
-b8 vulkan_renderer_backend_end_frame (renderer_backend* backend, f64 delta_time);
\ No newline at end of file
+b8 vulkan_renderer_backend_end_frame (renderer_backend* backend, f64 delta_time);
+void vulkan_renderer_backend_get_frame_counters(renderer_backend* backend, renderer_frame_counters* out_counters);
+i32 vulkan_renderer_backend_get_memory_usage(renderer_backend* backend, char* buffer, u64 size);
+void vulkan_renderer_backend_get_upload_stats(renderer_backend* backend, renderer_upload_stats* out_stats);
+#if defined(VKR_ENABLE_CHECKS)
+renderer_check_status vulkan_renderer_backend_check_memory_step(renderer_backend* backend);
+renderer_check_status vulkan_renderer_backend_check_compute_step(renderer_backend* backend);
+renderer_check_status vulkan_renderer_backend_check_timeline_step(renderer_backend* backend);
+#endif
+b8 vulkan_renderer_backend_create_geometry(renderer_backend* backend, u32 vertex_size, u32 vertex_count, const void* vertices,
+    u32 index_count, const u32* indices, geometry* out_geometry);
+void vulkan_renderer_backend_destroy_geometry(renderer_backend* backend, geometry* geometry);
+b8 vulkan_renderer_backend_geometry_is_ready(renderer_backend* backend, const geometry* geometry);
+void vulkan_renderer_backend_draw_geometry(renderer_backend* backend, const geometry_render_data* data);
+void* vulkan_renderer_backend_begin_draw_batch(renderer_backend* backend);
+void vulkan_renderer_backend_draw_geometry_batch(renderer_backend* backend, void* batch, const geometry_render_data* data);
+void vulkan_renderer_backend_end_draw_batch(renderer_backend* backend, void* batch);
+void vulkan_renderer_backend_execute_draw_batches(renderer_backend* backend, u32 count, void* const* batches);
\ No newline at end of file
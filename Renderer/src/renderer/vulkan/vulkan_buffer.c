@@ -0,0 +1,200 @@
+#include "vulkan_buffer.h"
+#include "vulkan_command_buffer.h"
+#include "vulkan_memory_allocator.h"
+#include "vulkan_utils.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+
+static b8 is_host_visible(vulkan_memory_usage memory_usage) {
+    return memory_usage != VULKAN_MEMORY_USAGE_GPU_ONLY;
+}
+
+static b8 create_buffer(
+    vulkan_context* context,
+    u64 size,
+    VkBufferUsageFlags usage,
+    vulkan_memory_usage memory_usage,
+    b8 is_concurrent,
+    vulkan_buffer* out_buffer) {
+    vzero_memory(out_buffer, sizeof(vulkan_buffer));
+    out_buffer->total_size = size;
+    out_buffer->memory_usage = memory_usage;
+
+    // Device local contents only get in and out through copies
+    if (!is_host_visible(memory_usage))
+        usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    out_buffer->usage = usage;
+
+    VkBufferCreateInfo buffer_info = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    buffer_info.size = size;
+    buffer_info.usage = usage;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE; // NOTE: only used on one queue
+
+    // Nothing to share when compute runs on the graphics family
+    u32 families[2] = { context->device.graphics_queue_index, context->device.compute_queue_index };
+    if (is_concurrent && families[0] != families[1]) {
+        buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        buffer_info.queueFamilyIndexCount = 2;
+        buffer_info.pQueueFamilyIndices = families;
+    }
+    out_buffer->is_concurrent = is_concurrent;
+
+    VkResult res = vkCreateBuffer(context->device.logical_device, &buffer_info, context->allocator, &out_buffer->handle);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkCreateBuffer failed with result: %s", vulkan_result_string(res, TRUE));
+        return FALSE;
+    }
+
+    u32 flags = is_host_visible(memory_usage) ? VULKAN_MEMORY_FLAG_MAPPED : 0;
+    if (!vulkan_memory_allocate_buffer(context, out_buffer->handle, memory_usage, flags, &out_buffer->memory)) {
+        VERROR("Failed to allocate memory for a buffer of %llu bytes", size);
+        vkDestroyBuffer(context->device.logical_device, out_buffer->handle, context->allocator);
+        out_buffer->handle = 0;
+        return FALSE;
+    }
+
+    freelist_create(size, &out_buffer->buffer_freelist);
+    return TRUE;
+}
+
+b8 vulkan_buffer_create(
+    vulkan_context* context,
+    u64 size,
+    VkBufferUsageFlags usage,
+    vulkan_memory_usage memory_usage,
+    vulkan_buffer* out_buffer) {
+    return create_buffer(context, size, usage, memory_usage, FALSE, out_buffer);
+}
+
+b8 vulkan_buffer_create_concurrent(
+    vulkan_context* context,
+    u64 size,
+    VkBufferUsageFlags usage,
+    vulkan_memory_usage memory_usage,
+    vulkan_buffer* out_buffer) {
+    return create_buffer(context, size, usage, memory_usage, TRUE, out_buffer);
+}
+
+void vulkan_buffer_destroy(vulkan_context* context, vulkan_buffer* buffer) {
+    freelist_destroy(&buffer->buffer_freelist);
+    if (buffer->memory.memory)
+        vulkan_memory_free(context, &buffer->memory);
+    if (buffer->handle)
+        vkDestroyBuffer(context->device.logical_device, buffer->handle, context->allocator);
+
+    buffer->handle = 0;
+    buffer->total_size = 0;
+    buffer->usage = 0;
+    buffer->is_locked = FALSE;
+}
+
+b8 vulkan_buffer_resize(
+    vulkan_context* context,
+    u64 new_size,
+    vulkan_buffer* buffer,
+    VkCommandPool pool,
+    VkQueue queue) {
+    if (new_size <= buffer->total_size) {
+        VERROR("vulkan_buffer_resize - new size %llu must exceed the current size %llu", new_size, buffer->total_size);
+        return FALSE;
+    }
+
+    vulkan_buffer resized;
+    if (!create_buffer(context, new_size, buffer->usage, buffer->memory_usage, buffer->is_concurrent, &resized))
+        return FALSE;
+
+    // The old buffer may still be read by frames in flight
+    VkResult res = vkDeviceWaitIdle(context->device.logical_device);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkDeviceWaitIdle failed with result: %s", vulkan_result_string(res, TRUE));
+        vulkan_buffer_destroy(context, &resized);
+        return FALSE;
+    }
+
+    if (is_host_visible(buffer->memory_usage))
+        vcopy_memory(resized.memory.mapped, buffer->memory.mapped, buffer->total_size);
+    else
+        vulkan_buffer_copy_to(context, pool, queue, buffer->handle, 0, resized.handle, 0, buffer->total_size);
+
+    // The handed out ranges carry over, the new space is free
+    freelist_destroy(&resized.buffer_freelist);
+    resized.buffer_freelist = buffer->buffer_freelist;
+    freelist_resize(&resized.buffer_freelist, new_size);
+    buffer->buffer_freelist.nodes = 0;
+
+    vulkan_buffer_destroy(context, buffer);
+    *buffer = resized;
+    return TRUE;
+}
+
+void* vulkan_buffer_map(vulkan_context* context, vulkan_buffer* buffer, u64 offset, u64 size) {
+    if (!buffer->memory.mapped) {
+        VERROR("vulkan_buffer_map - the buffer is not host visible");
+        return 0;
+    }
+
+    if (offset + size > buffer->total_size) {
+        VERROR("vulkan_buffer_map - range %llu+%llu is outside of the buffer of size %llu", offset, size, buffer->total_size);
+        return 0;
+    }
+
+    buffer->is_locked = TRUE;
+    return (u8*)buffer->memory.mapped + offset;
+}
+
+void vulkan_buffer_unmap(vulkan_context* context, vulkan_buffer* buffer) {
+    buffer->is_locked = FALSE;
+}
+
+void vulkan_buffer_load_data(vulkan_context* context, vulkan_buffer* buffer, u64 offset, u64 size, const void* data) {
+    void* dest = vulkan_buffer_map(context, buffer, offset, size);
+    if (dest) {
+        vcopy_memory(dest, (void*)data, size);
+        vulkan_buffer_unmap(context, buffer);
+    }
+}
+
+void vulkan_buffer_copy_to(
+    vulkan_context* context,
+    VkCommandPool pool,
+    VkQueue queue,
+    VkBuffer source,
+    u64 source_offset,
+    VkBuffer dest,
+    u64 dest_offset,
+    u64 size) {
+    vulkan_command_buffer command_buffer;
+    vulkan_command_buffer_allocate_begin_single_use(context, pool, &command_buffer);
+
+    VkBufferCopy region;
+    region.srcOffset = source_offset;
+    region.dstOffset = dest_offset;
+    region.size = size;
+    vkCmdCopyBuffer(command_buffer.handle, source, dest, 1, &region);
+
+    vulkan_command_buffer_end_single_use(context, pool, &command_buffer, queue);
+}
+
+b8 vulkan_buffer_allocate(vulkan_buffer* buffer, u64 size, u64 alignment, u64* out_offset) {
+    return freelist_allocate_block(&buffer->buffer_freelist, size, alignment, out_offset);
+}
+
+b8 vulkan_buffer_free(vulkan_buffer* buffer, u64 size, u64 offset) {
+    return freelist_free_block(&buffer->buffer_freelist, size, offset);
+}
+
+void vulkan_buffer_bind_vertex(vulkan_command_buffer* command_buffer, vulkan_buffer* buffer, u64 offset) {
+    VkDeviceSize offsets[1] = { offset };
+    vkCmdBindVertexBuffers(command_buffer->handle, 0, 1, &buffer->handle, offsets);
+}
+
+void vulkan_buffer_bind_vertex_strided(vulkan_command_buffer* command_buffer, vulkan_buffer* buffer, u64 offset, u32 stride) {
+    VkDeviceSize offsets[1] = { offset };
+    VkDeviceSize strides[1] = { stride };
+    vkCmdBindVertexBuffers2(command_buffer->handle, 0, 1, &buffer->handle, offsets, 0, strides);
+    command_buffer->vertex_stride = stride;
+}
+
+void vulkan_buffer_bind_index(vulkan_command_buffer* command_buffer, vulkan_buffer* buffer, u64 offset, VkIndexType index_type) {
+    vkCmdBindIndexBuffer(command_buffer->handle, buffer->handle, offset, index_type);
+}
@@ -0,0 +1,155 @@
+#pragma once
+#include "vulkan_types.inl"
+
+/*
+* Creates a buffer and binds memory to it. Host visible buffers are
+* mapped once here, device local buffers can be copied into and out of.
+*
+* @param context - The vulkan context
+* @param size - Size of the buffer in bytes
+* @param usage - How the buffer is used (vertex, index, uniform, transfer...)
+* @param memory_usage - What the memory of the buffer is used for
+* @param out_buffer - The created buffer
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_buffer_create(
+    vulkan_context* context,
+    u64 size,
+    VkBufferUsageFlags usage,
+    vulkan_memory_usage memory_usage,
+    vulkan_buffer* out_buffer);
+
+/*
+* Creates a buffer both the graphics and the compute queue access, e.g. the
+* output of async compute read by draws. No queue family ownership transfers
+* are needed for it, which can make access slower on some devices.
+*
+* @param context - The vulkan context
+* @param size - Size of the buffer in bytes
+* @param usage - How the buffer is used (storage, vertex, indirect...)
+* @param memory_usage - What the memory of the buffer is used for
+* @param out_buffer - The created buffer
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_buffer_create_concurrent(
+    vulkan_context* context,
+    u64 size,
+    VkBufferUsageFlags usage,
+    vulkan_memory_usage memory_usage,
+    vulkan_buffer* out_buffer);
+
+/*
+* Destroys the buffer and frees its memory. The GPU must not use it anymore.
+*
+* @param context - The vulkan context
+* @param buffer - The buffer to destroy
+*/
+void vulkan_buffer_destroy(vulkan_context* context, vulkan_buffer* buffer);
+
+/*
+* Grows a buffer, keeping its contents and the ranges handed out. Waits
+* for the device to go idle since the old buffer may still be in use.
+* Uploads into the buffer that have not been flushed are lost.
+*
+* @param context - The vulkan context
+* @param new_size - The new size, must be larger than the current one
+* @param buffer - The buffer to resize
+* @param pool - Command pool for the copy of device local contents
+* @param queue - Queue the copy is submitted to
+* @return b8 - TRUE if successful, FALSE otherwise. The old buffer stays valid on failure
+*/
+b8 vulkan_buffer_resize(
+    vulkan_context* context,
+    u64 new_size,
+    vulkan_buffer* buffer,
+    VkCommandPool pool,
+    VkQueue queue);
+
+/*
+* Gets a host pointer to a range of a host visible buffer.
+*
+* @param context - The vulkan context
+* @param buffer - The buffer
+* @param offset - Offset of the range in bytes
+* @param size - Size of the range in bytes
+* @return void* - Pointer to the range, 0 if the buffer is not host visible
+*/
+void* vulkan_buffer_map(vulkan_context* context, vulkan_buffer* buffer, u64 offset, u64 size);
+
+/*
+* Ends host access started with vulkan_buffer_map. The memory is coherent,
+* writes are visible to the GPU without a flush.
+*
+* @param context - The vulkan context
+* @param buffer - The buffer
+*/
+void vulkan_buffer_unmap(vulkan_context* context, vulkan_buffer* buffer);
+
+/*
+* Copies data into a host visible buffer.
+*
+* @param context - The vulkan context
+* @param buffer - The buffer
+* @param offset - Offset in the buffer in bytes
+* @param size - Amount of bytes to copy
+* @param data - The data to copy
+*/
+void vulkan_buffer_load_data(vulkan_context* context, vulkan_buffer* buffer, u64 offset, u64 size, const void* data);
+
+/*
+* Copies a range between buffers with a single use command buffer and waits for it.
+*
+* @param context - The vulkan context
+* @param pool - Command pool the command buffer is allocated from
+* @param queue - Queue the copy is submitted to
+* @param source - Buffer to copy from
+* @param source_offset - Offset in the source buffer
+* @param dest - Buffer to copy to
+* @param dest_offset - Offset in the destination buffer
+* @param size - Amount of bytes to copy
+*/
+void vulkan_buffer_copy_to(
+    vulkan_context* context,
+    VkCommandPool pool,
+    VkQueue queue,
+    VkBuffer source,
+    u64 source_offset,
+    VkBuffer dest,
+    u64 dest_offset,
+    u64 size);
+
+/*
+* Takes a range of the buffer for a resource.
+*
+* @param buffer - The buffer
+* @param size - Size of the range in bytes
+* @param alignment - The offset is a multiple of it
+* @param out_offset - Offset of the range
+* @return b8 - TRUE if successful, FALSE if the buffer has no free range of that size
+*/
+b8 vulkan_buffer_allocate(vulkan_buffer* buffer, u64 size, u64 alignment, u64* out_offset);
+
+/*
+* Returns a range taken with vulkan_buffer_allocate.
+*
+* @param buffer - The buffer
+* @param size - Size of the range in bytes
+* @param offset - Offset of the range
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_buffer_free(vulkan_buffer* buffer, u64 size, u64 offset);
+
+void vulkan_buffer_bind_vertex(vulkan_command_buffer* command_buffer, vulkan_buffer* buffer, u64 offset);
+
+/*
+* Binds a vertex buffer with the stride given at record time.
+* The bound pipeline needs VK_DYNAMIC_STATE_VERTEX_INPUT_BINDING_STRIDE.
+*
+* @param command_buffer - The command buffer, remembers the stride
+* @param buffer - The vertex buffer
+* @param offset - Offset of the first vertex
+* @param stride - Distance between two vertices in bytes
+*/
+void vulkan_buffer_bind_vertex_strided(vulkan_command_buffer* command_buffer, vulkan_buffer* buffer, u64 offset, u32 stride);
+
+void vulkan_buffer_bind_index(vulkan_command_buffer* command_buffer, vulkan_buffer* buffer, u64 offset, VkIndexType index_type);
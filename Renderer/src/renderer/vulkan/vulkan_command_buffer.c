@@ -46,6 +46,32 @@ void vulkan_command_buffer_begin_recording(
     VkResult res = vkBeginCommandBuffer(command_buffer->handle, &begin_info);
     VK_CHECK(res);
     command_buffer->state = COMMAND_BUFFER_STATE_RECORDING;
+    vzero_memory(&command_buffer->counters, sizeof(vulkan_command_counters));
+    command_buffer->vertex_stride = 0;
+}
+
+void vulkan_command_buffer_begin_secondary(
+    vulkan_command_buffer* command_buffer,
+    VkRenderPass renderpass,
+    u32 subpass,
+    VkFramebuffer framebuffer,
+    VkQueryPipelineStatisticFlags pipeline_statistics) {
+    VkCommandBufferInheritanceInfo inheritance_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+    inheritance_info.renderPass = renderpass;
+    inheritance_info.subpass = subpass;
+    inheritance_info.framebuffer = framebuffer;
+    inheritance_info.occlusionQueryEnable = VK_FALSE;
+    inheritance_info.pipelineStatistics = pipeline_statistics;
+
+    VkCommandBufferBeginInfo begin_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_info.pInheritanceInfo = &inheritance_info;
+
+    VkResult res = vkBeginCommandBuffer(command_buffer->handle, &begin_info);
+    VK_CHECK(res);
+    command_buffer->state = COMMAND_BUFFER_STATE_IN_RENDER_PASS;
+    vzero_memory(&command_buffer->counters, sizeof(vulkan_command_counters));
+    command_buffer->vertex_stride = 0;
 }
 
 void vulkan_command_buffer_end_recording(vulkan_command_buffer* command_buffer) {
@@ -92,4 +118,98 @@ void vulkan_command_buffer_end_single_use(
 
     // Free command buffer
     vulkan_command_buffer_free(context, pool, command_buffer);
-}
\ No newline at end of file
+}
+
+void vulkan_command_buffer_draw(
+    vulkan_command_buffer* command_buffer,
+    u32 vertex_count,
+    u32 instance_count,
+    u32 first_vertex,
+    u32 first_instance) {
+    vkCmdDraw(command_buffer->handle, vertex_count, instance_count, first_vertex, first_instance);
+    ++command_buffer->counters.draw_calls;
+    command_buffer->counters.triangles += (u64)(vertex_count / 3) * instance_count; // Triangle lists
+}
+
+void vulkan_command_buffer_draw_indexed(
+    vulkan_command_buffer* command_buffer,
+    u32 index_count,
+    u32 instance_count,
+    u32 first_index,
+    i32 vertex_offset,
+    u32 first_instance) {
+    vkCmdDrawIndexed(command_buffer->handle, index_count, instance_count, first_index, vertex_offset, first_instance);
+    ++command_buffer->counters.draw_calls;
+    command_buffer->counters.triangles += (u64)(index_count / 3) * instance_count; // Triangle lists
+}
+
+void vulkan_command_buffer_dispatch(
+    vulkan_command_buffer* command_buffer,
+    u32 group_count_x,
+    u32 group_count_y,
+    u32 group_count_z) {
+    vkCmdDispatch(command_buffer->handle, group_count_x, group_count_y, group_count_z);
+    ++command_buffer->counters.dispatches;
+}
+
+void vulkan_command_buffer_execute_commands(
+    vulkan_command_buffer* command_buffer,
+    u32 secondary_count,
+    vulkan_command_buffer* const* secondaries) {
+    // Handles are gathered in chunks, any amount of secondaries can be executed
+    VkCommandBuffer handles[32];
+    u32 handle_count = 0;
+    for (u32 idx = 0; idx != secondary_count; ++idx) {
+        const vulkan_command_counters* counters = &secondaries[idx]->counters;
+        command_buffer->counters.draw_calls += counters->draw_calls;
+        command_buffer->counters.triangles += counters->triangles;
+        command_buffer->counters.barriers += counters->barriers;
+        command_buffer->counters.descriptor_binds += counters->descriptor_binds;
+        command_buffer->counters.pipeline_binds += counters->pipeline_binds;
+        secondaries[idx]->state = COMMAND_BUFFER_STATE_SUBMITTED;
+
+        handles[handle_count++] = secondaries[idx]->handle;
+        if (handle_count == 32 || idx + 1 == secondary_count) {
+            vkCmdExecuteCommands(command_buffer->handle, handle_count, handles);
+            handle_count = 0;
+        }
+    }
+}
+
+void vulkan_command_buffer_bind_pipeline(
+    vulkan_command_buffer* command_buffer,
+    VkPipelineBindPoint bind_point,
+    VkPipeline pipeline) {
+    vkCmdBindPipeline(command_buffer->handle, bind_point, pipeline);
+    ++command_buffer->counters.pipeline_binds;
+}
+
+void vulkan_command_buffer_bind_descriptor_sets(
+    vulkan_command_buffer* command_buffer,
+    VkPipelineBindPoint bind_point,
+    VkPipelineLayout layout,
+    u32 first_set,
+    u32 set_count,
+    const VkDescriptorSet* sets) {
+    vkCmdBindDescriptorSets(command_buffer->handle, bind_point, layout, first_set, set_count, sets, 0, 0);
+    command_buffer->counters.descriptor_binds += set_count;
+}
+
+void vulkan_command_buffer_pipeline_barrier(
+    vulkan_command_buffer* command_buffer,
+    VkPipelineStageFlags src_stage_mask,
+    VkPipelineStageFlags dst_stage_mask,
+    u32 buffer_barrier_count,
+    const VkBufferMemoryBarrier* buffer_barriers,
+    u32 image_barrier_count,
+    const VkImageMemoryBarrier* image_barriers) {
+    vkCmdPipelineBarrier(
+        command_buffer->handle,
+        src_stage_mask,
+        dst_stage_mask,
+        0,
+        0, 0,
+        buffer_barrier_count, buffer_barriers,
+        image_barrier_count, image_barriers);
+    command_buffer->counters.barriers += buffer_barrier_count + image_barrier_count;
+}
@@ -18,6 +18,22 @@ void vulkan_command_buffer_begin_recording(
     b8 is_renderpass_continue,
     b8 is_simultanious_use);
 
+/*
+* Begins recording a secondary command buffer that continues a render pass.
+*
+* @param command_buffer - The secondary command buffer
+* @param renderpass - The render pass it is executed in
+* @param subpass - The subpass it is executed in
+* @param framebuffer - The framebuffer of the render pass, 0 if not known
+* @param pipeline_statistics - Statistics of a query active in the primary command buffer, 0 for none
+*/
+void vulkan_command_buffer_begin_secondary(
+    vulkan_command_buffer* command_buffer,
+    VkRenderPass renderpass,
+    u32 subpass,
+    VkFramebuffer framebuffer,
+    VkQueryPipelineStatisticFlags pipeline_statistics);
+
 void vulkan_command_buffer_end_recording(vulkan_command_buffer* command_buffer);
 
 void vulkan_command_buffer_update_submit(vulkan_command_buffer* command_buffer);
@@ -33,4 +49,54 @@ void vulkan_command_buffer_end_single_use(
     vulkan_context* context,
     VkCommandPool pool,
     vulkan_command_buffer* command_buffer,
-    VkQueue queue);
\ No newline at end of file
+    VkQueue queue);
+
+// Recording helpers. They record the command and update the counters of the command buffer
+void vulkan_command_buffer_draw(
+    vulkan_command_buffer* command_buffer,
+    u32 vertex_count,
+    u32 instance_count,
+    u32 first_vertex,
+    u32 first_instance);
+
+void vulkan_command_buffer_draw_indexed(
+    vulkan_command_buffer* command_buffer,
+    u32 index_count,
+    u32 instance_count,
+    u32 first_index,
+    i32 vertex_offset,
+    u32 first_instance);
+
+void vulkan_command_buffer_dispatch(
+    vulkan_command_buffer* command_buffer,
+    u32 group_count_x,
+    u32 group_count_y,
+    u32 group_count_z);
+
+// Executes secondary command buffers, their counters are added to those of the primary
+void vulkan_command_buffer_execute_commands(
+    vulkan_command_buffer* command_buffer,
+    u32 secondary_count,
+    vulkan_command_buffer* const* secondaries);
+
+void vulkan_command_buffer_bind_pipeline(
+    vulkan_command_buffer* command_buffer,
+    VkPipelineBindPoint bind_point,
+    VkPipeline pipeline);
+
+void vulkan_command_buffer_bind_descriptor_sets(
+    vulkan_command_buffer* command_buffer,
+    VkPipelineBindPoint bind_point,
+    VkPipelineLayout layout,
+    u32 first_set,
+    u32 set_count,
+    const VkDescriptorSet* sets);
+
+void vulkan_command_buffer_pipeline_barrier(
+    vulkan_command_buffer* command_buffer,
+    VkPipelineStageFlags src_stage_mask,
+    VkPipelineStageFlags dst_stage_mask,
+    u32 buffer_barrier_count,
+    const VkBufferMemoryBarrier* buffer_barriers,
+    u32 image_barrier_count,
+    const VkImageMemoryBarrier* image_barriers);
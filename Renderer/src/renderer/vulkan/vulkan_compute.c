@@ -0,0 +1,97 @@
+#include "vulkan_compute.h"
+#include "vulkan_command_buffer.h"
+#include "vulkan_timeline.h"
+#include "vulkan_utils.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+
+b8 vulkan_compute_create(vulkan_context* context, u32 frame_count, vulkan_compute* out_compute) {
+    vzero_memory(out_compute, sizeof(vulkan_compute));
+    out_compute->queue = context->device.compute_queue;
+    out_compute->pool = context->device.compute_command_pool;
+    out_compute->frame_count = frame_count;
+    out_compute->recording_frame = INVALID_ID;
+    out_compute->command_buffers = vallocate(sizeof(vulkan_command_buffer) * frame_count, MEMORY_TAG_RENDERER);
+    out_compute->complete_semaphores = vallocate(sizeof(VkSemaphore) * frame_count, MEMORY_TAG_RENDERER);
+
+    for (u32 idx = 0; idx != frame_count; ++idx) {
+        vulkan_command_buffer_allocate(context, out_compute->pool, TRUE, &out_compute->command_buffers[idx]);
+
+        VkSemaphoreCreateInfo semaphore_info = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+        VkResult res = vkCreateSemaphore(context->device.logical_device, &semaphore_info, context->allocator, &out_compute->complete_semaphores[idx]);
+        if (!vulkan_result_is_success(res)) {
+            VERROR("vkCreateSemaphore failed with result: %s", vulkan_result_string(res, TRUE));
+            vulkan_compute_destroy(context, out_compute);
+            return FALSE;
+        }
+    }
+
+    if (context->device.compute_queue_index != context->device.graphics_queue_index) {
+        VINFO("Async compute runs on the queue family %u", context->device.compute_queue_index);
+    } else {
+        VINFO("No dedicated compute queue family, compute shares the graphics queue");
+    }
+    return TRUE;
+}
+
+void vulkan_compute_destroy(vulkan_context* context, vulkan_compute* compute) {
+    if (compute->command_buffers) {
+        for (u32 idx = 0; idx != compute->frame_count; ++idx) {
+            if (compute->command_buffers[idx].handle)
+                vulkan_command_buffer_free(context, compute->pool, &compute->command_buffers[idx]);
+        }
+        vfree(compute->command_buffers, sizeof(vulkan_command_buffer) * compute->frame_count, MEMORY_TAG_RENDERER);
+    }
+
+    if (compute->complete_semaphores) {
+        for (u32 idx = 0; idx != compute->frame_count; ++idx) {
+            if (compute->complete_semaphores[idx])
+                vkDestroySemaphore(context->device.logical_device, compute->complete_semaphores[idx], context->allocator);
+        }
+        vfree(compute->complete_semaphores, sizeof(VkSemaphore) * compute->frame_count, MEMORY_TAG_RENDERER);
+    }
+
+    vzero_memory(compute, sizeof(vulkan_compute));
+}
+
+vulkan_command_buffer* vulkan_compute_begin(vulkan_context* context, vulkan_compute* compute) {
+    if (compute->recording_frame != INVALID_ID)
+        return &compute->command_buffers[compute->recording_frame];
+
+    // The frame that last used the command buffer waited for it, so its completion covers the compute work
+    u32 frame = context->current_frame;
+    if (!vulkan_frame_wait(context, context->frame_slot_numbers[frame])) {
+        VERROR("vulkan_compute_begin - The compute work of frame %llu may still run", context->frame_slot_numbers[frame]);
+        return 0;
+    }
+
+    vulkan_command_buffer* command_buffer = &compute->command_buffers[frame];
+    vulkan_command_buffer_reset(command_buffer);
+    vulkan_command_buffer_begin_recording(command_buffer, TRUE, FALSE, FALSE);
+    compute->recording_frame = frame;
+    return command_buffer;
+}
+
+VkSemaphore vulkan_compute_submit(vulkan_context* context, vulkan_compute* compute) {
+    if (compute->recording_frame == INVALID_ID)
+        return 0;
+
+    vulkan_command_buffer* command_buffer = &compute->command_buffers[compute->recording_frame];
+    VkSemaphore semaphore = compute->complete_semaphores[compute->recording_frame];
+    compute->recording_frame = INVALID_ID;
+    vulkan_command_buffer_end_recording(command_buffer);
+
+    VkSubmitInfo submit_info = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer->handle;
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = &semaphore;
+    VkResult res = vkQueueSubmit(compute->queue, 1, &submit_info, 0);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkQueueSubmit of the compute work failed with result: %s", vulkan_result_string(res, TRUE));
+        return 0;
+    }
+
+    vulkan_command_buffer_update_submit(command_buffer);
+    return semaphore;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "vulkan_types.inl"
+
+/*
+* Creates the async compute path on the compute queue.
+*
+* @param context - The vulkan context, the device must exist
+* @param frame_count - Amount of frames in flight
+* @param out_compute - The compute that will be created
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_compute_create(vulkan_context* context, u32 frame_count, vulkan_compute* out_compute);
+
+/*
+* Destroys the command buffers and semaphores. The device must be idle.
+*
+* @param context - The vulkan context
+* @param compute - The compute to destroy
+*/
+void vulkan_compute_destroy(vulkan_context* context, vulkan_compute* compute);
+
+/*
+* Returns the compute command buffer of the current frame, it begins
+* recording on the first call of a frame. Resources shared with draws
+* need to be created with vulkan_buffer_create_concurrent or
+* vulkan_image_create_concurrent when the compute queue is of another
+* family. They are best kept per frame in flight, the next frame's
+* compute work may run while a frame still draws.
+*
+* @param context - The vulkan context
+* @param compute - The compute
+* @return vulkan_command_buffer* - The command buffer, outside of a render pass. 0 if waiting for
+* the frame that last used it failed
+*/
+vulkan_command_buffer* vulkan_compute_begin(vulkan_context* context, vulkan_compute* compute);
+
+/*
+* Submits the compute work recorded for the current frame.
+*
+* @param context - The vulkan context
+* @param compute - The compute
+* @return VkSemaphore - Signaled when the work completed, the frame has to wait on it.
+* 0 if nothing was recorded
+*/
+VkSemaphore vulkan_compute_submit(vulkan_context* context, vulkan_compute* compute);
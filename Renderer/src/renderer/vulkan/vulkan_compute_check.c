@@ -0,0 +1,221 @@
+#include "vulkan_compute_check.h"
+
+// Only built into renderers configured for testing
+#if defined(VKR_ENABLE_CHECKS)
+#include "vulkan_compute.h"
+#include "vulkan_compute_pipeline.h"
+#include "vulkan_buffer.h"
+#include "vulkan_command_buffer.h"
+#include "vulkan_timeline.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+
+// Values filled by one dispatch, a multiple of the work group size
+#define COMPUTE_CHECK_WORK_GROUP_SIZE 64
+#define COMPUTE_CHECK_VALUE_COUNT (COMPUTE_CHECK_WORK_GROUP_SIZE * 1024)
+// More dispatches than frames in flight, so every buffer and compute command buffer is reused
+#define COMPUTE_CHECK_DISPATCH_COUNT 8
+// Frames the dispatches may take until all of them are read back
+#define COMPUTE_CHECK_MAX_FRAMES 64
+
+/*
+* SPIR-V of the fill kernel:
+*
+*   #version 450
+*   layout(local_size_x = 64) in;
+*   layout(push_constant) uniform constants { uint seed; };
+*   layout(std430, binding = 0) buffer values { uint data[]; };
+*   void main() { uint i = gl_GlobalInvocationID.x; data[i] = i * 3u + seed; }
+*/
+static const u32 fill_spirv[] = {
+    0x07230203, 0x00010000, 0x00000000, 0x00000020, 0x00000000, 0x00020011,
+    0x00000001, 0x0003000e, 0x00000000, 0x00000001, 0x0006000f, 0x00000005,
+    0x00000001, 0x6e69616d, 0x00000000, 0x00000007, 0x00060010, 0x00000001,
+    0x00000011, 0x00000040, 0x00000001, 0x00000001, 0x00040047, 0x00000007,
+    0x0000000b, 0x0000001c, 0x00040047, 0x0000000b, 0x00000006, 0x00000004,
+    0x00050048, 0x0000000c, 0x00000000, 0x00000023, 0x00000000, 0x00030047,
+    0x0000000c, 0x00000003, 0x00040047, 0x0000000e, 0x00000022, 0x00000000,
+    0x00040047, 0x0000000e, 0x00000021, 0x00000000, 0x00050048, 0x0000000f,
+    0x00000000, 0x00000023, 0x00000000, 0x00030047, 0x0000000f, 0x00000002,
+    0x00020013, 0x00000002, 0x00030021, 0x00000003, 0x00000002, 0x00040015,
+    0x00000004, 0x00000020, 0x00000000, 0x00040017, 0x00000005, 0x00000004,
+    0x00000003, 0x00040020, 0x00000006, 0x00000001, 0x00000005, 0x0004003b,
+    0x00000006, 0x00000007, 0x00000001, 0x00040020, 0x00000008, 0x00000001,
+    0x00000004, 0x00040015, 0x00000009, 0x00000020, 0x00000001, 0x0004002b,
+    0x00000009, 0x0000000a, 0x00000000, 0x0003001d, 0x0000000b, 0x00000004,
+    0x0003001e, 0x0000000c, 0x0000000b, 0x00040020, 0x0000000d, 0x00000002,
+    0x0000000c, 0x0004003b, 0x0000000d, 0x0000000e, 0x00000002, 0x0003001e,
+    0x0000000f, 0x00000004, 0x00040020, 0x00000010, 0x00000009, 0x0000000f,
+    0x0004003b, 0x00000010, 0x00000011, 0x00000009, 0x00040020, 0x00000012,
+    0x00000009, 0x00000004, 0x00040020, 0x00000013, 0x00000002, 0x00000004,
+    0x0004002b, 0x00000004, 0x00000014, 0x00000003, 0x0004002b, 0x00000004,
+    0x00000015, 0x00000000, 0x00050036, 0x00000002, 0x00000001, 0x00000000,
+    0x00000003, 0x000200f8, 0x00000018, 0x00050041, 0x00000008, 0x00000019,
+    0x00000007, 0x00000015, 0x0004003d, 0x00000004, 0x0000001a, 0x00000019,
+    0x00050084, 0x00000004, 0x0000001b, 0x0000001a, 0x00000014, 0x00050041,
+    0x00000012, 0x0000001c, 0x00000011, 0x0000000a, 0x0004003d, 0x00000004,
+    0x0000001d, 0x0000001c, 0x00050080, 0x00000004, 0x0000001e, 0x0000001b,
+    0x0000001d, 0x00060041, 0x00000013, 0x0000001f, 0x0000000e, 0x0000000a,
+    0x0000001a, 0x0003003e, 0x0000001f, 0x0000001e, 0x000100fd, 0x00010038
+};
+
+// Buffer the compute work of a frame in flight fills, read back when the slot comes around again
+typedef struct compute_check_slot {
+    vulkan_buffer buffer;
+    VkDescriptorSet set;
+    b8 pending;
+    u32 seed;
+    u64 frame_number;
+} compute_check_slot;
+
+typedef struct compute_check_state {
+    b8 created;
+    // Failed checks keep their resources until shutdown, dispatches may still be in flight
+    b8 failed;
+    u32 step;
+    u32 dispatch_count;
+    u32 read_count;
+    u32 slot_count;
+    compute_check_slot* slots;
+    vulkan_compute_pipeline pipeline;
+} compute_check_state;
+
+static compute_check_state state;
+
+static b8 create_resources(vulkan_context* context) {
+    state.slot_count = context->compute.frame_count;
+    state.slots = vallocate(sizeof(compute_check_slot) * state.slot_count, MEMORY_TAG_RENDERER);
+
+    const VkDescriptorType binding_type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    if (!vulkan_compute_pipeline_create(context, sizeof(fill_spirv), fill_spirv, 1, &binding_type, sizeof(u32),
+        state.slot_count, &state.pipeline)) {
+        VERROR("Could not create the fill pipeline");
+        return FALSE;
+    }
+
+    // Written by the compute queue and read on the host after the graphics queue waited for it
+    for (u32 idx = 0; idx != state.slot_count; ++idx) {
+        compute_check_slot* slot = &state.slots[idx];
+        if (!vulkan_buffer_create_concurrent(context, sizeof(u32) * COMPUTE_CHECK_VALUE_COUNT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VULKAN_MEMORY_USAGE_GPU_TO_CPU, &slot->buffer)) {
+            VERROR("Could not create the storage buffer of frame %u", idx);
+            return FALSE;
+        }
+        if (!vulkan_compute_pipeline_allocate_set(context, &state.pipeline, &slot->set))
+            return FALSE;
+        vulkan_compute_set_storage_buffer(context, slot->set, 0, &slot->buffer, 0, VK_WHOLE_SIZE);
+    }
+    return TRUE;
+}
+
+static b8 record_dispatch(vulkan_context* context, compute_check_slot* slot) {
+    vulkan_command_buffer* command_buffer = vulkan_compute_begin(context, &context->compute);
+    if (!command_buffer)
+        return FALSE;
+    slot->seed = 0x9E3779B9u * (state.dispatch_count + 1);
+    vulkan_compute_pipeline_dispatch(command_buffer, &state.pipeline, slot->set, &slot->seed,
+        COMPUTE_CHECK_VALUE_COUNT / COMPUTE_CHECK_WORK_GROUP_SIZE, 1, 1);
+
+    // The semaphores order the work, the writes still have to be made visible to the host
+    VkBufferMemoryBarrier barrier = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = slot->buffer.handle;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    vulkan_command_buffer_pipeline_barrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+        1, &barrier, 0, 0);
+
+    // The frame submitted next waits on the compute semaphore, its completion covers the dispatch
+    slot->frame_number = context->frame_number;
+    slot->pending = TRUE;
+    ++state.dispatch_count;
+    return TRUE;
+}
+
+static b8 read_back(vulkan_context* context, compute_check_slot* slot) {
+    const u32* values = vulkan_buffer_map(context, &slot->buffer, 0, sizeof(u32) * COMPUTE_CHECK_VALUE_COUNT);
+    if (!values)
+        return FALSE;
+
+    b8 success = TRUE;
+    for (u32 idx = 0; idx != COMPUTE_CHECK_VALUE_COUNT; ++idx) {
+        u32 expected = idx * 3 + slot->seed;
+        if (values[idx] != expected) {
+            VERROR("Dispatch of frame %llu: value %u is %u, expected %u", slot->frame_number, idx, values[idx], expected);
+            success = FALSE;
+            break;
+        }
+    }
+    vulkan_buffer_unmap(context, &slot->buffer);
+
+    slot->pending = FALSE;
+    ++state.read_count;
+    return success;
+}
+
+static renderer_check_status fail() {
+    state.failed = TRUE;
+    return RENDERER_CHECK_FAILED;
+}
+
+renderer_check_status vulkan_compute_check_step(vulkan_context* context) {
+    if (state.failed)
+        return RENDERER_CHECK_FAILED;
+
+    if (!state.created) {
+        vzero_memory(&state, sizeof(compute_check_state));
+        state.created = TRUE;
+        if (!create_resources(context))
+            return fail();
+
+        VINFO("Checking async compute: %u dispatches of %u values on queue family %u, graphics on %u, %u frames in flight",
+            COMPUTE_CHECK_DISPATCH_COUNT, COMPUTE_CHECK_VALUE_COUNT, context->device.compute_queue_index,
+            context->device.graphics_queue_index, state.slot_count);
+    }
+
+    if (++state.step > COMPUTE_CHECK_MAX_FRAMES) {
+        VERROR("Only %u of %u dispatches were read back after %u frames", state.read_count, COMPUTE_CHECK_DISPATCH_COUNT, COMPUTE_CHECK_MAX_FRAMES);
+        return fail();
+    }
+
+    compute_check_slot* slot = &state.slots[context->current_frame];
+    if (slot->pending) {
+        // The frame of the dispatch was skipped, the dispatch goes out with the next frame
+        if (slot->frame_number >= context->frame_number)
+            return RENDERER_CHECK_RUNNING;
+
+        if (!vulkan_frame_wait(context, slot->frame_number) || !read_back(context, slot))
+            return fail();
+    }
+
+    if (state.dispatch_count != COMPUTE_CHECK_DISPATCH_COUNT) {
+        if (!record_dispatch(context, slot))
+            return fail();
+        return RENDERER_CHECK_RUNNING;
+    }
+    if (state.read_count != COMPUTE_CHECK_DISPATCH_COUNT)
+        return RENDERER_CHECK_RUNNING;
+
+    // Every dispatch completed, nothing in flight uses the resources anymore
+    vulkan_compute_check_destroy(context);
+    return RENDERER_CHECK_PASSED;
+}
+
+void vulkan_compute_check_destroy(vulkan_context* context) {
+    if (!state.created)
+        return;
+
+    if (state.slots) {
+        for (u32 idx = 0; idx != state.slot_count; ++idx) {
+            if (state.slots[idx].buffer.handle)
+                vulkan_buffer_destroy(context, &state.slots[idx].buffer);
+        }
+        vfree(state.slots, sizeof(compute_check_slot) * state.slot_count, MEMORY_TAG_RENDERER);
+    }
+    vulkan_compute_pipeline_destroy(context, &state.pipeline);
+    vzero_memory(&state, sizeof(compute_check_state));
+}
+#endif
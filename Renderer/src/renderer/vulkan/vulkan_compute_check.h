@@ -0,0 +1,23 @@
+#pragma once
+#include "vulkan_types.inl"
+
+#if defined(VKR_ENABLE_CHECKS)
+/*
+* Runs the next step of the self check of async compute. Every step reads back
+* the buffer the compute work of the current frame in flight filled the last time
+* it came around, then records the next dispatch into it. The frame waits on the
+* compute semaphore, so once the frame completed the buffer holds the results.
+* Call once per frame outside of frame recording.
+*
+* @param context - The vulkan context
+* @return renderer_check_status - RUNNING until every dispatch was read back, then PASSED or FAILED
+*/
+renderer_check_status vulkan_compute_check_step(vulkan_context* context);
+
+/*
+* Destroys what the check created if it did not finish. The device must be idle.
+*
+* @param context - The vulkan context
+*/
+void vulkan_compute_check_destroy(vulkan_context* context);
+#endif
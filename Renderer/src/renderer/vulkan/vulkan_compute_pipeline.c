@@ -0,0 +1,211 @@
+#include "vulkan_compute_pipeline.h"
+#include "vulkan_command_buffer.h"
+#include "vulkan_utils.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+
+b8 vulkan_compute_pipeline_create(
+    vulkan_context* context,
+    u64 code_size,
+    const u32* code,
+    u32 binding_count,
+    const VkDescriptorType* binding_types,
+    u32 push_constant_size,
+    u32 max_sets,
+    vulkan_compute_pipeline* out_pipeline) {
+    vzero_memory(out_pipeline, sizeof(vulkan_compute_pipeline));
+
+    if (binding_count > VULKAN_COMPUTE_MAX_BINDINGS) {
+        VERROR("vulkan_compute_pipeline_create - %u bindings, at most %u are supported", binding_count, VULKAN_COMPUTE_MAX_BINDINGS);
+        return FALSE;
+    }
+
+    // One pool size per descriptor type in use
+    VkDescriptorSetLayoutBinding bindings[VULKAN_COMPUTE_MAX_BINDINGS];
+    VkDescriptorPoolSize pool_sizes[2];
+    u32 pool_size_count = 0;
+    for (u32 idx = 0; idx != binding_count; ++idx) {
+        if (binding_types[idx] != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER && binding_types[idx] != VK_DESCRIPTOR_TYPE_STORAGE_IMAGE) {
+            VERROR("vulkan_compute_pipeline_create - binding %u is neither a storage buffer nor a storage image", idx);
+            return FALSE;
+        }
+
+        bindings[idx].binding = idx;
+        bindings[idx].descriptorType = binding_types[idx];
+        bindings[idx].descriptorCount = 1;
+        bindings[idx].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        bindings[idx].pImmutableSamplers = 0;
+        out_pipeline->binding_types[idx] = binding_types[idx];
+
+        u32 size = 0;
+        while (size != pool_size_count && pool_sizes[size].type != binding_types[idx])
+            ++size;
+        if (size == pool_size_count) {
+            pool_sizes[pool_size_count].type = binding_types[idx];
+            pool_sizes[pool_size_count++].descriptorCount = 0;
+        }
+        pool_sizes[size].descriptorCount += max_sets;
+    }
+    out_pipeline->binding_count = binding_count;
+    out_pipeline->push_constant_size = push_constant_size;
+
+    VkDevice device = context->device.logical_device;
+    VkDescriptorSetLayoutCreateInfo set_layout_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    set_layout_info.bindingCount = binding_count;
+    set_layout_info.pBindings = bindings;
+    VkResult res = vkCreateDescriptorSetLayout(device, &set_layout_info, context->allocator, &out_pipeline->set_layout);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkCreateDescriptorSetLayout failed with result: %s", vulkan_result_string(res, TRUE));
+        vulkan_compute_pipeline_destroy(context, out_pipeline);
+        return FALSE;
+    }
+
+    if (binding_count && max_sets) {
+        VkDescriptorPoolCreateInfo pool_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+        pool_info.maxSets = max_sets;
+        pool_info.poolSizeCount = pool_size_count;
+        pool_info.pPoolSizes = pool_sizes;
+        res = vkCreateDescriptorPool(device, &pool_info, context->allocator, &out_pipeline->descriptor_pool);
+        if (!vulkan_result_is_success(res)) {
+            VERROR("vkCreateDescriptorPool failed with result: %s", vulkan_result_string(res, TRUE));
+            vulkan_compute_pipeline_destroy(context, out_pipeline);
+            return FALSE;
+        }
+    }
+
+    VkPushConstantRange push_constants;
+    push_constants.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constants.offset = 0;
+    push_constants.size = push_constant_size;
+
+    VkPipelineLayoutCreateInfo layout_info = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    layout_info.setLayoutCount = 1;
+    layout_info.pSetLayouts = &out_pipeline->set_layout;
+    layout_info.pushConstantRangeCount = push_constant_size ? 1 : 0;
+    layout_info.pPushConstantRanges = &push_constants;
+    res = vkCreatePipelineLayout(device, &layout_info, context->allocator, &out_pipeline->layout);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkCreatePipelineLayout failed with result: %s", vulkan_result_string(res, TRUE));
+        vulkan_compute_pipeline_destroy(context, out_pipeline);
+        return FALSE;
+    }
+
+    // The module is only needed while the pipeline is created
+    VkShaderModuleCreateInfo module_info = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+    module_info.codeSize = code_size;
+    module_info.pCode = code;
+    VkShaderModule module;
+    res = vkCreateShaderModule(device, &module_info, context->allocator, &module);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkCreateShaderModule failed with result: %s", vulkan_result_string(res, TRUE));
+        vulkan_compute_pipeline_destroy(context, out_pipeline);
+        return FALSE;
+    }
+
+    VkComputePipelineCreateInfo pipeline_info = { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+    pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_info.stage.module = module;
+    pipeline_info.stage.pName = "main";
+    pipeline_info.layout = out_pipeline->layout;
+    res = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_info, context->allocator, &out_pipeline->handle);
+    vkDestroyShaderModule(device, module, context->allocator);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkCreateComputePipelines failed with result: %s", vulkan_result_string(res, TRUE));
+        out_pipeline->handle = 0;
+        vulkan_compute_pipeline_destroy(context, out_pipeline);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void vulkan_compute_pipeline_destroy(vulkan_context* context, vulkan_compute_pipeline* pipeline) {
+    VkDevice device = context->device.logical_device;
+    if (pipeline->handle)
+        vkDestroyPipeline(device, pipeline->handle, context->allocator);
+    if (pipeline->layout)
+        vkDestroyPipelineLayout(device, pipeline->layout, context->allocator);
+    if (pipeline->descriptor_pool)
+        vkDestroyDescriptorPool(device, pipeline->descriptor_pool, context->allocator);
+    if (pipeline->set_layout)
+        vkDestroyDescriptorSetLayout(device, pipeline->set_layout, context->allocator);
+
+    vzero_memory(pipeline, sizeof(vulkan_compute_pipeline));
+}
+
+b8 vulkan_compute_pipeline_allocate_set(vulkan_context* context, vulkan_compute_pipeline* pipeline, VkDescriptorSet* out_set) {
+    if (!pipeline->descriptor_pool) {
+        VERROR("vulkan_compute_pipeline_allocate_set - the pipeline has no bindings or no sets");
+        return FALSE;
+    }
+
+    VkDescriptorSetAllocateInfo set_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    set_info.descriptorPool = pipeline->descriptor_pool;
+    set_info.descriptorSetCount = 1;
+    set_info.pSetLayouts = &pipeline->set_layout;
+    VkResult res = vkAllocateDescriptorSets(context->device.logical_device, &set_info, out_set);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkAllocateDescriptorSets failed with result: %s", vulkan_result_string(res, TRUE));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void vulkan_compute_set_storage_buffer(
+    vulkan_context* context,
+    VkDescriptorSet set,
+    u32 binding,
+    const vulkan_buffer* buffer,
+    u64 offset,
+    u64 range) {
+    VkDescriptorBufferInfo buffer_info;
+    buffer_info.buffer = buffer->handle;
+    buffer_info.offset = offset;
+    buffer_info.range = range;
+
+    VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+    write.dstSet = set;
+    write.dstBinding = binding;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &buffer_info;
+    vkUpdateDescriptorSets(context->device.logical_device, 1, &write, 0, 0);
+}
+
+void vulkan_compute_set_storage_image(
+    vulkan_context* context,
+    VkDescriptorSet set,
+    u32 binding,
+    const vulkan_image* image) {
+    VkDescriptorImageInfo image_info;
+    image_info.sampler = 0;
+    image_info.imageView = image->view;
+    image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+    write.dstSet = set;
+    write.dstBinding = binding;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    write.pImageInfo = &image_info;
+    vkUpdateDescriptorSets(context->device.logical_device, 1, &write, 0, 0);
+}
+
+void vulkan_compute_pipeline_dispatch(
+    vulkan_command_buffer* command_buffer,
+    const vulkan_compute_pipeline* pipeline,
+    VkDescriptorSet set,
+    const void* push_constants,
+    u32 group_count_x,
+    u32 group_count_y,
+    u32 group_count_z) {
+    vulkan_command_buffer_bind_pipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->handle);
+    if (pipeline->binding_count)
+        vulkan_command_buffer_bind_descriptor_sets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->layout, 0, 1, &set);
+    if (pipeline->push_constant_size)
+        vkCmdPushConstants(command_buffer->handle, pipeline->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, pipeline->push_constant_size, push_constants);
+
+    vulkan_command_buffer_dispatch(command_buffer, group_count_x, group_count_y, group_count_z);
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "vulkan_types.inl"
+
+/*
+* Creates a compute pipeline from SPIR-V code with entry point "main".
+*
+* @param context - The vulkan context
+* @param code_size - Size of the SPIR-V code in bytes
+* @param code - The SPIR-V code
+* @param binding_count - Amount of resources, at most VULKAN_COMPUTE_MAX_BINDINGS
+* @param binding_types - VK_DESCRIPTOR_TYPE_STORAGE_BUFFER or VK_DESCRIPTOR_TYPE_STORAGE_IMAGE per binding
+* @param push_constant_size - Size of the push constant block in bytes, 0 for none
+* @param max_sets - Descriptor sets that can be allocated for the pipeline
+* @param out_pipeline - The created pipeline
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_compute_pipeline_create(
+    vulkan_context* context,
+    u64 code_size,
+    const u32* code,
+    u32 binding_count,
+    const VkDescriptorType* binding_types,
+    u32 push_constant_size,
+    u32 max_sets,
+    vulkan_compute_pipeline* out_pipeline);
+
+/*
+* Destroys the pipeline together with its descriptor sets. The GPU must not use it anymore.
+*
+* @param context - The vulkan context
+* @param pipeline - The pipeline to destroy
+*/
+void vulkan_compute_pipeline_destroy(vulkan_context* context, vulkan_compute_pipeline* pipeline);
+
+/*
+* Allocates a descriptor set of the pipeline. Sets are meant to be kept,
+* e.g. one per frame in flight, they are only freed with the pipeline.
+*
+* @param context - The vulkan context
+* @param pipeline - The pipeline
+* @param out_set - The set, its bindings have to be written before a dispatch uses it
+* @return b8 - TRUE if successful, FALSE once max_sets are allocated
+*/
+b8 vulkan_compute_pipeline_allocate_set(vulkan_context* context, vulkan_compute_pipeline* pipeline, VkDescriptorSet* out_set);
+
+/*
+* Points a storage buffer binding at a range of a buffer. The set must not be
+* used by a command buffer that is pending.
+*
+* @param context - The vulkan context
+* @param set - The descriptor set
+* @param binding - The binding
+* @param buffer - The buffer, created with VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+* @param offset - Start of the range, a multiple of minStorageBufferOffsetAlignment
+* @param range - Size of the range, VK_WHOLE_SIZE for the rest of the buffer
+*/
+void vulkan_compute_set_storage_buffer(
+    vulkan_context* context,
+    VkDescriptorSet set,
+    u32 binding,
+    const vulkan_buffer* buffer,
+    u64 offset,
+    u64 range);
+
+/*
+* Points a storage image binding at an image. The image has to be in
+* VK_IMAGE_LAYOUT_GENERAL when the dispatch runs.
+*
+* @param context - The vulkan context
+* @param set - The descriptor set
+* @param binding - The binding
+* @param image - The image, created with VK_IMAGE_USAGE_STORAGE_BIT and a view
+*/
+void vulkan_compute_set_storage_image(
+    vulkan_context* context,
+    VkDescriptorSet set,
+    u32 binding,
+    const vulkan_image* image);
+
+/*
+* Records a dispatch. Works on graphics and compute command buffers, outside of render passes.
+*
+* @param command_buffer - The command buffer that is recording
+* @param pipeline - The pipeline
+* @param set - Descriptor set of the pipeline, 0 when it has no bindings
+* @param push_constants - push_constant_size bytes, 0 when it has none
+* @param group_count_x - Work groups along x
+* @param group_count_y - Work groups along y
+* @param group_count_z - Work groups along z
+*/
+void vulkan_compute_pipeline_dispatch(
+    vulkan_command_buffer* command_buffer,
+    const vulkan_compute_pipeline* pipeline,
+    VkDescriptorSet set,
+    const void* push_constants,
+    u32 group_count_x,
+    u32 group_count_y,
+    u32 group_count_z);
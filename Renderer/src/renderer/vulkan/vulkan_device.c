@@ -13,6 +13,7 @@ typedef struct vulkan_physical_device_requirments {
     b8 transfer;
     const char** device_extensions; // darray
     b8 sampler_anisotropy;
+    b8 timeline_semaphore;
     b8 discrete_gpu;
 } vulkan_physical_device_requirments;
 
@@ -42,26 +43,22 @@ b8 vulkan_device_create(vulkan_context* context) {
 
     VINFO("Creating logical device...");
     // NOTE: no additional queues for shared indices
-    b8 present_shares_graphics_queue = context->device.present_queue_index == context->device.graphics_queue_index;
-    b8 transfer_shares_graphics_queue = context->device.transfer_queue_index == context->device.graphics_queue_index;
-    u32 index_count = 1;
-
-    if (!present_shares_graphics_queue)
-        ++index_count;
-
-    if (!transfer_shares_graphics_queue)
-        ++index_count;
-
-    u32* indices = vallocate(sizeof(u32) * index_count, MEMORY_TAG_RENDERER);
-    u8 index = 0;
-    indices[index++] = context->device.graphics_queue_index;
-    if (!present_shares_graphics_queue)
-        indices[index++] = context->device.present_queue_index;
-
-    if (!transfer_shares_graphics_queue)
-        indices[index++] = context->device.transfer_queue_index;
+    u32 families[4] = {
+        context->device.graphics_queue_index,
+        context->device.present_queue_index,
+        context->device.transfer_queue_index,
+        context->device.compute_queue_index
+    };
+    u32 index_count = 0;
+    u32 indices[4];
+    for (u32 idx = 0; idx != 4; ++idx) {
+        b8 seen = FALSE;
+        for (u32 j = 0; j != index_count; ++j)
+            seen |= indices[j] == families[idx];
+        if (!seen)
+            indices[index_count++] = families[idx];
+    }
 
-    // TODO: add compute when needed
     VkDeviceQueueCreateInfo* queue_create_info = vallocate(sizeof(VkDeviceQueueCreateInfo) * index_count, MEMORY_TAG_RENDERER);
 
     f32 queue_priority = 1.0f;
@@ -87,10 +84,17 @@ b8 vulkan_device_create(vulkan_context* context) {
     // TODO: should be configuration driven
     VkPhysicalDeviceFeatures device_features = { 0 };   
     device_features.samplerAnisotropy = VK_TRUE;
- 
+    // Optional, used for per frame workload counters
+    device_features.pipelineStatisticsQuery = context->device.features.pipelineStatisticsQuery;
+    // Lets secondary command buffers run while the statistics query of the frame is active
+    device_features.inheritedQueries = context->device.features.inheritedQueries;
 
+    // Frames and transfer batches signal timeline semaphores
+    VkPhysicalDeviceVulkan12Features device_features_12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+    device_features_12.timelineSemaphore = VK_TRUE;
 
     VkDeviceCreateInfo device_create_info = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+    device_create_info.pNext = &device_features_12;
     device_create_info.queueCreateInfoCount = index_count;
     device_create_info.pQueueCreateInfos = queue_create_info;
     device_create_info.pEnabledFeatures = &device_features;
@@ -110,7 +114,7 @@ b8 vulkan_device_create(vulkan_context* context) {
     vkGetDeviceQueue(context->device.logical_device, context->device.graphics_queue_index, 0, &context->device.graphics_queue);
     vkGetDeviceQueue(context->device.logical_device, context->device.present_queue_index, 0, &context->device.present_queue);
     vkGetDeviceQueue(context->device.logical_device, context->device.transfer_queue_index, 0, &context->device.transfer_queue);
-    // TODO: get the compute queue
+    vkGetDeviceQueue(context->device.logical_device, context->device.compute_queue_index, 0, &context->device.compute_queue);
     VINFO("Queues obtained!");
 
     // Create command pool for graphics
@@ -123,9 +127,22 @@ b8 vulkan_device_create(vulkan_context* context) {
     VK_CHECK(res);
     VINFO("Graphics command pool created");
 
-    // Free queue and index memory
+    // Uploads on the transfer queue record into short lived command buffers of their own pool
+    pool_info.queueFamilyIndex = context->device.transfer_queue_index;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    res = vkCreateCommandPool(context->device.logical_device, &pool_info, context->allocator, &context->device.transfer_command_pool);
+    VK_CHECK(res);
+    VINFO("Transfer command pool created");
+
+    // Command buffers of the compute queue are re-recorded every frame
+    pool_info.queueFamilyIndex = context->device.compute_queue_index;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    res = vkCreateCommandPool(context->device.logical_device, &pool_info, context->allocator, &context->device.compute_command_pool);
+    VK_CHECK(res);
+    VINFO("Compute command pool created");
+
+    // Free queue memory
     vfree(queue_create_info, sizeof(VkDeviceQueueCreateInfo) * index_count, MEMORY_TAG_RENDERER);
-    vfree(indices, sizeof(u32) * index_count, MEMORY_TAG_RENDERER);
 
     return TRUE;
 }
@@ -134,10 +151,12 @@ void vulkan_device_destroy(vulkan_context* context) {
     context->device.graphics_queue = 0;
     context->device.transfer_queue = 0;
     context->device.present_queue = 0;
-    // Same for compute queue
+    context->device.compute_queue = 0;
 
     VINFO("Destroying command pools...");
     vkDestroyCommandPool(context->device.logical_device, context->device.graphics_command_pool, context->allocator);
+    vkDestroyCommandPool(context->device.logical_device, context->device.transfer_command_pool, context->allocator);
+    vkDestroyCommandPool(context->device.logical_device, context->device.compute_command_pool, context->allocator);
 
     VINFO("Destroying logical device...");
     if (context->device.logical_device) {
@@ -258,86 +277,89 @@ b8 select_physical_device(vulkan_context* context) {
     vulkan_physical_device_requirments requirements;
     requirements.graphics = TRUE;
     requirements.present = TRUE;
-    // TODO: enable this if compute required
-    //requirements.compute = TRUE;
+    requirements.compute = TRUE;
     requirements.transfer = TRUE;
     requirements.discrete_gpu = TRUE;
     requirements.device_extensions = darray_create(const char*);
     const char* swapchain_ext = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
     darray_push(requirements.device_extensions, swapchain_ext);
     requirements.sampler_anisotropy = TRUE;
-
-    for (u32 idx = 0; idx != device_count; ++idx) {
-        VkPhysicalDeviceProperties device_properties;
-        vkGetPhysicalDeviceProperties(devices[idx], &device_properties);
-
-        VkPhysicalDeviceFeatures device_features;
-        vkGetPhysicalDeviceFeatures(devices[idx], &device_features);
-
-        VkPhysicalDeviceMemoryProperties device_memory;
-        vkGetPhysicalDeviceMemoryProperties(devices[idx], &device_memory);
-
-        vulkan_physical_device_queue_family_info queue_infos;
-
-        b8 meets_requirments = physical_device_meets_requirments(devices[idx], context->surface,
-            &device_properties, &device_features, &requirements,&queue_infos, &context->device.swapchain_support);
-
-        if (meets_requirments) {
-            VINFO("Selected device: '%s'.", device_properties.deviceName);
-
-            // GPU Type
-            switch (device_properties.deviceType) {
-            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
-                VINFO("Device type is integrated GPU");
-                break;
-            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
-                VINFO("Device type is discrete GPU");
-                break;
-            case VK_PHYSICAL_DEVICE_TYPE_OTHER:
-                VINFO("Device type is other");
-                break;
-            case VK_PHYSICAL_DEVICE_TYPE_CPU:
-                VINFO("Device type is CPU");
-                break;
-            }
-
-            // Driver info
-            VINFO("GPU Driver version: %d.%d.%d",
-                VK_VERSION_MAJOR(device_properties.driverVersion),
-                VK_VERSION_MINOR(device_properties.driverVersion),
-                VK_VERSION_PATCH(device_properties.driverVersion));
-
-            // Vulkan API version
-            VINFO("Vulkan API version: %d.%d.%d",
-                VK_VERSION_MAJOR(device_properties.apiVersion),
-                VK_VERSION_MINOR(device_properties.apiVersion),
-                VK_VERSION_PATCH(device_properties.apiVersion));
-
-            // Memory information
-            for (u32 midx = 0; midx != device_memory.memoryHeapCount; ++midx) {
-                f32 memory_size_gib = (((f32)device_memory.memoryHeaps[midx].size) / 1024.f / 1024.f / 1024.f);
-                if (device_memory.memoryHeaps[midx].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
-                    VINFO("Local GPU memory: %.2f GiB", memory_size_gib);
+    requirements.timeline_semaphore = TRUE;
+
+    // Prefer a discrete GPU, fall back to any device (integrated or software like lavapipe)
+    for (u32 pass = 0; pass != 2 && !context->device.physical_device; ++pass) {
+        requirements.discrete_gpu = (pass == 0);
+        for (u32 idx = 0; idx != device_count; ++idx) {
+            VkPhysicalDeviceProperties device_properties;
+            vkGetPhysicalDeviceProperties(devices[idx], &device_properties);
+
+            VkPhysicalDeviceFeatures device_features;
+            vkGetPhysicalDeviceFeatures(devices[idx], &device_features);
+
+            VkPhysicalDeviceMemoryProperties device_memory;
+            vkGetPhysicalDeviceMemoryProperties(devices[idx], &device_memory);
+
+            vulkan_physical_device_queue_family_info queue_infos;
+
+            b8 meets_requirments = physical_device_meets_requirments(devices[idx], context->surface,
+                &device_properties, &device_features, &requirements,&queue_infos, &context->device.swapchain_support);
+
+            if (meets_requirments) {
+                VINFO("Selected device: '%s'.", device_properties.deviceName);
+
+                // GPU Type
+                switch (device_properties.deviceType) {
+                case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+                    VINFO("Device type is integrated GPU");
+                    break;
+                case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+                    VINFO("Device type is discrete GPU");
+                    break;
+                case VK_PHYSICAL_DEVICE_TYPE_OTHER:
+                    VINFO("Device type is other");
+                    break;
+                case VK_PHYSICAL_DEVICE_TYPE_CPU:
+                    VINFO("Device type is CPU");
+                    break;
                 }
-                else {
-                    VINFO("Shared system memory: %.2f", memory_size_gib);
+
+                // Driver info
+                VINFO("GPU Driver version: %d.%d.%d",
+                    VK_VERSION_MAJOR(device_properties.driverVersion),
+                    VK_VERSION_MINOR(device_properties.driverVersion),
+                    VK_VERSION_PATCH(device_properties.driverVersion));
+
+                // Vulkan API version
+                VINFO("Vulkan API version: %d.%d.%d",
+                    VK_VERSION_MAJOR(device_properties.apiVersion),
+                    VK_VERSION_MINOR(device_properties.apiVersion),
+                    VK_VERSION_PATCH(device_properties.apiVersion));
+
+                // Memory information
+                for (u32 midx = 0; midx != device_memory.memoryHeapCount; ++midx) {
+                    f32 memory_size_gib = (((f32)device_memory.memoryHeaps[midx].size) / 1024.f / 1024.f / 1024.f);
+                    if (device_memory.memoryHeaps[midx].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+                        VINFO("Local GPU memory: %.2f GiB", memory_size_gib);
+                    }
+                    else {
+                        VINFO("Shared system memory: %.2f", memory_size_gib);
+                    }
                 }
-            }
             
-            // Set device properties in context
-            context->device.physical_device = devices[idx];
-            // Keep copy of system properties
-            context->device.properties = device_properties;
-            context->device.features = device_features;
-            context->device.memory = device_memory;
-
-            // Queues
-            context->device.graphics_queue_index = queue_infos.graphics_family_index;
-            context->device.present_queue_index = queue_infos.present_family_index;
-            context->device.transfer_queue_index = queue_infos.transfer_family_index;
-            // TODO: set compute index later when needed
-            //context->device.compute_queue_index = queue_infos.compute_family_index;
-            break;
+                // Set device properties in context
+                context->device.physical_device = devices[idx];
+                // Keep copy of system properties
+                context->device.properties = device_properties;
+                context->device.features = device_features;
+                context->device.memory = device_memory;
+
+                // Queues
+                context->device.graphics_queue_index = queue_infos.graphics_family_index;
+                context->device.present_queue_index = queue_infos.present_family_index;
+                context->device.transfer_queue_index = queue_infos.transfer_family_index;
+                context->device.compute_queue_index = queue_infos.compute_family_index;
+                break;
+            }
         }
     }
 
@@ -376,6 +398,12 @@ b8 physical_device_meets_requirments(
        }
     }
 
+    // Dynamic vertex strides and vkCmdBindVertexBuffers2 are core in 1.3
+    if (properties->apiVersion < VK_API_VERSION_1_3) {
+        VINFO("Device does not support Vulkan 1.3. Skipping");
+        return FALSE;
+    }
+
     u32 queue_family_count = 0;
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, 0);
     VkQueueFamilyProperties* queue_properties = vallocate(sizeof(VkQueueFamilyProperties) * queue_family_count, MEMORY_TAG_RENDERER);
@@ -384,6 +412,7 @@ b8 physical_device_meets_requirments(
     // Look at each queue and see what it supports
     VINFO("| Graphics | Present   | Compute   | Transfer  | Name    |");
     u8 min_transfer_score = 255;
+    b8 dedicated_compute = FALSE;
     for (u32 idx = 0; idx != queue_family_count; ++idx) {
         u8 current_transfer_score = 0;
         
@@ -393,9 +422,13 @@ b8 physical_device_meets_requirments(
             ++current_transfer_score;
         }
 
-        // Compute queue?
+        // Compute queue? A family without graphics runs compute asynchronously to rendering
         if (queue_properties[idx].queueFlags & VK_QUEUE_COMPUTE_BIT) {
-            out_queue_family_info->compute_family_index = idx;
+            b8 is_dedicated = (queue_properties[idx].queueFlags & VK_QUEUE_GRAPHICS_BIT) == 0;
+            if (!dedicated_compute || is_dedicated) {
+                out_queue_family_info->compute_family_index = idx;
+                dedicated_compute = is_dedicated;
+            }
             ++current_transfer_score;
         }
 
@@ -493,6 +526,19 @@ b8 physical_device_meets_requirments(
             return FALSE;
         }
 
+        // Timeline semaphores are core since Vulkan 1.2
+        if (requirements->timeline_semaphore) {
+            VkPhysicalDeviceVulkan12Features features_12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+            VkPhysicalDeviceFeatures2 features_2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+            features_2.pNext = &features_12;
+            if (properties->apiVersion >= VK_API_VERSION_1_2)
+                vkGetPhysicalDeviceFeatures2(device, &features_2);
+            if (!features_12.timelineSemaphore) {
+                VINFO("Device does not support timeline semaphores. Skipping device");
+                return FALSE;
+            }
+        }
+
         return TRUE;
     }
 
@@ -0,0 +1,136 @@
+#include "vulkan_frame_counters.h"
+#include "vulkan_utils.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+
+// Results are written in bit order of the flags
+#define STATISTICS_FLAGS                                                    \
+    (VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |              \
+     VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |            \
+     VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |            \
+     VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |                  \
+     VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT)
+#define STATISTICS_COUNT 5
+
+b8 vulkan_frame_counters_create(
+    vulkan_context* context,
+    u32 frame_count,
+    vulkan_frame_counters* out_counters) {
+    vzero_memory(out_counters, sizeof(vulkan_frame_counters));
+    out_counters->frame_count = frame_count;
+    out_counters->frames = vallocate(sizeof(renderer_frame_counters) * frame_count, MEMORY_TAG_RENDERER);
+    out_counters->pending = vallocate(sizeof(b8) * frame_count, MEMORY_TAG_RENDERER);
+
+    // The query stays active while secondary command buffers execute, which needs inheritedQueries
+    if (!context->device.features.pipelineStatisticsQuery || !context->device.features.inheritedQueries) {
+        VINFO("Pipeline statistics queries not supported. Only CPU frame counters are available");
+        return TRUE;
+    }
+
+    VkQueryPoolCreateInfo pool_info = { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+    pool_info.pNext = 0;
+    pool_info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+    pool_info.queryCount = frame_count;
+    pool_info.pipelineStatistics = STATISTICS_FLAGS;
+
+    VkResult res = vkCreateQueryPool(context->device.logical_device, &pool_info, context->allocator, &out_counters->statistics_pool);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkCreateQueryPool failed with result: %s", vulkan_result_string(res, TRUE));
+        out_counters->statistics_pool = 0;
+        vulkan_frame_counters_destroy(context, out_counters);
+        return FALSE;
+    }
+
+    out_counters->statistics_supported = TRUE;
+    return TRUE;
+}
+
+void vulkan_frame_counters_destroy(vulkan_context* context, vulkan_frame_counters* counters) {
+    if (counters->statistics_pool) {
+        vkDestroyQueryPool(context->device.logical_device, counters->statistics_pool, context->allocator);
+        counters->statistics_pool = 0;
+    }
+
+    if (counters->frames) {
+        vfree(counters->frames, sizeof(renderer_frame_counters) * counters->frame_count, MEMORY_TAG_RENDERER);
+        counters->frames = 0;
+    }
+
+    if (counters->pending) {
+        vfree(counters->pending, sizeof(b8) * counters->frame_count, MEMORY_TAG_RENDERER);
+        counters->pending = 0;
+    }
+
+    counters->statistics_supported = FALSE;
+}
+
+void vulkan_frame_counters_begin_frame(
+    vulkan_frame_counters* counters,
+    vulkan_command_buffer* command_buffer,
+    u32 frame) {
+    if (!counters->statistics_supported)
+        return;
+
+    vkCmdResetQueryPool(command_buffer->handle, counters->statistics_pool, frame, 1);
+    vkCmdBeginQuery(command_buffer->handle, counters->statistics_pool, frame, 0);
+}
+
+void vulkan_frame_counters_end_frame(
+    vulkan_frame_counters* counters,
+    vulkan_command_buffer* command_buffer,
+    u32 frame,
+    u64 frame_number) {
+    if (counters->statistics_supported)
+        vkCmdEndQuery(command_buffer->handle, counters->statistics_pool, frame);
+
+    renderer_frame_counters* out = &counters->frames[frame];
+    vzero_memory(out, sizeof(renderer_frame_counters));
+    out->frame_number = frame_number;
+    out->draw_calls = command_buffer->counters.draw_calls;
+    out->triangles = command_buffer->counters.triangles;
+    out->render_passes = command_buffer->counters.render_passes;
+    out->barriers = command_buffer->counters.barriers;
+    out->descriptor_binds = command_buffer->counters.descriptor_binds;
+    out->pipeline_binds = command_buffer->counters.pipeline_binds;
+    counters->pending[frame] = TRUE;
+}
+
+VkQueryPipelineStatisticFlags vulkan_frame_counters_statistics(const vulkan_frame_counters* counters) {
+    return counters->statistics_supported ? STATISTICS_FLAGS : 0;
+}
+
+void vulkan_frame_counters_collect(
+    vulkan_context* context,
+    vulkan_frame_counters* counters,
+    u32 frame) {
+    if (!counters->pending[frame])
+        return;
+
+    counters->pending[frame] = FALSE;
+    renderer_frame_counters* out = &counters->frames[frame];
+
+    if (counters->statistics_supported) {
+        u64 statistics[STATISTICS_COUNT];
+        VkResult res = vkGetQueryPoolResults(
+            context->device.logical_device,
+            counters->statistics_pool,
+            frame,
+            1,
+            sizeof(statistics),
+            statistics,
+            sizeof(statistics),
+            VK_QUERY_RESULT_64_BIT);
+
+        // VK_NOT_READY means the frame was never submitted. Publish only the CPU counters
+        if (res == VK_SUCCESS) {
+            out->pipeline_statistics_valid = TRUE;
+            out->input_vertices = statistics[0];
+            out->input_primitives = statistics[1];
+            out->vertex_invocations = statistics[2];
+            out->clipping_primitives = statistics[3];
+            out->fragment_invocations = statistics[4];
+        }
+    }
+
+    counters->last = *out;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "vulkan_types.inl"
+
+/*
+* Creates the per frame counters. The pipeline statistics query pool is
+* only created when the device has the pipelineStatisticsQuery and
+* inheritedQueries features.
+*
+* @param context - The vulkan context
+* @param frame_count - The amount of frames in flight
+* @param out_counters - The counters that will be created
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_frame_counters_create(
+    vulkan_context* context,
+    u32 frame_count,
+    vulkan_frame_counters* out_counters);
+
+/*
+* Destroys the query pool and storage of the counters.
+*
+* @param context - The vulkan context
+* @param counters - The counters to destroy
+*/
+void vulkan_frame_counters_destroy(vulkan_context* context, vulkan_frame_counters* counters);
+
+/*
+* Resets and begins the pipeline statistics query of a frame.
+* Must be recorded outside of a render pass.
+*
+* @param counters - The frame counters
+* @param command_buffer - The command buffer of the frame (recording)
+* @param frame - The index of the frame in flight
+*/
+void vulkan_frame_counters_begin_frame(
+    vulkan_frame_counters* counters,
+    vulkan_command_buffer* command_buffer,
+    u32 frame);
+
+/*
+* Ends the pipeline statistics query of a frame and stores the CPU
+* counters of the command buffer for the frame.
+*
+* @param counters - The frame counters
+* @param command_buffer - The command buffer of the frame (recording)
+* @param frame - The index of the frame in flight
+* @param frame_number - The number of the frame being recorded
+*/
+void vulkan_frame_counters_end_frame(
+    vulkan_frame_counters* counters,
+    vulkan_command_buffer* command_buffer,
+    u32 frame,
+    u64 frame_number);
+
+/*
+* @param counters - The frame counters
+* @return VkQueryPipelineStatisticFlags - Statistics the query of a frame counts, secondary
+* command buffers executed while it is active must inherit them. 0 without statistics
+*/
+VkQueryPipelineStatisticFlags vulkan_frame_counters_statistics(const vulkan_frame_counters* counters);
+
+/*
+* Reads back the pipeline statistics of a frame without waiting and
+* publishes its counters. Should only be called once the frame that last
+* used the slot has completed.
+*
+* @param context - The vulkan context
+* @param counters - The frame counters
+* @param frame - The index of the frame in flight
+*/
+void vulkan_frame_counters_collect(
+    vulkan_context* context,
+    vulkan_frame_counters* counters,
+    u32 frame);
@@ -0,0 +1,123 @@
+#include "vulkan_frame_pool.h"
+#include "vulkan_command_buffer.h"
+#include "vulkan_utils.h"
+#include "core/job_system.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+#include "containers/darray.h"
+
+static void free_command_buffers(vulkan_context* context, VkCommandPool pool, vulkan_command_buffer** command_buffers) {
+    u32 count = (u32)darray_length(command_buffers);
+    for (u32 idx = 0; idx != count; ++idx) {
+        vulkan_command_buffer_free(context, pool, command_buffers[idx]);
+        vfree(command_buffers[idx], sizeof(vulkan_command_buffer), MEMORY_TAG_RENDERER);
+    }
+    darray_destroy(command_buffers);
+}
+
+b8 vulkan_frame_pool_create(vulkan_context* context, u32 queue_family, u32 frame_count, vulkan_frame_pool* out_pool) {
+    vzero_memory(out_pool, sizeof(vulkan_frame_pool));
+    out_pool->frame_count = frame_count;
+    out_pool->thread_count = job_system_thread_count();
+
+    u32 pool_count = frame_count * out_pool->thread_count;
+    out_pool->pools = vallocate(sizeof(vulkan_thread_command_pool) * pool_count, MEMORY_TAG_RENDERER);
+    vzero_memory(out_pool->pools, sizeof(vulkan_thread_command_pool) * pool_count);
+
+    // Command buffers are never reset one by one, the pools are
+    VkCommandPoolCreateInfo pool_info = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+    pool_info.queueFamilyIndex = queue_family;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    for (u32 idx = 0; idx != pool_count; ++idx) {
+        vulkan_thread_command_pool* thread_pool = &out_pool->pools[idx];
+        VkResult res = vkCreateCommandPool(context->device.logical_device, &pool_info, context->allocator, &thread_pool->handle);
+        if (!vulkan_result_is_success(res)) {
+            VERROR("vkCreateCommandPool failed with result: %s", vulkan_result_string(res, TRUE));
+            vulkan_frame_pool_destroy(context, out_pool);
+            return FALSE;
+        }
+        thread_pool->primary = darray_create(vulkan_command_buffer*);
+        thread_pool->secondary = darray_create(vulkan_command_buffer*);
+    }
+
+    VINFO("Created %u transient command pools (%u frames, %u threads)", pool_count, frame_count, out_pool->thread_count);
+    return TRUE;
+}
+
+void vulkan_frame_pool_destroy(vulkan_context* context, vulkan_frame_pool* pool) {
+    if (pool->pools) {
+        u32 pool_count = pool->frame_count * pool->thread_count;
+        for (u32 idx = 0; idx != pool_count; ++idx) {
+            vulkan_thread_command_pool* thread_pool = &pool->pools[idx];
+            if (thread_pool->primary)
+                free_command_buffers(context, thread_pool->handle, thread_pool->primary);
+            if (thread_pool->secondary)
+                free_command_buffers(context, thread_pool->handle, thread_pool->secondary);
+            if (thread_pool->handle)
+                vkDestroyCommandPool(context->device.logical_device, thread_pool->handle, context->allocator);
+        }
+        vfree(pool->pools, sizeof(vulkan_thread_command_pool) * pool_count, MEMORY_TAG_RENDERER);
+    }
+
+    vzero_memory(pool, sizeof(vulkan_frame_pool));
+}
+
+void vulkan_frame_pool_reset(vulkan_context* context, vulkan_frame_pool* pool, u32 frame) {
+    vulkan_thread_command_pool* thread_pools = &pool->pools[frame * pool->thread_count];
+    for (u32 idx = 0; idx != pool->thread_count; ++idx) {
+        vulkan_thread_command_pool* thread_pool = &thread_pools[idx];
+        // Nothing was recorded, the pool holds nothing to give back
+        if (!thread_pool->primary_used && !thread_pool->secondary_used)
+            continue;
+
+        VkResult res = vkResetCommandPool(context->device.logical_device, thread_pool->handle, 0);
+        if (!vulkan_result_is_success(res)) {
+            VERROR("vkResetCommandPool failed with result: %s", vulkan_result_string(res, TRUE));
+        }
+
+        for (u32 used = 0; used != thread_pool->primary_used; ++used)
+            vulkan_command_buffer_reset(thread_pool->primary[used]);
+        for (u32 used = 0; used != thread_pool->secondary_used; ++used)
+            vulkan_command_buffer_reset(thread_pool->secondary[used]);
+        thread_pool->primary_used = 0;
+        thread_pool->secondary_used = 0;
+    }
+}
+
+vulkan_command_buffer* vulkan_frame_pool_get_command_buffer(
+    vulkan_context* context,
+    vulkan_frame_pool* pool,
+    u32 frame,
+    b8 is_primary) {
+    i32 thread_index = job_system_thread_index();
+    // Threads outside the job system would share the main thread's pool unsynchronized
+    if (thread_index < 0) {
+        VERROR("vulkan_frame_pool_get_command_buffer - called from a thread that is not a job thread");
+        return 0;
+    }
+    u32 slot = (u32)thread_index;
+    if (slot >= pool->thread_count) {
+        VERROR("vulkan_frame_pool_get_command_buffer - thread %u has no command pool, the pool was created for %u threads", slot, pool->thread_count);
+        return 0;
+    }
+
+    vulkan_thread_command_pool* thread_pool = &pool->pools[frame * pool->thread_count + slot];
+    vulkan_command_buffer*** command_buffers = is_primary ? &thread_pool->primary : &thread_pool->secondary;
+    u32* used = is_primary ? &thread_pool->primary_used : &thread_pool->secondary_used;
+
+    if (*used == darray_length(*command_buffers)) {
+        // Heap allocated so the pointers handed out stay valid when the darray grows
+        vulkan_command_buffer* command_buffer = vallocate(sizeof(vulkan_command_buffer), MEMORY_TAG_RENDERER);
+        vulkan_command_buffer_allocate(context, thread_pool->handle, is_primary, command_buffer);
+        // VK_CHECK only asserts, without assertions a failed allocation leaves the handle empty
+        if (!command_buffer->handle) {
+            VERROR("vulkan_frame_pool_get_command_buffer - could not allocate a %s command buffer", is_primary ? "primary" : "secondary");
+            vfree(command_buffer, sizeof(vulkan_command_buffer), MEMORY_TAG_RENDERER);
+            return 0;
+        }
+        darray_push(*command_buffers, command_buffer);
+    }
+
+    return (*command_buffers)[(*used)++];
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "vulkan_types.inl"
+
+/*
+* Creates a transient command pool per frame in flight and job thread.
+*
+* @param context - The vulkan context, the device must exist
+* @param queue_family - Queue family the command buffers are submitted to
+* @param frame_count - Amount of frames in flight
+* @param out_pool - The frame pool that will be created
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_frame_pool_create(vulkan_context* context, u32 queue_family, u32 frame_count, vulkan_frame_pool* out_pool);
+
+/*
+* Destroys the command pools with their command buffers. The device must be idle.
+*
+* @param context - The vulkan context
+* @param pool - The frame pool to destroy
+*/
+void vulkan_frame_pool_destroy(vulkan_context* context, vulkan_frame_pool* pool);
+
+/*
+* Resets the command pools of a frame, all command buffers handed out for it
+* become available again. The frame that last used them must have completed
+* and no thread may record for the frame.
+*
+* @param context - The vulkan context
+* @param pool - The frame pool
+* @param frame - Index of the frame in flight
+*/
+void vulkan_frame_pool_reset(vulkan_context* context, vulkan_frame_pool* pool, u32 frame);
+
+/*
+* Hands out a command buffer from the calling thread's pool of a frame. It is
+* recycled when the frame is reset, new ones are only allocated when a frame
+* needs more than any frame before. Threads outside the job system use the
+* pool of the main thread.
+*
+* @param context - The vulkan context
+* @param pool - The frame pool
+* @param frame - Index of the frame in flight
+* @param is_primary - TRUE for a primary, FALSE for a secondary command buffer
+* @return vulkan_command_buffer* - The command buffer, ready to begin recording. Valid until the pool is destroyed
+*/
+vulkan_command_buffer* vulkan_frame_pool_get_command_buffer(
+    vulkan_context* context,
+    vulkan_frame_pool* pool,
+    u32 frame,
+    b8 is_primary);
@@ -0,0 +1,130 @@
+#include "vulkan_gpu_timer.h"
+#include "vulkan_utils.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+#include "core/frame_stats.h"
+
+b8 vulkan_gpu_timer_create(
+    vulkan_context* context,
+    u32 frame_count,
+    vulkan_gpu_timer* out_timer) {
+    vzero_memory(out_timer, sizeof(vulkan_gpu_timer));
+    out_timer->frame_count = frame_count;
+
+    // Timestamp support is a property of the queue family the commands are submitted on
+    u32 queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(context->device.physical_device, &queue_family_count, 0);
+    VkQueueFamilyProperties* queue_properties = vallocate(sizeof(VkQueueFamilyProperties) * queue_family_count, MEMORY_TAG_RENDERER);
+    vkGetPhysicalDeviceQueueFamilyProperties(context->device.physical_device, &queue_family_count, queue_properties);
+    u32 valid_bits = queue_properties[context->device.graphics_queue_index].timestampValidBits;
+    vfree(queue_properties, sizeof(VkQueueFamilyProperties) * queue_family_count, MEMORY_TAG_RENDERER);
+
+    if (valid_bits == 0 || context->device.properties.limits.timestampPeriod == 0.0f) {
+        VWARN("Graphics queue does not support timestamps. GPU timings are disabled");
+        return TRUE;
+    }
+
+    out_timer->valid_mask = valid_bits >= 64 ? ~0ull : ((1ull << valid_bits) - 1);
+    out_timer->timestamp_period = (f64)context->device.properties.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo pool_info = { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+    pool_info.pNext = 0;
+    pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    pool_info.queryCount = frame_count * VULKAN_GPU_TIMESTAMP_COUNT;
+
+    VkResult res = vkCreateQueryPool(context->device.logical_device, &pool_info, context->allocator, &out_timer->query_pool);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkCreateQueryPool failed with result: %s", vulkan_result_string(res, TRUE));
+        return FALSE;
+    }
+
+    out_timer->pending = vallocate(sizeof(b8) * frame_count, MEMORY_TAG_RENDERER);
+    out_timer->supported = TRUE;
+    VINFO("GPU timer created. Timestamp period: %.3fns, valid bits: %u", out_timer->timestamp_period, valid_bits);
+    return TRUE;
+}
+
+void vulkan_gpu_timer_destroy(vulkan_context* context, vulkan_gpu_timer* timer) {
+    if (timer->query_pool) {
+        vkDestroyQueryPool(context->device.logical_device, timer->query_pool, context->allocator);
+        timer->query_pool = 0;
+    }
+
+    if (timer->pending) {
+        vfree(timer->pending, sizeof(b8) * timer->frame_count, MEMORY_TAG_RENDERER);
+        timer->pending = 0;
+    }
+
+    timer->supported = FALSE;
+}
+
+void vulkan_gpu_timer_begin_frame(
+    vulkan_gpu_timer* timer,
+    vulkan_command_buffer* command_buffer,
+    u32 frame) {
+    if (!timer->supported)
+        return;
+
+    vkCmdResetQueryPool(command_buffer->handle, timer->query_pool, frame * VULKAN_GPU_TIMESTAMP_COUNT, VULKAN_GPU_TIMESTAMP_COUNT);
+    vulkan_gpu_timer_write(timer, command_buffer, frame, VULKAN_GPU_TIMESTAMP_FRAME_BEGIN, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+}
+
+void vulkan_gpu_timer_write(
+    vulkan_gpu_timer* timer,
+    vulkan_command_buffer* command_buffer,
+    u32 frame,
+    vulkan_gpu_timestamp timestamp,
+    VkPipelineStageFlagBits stage) {
+    if (!timer->supported)
+        return;
+
+    vkCmdWriteTimestamp(command_buffer->handle, stage, timer->query_pool, frame * VULKAN_GPU_TIMESTAMP_COUNT + timestamp);
+}
+
+void vulkan_gpu_timer_end_frame(
+    vulkan_gpu_timer* timer,
+    vulkan_command_buffer* command_buffer,
+    u32 frame) {
+    if (!timer->supported)
+        return;
+
+    vulkan_gpu_timer_write(timer, command_buffer, frame, VULKAN_GPU_TIMESTAMP_FRAME_END, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+}
+
+void vulkan_gpu_timer_submitted(vulkan_gpu_timer* timer, u32 frame) {
+    if (timer->supported)
+        timer->pending[frame] = TRUE;
+}
+
+void vulkan_gpu_timer_collect(
+    vulkan_context* context,
+    vulkan_gpu_timer* timer,
+    u32 frame) {
+    if (!timer->supported || !timer->pending[frame])
+        return;
+
+    // Whatever the outcome the queries are reset when the frame is recorded again
+    timer->pending[frame] = FALSE;
+
+    u64 timestamps[VULKAN_GPU_TIMESTAMP_COUNT];
+    VkResult res = vkGetQueryPoolResults(
+        context->device.logical_device,
+        timer->query_pool,
+        frame * VULKAN_GPU_TIMESTAMP_COUNT,
+        VULKAN_GPU_TIMESTAMP_COUNT,
+        sizeof(timestamps),
+        timestamps,
+        sizeof(u64),
+        VK_QUERY_RESULT_64_BIT);
+
+    // The frame completed, VK_NOT_READY would mean a timestamp was not written. Drop it instead of waiting
+    if (res != VK_SUCCESS)
+        return;
+
+    f64 seconds_per_tick = timer->timestamp_period * 0.000000001;
+    u64 frame_ticks = (timestamps[VULKAN_GPU_TIMESTAMP_FRAME_END] - timestamps[VULKAN_GPU_TIMESTAMP_FRAME_BEGIN]) & timer->valid_mask;
+    u64 main_pass_ticks = (timestamps[VULKAN_GPU_TIMESTAMP_MAIN_PASS_END] - timestamps[VULKAN_GPU_TIMESTAMP_MAIN_PASS_BEGIN]) & timer->valid_mask;
+
+    frame_stats_record(FRAME_STAT_ZONE_GPU_FRAME, (f64)frame_ticks * seconds_per_tick);
+    frame_stats_record(FRAME_STAT_ZONE_GPU_MAIN_PASS, (f64)main_pass_ticks * seconds_per_tick);
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "vulkan_types.inl"
+
+/*
+* Creates the timestamp query pool of the GPU timer. If the graphics queue
+* does not support timestamps the timer is created as unsupported and
+* every other call becomes a no-op.
+*
+* @param context - The vulkan context
+* @param frame_count - The amount of frames in flight, one query set is created per frame
+* @param out_timer - The timer that will be created
+* @return b8 - TRUE if created (even if unsupported), FALSE on failure
+*/
+b8 vulkan_gpu_timer_create(
+    vulkan_context* context,
+    u32 frame_count,
+    vulkan_gpu_timer* out_timer);
+
+/*
+* Destroys the query pool of the timer.
+*
+* @param context - The vulkan context
+* @param timer - The timer to destroy
+*/
+void vulkan_gpu_timer_destroy(vulkan_context* context, vulkan_gpu_timer* timer);
+
+/*
+* Resets the queries of a frame and writes the frame begin timestamp.
+* Must be recorded outside of a render pass.
+*
+* @param timer - The GPU timer
+* @param command_buffer - The command buffer of the frame (recording)
+* @param frame - The index of the frame in flight
+*/
+void vulkan_gpu_timer_begin_frame(
+    vulkan_gpu_timer* timer,
+    vulkan_command_buffer* command_buffer,
+    u32 frame);
+
+/*
+* Writes a single timestamp of a frame.
+*
+* @param timer - The GPU timer
+* @param command_buffer - The command buffer of the frame (recording)
+* @param frame - The index of the frame in flight
+* @param timestamp - Which timestamp of the frame is written
+* @param stage - The pipeline stage after which the timestamp is written
+*/
+void vulkan_gpu_timer_write(
+    vulkan_gpu_timer* timer,
+    vulkan_command_buffer* command_buffer,
+    u32 frame,
+    vulkan_gpu_timestamp timestamp,
+    VkPipelineStageFlagBits stage);
+
+/*
+* Writes the frame end timestamp.
+*
+* @param timer - The GPU timer
+* @param command_buffer - The command buffer of the frame (recording)
+* @param frame - The index of the frame in flight
+*/
+void vulkan_gpu_timer_end_frame(
+    vulkan_gpu_timer* timer,
+    vulkan_command_buffer* command_buffer,
+    u32 frame);
+
+/*
+* Marks the frame as pending read back. Call once its command buffer was submitted,
+* the queries of a frame that never reached the GPU were not reset and hold no results.
+*
+* @param timer - The GPU timer
+* @param frame - The index of the frame in flight
+*/
+void vulkan_gpu_timer_submitted(vulkan_gpu_timer* timer, u32 frame);
+
+/*
+* Reads back the timestamps of a frame without waiting and feeds them into
+* the frame statistics. Should only be called once the frame that last
+* used the slot has completed.
+*
+* @param context - The vulkan context
+* @param timer - The GPU timer
+* @param frame - The index of the frame in flight
+*/
+void vulkan_gpu_timer_collect(
+    vulkan_context* context,
+    vulkan_gpu_timer* timer,
+    u32 frame);
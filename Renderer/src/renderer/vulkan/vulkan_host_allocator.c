@@ -0,0 +1,231 @@
+#include "vulkan_host_allocator.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+#include "core/vatomic.h"
+#include "core/job_system.h"
+#include "core/vassert.h"
+
+#include <stdio.h>
+
+/*
+* Precedes every block handed to the driver, the free callback
+* only passes the pointer back.
+*/
+typedef struct host_allocation_header {
+    u64 size;
+    u32 alignment;
+    u16 scope;
+    // Index + 1 of the scratch arena the block came from, 0 for the heap
+    u16 scratch;
+} host_allocation_header;
+
+// Blocks are at least aligned to the header so it can sit right before them
+#define HOST_MIN_ALIGNMENT 16
+
+static const char* scope_names[VULKAN_HOST_SCOPE_COUNT] = {
+    "command",
+    "object",
+    "cache",
+    "device",
+    "instance"
+};
+
+/*
+* Each job thread bumps its own arena without atomics. This relies on the driver freeing
+* command scope blocks before the command that took them returns, so on the same thread;
+* host_free asserts it. Threads outside the job system, like driver workers, use the heap.
+*/
+static void* take_scratch(vulkan_host_allocator* allocator, u64 size, u64 alignment, u16* out_scratch) {
+    i32 thread = job_system_thread_index();
+    if (thread < 0 || (u32)thread >= allocator->scratch_count)
+        return 0;
+
+    vulkan_host_scratch* scratch = &allocator->scratch[thread];
+    u64 start = (u64)(scratch->memory + scratch->offset) + sizeof(host_allocation_header);
+    u64 address = (start + alignment - 1) & ~(alignment - 1);
+    u64 end = address + size;
+    if (end > (u64)(scratch->memory + VULKAN_HOST_SCRATCH_SIZE))
+        return 0;
+
+    scratch->offset = end - (u64)scratch->memory;
+    scratch->live++;
+    *out_scratch = (u16)(thread + 1);
+    return (void*)address;
+}
+
+static void* VKAPI_PTR host_allocate(void* user_data, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    vulkan_host_allocator* allocator = user_data;
+    if (size == 0)
+        return 0;
+
+    if (alignment < HOST_MIN_ALIGNMENT)
+        alignment = HOST_MIN_ALIGNMENT;
+
+    u64 total = vatomic_fetch_add_u64(&allocator->total_bytes, size, VMEMORY_ORDER_RELAXED) + size;
+    if (allocator->budget && total > allocator->budget) {
+        vatomic_fetch_sub_u64(&allocator->total_bytes, size, VMEMORY_ORDER_RELAXED);
+        VWARN("Driver host allocation of %llu bytes denied, budget of %llu bytes reached", (u64)size, allocator->budget);
+        return 0;
+    }
+
+    // Command scope memory is gone once the command returns, a bump allocator is enough for it
+    u16 scratch = 0;
+    u8* block = 0;
+    if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) {
+        block = take_scratch(allocator, size, alignment, &scratch);
+        if (block)
+            vatomic_fetch_add_u64(&allocator->scratch_hits, 1, VMEMORY_ORDER_RELAXED);
+        else
+            vatomic_fetch_add_u64(&allocator->scratch_misses, 1, VMEMORY_ORDER_RELAXED);
+    }
+
+    if (!block) {
+        // The header lives in the first alignment bytes of the underlying block
+        u8* base = vallocate_aligned(size + alignment, alignment, MEMORY_TAG_VULKAN);
+        if (!base) {
+            vatomic_fetch_sub_u64(&allocator->total_bytes, size, VMEMORY_ORDER_RELAXED);
+            return 0;
+        }
+        block = base + alignment;
+    }
+
+    host_allocation_header* header = (host_allocation_header*)block - 1;
+    header->size = size;
+    header->alignment = (u32)alignment;
+    header->scope = (u16)scope;
+    header->scratch = scratch;
+
+    vatomic_fetch_add_u64(&allocator->scopes[scope].allocation_count, 1, VMEMORY_ORDER_RELAXED);
+    vatomic_fetch_add_u64(&allocator->scopes[scope].bytes, size, VMEMORY_ORDER_RELAXED);
+
+    u64 peak = vatomic_load_u64(&allocator->peak_bytes, VMEMORY_ORDER_RELAXED);
+    while (total > peak && !vatomic_compare_exchange_u64(&allocator->peak_bytes, &peak, total, VMEMORY_ORDER_RELAXED)) {
+    }
+
+    return block;
+}
+
+static void VKAPI_PTR host_free(void* user_data, void* memory) {
+    vulkan_host_allocator* allocator = user_data;
+    if (!memory)
+        return;
+
+    host_allocation_header* header = (host_allocation_header*)memory - 1;
+    vatomic_fetch_sub_u64(&allocator->total_bytes, header->size, VMEMORY_ORDER_RELAXED);
+    vatomic_fetch_sub_u64(&allocator->scopes[header->scope].allocation_count, 1, VMEMORY_ORDER_RELAXED);
+    vatomic_fetch_sub_u64(&allocator->scopes[header->scope].bytes, header->size, VMEMORY_ORDER_RELAXED);
+
+    if (header->scratch) {
+        VASSERT_MSG(job_system_thread_index() == header->scratch - 1, "Command scope block freed off the thread that took it");
+        vulkan_host_scratch* scratch = &allocator->scratch[header->scratch - 1];
+        if (--scratch->live == 0)
+            scratch->offset = 0;
+        return;
+    }
+
+    u64 alignment = header->alignment;
+    vfree_aligned((u8*)memory - alignment, header->size + alignment, alignment, MEMORY_TAG_VULKAN);
+}
+
+static void* VKAPI_PTR host_reallocate(void* user_data, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    if (!original)
+        return host_allocate(user_data, size, alignment, scope);
+
+    if (size == 0) {
+        host_free(user_data, original);
+        return 0;
+    }
+
+    // On failure the original block must stay valid
+    void* block = host_allocate(user_data, size, alignment, scope);
+    if (!block)
+        return 0;
+
+    host_allocation_header* header = (host_allocation_header*)original - 1;
+    vcopy_memory(block, original, header->size < size ? header->size : size);
+    host_free(user_data, original);
+    return block;
+}
+
+// Executable memory is the only internal allocation type, the scope is what tells them apart
+static void VKAPI_PTR host_internal_allocation(void* user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope) {
+    vulkan_host_allocator* allocator = user_data;
+    (void)type;
+    vatomic_fetch_add_u64(&allocator->internal_bytes, size, VMEMORY_ORDER_RELAXED);
+    vatomic_fetch_add_u64(&allocator->scopes[scope].internal_bytes, size, VMEMORY_ORDER_RELAXED);
+}
+
+static void VKAPI_PTR host_internal_free(void* user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope) {
+    vulkan_host_allocator* allocator = user_data;
+    (void)type;
+    vatomic_fetch_sub_u64(&allocator->internal_bytes, size, VMEMORY_ORDER_RELAXED);
+    vatomic_fetch_sub_u64(&allocator->scopes[scope].internal_bytes, size, VMEMORY_ORDER_RELAXED);
+}
+
+b8 vulkan_host_allocator_create(u64 budget, vulkan_host_allocator* out_allocator) {
+    vzero_memory(out_allocator, sizeof(vulkan_host_allocator));
+    out_allocator->budget = budget;
+
+    // Threads outside of the job system fall back to the heap for command scope memory
+    out_allocator->scratch_count = job_system_thread_count();
+    out_allocator->scratch = vallocate(sizeof(vulkan_host_scratch) * out_allocator->scratch_count, MEMORY_TAG_VULKAN);
+    for (u32 idx = 0; idx != out_allocator->scratch_count; ++idx) {
+        out_allocator->scratch[idx].memory = vallocate_aligned(VULKAN_HOST_SCRATCH_SIZE, 64, MEMORY_TAG_VULKAN);
+        if (!out_allocator->scratch[idx].memory) {
+            VERROR("Failed to allocate the vulkan scratch arena of job thread %u", idx);
+            vulkan_host_allocator_destroy(out_allocator);
+            return FALSE;
+        }
+    }
+
+    out_allocator->callbacks.pUserData = out_allocator;
+    out_allocator->callbacks.pfnAllocation = host_allocate;
+    out_allocator->callbacks.pfnReallocation = host_reallocate;
+    out_allocator->callbacks.pfnFree = host_free;
+    out_allocator->callbacks.pfnInternalAllocation = host_internal_allocation;
+    out_allocator->callbacks.pfnInternalFree = host_internal_free;
+    return TRUE;
+}
+
+void vulkan_host_allocator_destroy(vulkan_host_allocator* allocator) {
+    u64 remaining = vatomic_load_u64(&allocator->total_bytes, VMEMORY_ORDER_RELAXED);
+    if (remaining != 0) {
+        VWARN("The driver still holds %llu bytes of host memory", remaining);
+    }
+
+    if (allocator->scratch) {
+        for (u32 idx = 0; idx != allocator->scratch_count; ++idx) {
+            if (allocator->scratch[idx].memory)
+                vfree_aligned(allocator->scratch[idx].memory, VULKAN_HOST_SCRATCH_SIZE, 64, MEMORY_TAG_VULKAN);
+        }
+        vfree(allocator->scratch, sizeof(vulkan_host_scratch) * allocator->scratch_count, MEMORY_TAG_VULKAN);
+        allocator->scratch = 0;
+    }
+
+    allocator->scratch_count = 0;
+    vzero_memory(&allocator->callbacks, sizeof(VkAllocationCallbacks));
+}
+
+i32 vulkan_host_allocator_usage_str(vulkan_host_allocator* allocator, char* buffer, u64 size) {
+    const f32 kib = 1024.f;
+    i32 offset = snprintf(buffer, size, "Driver host memory: %.2fKiB (peak %.2fKiB, internal %.2fKiB)\n",
+        vatomic_load_u64(&allocator->total_bytes, VMEMORY_ORDER_RELAXED) / kib,
+        vatomic_load_u64(&allocator->peak_bytes, VMEMORY_ORDER_RELAXED) / kib,
+        vatomic_load_u64(&allocator->internal_bytes, VMEMORY_ORDER_RELAXED) / kib);
+
+    for (u32 idx = 0; idx != VULKAN_HOST_SCOPE_COUNT && offset >= 0 && (u64)offset < size; ++idx) {
+        offset += snprintf(buffer + offset, size - offset, " %-8s: %.2fKiB in %llu allocations, internal %.2fKiB\n",
+            scope_names[idx],
+            vatomic_load_u64(&allocator->scopes[idx].bytes, VMEMORY_ORDER_RELAXED) / kib,
+            vatomic_load_u64(&allocator->scopes[idx].allocation_count, VMEMORY_ORDER_RELAXED),
+            vatomic_load_u64(&allocator->scopes[idx].internal_bytes, VMEMORY_ORDER_RELAXED) / kib);
+    }
+
+    if (offset >= 0 && (u64)offset < size) {
+        offset += snprintf(buffer + offset, size - offset, " Command scope scratch hits: %llu, misses: %llu\n",
+            vatomic_load_u64(&allocator->scratch_hits, VMEMORY_ORDER_RELAXED),
+            vatomic_load_u64(&allocator->scratch_misses, VMEMORY_ORDER_RELAXED));
+    }
+
+    return offset;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "vulkan_types.inl"
+
+/*
+* Creates the allocation callbacks handed to every Vulkan call. Must be
+* created before the instance and destroyed after it, since objects have
+* to be freed with the callbacks they were created with.
+*
+* @param budget - Bytes the driver may hold at most, 0 for no bound
+* @param out_allocator - The allocator that will be created
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_host_allocator_create(u64 budget, vulkan_host_allocator* out_allocator);
+
+/*
+* Releases the scratch arenas and reports driver memory that is still held.
+*
+* @param allocator - The allocator to destroy
+*/
+void vulkan_host_allocator_destroy(vulkan_host_allocator* allocator);
+
+/*
+* Formats the host memory of the driver, broken down by allocation scope.
+*
+* @param allocator - The allocator
+* @param buffer - The buffer that will hold the text
+* @param size - The size of the buffer in bytes
+* @return i32 - The amount of characters written
+*/
+i32 vulkan_host_allocator_usage_str(vulkan_host_allocator* allocator, char* buffer, u64 size);
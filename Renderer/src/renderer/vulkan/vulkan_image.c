@@ -1,9 +1,10 @@
 #include "vulkan_image.h"
 #include "vulkan_device.h"
+#include "vulkan_memory_allocator.h"
 #include "core/logger.h"
 #include "core/vmemory.h"
 
-void vulkan_image_create(
+static void create_image(
     vulkan_context* context,
     VkImageType image_type,
     u32 width,
@@ -11,9 +12,10 @@ void vulkan_image_create(
     VkFormat format,
     VkImageTiling tiling,
     VkImageUsageFlags usage,
-    VkMemoryPropertyFlags memory_flags,
+    vulkan_memory_usage memory_usage,
     b32 create_view,
     VkImageAspectFlags view_aspect_flags,
+    b8 is_concurrent,
     vulkan_image* out_image) {
     out_image->width = width;
     out_image->height = height;
@@ -30,31 +32,26 @@ void vulkan_image_create(
     image_info.samples = VK_SAMPLE_COUNT_1_BIT; // TODO: configurable sample count
     image_info.tiling = tiling;
     image_info.usage = usage;
-    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE; // TODO: configurable sharing mode
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-    VkResult res = vkCreateImage(context->device.logical_device, &image_info, context->allocator, &out_image->handle);
-    VK_CHECK(res);
-    VkMemoryRequirements memory_requirments;
-    vkGetImageMemoryRequirements(context->device.logical_device, out_image->handle, &memory_requirments);
-
-    i32 memory_type = context->find_memory_index(memory_requirments.memoryTypeBits, memory_flags);
-    if (memory_type == -1) {
-        VERROR("Required memory type not found! Image not valid");
+    // Nothing to share when compute runs on the graphics family
+    u32 families[2] = { context->device.graphics_queue_index, context->device.compute_queue_index };
+    if (is_concurrent && families[0] != families[1]) {
+        image_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        image_info.queueFamilyIndexCount = 2;
+        image_info.pQueueFamilyIndices = families;
     }
+    out_image->is_concurrent = is_concurrent;
 
-    // Allocate memory
-    VkMemoryAllocateInfo allocate_info = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    allocate_info.memoryTypeIndex = memory_type;
-    allocate_info.pNext = 0;
-    allocate_info.allocationSize = memory_requirments.size;
-
-    res = vkAllocateMemory(context->device.logical_device, &allocate_info, context->allocator, &out_image->memory);
+    VkResult res = vkCreateImage(context->device.logical_device, &image_info, context->allocator, &out_image->handle);
     VK_CHECK(res);
 
-    // Bind memory
-    res = vkBindImageMemory(context->device.logical_device, out_image->handle, out_image->memory, 0); // TODO: configurable offset
-    VK_CHECK(res);
+    // Sub-allocated from a shared block unless the image is large or the driver wants it dedicated
+    u32 allocation_flags = tiling == VK_IMAGE_TILING_OPTIMAL ? VULKAN_MEMORY_FLAG_OPTIMAL : 0;
+    if (!vulkan_memory_allocate_image(context, out_image->handle, memory_usage, allocation_flags, &out_image->memory)) {
+        VERROR("Failed to allocate memory for the image! Image not valid");
+    }
 
     if (create_view) {
         out_image->view = 0;
@@ -62,6 +59,38 @@ void vulkan_image_create(
     }
 }
 
+void vulkan_image_create(
+    vulkan_context* context,
+    VkImageType image_type,
+    u32 width,
+    u32 height,
+    VkFormat format,
+    VkImageTiling tiling,
+    VkImageUsageFlags usage,
+    vulkan_memory_usage memory_usage,
+    b32 create_view,
+    VkImageAspectFlags view_aspect_flags,
+    vulkan_image* out_image) {
+    create_image(context, image_type, width, height, format, tiling, usage, memory_usage,
+        create_view, view_aspect_flags, FALSE, out_image);
+}
+
+void vulkan_image_create_concurrent(
+    vulkan_context* context,
+    VkImageType image_type,
+    u32 width,
+    u32 height,
+    VkFormat format,
+    VkImageTiling tiling,
+    VkImageUsageFlags usage,
+    vulkan_memory_usage memory_usage,
+    b32 create_view,
+    VkImageAspectFlags view_aspect_flags,
+    vulkan_image* out_image) {
+    create_image(context, image_type, width, height, format, tiling, usage, memory_usage,
+        create_view, view_aspect_flags, TRUE, out_image);
+}
+
 void vulkan_image_view_create(
     vulkan_context* context,
     VkFormat format,
@@ -89,12 +118,9 @@ void vulkan_image_destroy(vulkan_context* context, vulkan_image* image) {
         vkDestroyImageView(context->device.logical_device, image->view, context->allocator);
         image->view = 0;
     }
-    if (image->memory) {
-        vkFreeMemory(context->device.logical_device, image->memory, context->allocator);
-        image->memory = 0;
-    }
     if (image->handle) {
         vkDestroyImage(context->device.logical_device, image->handle, context->allocator);
         image->handle = 0;
     }
+    vulkan_memory_free(context, &image->memory);
 }
\ No newline at end of file
@@ -15,7 +15,7 @@
 * @param format - The format of the image (Vulkan Spec Format)
 * @param tiling - The memory tiling
 * @param usage - How should the image be used
-* @param memory_flags - Memory type of the image
+* @param memory_usage - What the memory of the image is used for
 * @param create_view - If you want to create a view with the image
 * @param view_aspect_flags - Aspect flags of the image
 * @param out_image - pointer to the out image
@@ -28,7 +28,27 @@ void vulkan_image_create(
     VkFormat format,
     VkImageTiling tiling,
     VkImageUsageFlags usage,
-    VkMemoryPropertyFlags memory_flags,
+    vulkan_memory_usage memory_usage,
+    b32 create_view,
+    VkImageAspectFlags view_aspect_flags,
+    vulkan_image* out_image);
+
+/*
+* Creates an image both the graphics and the compute queue access, e.g. a storage
+* image written by async compute and sampled by draws. No queue family ownership
+* transfers are needed for it, which can make access slower on some devices.
+* Images of vulkan_image_create are exclusive to one family at a time.
+* Parameters are the same as for vulkan_image_create.
+*/
+void vulkan_image_create_concurrent(
+    vulkan_context *context,
+    VkImageType image_type,
+    u32 width,
+    u32 height,
+    VkFormat format,
+    VkImageTiling tiling,
+    VkImageUsageFlags usage,
+    vulkan_memory_usage memory_usage,
     b32 create_view,
     VkImageAspectFlags view_aspect_flags,
     vulkan_image* out_image);
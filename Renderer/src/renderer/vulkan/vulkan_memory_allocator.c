@@ -0,0 +1,976 @@
+#include "vulkan_memory_allocator.h"
+#include "vulkan_timeline.h"
+#include "vulkan_utils.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+#include "containers/darray.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Block size of heaps of at least 1 GiB, smaller heaps use an eighth of their size
+#define VULKAN_MEMORY_DEFAULT_BLOCK_SIZE (64ull * 1024 * 1024)
+#define VULKAN_MEMORY_MIN_BLOCK_SIZE (1ull * 1024 * 1024)
+
+// Memory types of each usage are ranked by these, see vulkan_memory_type_query
+static const vulkan_memory_type_query usage_queries[VULKAN_MEMORY_USAGE_COUNT] = {
+    // GPU only: VRAM first, system memory once it runs out
+    { 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT },
+    // Staging: plain write combined system memory
+    { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT },
+    // CPU to GPU: host visible VRAM (resizable BAR, integrated GPUs) before system memory
+    { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT },
+    // GPU to CPU: cached memory so reads do not go over the bus uncached
+    { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT }
+};
+
+static const char* usage_names[VULKAN_MEMORY_USAGE_COUNT] = {
+    "gpu only",
+    "staging",
+    "cpu to gpu",
+    "gpu to cpu"
+};
+
+static VkDeviceSize next_power_of_two(VkDeviceSize value) {
+    VkDeviceSize result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+static u8 order_of(VkDeviceSize node_size) {
+    u8 order = 0;
+    while ((VULKAN_MEMORY_MIN_NODE_SIZE << order) < node_size)
+        ++order;
+    return order;
+}
+
+static VkDeviceSize node_size_of(u8 order) {
+    return VULKAN_MEMORY_MIN_NODE_SIZE << order;
+}
+
+// Takes a free node of the order, splitting a larger one if needed
+static b8 block_take_node(vulkan_memory_block* block, u8 order, VkDeviceSize* out_offset) {
+    u32 k = order;
+    while (k < block->order_count && darray_length(block->free_nodes[k]) == 0)
+        ++k;
+
+    if (k >= block->order_count)
+        return FALSE;
+
+    VkDeviceSize offset;
+    darray_pop(block->free_nodes[k], &offset);
+
+    // Keep the lower half, the upper halves become free nodes of the smaller orders
+    while (k > order) {
+        --k;
+        VkDeviceSize buddy = offset + node_size_of((u8)k);
+        darray_push(block->free_nodes[k], buddy);
+    }
+
+    *out_offset = offset;
+    return TRUE;
+}
+
+// Returns a node, merging it with its buddy as long as the buddy is free as well
+static void block_return_node(vulkan_memory_block* block, VkDeviceSize offset, u8 order) {
+    u32 k = order;
+    while (k + 1 < block->order_count) {
+        VkDeviceSize buddy = offset ^ node_size_of((u8)k);
+        VkDeviceSize* free_nodes = block->free_nodes[k];
+        u64 length = darray_length(free_nodes);
+        u64 idx = 0;
+        while (idx != length && free_nodes[idx] != buddy)
+            ++idx;
+
+        if (idx == length)
+            break;
+
+        free_nodes[idx] = free_nodes[length - 1];
+        darray_length_set(free_nodes, length - 1);
+        offset &= ~node_size_of((u8)k);
+        ++k;
+    }
+
+    darray_push(block->free_nodes[k], offset);
+}
+
+static b8 map_block(vulkan_context* context, vulkan_memory_block* block) {
+    if (block->mapped)
+        return TRUE;
+
+    VkResult res = vkMapMemory(context->device.logical_device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkMapMemory failed with result: %s", vulkan_result_string(res, TRUE));
+        block->mapped = 0;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static b8 allocate_device_memory(
+    vulkan_context* context,
+    u32 memory_type,
+    VkDeviceSize size,
+    const void* next,
+    VkDeviceMemory* out_memory) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    if (allocator->device_memory_count >= context->device.properties.limits.maxMemoryAllocationCount) {
+        VERROR("Device memory allocation limit of %u reached", context->device.properties.limits.maxMemoryAllocationCount);
+        return FALSE;
+    }
+
+    VkMemoryAllocateInfo allocate_info = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    allocate_info.pNext = next;
+    allocate_info.allocationSize = size;
+    allocate_info.memoryTypeIndex = memory_type;
+
+    VkResult res = vkAllocateMemory(context->device.logical_device, &allocate_info, context->allocator, out_memory);
+    if (!vulkan_result_is_success(res)) {
+        VWARN("vkAllocateMemory of %llu bytes failed with result: %s", size, vulkan_result_string(res, TRUE));
+        return FALSE;
+    }
+
+    ++allocator->device_memory_count;
+    return TRUE;
+}
+
+static u32 create_block(vulkan_context* context, u32 memory_type, b8 optimal, VkDeviceSize min_size) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    u32 heap = allocator->properties.memoryTypes[memory_type].heapIndex;
+
+    // Retry with smaller blocks when the heap is running out
+    VkDeviceSize size = allocator->block_size[heap];
+    VkDeviceMemory memory = 0;
+    while (!allocate_device_memory(context, memory_type, size, 0, &memory)) {
+        size >>= 1;
+        if (size < min_size || size < VULKAN_MEMORY_MIN_BLOCK_SIZE)
+            return INVALID_ID;
+    }
+
+    // Reuse the slot of a released block so block indices stay stable
+    u32 index = INVALID_ID;
+    u32 block_count = (u32)darray_length(allocator->blocks);
+    for (u32 idx = 0; idx != block_count; ++idx) {
+        if (!allocator->blocks[idx].memory) {
+            index = idx;
+            break;
+        }
+    }
+
+    if (index == INVALID_ID) {
+        vulkan_memory_block empty;
+        vzero_memory(&empty, sizeof(vulkan_memory_block));
+        darray_push(allocator->blocks, empty);
+        index = block_count;
+    }
+
+    vulkan_memory_block* block = &allocator->blocks[index];
+    vzero_memory(block, sizeof(vulkan_memory_block));
+    block->memory = memory;
+    block->size = size;
+    block->memory_type = memory_type;
+    block->optimal = optimal;
+    block->order_count = order_of(size) + 1;
+    for (u32 k = 0; k != block->order_count; ++k)
+        block->free_nodes[k] = darray_create(VkDeviceSize);
+    block->movables = darray_create(vulkan_memory_movable);
+
+    // The whole block starts out as a single free node of the highest order
+    VkDeviceSize root = 0;
+    darray_push(block->free_nodes[block->order_count - 1], root);
+
+    allocator->heaps[heap].block_count++;
+    allocator->heaps[heap].block_bytes += size;
+    VDEBUG("Created device memory block %u of %llu bytes (type %u, %s)", index, size, memory_type, optimal ? "optimal" : "linear");
+    return index;
+}
+
+static void release_block(vulkan_context* context, u32 index) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    vulkan_memory_block* block = &allocator->blocks[index];
+    u32 heap = allocator->properties.memoryTypes[block->memory_type].heapIndex;
+
+    // Freeing memory unmaps it implicitly
+    vkFreeMemory(context->device.logical_device, block->memory, context->allocator);
+    --allocator->device_memory_count;
+    allocator->heaps[heap].block_count--;
+    allocator->heaps[heap].block_bytes -= block->size;
+
+    for (u32 k = 0; k != block->order_count; ++k)
+        darray_destroy(block->free_nodes[k]);
+    darray_destroy(block->movables);
+    vzero_memory(block, sizeof(vulkan_memory_block));
+}
+
+static b8 blocks_compatible(const vulkan_memory_allocator* allocator, const vulkan_memory_block* block, u32 memory_type, b8 optimal) {
+    return block->memory && block->memory_type == memory_type && (allocator->share_blocks || block->optimal == optimal);
+}
+
+static b8 allocate_dedicated(
+    vulkan_context* context,
+    const VkMemoryRequirements* requirements,
+    u32 memory_type,
+    u32 flags,
+    VkImage image,
+    VkBuffer buffer,
+    vulkan_allocation* out_allocation) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+
+    // Tells the driver which resource the memory is for, so it can place it best
+    VkMemoryDedicatedAllocateInfo dedicated_info = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO };
+    dedicated_info.image = image;
+    dedicated_info.buffer = buffer;
+    const void* next = (image || buffer) ? &dedicated_info : 0;
+
+    platform_mutex_lock(&allocator->mutex);
+    b8 result = allocate_device_memory(context, memory_type, requirements->size, next, &out_allocation->memory);
+    if (result) {
+        u32 heap = allocator->properties.memoryTypes[memory_type].heapIndex;
+        allocator->heaps[heap].dedicated_count++;
+        allocator->heaps[heap].dedicated_bytes += requirements->size;
+    }
+    platform_mutex_unlock(&allocator->mutex);
+
+    if (!result)
+        return FALSE;
+
+    out_allocation->offset = 0;
+    out_allocation->size = requirements->size;
+    out_allocation->memory_type = memory_type;
+    out_allocation->block = INVALID_ID;
+
+    if (flags & VULKAN_MEMORY_FLAG_MAPPED) {
+        VkResult res = vkMapMemory(context->device.logical_device, out_allocation->memory, 0, VK_WHOLE_SIZE, 0, &out_allocation->mapped);
+        if (!vulkan_result_is_success(res)) {
+            VERROR("vkMapMemory failed with result: %s", vulkan_result_string(res, TRUE));
+            vulkan_memory_free(context, out_allocation);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+// Sub-allocates from a block of the memory type, creating a block if none has room
+static b8 allocate_from_type(
+    vulkan_context* context,
+    const VkMemoryRequirements* requirements,
+    u32 memory_type,
+    u32 flags,
+    VkImage image,
+    VkBuffer buffer,
+    vulkan_allocation* out_allocation) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+
+    // Nodes are aligned to their size, so rounding up to the alignment satisfies it
+    VkDeviceSize node_size = next_power_of_two(requirements->size > requirements->alignment ? requirements->size : requirements->alignment);
+    if (node_size < VULKAN_MEMORY_MIN_NODE_SIZE)
+        node_size = VULKAN_MEMORY_MIN_NODE_SIZE;
+
+    u32 heap = allocator->properties.memoryTypes[memory_type].heapIndex;
+    if ((flags & VULKAN_MEMORY_FLAG_DEDICATED) || node_size > allocator->block_size[heap] / 2)
+        return allocate_dedicated(context, requirements, memory_type, flags, image, buffer, out_allocation);
+
+    b8 optimal = (flags & VULKAN_MEMORY_FLAG_OPTIMAL) != 0;
+    u8 order = order_of(node_size);
+    VkDeviceSize offset = 0;
+
+    platform_mutex_lock(&allocator->mutex);
+    u32 index = INVALID_ID;
+    u32 block_count = (u32)darray_length(allocator->blocks);
+    for (u32 idx = 0; idx != block_count; ++idx) {
+        vulkan_memory_block* block = &allocator->blocks[idx];
+        if (blocks_compatible(allocator, block, memory_type, optimal) && order < block->order_count &&
+            block_take_node(block, order, &offset)) {
+            index = idx;
+            break;
+        }
+    }
+
+    if (index == INVALID_ID) {
+        index = create_block(context, memory_type, optimal, node_size);
+        if (index == INVALID_ID || !block_take_node(&allocator->blocks[index], order, &offset)) {
+            platform_mutex_unlock(&allocator->mutex);
+            return FALSE;
+        }
+    }
+
+    vulkan_memory_block* block = &allocator->blocks[index];
+    if ((flags & VULKAN_MEMORY_FLAG_MAPPED) && !map_block(context, block)) {
+        block_return_node(block, offset, order);
+        platform_mutex_unlock(&allocator->mutex);
+        return FALSE;
+    }
+
+    block->allocation_count++;
+    block->used += node_size;
+    allocator->heaps[heap].allocation_count++;
+    allocator->heaps[heap].used_bytes += node_size;
+    allocator->heaps[heap].requested_bytes += requirements->size;
+
+    out_allocation->memory = block->memory;
+    out_allocation->offset = offset;
+    out_allocation->size = requirements->size;
+    out_allocation->mapped = (flags & VULKAN_MEMORY_FLAG_MAPPED) ? (u8*)block->mapped + offset : 0;
+    out_allocation->memory_type = memory_type;
+    out_allocation->block = index;
+    out_allocation->order = order;
+    platform_mutex_unlock(&allocator->mutex);
+    return TRUE;
+}
+
+static b8 allocate(
+    vulkan_context* context,
+    const VkMemoryRequirements* requirements,
+    vulkan_memory_usage usage,
+    u32 flags,
+    VkImage image,
+    VkBuffer buffer,
+    vulkan_allocation* out_allocation) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    vzero_memory(out_allocation, sizeof(vulkan_allocation));
+
+    // Walk the chain of the usage, falling back to the next type when a heap is full
+    const vulkan_memory_type_chain* chain = &allocator->chains[usage];
+    u32 tried = 0;
+    for (u32 idx = 0; idx != chain->count; ++idx) {
+        u32 memory_type = chain->types[idx];
+        if (!(requirements->memoryTypeBits & (1u << memory_type)))
+            continue;
+
+        if ((flags & VULKAN_MEMORY_FLAG_MAPPED) &&
+            !(allocator->properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+            continue;
+
+        if (tried++ != 0) {
+            VWARN("Falling back to memory type %u for an allocation of %llu bytes (%s)",
+                memory_type, requirements->size, usage_names[usage]);
+        }
+
+        if (allocate_from_type(context, requirements, memory_type, flags, image, buffer, out_allocation))
+            return TRUE;
+    }
+
+    if (tried == 0) {
+        VERROR("No memory type of usage %s suits the resource (type bits 0x%x)", usage_names[usage], requirements->memoryTypeBits);
+    } else {
+        VERROR("Out of device memory for an allocation of %llu bytes", requirements->size);
+    }
+    return FALSE;
+}
+
+static u32 count_bits(u32 value) {
+    u32 count = 0;
+    for (; value; value &= value - 1)
+        ++count;
+    return count;
+}
+
+static void build_chain(
+    const VkPhysicalDeviceMemoryProperties* properties,
+    const vulkan_memory_type_query* query,
+    vulkan_memory_type_chain* out_chain) {
+    VkMemoryPropertyFlags special = (VK_MEMORY_PROPERTY_PROTECTED_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) & ~query->required;
+    u32 scores[VK_MAX_MEMORY_TYPES];
+    out_chain->count = 0;
+
+    for (u32 idx = 0; idx != properties->memoryTypeCount; ++idx) {
+        VkMemoryPropertyFlags type_flags = properties->memoryTypes[idx].propertyFlags;
+        if ((type_flags & query->required) != query->required || (type_flags & special))
+            continue;
+
+        // More preferred flags rank higher, more avoided flags lower, ties keep the driver order
+        u32 score = count_bits(type_flags & query->preferred) * 64 + (32 - count_bits(type_flags & query->avoided));
+
+        // Insertion sort, stable since equal scores are passed over
+        u32 position = out_chain->count;
+        while (position > 0 && scores[position - 1] < score) {
+            scores[position] = scores[position - 1];
+            out_chain->types[position] = out_chain->types[position - 1];
+            --position;
+        }
+        scores[position] = score;
+        out_chain->types[position] = (u8)idx;
+        out_chain->count++;
+    }
+}
+
+i32 vulkan_memory_find_type(vulkan_context* context, u32 type_filter, vulkan_memory_usage usage) {
+    const vulkan_memory_type_chain* chain = &context->memory_allocator.chains[usage];
+    for (u32 idx = 0; idx != chain->count; ++idx) {
+        if (type_filter & (1u << chain->types[idx]))
+            return chain->types[idx];
+    }
+
+    return -1;
+}
+
+i32 vulkan_memory_find_type_query(vulkan_context* context, u32 type_filter, const vulkan_memory_type_query* query) {
+    vulkan_memory_type_chain chain;
+    build_chain(&context->memory_allocator.properties, query, &chain);
+    for (u32 idx = 0; idx != chain.count; ++idx) {
+        if (type_filter & (1u << chain.types[idx]))
+            return chain.types[idx];
+    }
+
+    return -1;
+}
+
+b8 vulkan_memory_allocator_create(vulkan_context* context) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    vzero_memory(allocator, sizeof(vulkan_memory_allocator));
+    allocator->properties = context->device.memory;
+
+    for (u32 idx = 0; idx != VULKAN_MEMORY_USAGE_COUNT; ++idx) {
+        build_chain(&allocator->properties, &usage_queries[idx], &allocator->chains[idx]);
+        if (allocator->chains[idx].count == 0) {
+            VWARN("No memory type suits usage %s", usage_names[idx]);
+            continue;
+        }
+
+        // The order allocations of the usage try the types in, with their heap and property flags
+        char types[VK_MAX_MEMORY_TYPES * 32];
+        i32 offset = 0;
+        for (u32 position = 0; position != allocator->chains[idx].count; ++position) {
+            u32 memory_type = allocator->chains[idx].types[position];
+            offset += snprintf(types + offset, sizeof(types) - offset, "%s%u (heap %u, flags 0x%x)", position ? ", " : "",
+                memory_type, allocator->properties.memoryTypes[memory_type].heapIndex, allocator->properties.memoryTypes[memory_type].propertyFlags);
+        }
+        VDEBUG("Memory types of usage %s: %s", usage_names[idx], types);
+    }
+
+    for (u32 idx = 0; idx != allocator->properties.memoryHeapCount; ++idx) {
+        VkDeviceSize heap_size = allocator->properties.memoryHeaps[idx].size;
+        VkDeviceSize block_size = VULKAN_MEMORY_DEFAULT_BLOCK_SIZE;
+        if (heap_size < 1024ull * 1024 * 1024) {
+            // Largest power of two not above an eighth of the heap
+            block_size = next_power_of_two(heap_size / 8 + 1) >> 1;
+            if (block_size < VULKAN_MEMORY_MIN_BLOCK_SIZE)
+                block_size = VULKAN_MEMORY_MIN_BLOCK_SIZE;
+        }
+        allocator->block_size[idx] = block_size;
+    }
+
+    // Resources never share a granularity page when every node is at least a page apart
+    VkDeviceSize granularity = context->device.properties.limits.bufferImageGranularity;
+    allocator->share_blocks = granularity <= VULKAN_MEMORY_MIN_NODE_SIZE;
+
+    allocator->blocks = darray_create(vulkan_memory_block);
+    allocator->retired = darray_create(vulkan_memory_retired);
+    if (!platform_mutex_create(&allocator->mutex)) {
+        VERROR("Failed to create the mutex of the memory allocator");
+        darray_destroy(allocator->blocks);
+        darray_destroy(allocator->retired);
+        allocator->blocks = 0;
+        allocator->retired = 0;
+        return FALSE;
+    }
+
+    VINFO("Vulkan memory allocator created. Buffer image granularity: %llu, %s blocks",
+        granularity, allocator->share_blocks ? "shared" : "separate linear and optimal");
+    return TRUE;
+}
+
+void vulkan_memory_allocator_destroy(vulkan_context* context) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    if (!allocator->blocks)
+        return;
+
+    // The device is idle, nodes still waiting for their frame are free
+    u32 retired_count = (u32)darray_length(allocator->retired);
+    for (u32 idx = 0; idx != retired_count; ++idx) {
+        allocator->blocks[allocator->retired[idx].block].allocation_count--;
+    }
+    darray_destroy(allocator->retired);
+    allocator->retired = 0;
+
+    u32 block_count = (u32)darray_length(allocator->blocks);
+    for (u32 idx = 0; idx != block_count; ++idx) {
+        vulkan_memory_block* block = &allocator->blocks[idx];
+        if (!block->memory)
+            continue;
+
+        if (block->allocation_count != 0) {
+            VWARN("Device memory block %u released with %u live allocations", idx, block->allocation_count);
+        }
+        release_block(context, idx);
+    }
+
+    if (allocator->device_memory_count != 0) {
+        VWARN("%u dedicated device memory allocations were not freed", allocator->device_memory_count);
+    }
+
+    darray_destroy(allocator->blocks);
+    allocator->blocks = 0;
+    platform_mutex_destroy(&allocator->mutex);
+}
+
+b8 vulkan_memory_allocate(
+    vulkan_context* context,
+    const VkMemoryRequirements* requirements,
+    vulkan_memory_usage usage,
+    u32 flags,
+    vulkan_allocation* out_allocation) {
+    return allocate(context, requirements, usage, flags, 0, 0, out_allocation);
+}
+
+b8 vulkan_memory_allocate_image(
+    vulkan_context* context,
+    VkImage image,
+    vulkan_memory_usage usage,
+    u32 flags,
+    vulkan_allocation* out_allocation) {
+    VkMemoryDedicatedRequirements dedicated_requirements = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS };
+    VkMemoryRequirements2 requirements = { VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2 };
+    requirements.pNext = &dedicated_requirements;
+    VkImageMemoryRequirementsInfo2 requirements_info = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2 };
+    requirements_info.image = image;
+    vkGetImageMemoryRequirements2(context->device.logical_device, &requirements_info, &requirements);
+
+    if (dedicated_requirements.prefersDedicatedAllocation || dedicated_requirements.requiresDedicatedAllocation)
+        flags |= VULKAN_MEMORY_FLAG_DEDICATED;
+
+    if (!allocate(context, &requirements.memoryRequirements, usage, flags, image, 0, out_allocation))
+        return FALSE;
+
+    VkResult res = vkBindImageMemory(context->device.logical_device, image, out_allocation->memory, out_allocation->offset);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkBindImageMemory failed with result: %s", vulkan_result_string(res, TRUE));
+        vulkan_memory_free(context, out_allocation);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+b8 vulkan_memory_allocate_buffer(
+    vulkan_context* context,
+    VkBuffer buffer,
+    vulkan_memory_usage usage,
+    u32 flags,
+    vulkan_allocation* out_allocation) {
+    VkMemoryDedicatedRequirements dedicated_requirements = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS };
+    VkMemoryRequirements2 requirements = { VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2 };
+    requirements.pNext = &dedicated_requirements;
+    VkBufferMemoryRequirementsInfo2 requirements_info = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2 };
+    requirements_info.buffer = buffer;
+    vkGetBufferMemoryRequirements2(context->device.logical_device, &requirements_info, &requirements);
+
+    if (dedicated_requirements.prefersDedicatedAllocation || dedicated_requirements.requiresDedicatedAllocation)
+        flags |= VULKAN_MEMORY_FLAG_DEDICATED;
+
+    // Buffers are always linear
+    flags &= ~VULKAN_MEMORY_FLAG_OPTIMAL;
+    if (!allocate(context, &requirements.memoryRequirements, usage, flags, 0, buffer, out_allocation))
+        return FALSE;
+
+    VkResult res = vkBindBufferMemory(context->device.logical_device, buffer, out_allocation->memory, out_allocation->offset);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkBindBufferMemory failed with result: %s", vulkan_result_string(res, TRUE));
+        vulkan_memory_free(context, out_allocation);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void vulkan_memory_free(vulkan_context* context, vulkan_allocation* allocation) {
+    if (!allocation->memory)
+        return;
+
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    u32 heap = allocator->properties.memoryTypes[allocation->memory_type].heapIndex;
+
+    platform_mutex_lock(&allocator->mutex);
+    if (allocation->block == INVALID_ID) {
+        vkFreeMemory(context->device.logical_device, allocation->memory, context->allocator);
+        --allocator->device_memory_count;
+        allocator->heaps[heap].dedicated_count--;
+        allocator->heaps[heap].dedicated_bytes -= allocation->size;
+    }
+    else {
+        vulkan_memory_block* block = &allocator->blocks[allocation->block];
+        VkDeviceSize node_size = node_size_of(allocation->order);
+        block_return_node(block, allocation->offset, allocation->order);
+        block->allocation_count--;
+        block->used -= node_size;
+        allocator->heaps[heap].allocation_count--;
+        allocator->heaps[heap].used_bytes -= node_size;
+        allocator->heaps[heap].requested_bytes -= allocation->size;
+
+        u64 movable_count = darray_length(block->movables);
+        for (u64 idx = 0; idx != movable_count; ++idx) {
+            if (block->movables[idx].offset == allocation->offset) {
+                block->movables[idx] = block->movables[movable_count - 1];
+                darray_length_set(block->movables, movable_count - 1);
+                break;
+            }
+        }
+
+        // Keep one empty block per kind around so a resource that is recreated
+        // every frame does not allocate device memory every frame
+        if (block->allocation_count == 0) {
+            u32 block_count = (u32)darray_length(allocator->blocks);
+            for (u32 idx = 0; idx != block_count; ++idx) {
+                vulkan_memory_block* other = &allocator->blocks[idx];
+                if (idx != allocation->block && other->allocation_count == 0 &&
+                    other->memory_type == block->memory_type && other->optimal == block->optimal && other->memory) {
+                    release_block(context, allocation->block);
+                    break;
+                }
+            }
+        }
+    }
+    platform_mutex_unlock(&allocator->mutex);
+
+    vzero_memory(allocation, sizeof(vulkan_allocation));
+}
+
+void vulkan_memory_set_movable(
+    vulkan_context* context,
+    const vulkan_allocation* allocation,
+    pfn_vulkan_memory_move move,
+    void* user_data) {
+    if (allocation->block == INVALID_ID || !allocation->memory)
+        return;
+
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    vulkan_memory_movable movable;
+    movable.offset = allocation->offset;
+    movable.size = allocation->size;
+    movable.order = allocation->order;
+    movable.move = move;
+    movable.user_data = user_data;
+
+    platform_mutex_lock(&allocator->mutex);
+    darray_push(allocator->blocks[allocation->block].movables, movable);
+    platform_mutex_unlock(&allocator->mutex);
+}
+
+u32 vulkan_memory_defragment(vulkan_context* context, u32 max_moves) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    u32 moves = 0;
+
+    platform_mutex_lock(&allocator->mutex);
+    // No blocks are created while defragmenting, so block pointers stay valid
+    u32 block_count = (u32)darray_length(allocator->blocks);
+    // A block is either drained or filled in one pass, so no allocation moves twice
+    b8* drained = vallocate(sizeof(b8) * (block_count + 1), MEMORY_TAG_RENDERER);
+    b8* filled = vallocate(sizeof(b8) * (block_count + 1), MEMORY_TAG_RENDERER);
+
+    while (moves < max_moves) {
+        // Drain the least used block first, it takes the fewest moves to release
+        u32 source_index = INVALID_ID;
+        for (u32 idx = 0; idx != block_count; ++idx) {
+            vulkan_memory_block* block = &allocator->blocks[idx];
+            if (!block->memory || drained[idx] || filled[idx] || darray_length(block->movables) == 0)
+                continue;
+            if (source_index == INVALID_ID || block->used < allocator->blocks[source_index].used)
+                source_index = idx;
+        }
+
+        if (source_index == INVALID_ID)
+            break;
+
+        drained[source_index] = TRUE;
+        vulkan_memory_block* source = &allocator->blocks[source_index];
+
+        for (u64 m = darray_length(source->movables); m-- != 0 && moves < max_moves;) {
+            vulkan_memory_movable movable = source->movables[m];
+            VkDeviceSize node_size = node_size_of(movable.order);
+
+            // Only move into fuller blocks so allocations never move back and forth
+            u32 target_index = INVALID_ID;
+            VkDeviceSize offset = 0;
+            for (u32 idx = 0; idx != block_count; ++idx) {
+                vulkan_memory_block* block = &allocator->blocks[idx];
+                if (drained[idx] || !blocks_compatible(allocator, block, source->memory_type, source->optimal) ||
+                    block->optimal != source->optimal || block->used < source->used || movable.order >= block->order_count)
+                    continue;
+                if (block_take_node(block, movable.order, &offset)) {
+                    target_index = idx;
+                    break;
+                }
+            }
+
+            if (target_index == INVALID_ID)
+                continue;
+
+            vulkan_memory_block* target = &allocator->blocks[target_index];
+            if (source->mapped && !map_block(context, target)) {
+                block_return_node(target, offset, movable.order);
+                continue;
+            }
+
+            vulkan_allocation from;
+            from.memory = source->memory;
+            from.offset = movable.offset;
+            from.size = movable.size;
+            from.mapped = source->mapped ? (u8*)source->mapped + movable.offset : 0;
+            from.memory_type = source->memory_type;
+            from.block = source_index;
+            from.order = movable.order;
+
+            vulkan_allocation to = from;
+            to.memory = target->memory;
+            to.offset = offset;
+            to.mapped = source->mapped ? (u8*)target->mapped + offset : 0;
+            to.block = target_index;
+
+            if (!movable.move(movable.user_data, &from, &to)) {
+                block_return_node(target, offset, movable.order);
+                continue;
+            }
+
+            // Frames in flight and copies recorded into this frame may still read the old node
+            vulkan_memory_retired retired;
+            retired.block = source_index;
+            retired.offset = movable.offset;
+            retired.order = movable.order;
+            retired.frame_number = context->frame_number;
+            darray_push(allocator->retired, retired);
+            target->allocation_count++;
+            target->used += node_size;
+            filled[target_index] = TRUE;
+
+            // Earlier entries were visited already, so the last one can fill the gap
+            u64 movable_count = darray_length(source->movables);
+            source->movables[m] = source->movables[movable_count - 1];
+            darray_length_set(source->movables, movable_count - 1);
+            movable.offset = offset;
+            darray_push(target->movables, movable);
+            ++moves;
+        }
+    }
+
+    vfree(drained, sizeof(b8) * (block_count + 1), MEMORY_TAG_RENDERER);
+    vfree(filled, sizeof(b8) * (block_count + 1), MEMORY_TAG_RENDERER);
+    platform_mutex_unlock(&allocator->mutex);
+    return moves;
+}
+
+void vulkan_memory_release_retired(vulkan_context* context) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    platform_mutex_lock(&allocator->mutex);
+    vulkan_memory_retired* retired = allocator->retired;
+    u32 count = (u32)darray_length(retired);
+    u32 kept = 0;
+    for (u32 idx = 0; idx != count; ++idx) {
+        if (!vulkan_frame_is_complete(context, retired[idx].frame_number)) {
+            retired[kept++] = retired[idx];
+            continue;
+        }
+
+        vulkan_memory_block* block = &allocator->blocks[retired[idx].block];
+        block_return_node(block, retired[idx].offset, retired[idx].order);
+        block->allocation_count--;
+        block->used -= node_size_of(retired[idx].order);
+
+        // Defragmentation drained the block, give its memory back
+        if (block->allocation_count == 0) {
+            u32 heap = allocator->properties.memoryTypes[block->memory_type].heapIndex;
+            VDEBUG("Defragmentation released device memory block %u (heap %u)", retired[idx].block, heap);
+            release_block(context, retired[idx].block);
+        }
+    }
+    darray_length_set(retired, kept);
+    platform_mutex_unlock(&allocator->mutex);
+}
+
+#if defined(VKR_ENABLE_CHECKS)
+static int compare_offsets(const void* a, const void* b) {
+    VkDeviceSize left = ((const VkDeviceSize*)a)[0];
+    VkDeviceSize right = ((const VkDeviceSize*)b)[0];
+    return left < right ? -1 : left > right ? 1 : 0;
+}
+
+// Checks the free lists of a block: nodes aligned and inside it, no overlaps, buddies merged and used bytes adding up
+static b8 validate_block(const vulkan_memory_block* block, u32 index) {
+    b8 valid = TRUE;
+    u64 node_count = 0;
+    for (u32 k = 0; k != block->order_count; ++k)
+        node_count += darray_length(block->free_nodes[k]);
+
+    // Pairs of offset and size, sorted by offset
+    VkDeviceSize* nodes = vallocate(sizeof(VkDeviceSize) * 2 * (node_count + 1), MEMORY_TAG_RENDERER);
+    u64 count = 0;
+    VkDeviceSize free_bytes = 0;
+    for (u32 k = 0; k != block->order_count; ++k) {
+        VkDeviceSize node_size = node_size_of((u8)k);
+        VkDeviceSize* free_nodes = block->free_nodes[k];
+        u64 length = darray_length(free_nodes);
+        for (u64 idx = 0; idx != length; ++idx) {
+            VkDeviceSize offset = free_nodes[idx];
+            if (offset % node_size != 0 || offset + node_size > block->size) {
+                VERROR("Block %u: free node at %llu of order %u is misaligned or outside the block", index, offset, k);
+                valid = FALSE;
+            }
+
+            // Two free buddies should have been merged into their parent
+            if (k + 1 < block->order_count) {
+                VkDeviceSize buddy = offset ^ node_size;
+                for (u64 other = 0; other != length; ++other) {
+                    if (free_nodes[other] == buddy && buddy > offset) {
+                        VERROR("Block %u: free buddies at %llu and %llu of order %u were not merged", index, offset, buddy, k);
+                        valid = FALSE;
+                    }
+                }
+            }
+
+            nodes[count * 2] = offset;
+            nodes[count * 2 + 1] = node_size;
+            ++count;
+            free_bytes += node_size;
+        }
+    }
+
+    qsort(nodes, count, sizeof(VkDeviceSize) * 2, compare_offsets);
+    for (u64 idx = 1; idx < count; ++idx) {
+        if (nodes[(idx - 1) * 2] + nodes[(idx - 1) * 2 + 1] > nodes[idx * 2]) {
+            VERROR("Block %u: free nodes at %llu and %llu overlap", index, nodes[(idx - 1) * 2], nodes[idx * 2]);
+            valid = FALSE;
+        }
+    }
+    vfree(nodes, sizeof(VkDeviceSize) * 2 * (node_count + 1), MEMORY_TAG_RENDERER);
+
+    if (free_bytes + block->used != block->size) {
+        VERROR("Block %u: %llu free and %llu used bytes do not add up to its %llu bytes", index, free_bytes, block->used, block->size);
+        valid = FALSE;
+    }
+    if ((block->allocation_count == 0) != (block->used == 0)) {
+        VERROR("Block %u: %u allocations use %llu bytes", index, block->allocation_count, block->used);
+        valid = FALSE;
+    }
+    return valid;
+}
+
+b8 vulkan_memory_validate(vulkan_context* context) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    platform_mutex_lock(&allocator->mutex);
+
+    // Rebuild the heap stats from the blocks. Retired nodes count as allocations of their block but not of their heap
+    vulkan_memory_heap_stats heaps[VK_MAX_MEMORY_HEAPS];
+    vzero_memory(heaps, sizeof(heaps));
+    b8 valid = TRUE;
+    u32 live_blocks = 0;
+    u32 block_count = (u32)darray_length(allocator->blocks);
+    for (u32 idx = 0; idx != block_count; ++idx) {
+        const vulkan_memory_block* block = &allocator->blocks[idx];
+        if (!block->memory)
+            continue;
+
+        u32 heap = allocator->properties.memoryTypes[block->memory_type].heapIndex;
+        heaps[heap].block_count++;
+        heaps[heap].block_bytes += block->size;
+        heaps[heap].allocation_count += block->allocation_count;
+        heaps[heap].used_bytes += block->used;
+        ++live_blocks;
+        if (!validate_block(block, idx))
+            valid = FALSE;
+    }
+
+    u32 retired_count = (u32)darray_length(allocator->retired);
+    for (u32 idx = 0; idx != retired_count; ++idx) {
+        const vulkan_memory_retired* retired = &allocator->retired[idx];
+        const vulkan_memory_block* block = &allocator->blocks[retired->block];
+        if (!block->memory) {
+            VERROR("Retired node at %llu belongs to released block %u", retired->offset, retired->block);
+            valid = FALSE;
+            continue;
+        }
+        u32 heap = allocator->properties.memoryTypes[block->memory_type].heapIndex;
+        heaps[heap].allocation_count--;
+        heaps[heap].used_bytes -= node_size_of(retired->order);
+    }
+
+    u32 dedicated_count = 0;
+    for (u32 heap = 0; heap != allocator->properties.memoryHeapCount; ++heap) {
+        const vulkan_memory_heap_stats* stats = &allocator->heaps[heap];
+        dedicated_count += stats->dedicated_count;
+        if (heaps[heap].block_count != stats->block_count || heaps[heap].block_bytes != stats->block_bytes ||
+            heaps[heap].allocation_count != stats->allocation_count || heaps[heap].used_bytes != stats->used_bytes) {
+            VERROR("Heap %u: stats of %u blocks (%llu bytes), %u allocations using %llu bytes do not match "
+                "the blocks: %u blocks (%llu bytes), %u allocations using %llu bytes", heap,
+                stats->block_count, stats->block_bytes, stats->allocation_count, stats->used_bytes,
+                heaps[heap].block_count, heaps[heap].block_bytes, heaps[heap].allocation_count, heaps[heap].used_bytes);
+            valid = FALSE;
+        }
+        if (stats->requested_bytes > stats->used_bytes) {
+            VERROR("Heap %u: %llu bytes requested but only %llu used", heap, stats->requested_bytes, stats->used_bytes);
+            valid = FALSE;
+        }
+    }
+
+    if (allocator->device_memory_count != live_blocks + dedicated_count) {
+        VERROR("%u device memory objects counted, but there are %u blocks and %u dedicated allocations",
+            allocator->device_memory_count, live_blocks, dedicated_count);
+        valid = FALSE;
+    }
+
+    platform_mutex_unlock(&allocator->mutex);
+    return valid;
+}
+#endif
+
+void vulkan_memory_get_heap_stats(vulkan_context* context, u32 heap, vulkan_memory_heap_stats* out_stats) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    platform_mutex_lock(&allocator->mutex);
+    *out_stats = allocator->heaps[heap];
+    platform_mutex_unlock(&allocator->mutex);
+}
+
+static f32 to_unit(VkDeviceSize bytes, const char** out_unit) {
+    const u64 gib = 1024 * 1024 * 1024;
+    const u64 mib = 1024 * 1024;
+    const u64 kib = 1024;
+
+    if (bytes >= gib) {
+        *out_unit = "GiB";
+        return bytes / (f32)gib;
+    }
+    if (bytes >= mib) {
+        *out_unit = "MiB";
+        return bytes / (f32)mib;
+    }
+    if (bytes >= kib) {
+        *out_unit = "KiB";
+        return bytes / (f32)kib;
+    }
+
+    *out_unit = "B";
+    return (f32)bytes;
+}
+
+i32 vulkan_memory_usage_str(vulkan_context* context, char* buffer, u64 size) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    platform_mutex_lock(&allocator->mutex);
+
+    i32 offset = snprintf(buffer, size, "GPU memory use (%u of %u device memory objects):\n",
+        allocator->device_memory_count, context->device.properties.limits.maxMemoryAllocationCount);
+
+    for (u32 idx = 0; idx != allocator->properties.memoryHeapCount && offset >= 0 && (u64)offset < size; ++idx) {
+        const vulkan_memory_heap_stats* stats = &allocator->heaps[idx];
+        const char* block_unit;
+        const char* used_unit;
+        const char* requested_unit;
+        const char* dedicated_unit;
+        f32 block_amount = to_unit(stats->block_bytes, &block_unit);
+        f32 used_amount = to_unit(stats->used_bytes, &used_unit);
+        f32 requested_amount = to_unit(stats->requested_bytes, &requested_unit);
+        f32 dedicated_amount = to_unit(stats->dedicated_bytes, &dedicated_unit);
+
+        offset += snprintf(buffer + offset, size - offset,
+            " Heap %u (%s): %u blocks %.2f%s, %.2f%s used by %u allocations (%.2f%s requested), %u dedicated %.2f%s\n",
+            idx,
+            (allocator->properties.memoryHeaps[idx].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? "device local" : "host",
+            stats->block_count, block_amount, block_unit,
+            used_amount, used_unit, stats->allocation_count,
+            requested_amount, requested_unit,
+            stats->dedicated_count, dedicated_amount, dedicated_unit);
+    }
+
+    platform_mutex_unlock(&allocator->mutex);
+    return offset;
+}
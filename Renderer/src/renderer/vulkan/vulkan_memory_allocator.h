@@ -0,0 +1,166 @@
+#pragma once
+#include "vulkan_types.inl"
+
+/*
+* Creates the device memory allocator of the context. Must be called once
+* the logical device exists and before any resource is created.
+*
+* @param context - The vulkan context
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_memory_allocator_create(vulkan_context* context);
+
+/*
+* Releases all blocks. Allocations that are still alive are reported.
+*
+* @param context - The vulkan context
+*/
+void vulkan_memory_allocator_destroy(vulkan_context* context);
+
+/*
+* Allocates memory for a resource. Requests larger than half a block or with
+* VULKAN_MEMORY_FLAG_DEDICATED get their own VkDeviceMemory. When the heap of
+* the best memory type is full the next type of the usage is tried.
+*
+* @param context - The vulkan context
+* @param requirements - The memory requirements of the resource
+* @param usage - What the memory is used for, selects the memory types tried
+* @param flags - Combination of vulkan_memory_flag
+* @param out_allocation - The allocation
+* @return b8 - TRUE if successful, FALSE if no memory type fits or all of them are out of memory
+*/
+b8 vulkan_memory_allocate(
+    vulkan_context* context,
+    const VkMemoryRequirements* requirements,
+    vulkan_memory_usage usage,
+    u32 flags,
+    vulkan_allocation* out_allocation);
+
+/*
+* Allocates memory for an image and binds it. Images the driver prefers
+* to have dedicated memory for get it.
+*
+* @param context - The vulkan context
+* @param image - The image, not yet bound to memory
+* @param usage - What the memory is used for, selects the memory types tried
+* @param flags - Combination of vulkan_memory_flag
+* @param out_allocation - The allocation
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_memory_allocate_image(
+    vulkan_context* context,
+    VkImage image,
+    vulkan_memory_usage usage,
+    u32 flags,
+    vulkan_allocation* out_allocation);
+
+/*
+* Allocates memory for a buffer and binds it. Buffers the driver prefers
+* to have dedicated memory for get it.
+*
+* @param context - The vulkan context
+* @param buffer - The buffer, not yet bound to memory
+* @param usage - What the memory is used for, selects the memory types tried
+* @param flags - Combination of vulkan_memory_flag
+* @param out_allocation - The allocation
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_memory_allocate_buffer(
+    vulkan_context* context,
+    VkBuffer buffer,
+    vulkan_memory_usage usage,
+    u32 flags,
+    vulkan_allocation* out_allocation);
+
+/*
+* Looks up the best memory type of a usage the resource can live in.
+* Uses the table built on creation, the driver is not queried.
+*
+* @param context - The vulkan context
+* @param type_filter - memoryTypeBits of the resource
+* @param usage - What the memory is used for
+* @return i32 - The memory type index, -1 if none fits
+*/
+i32 vulkan_memory_find_type(vulkan_context* context, u32 type_filter, vulkan_memory_usage usage);
+
+/*
+* Looks up the best memory type for flags no usage covers. Ranks the
+* cached memory types on every call, prefer vulkan_memory_find_type.
+*
+* @param context - The vulkan context
+* @param type_filter - memoryTypeBits of the resource
+* @param query - Required, preferred and avoided property flags
+* @return i32 - The memory type index, -1 if none fits
+*/
+i32 vulkan_memory_find_type_query(vulkan_context* context, u32 type_filter, const vulkan_memory_type_query* query);
+
+/*
+* Frees an allocation. The resource bound to it must not be in use by the GPU anymore.
+*
+* @param context - The vulkan context
+* @param allocation - The allocation, zeroed afterwards
+*/
+void vulkan_memory_free(vulkan_context* context, vulkan_allocation* allocation);
+
+/*
+* Lets defragmentation move an allocation. Dedicated allocations are never moved.
+*
+* @param context - The vulkan context
+* @param allocation - The allocation
+* @param move - Called when the allocation is moved
+* @param user_data - Passed to move
+*/
+void vulkan_memory_set_movable(
+    vulkan_context* context,
+    const vulkan_allocation* allocation,
+    pfn_vulkan_memory_move move,
+    void* user_data);
+
+/*
+* Moves movable allocations out of the least used blocks into free space of
+* other blocks of the same memory type. The memory moved out of is freed by
+* vulkan_memory_release_retired once the frame being recorded completes, blocks
+* that become empty are released then. The move callbacks must not call into the allocator.
+*
+* @param context - The vulkan context
+* @param max_moves - Upper bound of allocations moved by this call
+* @return u32 - Amount of allocations moved
+*/
+u32 vulkan_memory_defragment(vulkan_context* context, u32 max_moves);
+
+/*
+* Frees the memory defragmentation moved allocations out of once the frames
+* that may still read it completed. Called at the start of each frame.
+*
+* @param context - The vulkan context
+*/
+void vulkan_memory_release_retired(vulkan_context* context);
+
+#if defined(VKR_ENABLE_CHECKS)
+/*
+* Checks the bookkeeping of the allocator: the free nodes of every block are
+* aligned, disjoint and merged with their free buddies, and the heap stats match
+* the blocks. Walks every free list, meant for checks rather than every frame.
+*
+* @param context - The vulkan context
+* @return b8 - TRUE if consistent, FALSE otherwise. Every inconsistency is logged
+*/
+b8 vulkan_memory_validate(vulkan_context* context);
+#endif
+
+/*
+* @param context - The vulkan context
+* @param heap - Index of the memory heap
+* @param out_stats - The usage of the heap
+*/
+void vulkan_memory_get_heap_stats(vulkan_context* context, u32 heap, vulkan_memory_heap_stats* out_stats);
+
+/*
+* Formats the usage of every memory heap, one line per heap.
+*
+* @param context - The vulkan context
+* @param buffer - The buffer that will hold the text
+* @param size - The size of the buffer in bytes
+* @return i32 - The amount of characters written
+*/
+i32 vulkan_memory_usage_str(vulkan_context* context, char* buffer, u64 size);
@@ -0,0 +1,399 @@
+#include "vulkan_memory_check.h"
+
+// Only built into renderers configured for testing
+#if defined(VKR_ENABLE_CHECKS)
+#include "vulkan_memory_allocator.h"
+#include "vulkan_buffer.h"
+#include "vulkan_timeline.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+#include "containers/darray.h"
+
+// Allocations of mixed sizes and alignments in the split and merge pattern
+#define MEMORY_CHECK_PATTERN_COUNT 60
+// Quarter block allocations made at most to find two blocks filled by them alone
+#define MEMORY_CHECK_QUARTER_COUNT 32
+// Frames to wait for the frame the defragmentation retired memory in
+#define MEMORY_CHECK_MAX_WAIT_FRAMES 16
+
+typedef struct memory_check_state {
+    u32 step;
+    u32 memory_type;
+    u32 heap;
+    VkDeviceSize block_size;
+    // Stats of the heap before the check, every pattern has to leave it like this
+    vulkan_memory_heap_stats baseline;
+
+    // Defragmentation pattern: three quarters kept in a fuller block and the
+    // quarter moved out of the block that is drained
+    vulkan_allocation kept[3];
+    vulkan_allocation moved;
+    u32 move_count;
+    u32 drained_block;
+    u64 retired_frame;
+} memory_check_state;
+
+static memory_check_state state;
+
+static VkDeviceSize node_size_of(const vulkan_allocation* allocation) {
+    return VULKAN_MEMORY_MIN_NODE_SIZE << allocation->order;
+}
+
+// Size of the node a request is rounded up to, like the allocator does
+static VkDeviceSize node_size_for(const VkMemoryRequirements* requirements) {
+    VkDeviceSize size = requirements->size > requirements->alignment ? requirements->size : requirements->alignment;
+    VkDeviceSize node_size = VULKAN_MEMORY_MIN_NODE_SIZE;
+    while (node_size < size)
+        node_size <<= 1;
+    return node_size;
+}
+
+static VkMemoryRequirements test_requirements(VkDeviceSize size, VkDeviceSize alignment) {
+    VkMemoryRequirements requirements;
+    requirements.size = size;
+    requirements.alignment = alignment;
+    requirements.memoryTypeBits = 1u << state.memory_type;
+    return requirements;
+}
+
+static b8 overlaps(const vulkan_allocation* a, const vulkan_allocation* b) {
+    if (a->memory != b->memory)
+        return FALSE;
+    VkDeviceSize a_size = a->block == INVALID_ID ? a->size : node_size_of(a);
+    VkDeviceSize b_size = b->block == INVALID_ID ? b->size : node_size_of(b);
+    return a->offset < b->offset + b_size && b->offset < a->offset + a_size;
+}
+
+static b8 check_placement(const vulkan_allocation* allocation, const VkMemoryRequirements* requirements, const char* pattern) {
+    b8 dedicated = node_size_for(requirements) > state.block_size / 2;
+    if (dedicated != (allocation->block == INVALID_ID)) {
+        VERROR("%s: %llu bytes aligned to %llu should %sbe dedicated", pattern,
+            requirements->size, requirements->alignment, dedicated ? "" : "not ");
+        return FALSE;
+    }
+    if (allocation->offset % requirements->alignment != 0 || (!dedicated && node_size_of(allocation) < requirements->size)) {
+        VERROR("%s: %llu bytes aligned to %llu were placed at %llu in a node of %llu bytes", pattern,
+            requirements->size, requirements->alignment, allocation->offset, dedicated ? allocation->size : node_size_of(allocation));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static b8 check_stats_restored(vulkan_context* context, const char* pattern) {
+    vulkan_memory_heap_stats stats;
+    vulkan_memory_get_heap_stats(context, state.heap, &stats);
+    const vulkan_memory_heap_stats* baseline = &state.baseline;
+    if (stats.allocation_count != baseline->allocation_count || stats.used_bytes != baseline->used_bytes ||
+        stats.requested_bytes != baseline->requested_bytes || stats.dedicated_count != baseline->dedicated_count ||
+        stats.dedicated_bytes != baseline->dedicated_bytes) {
+        VERROR("%s: heap %u holds %u allocations using %llu bytes (%llu requested) and %u dedicated of %llu bytes "
+            "after freeing everything, before it held %u using %llu (%llu) and %u of %llu", pattern, state.heap,
+            stats.allocation_count, stats.used_bytes, stats.requested_bytes, stats.dedicated_count, stats.dedicated_bytes,
+            baseline->allocation_count, baseline->used_bytes, baseline->requested_bytes, baseline->dedicated_count, baseline->dedicated_bytes);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Sizes and alignments around the node sizes, freed in two interleaved halves so buddies merge in any order
+static b8 check_split_merge(vulkan_context* context) {
+    static const VkDeviceSize sizes[] = { 1, 255, 256, 257, 1000, 4096, 5000, 65536, 100000, 1024 * 1024 };
+    static const VkDeviceSize alignments[] = { 1, 16, 256, 4096, 65536, 1024 * 1024 };
+    const u32 size_count = sizeof(sizes) / sizeof(sizes[0]);
+    const u32 alignment_count = sizeof(alignments) / sizeof(alignments[0]);
+
+    vulkan_allocation allocations[MEMORY_CHECK_PATTERN_COUNT];
+    b8 success = TRUE;
+    u32 count = 0;
+    for (; count != MEMORY_CHECK_PATTERN_COUNT && success; ++count) {
+        VkMemoryRequirements requirements = test_requirements(sizes[count % size_count], alignments[(count / size_count) % alignment_count]);
+        if (!vulkan_memory_allocate(context, &requirements, VULKAN_MEMORY_USAGE_GPU_ONLY, 0, &allocations[count])) {
+            VERROR("split and merge: allocation %u of %llu bytes failed", count, requirements.size);
+            success = FALSE;
+            break;
+        }
+
+        success = check_placement(&allocations[count], &requirements, "split and merge");
+        for (u32 other = 0; other != count && success; ++other) {
+            if (overlaps(&allocations[other], &allocations[count])) {
+                VERROR("split and merge: allocations %u and %u overlap at %llu and %llu", other, count,
+                    allocations[other].offset, allocations[count].offset);
+                success = FALSE;
+            }
+        }
+    }
+
+    success = vulkan_memory_validate(context) && success;
+    for (u32 idx = 1; idx < count; idx += 2)
+        vulkan_memory_free(context, &allocations[idx]);
+    success = vulkan_memory_validate(context) && success;
+    for (u32 idx = 0; idx < count; idx += 2)
+        vulkan_memory_free(context, &allocations[idx]);
+    success = vulkan_memory_validate(context) && success;
+
+    return check_stats_restored(context, "split and merge") && success;
+}
+
+// Linear and optimal resources only share blocks when bufferImageGranularity allows it
+static b8 check_granularity(vulkan_context* context) {
+    VkMemoryRequirements requirements = test_requirements(4096, 256);
+    vulkan_allocation linear;
+    vulkan_allocation optimal;
+    if (!vulkan_memory_allocate(context, &requirements, VULKAN_MEMORY_USAGE_GPU_ONLY, 0, &linear))
+        return FALSE;
+    if (!vulkan_memory_allocate(context, &requirements, VULKAN_MEMORY_USAGE_GPU_ONLY, VULKAN_MEMORY_FLAG_OPTIMAL, &optimal)) {
+        vulkan_memory_free(context, &linear);
+        return FALSE;
+    }
+
+    const vulkan_memory_allocator* allocator = &context->memory_allocator;
+    b8 success = !overlaps(&linear, &optimal);
+    if (!allocator->share_blocks &&
+        (linear.block == optimal.block || allocator->blocks[linear.block].optimal || !allocator->blocks[optimal.block].optimal)) {
+        VERROR("granularity: a linear allocation in block %u and an optimal one in block %u share memory, bufferImageGranularity is %llu",
+            linear.block, optimal.block, context->device.properties.limits.bufferImageGranularity);
+        success = FALSE;
+    }
+
+    success = vulkan_memory_validate(context) && success;
+    vulkan_memory_free(context, &optimal);
+    vulkan_memory_free(context, &linear);
+    return check_stats_restored(context, "granularity") && success;
+}
+
+// Flagged and oversized requests get their own device memory
+static b8 check_dedicated(vulkan_context* context) {
+    u32 device_memory_count = context->memory_allocator.device_memory_count;
+    VkMemoryRequirements flagged_requirements = test_requirements(4096, 256);
+    VkMemoryRequirements oversized_requirements = test_requirements(state.block_size / 2 + 1, 256);
+    vulkan_allocation flagged;
+    vulkan_allocation oversized;
+    if (!vulkan_memory_allocate(context, &flagged_requirements, VULKAN_MEMORY_USAGE_GPU_ONLY, VULKAN_MEMORY_FLAG_DEDICATED, &flagged))
+        return FALSE;
+    if (!vulkan_memory_allocate(context, &oversized_requirements, VULKAN_MEMORY_USAGE_GPU_ONLY, 0, &oversized)) {
+        vulkan_memory_free(context, &flagged);
+        return FALSE;
+    }
+
+    vulkan_memory_heap_stats stats;
+    vulkan_memory_get_heap_stats(context, state.heap, &stats);
+    b8 success = check_placement(&oversized, &oversized_requirements, "dedicated");
+    if (flagged.block != INVALID_ID || flagged.offset != 0) {
+        VERROR("dedicated: a flagged allocation was placed at %llu in block %u", flagged.offset, flagged.block);
+        success = FALSE;
+    }
+    if (context->memory_allocator.device_memory_count != device_memory_count + 2 ||
+        stats.dedicated_count != state.baseline.dedicated_count + 2 ||
+        stats.dedicated_bytes != state.baseline.dedicated_bytes + flagged_requirements.size + oversized_requirements.size) {
+        VERROR("dedicated: two dedicated allocations are counted as %u device memory objects more and %u dedicated allocations of %llu bytes",
+            context->memory_allocator.device_memory_count - device_memory_count, stats.dedicated_count, stats.dedicated_bytes);
+        success = FALSE;
+    }
+
+    success = vulkan_memory_validate(context) && success;
+    vulkan_memory_free(context, &oversized);
+    vulkan_memory_free(context, &flagged);
+    if (context->memory_allocator.device_memory_count != device_memory_count) {
+        VERROR("dedicated: freeing left %u device memory objects, before there were %u",
+            context->memory_allocator.device_memory_count, device_memory_count);
+        success = FALSE;
+    }
+    return check_stats_restored(context, "dedicated") && success;
+}
+
+// Mapped memory reads back what was written, buffers are bound through the driver's requirements
+static b8 check_mapped_and_buffers(vulkan_context* context) {
+    VkMemoryRequirements requirements = test_requirements(64 * 1024, 256);
+    requirements.memoryTypeBits = 0xFFFFFFFF;
+    vulkan_allocation mapped;
+    if (!vulkan_memory_allocate(context, &requirements, VULKAN_MEMORY_USAGE_STAGING, VULKAN_MEMORY_FLAG_MAPPED, &mapped))
+        return FALSE;
+
+    b8 success = TRUE;
+    u8* bytes = mapped.mapped;
+    if (!bytes) {
+        VERROR("mapped: the allocation has no host pointer");
+        success = FALSE;
+    }
+    else {
+        for (u32 idx = 0; idx != requirements.size; ++idx)
+            bytes[idx] = (u8)(idx * 31);
+        for (u32 idx = 0; idx != requirements.size && success; ++idx) {
+            if (bytes[idx] != (u8)(idx * 31)) {
+                VERROR("mapped: byte %u reads back as %u", idx, bytes[idx]);
+                success = FALSE;
+            }
+        }
+    }
+    vulkan_memory_free(context, &mapped);
+
+    vulkan_buffer buffer;
+    if (!vulkan_buffer_create(context, 64 * 1024, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VULKAN_MEMORY_USAGE_GPU_ONLY, &buffer)) {
+        VERROR("buffers: a device local buffer could not be created");
+        return FALSE;
+    }
+    success = vulkan_memory_validate(context) && success;
+    vulkan_buffer_destroy(context, &buffer);
+
+    return check_stats_restored(context, "buffers") && success;
+}
+
+static b8 move_allocation(void* user_data, const vulkan_allocation* from, const vulkan_allocation* to) {
+    // Test allocations hold no resource, moving one only updates its owner
+    vulkan_allocation* allocation = (vulkan_allocation*)user_data;
+    if (allocation->memory != from->memory || allocation->offset != from->offset) {
+        VERROR("defragmentation: asked to move an allocation from %llu, it lives at %llu", from->offset, allocation->offset);
+        return FALSE;
+    }
+
+    *allocation = *to;
+    state.move_count++;
+    return TRUE;
+}
+
+static void free_defragmentation_allocations(vulkan_context* context) {
+    for (u32 idx = 0; idx != 3; ++idx)
+        vulkan_memory_free(context, &state.kept[idx]);
+    vulkan_memory_free(context, &state.moved);
+}
+
+// Fills two blocks with quarter block allocations, leaves one of them a single quarter and defragments it away
+static b8 start_defragmentation(vulkan_context* context) {
+    VkMemoryRequirements requirements = test_requirements(state.block_size / 4, 256);
+    vulkan_allocation quarters[MEMORY_CHECK_QUARTER_COUNT];
+    u32 full_blocks[2];
+    u32 full_count = 0;
+    u32 count = 0;
+    b8 success = TRUE;
+
+    // Blocks other resources use partly take some quarters too, only blocks holding four test quarters count
+    while (count != MEMORY_CHECK_QUARTER_COUNT && full_count != 2) {
+        if (!vulkan_memory_allocate(context, &requirements, VULKAN_MEMORY_USAGE_GPU_ONLY, 0, &quarters[count])) {
+            VERROR("defragmentation: quarter block allocation %u failed", count);
+            success = FALSE;
+            break;
+        }
+
+        u32 block = quarters[count++].block;
+        u32 in_block = 0;
+        for (u32 idx = 0; idx != count; ++idx)
+            in_block += quarters[idx].block == block;
+        if (block != INVALID_ID && in_block == 4)
+            full_blocks[full_count++] = block;
+    }
+
+    if (success && full_count != 2) {
+        VERROR("defragmentation: %u quarter block allocations did not fill two blocks", count);
+        success = FALSE;
+    }
+
+    // Three quarters stay in the first block, one in the second
+    u32 kept_count = 0;
+    b8 moved_kept = FALSE;
+    for (u32 idx = 0; idx != count; ++idx) {
+        if (success && quarters[idx].block == full_blocks[0] && kept_count != 3)
+            state.kept[kept_count++] = quarters[idx];
+        else if (success && quarters[idx].block == full_blocks[1] && !moved_kept) {
+            state.moved = quarters[idx];
+            moved_kept = TRUE;
+        }
+        else
+            vulkan_memory_free(context, &quarters[idx]);
+    }
+    if (!success)
+        return FALSE;
+
+    state.drained_block = full_blocks[1];
+    state.move_count = 0;
+    vulkan_memory_set_movable(context, &state.moved, move_allocation, &state.moved);
+    u32 moves = vulkan_memory_defragment(context, 16);
+
+    const vulkan_memory_allocator* allocator = &context->memory_allocator;
+    if (moves != 1 || state.move_count != 1 || state.moved.block == state.drained_block) {
+        VERROR("defragmentation: %u moves reported, %u made, the quarter lives in block %u, the drained block is %u",
+            moves, state.move_count, state.moved.block, state.drained_block);
+        success = FALSE;
+    }
+    else if (allocator->blocks[state.drained_block].allocation_count != 1) {
+        VERROR("defragmentation: the drained block holds %u allocations, only the retired quarter should be left",
+            allocator->blocks[state.drained_block].allocation_count);
+        success = FALSE;
+    }
+
+    success = vulkan_memory_validate(context) && success;
+    if (!success) {
+        free_defragmentation_allocations(context);
+        return FALSE;
+    }
+
+    // The node moved out of may be read by the frame recorded next
+    state.retired_frame = context->frame_number;
+    return TRUE;
+}
+
+// Once the frame completed, the retired quarter is freed and the drained block released
+static renderer_check_status finish_defragmentation(vulkan_context* context) {
+    if (!vulkan_frame_is_complete(context, state.retired_frame)) {
+        if (state.step <= MEMORY_CHECK_MAX_WAIT_FRAMES)
+            return RENDERER_CHECK_RUNNING;
+
+        VERROR("defragmentation: frame %llu did not complete within %u frames", state.retired_frame, MEMORY_CHECK_MAX_WAIT_FRAMES);
+        free_defragmentation_allocations(context);
+        return RENDERER_CHECK_FAILED;
+    }
+
+    // Runs at the start of every frame too, this step may come first
+    vulkan_memory_release_retired(context);
+
+    b8 success = TRUE;
+    const vulkan_memory_allocator* allocator = &context->memory_allocator;
+    if (allocator->blocks[state.drained_block].memory) {
+        VERROR("defragmentation: block %u still holds %u allocations after frame %llu completed",
+            state.drained_block, allocator->blocks[state.drained_block].allocation_count, state.retired_frame);
+        success = FALSE;
+    }
+
+    success = vulkan_memory_validate(context) && success;
+    free_defragmentation_allocations(context);
+    success = vulkan_memory_validate(context) && success;
+    success = check_stats_restored(context, "defragmentation") && success;
+    return success ? RENDERER_CHECK_PASSED : RENDERER_CHECK_FAILED;
+}
+
+renderer_check_status vulkan_memory_check_step(vulkan_context* context) {
+    if (state.step != 0) {
+        state.step++;
+        renderer_check_status status = finish_defragmentation(context);
+        if (status != RENDERER_CHECK_RUNNING)
+            state.step = 0;
+        return status;
+    }
+
+    vzero_memory(&state, sizeof(memory_check_state));
+    i32 memory_type = vulkan_memory_find_type(context, 0xFFFFFFFF, VULKAN_MEMORY_USAGE_GPU_ONLY);
+    if (memory_type < 0) {
+        VERROR("No memory type for device local resources");
+        return RENDERER_CHECK_FAILED;
+    }
+
+    const vulkan_memory_allocator* allocator = &context->memory_allocator;
+    state.memory_type = (u32)memory_type;
+    state.heap = allocator->properties.memoryTypes[memory_type].heapIndex;
+    state.block_size = allocator->block_size[state.heap];
+    vulkan_memory_get_heap_stats(context, state.heap, &state.baseline);
+    VINFO("Checking the device memory allocator on memory type %u: heap %u, blocks of %llu bytes, %s",
+        state.memory_type, state.heap, state.block_size, allocator->share_blocks ? "shared blocks" : "separate linear and optimal blocks");
+
+    b8 success = vulkan_memory_validate(context);
+    success = success && check_split_merge(context);
+    success = success && check_granularity(context);
+    success = success && check_dedicated(context);
+    success = success && check_mapped_and_buffers(context);
+    success = success && start_defragmentation(context);
+    if (!success)
+        return RENDERER_CHECK_FAILED;
+
+    state.step = 1;
+    return RENDERER_CHECK_RUNNING;
+}
+#endif
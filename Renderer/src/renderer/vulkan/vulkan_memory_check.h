@@ -0,0 +1,18 @@
+#pragma once
+#include "vulkan_types.inl"
+
+#if defined(VKR_ENABLE_CHECKS)
+
+/*
+* Runs the next step of the self check of the device memory allocator. The first
+* step allocates and frees test allocations of many sizes and alignments, linear and
+* optimal ones, dedicated, mapped and buffer backed ones, then defragments a block
+* and checks the bookkeeping after each of them. The following steps wait for the
+* frame the defragmentation retired memory in, check that the drained block is
+* released and free the rest. Call once per frame outside of frame recording.
+*
+* @param context - The vulkan context
+* @return renderer_check_status - RUNNING until the last step, then PASSED or FAILED
+*/
+renderer_check_status vulkan_memory_check_step(vulkan_context* context);
+#endif
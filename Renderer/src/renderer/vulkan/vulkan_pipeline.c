@@ -0,0 +1,172 @@
+#include "vulkan_pipeline.h"
+#include "vulkan_command_buffer.h"
+#include "vulkan_utils.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+
+static b8 create_shader_module(vulkan_context* context, u64 code_size, const u32* code, VkShaderModule* out_module) {
+    VkShaderModuleCreateInfo module_info = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+    module_info.codeSize = code_size;
+    module_info.pCode = code;
+
+    VkResult res = vkCreateShaderModule(context->device.logical_device, &module_info, context->allocator, out_module);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkCreateShaderModule failed with result: %s", vulkan_result_string(res, TRUE));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+b8 vulkan_graphics_pipeline_create(
+    vulkan_context* context,
+    vulkan_renderpass* renderpass,
+    u64 vertex_code_size,
+    const u32* vertex_code,
+    u64 fragment_code_size,
+    const u32* fragment_code,
+    vulkan_pipeline* out_pipeline) {
+    vzero_memory(out_pipeline, sizeof(vulkan_pipeline));
+
+    VkShaderModule vertex_module = 0;
+    VkShaderModule fragment_module = 0;
+    if (!create_shader_module(context, vertex_code_size, vertex_code, &vertex_module))
+        return FALSE;
+    if (!create_shader_module(context, fragment_code_size, fragment_code, &fragment_module)) {
+        vkDestroyShaderModule(context->device.logical_device, vertex_module, context->allocator);
+        return FALSE;
+    }
+
+    VkPipelineShaderStageCreateInfo stages[2] = { 0 };
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = vertex_module;
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = fragment_module;
+    stages[1].pName = "main";
+
+    // Position at the start of each vertex, the stride is set when the vertex buffer is bound
+    VkVertexInputBindingDescription binding = { 0 };
+    binding.binding = 0;
+    binding.stride = sizeof(f32) * 3;
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    VkVertexInputAttributeDescription position = { 0 };
+    position.location = 0;
+    position.binding = 0;
+    position.format = VK_FORMAT_R32G32B32_SFLOAT;
+    position.offset = 0;
+
+    VkPipelineVertexInputStateCreateInfo vertex_input = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+    vertex_input.vertexBindingDescriptionCount = 1;
+    vertex_input.pVertexBindingDescriptions = &binding;
+    vertex_input.vertexAttributeDescriptionCount = 1;
+    vertex_input.pVertexAttributeDescriptions = &position;
+
+    VkPipelineInputAssemblyStateCreateInfo input_assembly = { VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+    input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    input_assembly.primitiveRestartEnable = VK_FALSE;
+
+    // Viewport and scissor are dynamic, only their count is fixed
+    VkPipelineViewportStateCreateInfo viewport_state = { VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+    viewport_state.viewportCount = 1;
+    viewport_state.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer = { VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.cullMode = VK_CULL_MODE_NONE;
+    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterizer.depthBiasEnable = VK_FALSE;
+    rasterizer.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisampling = { VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.minSampleShading = 1.0f;
+
+    VkPipelineDepthStencilStateCreateInfo depth_stencil = { VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
+    depth_stencil.depthTestEnable = VK_TRUE;
+    depth_stencil.depthWriteEnable = VK_TRUE;
+    depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS;
+    depth_stencil.depthBoundsTestEnable = VK_FALSE;
+    depth_stencil.stencilTestEnable = VK_FALSE;
+
+    VkPipelineColorBlendAttachmentState color_blend_attachment = { 0 };
+    color_blend_attachment.blendEnable = VK_FALSE;
+    color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                            VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    VkPipelineColorBlendStateCreateInfo color_blend = { VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+    color_blend.logicOpEnable = VK_FALSE;
+    color_blend.attachmentCount = 1;
+    color_blend.pAttachments = &color_blend_attachment;
+
+    VkDynamicState dynamic_states[3] = {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR,
+        VK_DYNAMIC_STATE_VERTEX_INPUT_BINDING_STRIDE
+    };
+    VkPipelineDynamicStateCreateInfo dynamic_state = { VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+    dynamic_state.dynamicStateCount = 3;
+    dynamic_state.pDynamicStates = dynamic_states;
+
+    // TODO: descriptor set layouts and push constants once materials exist
+    VkPipelineLayoutCreateInfo layout_info = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    VkResult res = vkCreatePipelineLayout(context->device.logical_device, &layout_info, context->allocator, &out_pipeline->layout);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkCreatePipelineLayout failed with result: %s", vulkan_result_string(res, TRUE));
+        vkDestroyShaderModule(context->device.logical_device, fragment_module, context->allocator);
+        vkDestroyShaderModule(context->device.logical_device, vertex_module, context->allocator);
+        return FALSE;
+    }
+
+    VkGraphicsPipelineCreateInfo pipeline_info = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+    pipeline_info.stageCount = 2;
+    pipeline_info.pStages = stages;
+    pipeline_info.pVertexInputState = &vertex_input;
+    pipeline_info.pInputAssemblyState = &input_assembly;
+    pipeline_info.pViewportState = &viewport_state;
+    pipeline_info.pRasterizationState = &rasterizer;
+    pipeline_info.pMultisampleState = &multisampling;
+    pipeline_info.pDepthStencilState = &depth_stencil;
+    pipeline_info.pColorBlendState = &color_blend;
+    pipeline_info.pDynamicState = &dynamic_state;
+    pipeline_info.layout = out_pipeline->layout;
+    pipeline_info.renderPass = renderpass->handle;
+    pipeline_info.subpass = 0;
+    pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
+    pipeline_info.basePipelineIndex = -1;
+
+    res = vkCreateGraphicsPipelines(context->device.logical_device, VK_NULL_HANDLE, 1, &pipeline_info, context->allocator, &out_pipeline->handle);
+
+    // The modules are only needed while the pipeline is created
+    vkDestroyShaderModule(context->device.logical_device, fragment_module, context->allocator);
+    vkDestroyShaderModule(context->device.logical_device, vertex_module, context->allocator);
+
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkCreateGraphicsPipelines failed with result: %s", vulkan_result_string(res, TRUE));
+        out_pipeline->handle = 0;
+        vulkan_pipeline_destroy(context, out_pipeline);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void vulkan_pipeline_destroy(vulkan_context* context, vulkan_pipeline* pipeline) {
+    if (pipeline->handle) {
+        vkDestroyPipeline(context->device.logical_device, pipeline->handle, context->allocator);
+        pipeline->handle = 0;
+    }
+
+    if (pipeline->layout) {
+        vkDestroyPipelineLayout(context->device.logical_device, pipeline->layout, context->allocator);
+        pipeline->layout = 0;
+    }
+}
+
+void vulkan_pipeline_bind(vulkan_command_buffer* command_buffer, VkPipelineBindPoint bind_point, vulkan_pipeline* pipeline) {
+    vulkan_command_buffer_bind_pipeline(command_buffer, bind_point, pipeline->handle);
+}
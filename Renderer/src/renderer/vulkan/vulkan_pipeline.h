@@ -0,0 +1,29 @@
+#pragma once
+#include "vulkan_types.inl"
+
+/*
+* Creates a graphics pipeline drawing triangle lists of vertices that start with a vec3 position.
+* Viewport, scissor and vertex stride are dynamic, so the pipeline survives swapchain resizes
+* and draws geometry of any vertex size.
+*
+* @param context - The vulkan context
+* @param renderpass - Renderpass the pipeline draws in, subpass 0
+* @param vertex_code_size - Size of the vertex shader SPIR-V in bytes
+* @param vertex_code - The vertex shader SPIR-V
+* @param fragment_code_size - Size of the fragment shader SPIR-V in bytes
+* @param fragment_code - The fragment shader SPIR-V
+* @param out_pipeline - The created pipeline
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_graphics_pipeline_create(
+    vulkan_context* context,
+    vulkan_renderpass* renderpass,
+    u64 vertex_code_size,
+    const u32* vertex_code,
+    u64 fragment_code_size,
+    const u32* fragment_code,
+    vulkan_pipeline* out_pipeline);
+
+void vulkan_pipeline_destroy(vulkan_context* context, vulkan_pipeline* pipeline);
+
+void vulkan_pipeline_bind(vulkan_command_buffer* command_buffer, VkPipelineBindPoint bind_point, vulkan_pipeline* pipeline);
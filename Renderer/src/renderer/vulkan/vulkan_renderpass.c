@@ -117,7 +117,8 @@ void vulkan_renderpass_destroy(
 void vulkan_renderpass_begin(
     vulkan_command_buffer* command_buffer,
     vulkan_renderpass* renderpass,
-    VkFramebuffer frame_buffer) {
+    VkFramebuffer frame_buffer,
+    VkSubpassContents contents) {
 
     VkRenderPassBeginInfo begin_info = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
     begin_info.pNext = 0;
@@ -146,8 +147,9 @@ void vulkan_renderpass_begin(
     begin_info.clearValueCount = 2;
     begin_info.pClearValues = clear_values;
 
-    vkCmdBeginRenderPass(command_buffer->handle, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(command_buffer->handle, &begin_info, contents);
     command_buffer->state = COMMAND_BUFFER_STATE_IN_RENDER_PASS;
+    ++command_buffer->counters.render_passes;
 }
 
 void vulkan_renderpass_end(
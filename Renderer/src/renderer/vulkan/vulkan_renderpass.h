@@ -16,7 +16,8 @@ void vulkan_renderpass_destroy(
 void vulkan_renderpass_begin(
     vulkan_command_buffer* command_buffer,
     vulkan_renderpass* renderpass,
-    VkFramebuffer frame_buffer);
+    VkFramebuffer frame_buffer,
+    VkSubpassContents contents);
 
 void vulkan_renderpass_end(
     vulkan_command_buffer* command_buffer,
@@ -0,0 +1,272 @@
+#include "vulkan_staging.h"
+#include "vulkan_buffer.h"
+#include "vulkan_command_buffer.h"
+#include "vulkan_timeline.h"
+#include "vulkan_utils.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+
+// Largest texel of the formats copied from the ring. Image copies need offsets aligned to the texel size
+#define VULKAN_STAGING_TEXEL_ALIGNMENT 16
+
+// Records the gathered buffer copies
+static void record_pending(vulkan_staging_ring* ring) {
+    if (ring->pending_count == 0)
+        return;
+
+    vulkan_command_buffer* command_buffer = &ring->command_buffers[ring->recording_frame];
+    vkCmdCopyBuffer(command_buffer->handle, ring->buffer.handle, ring->pending_destination, ring->pending_count, ring->pending_regions);
+    ring->pending_count = 0;
+    ring->pending_destination = 0;
+}
+
+// Starts the transfer command buffer of the current frame unless it already records
+static vulkan_command_buffer* begin_recording(vulkan_context* context, vulkan_staging_ring* ring) {
+    if (ring->recording_frame != INVALID_ID)
+        return &ring->command_buffers[ring->recording_frame];
+
+    // Uploads can come in before begin_frame waited for the frame, the command buffer must not be in use
+    u32 frame = context->current_frame;
+    vulkan_frame_wait(context, context->frame_slot_numbers[frame]);
+    vulkan_staging_ring_reclaim(ring, frame);
+
+    vulkan_command_buffer* command_buffer = &ring->command_buffers[frame];
+    vulkan_command_buffer_reset(command_buffer);
+    vulkan_command_buffer_begin_recording(command_buffer, TRUE, FALSE, FALSE);
+    ring->recording_frame = frame;
+    return command_buffer;
+}
+
+static vulkan_command_buffer* end_recording(vulkan_staging_ring* ring) {
+    record_pending(ring);
+    vulkan_command_buffer* command_buffer = &ring->command_buffers[ring->recording_frame];
+
+    // Everything reading geometry, uniforms or textures later on the queue sees the uploads
+    VkMemoryBarrier barrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+        VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer->handle,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0, 1, &barrier, 0, 0, 0, 0);
+    ++command_buffer->counters.barriers;
+
+    vulkan_command_buffer_end_recording(command_buffer);
+    ring->recording_frame = INVALID_ID;
+    return command_buffer;
+}
+
+// Takes space at the head, waits for the queue when the ring is full
+static u64 take_space(vulkan_context* context, vulkan_staging_ring* ring, u64 size) {
+    u64 ring_size = ring->buffer.total_size;
+    for (;;) {
+        u64 position = (ring->head + ring->alignment - 1) / ring->alignment * ring->alignment;
+        u64 offset = position % ring_size;
+
+        // Ranges never wrap around the end of the buffer
+        if (offset + size > ring_size) {
+            position += ring_size - offset;
+            offset = 0;
+        }
+
+        if (position + size - ring->tail <= ring_size) {
+            ring->head = position + size;
+            return offset;
+        }
+
+        ++ring->stall_count;
+        VWARN("Staging ring full, waiting for the queue to upload %llu bytes", size);
+        vulkan_staging_ring_flush(context, ring);
+    }
+}
+
+b8 vulkan_staging_ring_create(
+    vulkan_context* context,
+    u64 frame_size,
+    u32 frame_count,
+    VkCommandPool pool,
+    VkQueue queue,
+    vulkan_staging_ring* out_ring) {
+    vzero_memory(out_ring, sizeof(vulkan_staging_ring));
+
+    // Copies are fastest from offsets aligned to optimalBufferCopyOffsetAlignment, a per device limit
+    u64 alignment = context->device.properties.limits.optimalBufferCopyOffsetAlignment;
+    if (alignment < VULKAN_STAGING_TEXEL_ALIGNMENT)
+        alignment = VULKAN_STAGING_TEXEL_ALIGNMENT;
+
+    // A multiple of the alignment keeps aligned positions aligned within the buffer
+    frame_size = (frame_size + alignment - 1) / alignment * alignment;
+    if (!vulkan_buffer_create(context, frame_size * frame_count, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VULKAN_MEMORY_USAGE_STAGING, &out_ring->buffer)) {
+        VERROR("Failed to create the buffer of the staging ring");
+        return FALSE;
+    }
+
+    out_ring->alignment = alignment;
+    out_ring->frame_count = frame_count;
+    out_ring->pool = pool;
+    out_ring->queue = queue;
+    out_ring->recording_frame = INVALID_ID;
+    out_ring->frame_heads = vallocate(sizeof(u64) * frame_count, MEMORY_TAG_RENDERER);
+    out_ring->command_buffers = vallocate(sizeof(vulkan_command_buffer) * frame_count, MEMORY_TAG_RENDERER);
+    for (u32 idx = 0; idx != frame_count; ++idx)
+        vulkan_command_buffer_allocate(context, pool, TRUE, &out_ring->command_buffers[idx]);
+
+    return TRUE;
+}
+
+void vulkan_staging_ring_destroy(vulkan_context* context, vulkan_staging_ring* ring) {
+    if (ring->command_buffers) {
+        for (u32 idx = 0; idx != ring->frame_count; ++idx) {
+            if (ring->command_buffers[idx].handle)
+                vulkan_command_buffer_free(context, ring->pool, &ring->command_buffers[idx]);
+        }
+        vfree(ring->command_buffers, sizeof(vulkan_command_buffer) * ring->frame_count, MEMORY_TAG_RENDERER);
+    }
+
+    if (ring->frame_heads)
+        vfree(ring->frame_heads, sizeof(u64) * ring->frame_count, MEMORY_TAG_RENDERER);
+
+    VINFO("Staging ring: %llu uploads, %.2fMiB, %u stalls",
+        ring->upload_count, ring->upload_bytes / 1024.f / 1024.f, ring->stall_count);
+    vulkan_buffer_destroy(context, &ring->buffer);
+    vzero_memory(ring, sizeof(vulkan_staging_ring));
+}
+
+void vulkan_staging_ring_reclaim(vulkan_staging_ring* ring, u32 frame) {
+    // Frames complete in submission order, so the tail only moves forward
+    if (ring->frame_heads[frame] > ring->tail)
+        ring->tail = ring->frame_heads[frame];
+}
+
+void vulkan_staging_upload_buffer(
+    vulkan_context* context,
+    vulkan_staging_ring* ring,
+    vulkan_buffer* dest,
+    u64 offset,
+    u64 size,
+    const void* data) {
+    const u8* source = data;
+    ++ring->upload_count;
+    ring->upload_bytes += size;
+
+    while (size != 0) {
+        u64 chunk = size < ring->buffer.total_size ? size : ring->buffer.total_size;
+        begin_recording(context, ring);
+        u64 ring_offset = take_space(context, ring, chunk);
+        // Taking space may have submitted the command buffer
+        begin_recording(context, ring);
+        vcopy_memory((u8*)ring->buffer.memory.mapped + ring_offset, (void*)source, chunk);
+
+        if (ring->pending_destination != dest->handle || ring->pending_count == VULKAN_STAGING_REGIONS_PER_COPY)
+            record_pending(ring);
+
+        VkBufferCopy* region = &ring->pending_regions[ring->pending_count++];
+        region->srcOffset = ring_offset;
+        region->dstOffset = offset;
+        region->size = chunk;
+        ring->pending_destination = dest->handle;
+
+        offset += chunk;
+        source += chunk;
+        size -= chunk;
+    }
+}
+
+b8 vulkan_staging_upload_image(
+    vulkan_context* context,
+    vulkan_staging_ring* ring,
+    vulkan_image* image,
+    u64 size,
+    const void* data) {
+    if (size > ring->buffer.total_size) {
+        VERROR("Image data of %llu bytes does not fit into the staging ring of %llu bytes", size, ring->buffer.total_size);
+        return FALSE;
+    }
+
+    ++ring->upload_count;
+    ring->upload_bytes += size;
+
+    begin_recording(context, ring);
+    u64 ring_offset = take_space(context, ring, size);
+    vulkan_command_buffer* command_buffer = begin_recording(context, ring);
+    vcopy_memory((u8*)ring->buffer.memory.mapped + ring_offset, (void*)data, size);
+    record_pending(ring);
+
+    VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image->handle;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vulkan_command_buffer_pipeline_barrier(command_buffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 1, &barrier);
+
+    VkBufferImageCopy region;
+    vzero_memory(&region, sizeof(VkBufferImageCopy));
+    region.bufferOffset = ring_offset;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent.width = image->width;
+    region.imageExtent.height = image->height;
+    region.imageExtent.depth = 1;
+    vkCmdCopyBufferToImage(command_buffer->handle, ring->buffer.handle, image->handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vulkan_command_buffer_pipeline_barrier(command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, 1, &barrier);
+    return TRUE;
+}
+
+vulkan_command_buffer* vulkan_staging_ring_end_frame(vulkan_context* context, vulkan_staging_ring* ring) {
+    if (ring->recording_frame == INVALID_ID)
+        return 0;
+
+    // The frame index was reset by a swapchain recreation, the slot of the command buffer is not this frame's
+    if (ring->recording_frame != context->current_frame) {
+        vulkan_staging_ring_flush(context, ring);
+        return 0;
+    }
+
+    ring->frame_heads[ring->recording_frame] = ring->head;
+    return end_recording(ring);
+}
+
+void vulkan_staging_ring_flush(vulkan_context* context, vulkan_staging_ring* ring) {
+    if (ring->recording_frame != INVALID_ID) {
+        vulkan_command_buffer* command_buffer = end_recording(ring);
+
+        VkSubmitInfo submit_info = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &command_buffer->handle;
+        VkResult res = vkQueueSubmit(ring->queue, 1, &submit_info, 0);
+        if (!vulkan_result_is_success(res)) {
+            VERROR("vkQueueSubmit of the staging uploads failed with result: %s", vulkan_result_string(res, TRUE));
+        }
+        vulkan_command_buffer_update_submit(command_buffer);
+    }
+
+    VkResult res = vkQueueWaitIdle(ring->queue);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkQueueWaitIdle failed with result: %s", vulkan_result_string(res, TRUE));
+    }
+
+    // Every frame using the ring has completed, start over at the beginning
+    ring->head = 0;
+    ring->tail = 0;
+    for (u32 idx = 0; idx != ring->frame_count; ++idx)
+        ring->frame_heads[idx] = 0;
+}
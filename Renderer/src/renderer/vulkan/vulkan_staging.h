@@ -0,0 +1,87 @@
+#pragma once
+#include "vulkan_types.inl"
+
+/*
+* Creates the staging ring.
+*
+* @param context - The vulkan context
+* @param frame_size - Bytes the ring holds per frame in flight
+* @param frame_count - Amount of frames in flight
+* @param pool - Command pool of the transfer command buffers
+* @param queue - Queue the frames are submitted to, used when the ring is full
+* @param out_ring - The created ring
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_staging_ring_create(
+    vulkan_context* context,
+    u64 frame_size,
+    u32 frame_count,
+    VkCommandPool pool,
+    VkQueue queue,
+    vulkan_staging_ring* out_ring);
+
+void vulkan_staging_ring_destroy(vulkan_context* context, vulkan_staging_ring* ring);
+
+/*
+* Returns the space of a frame to the ring. Call once the frame that last used the slot has completed.
+*
+* @param ring - The ring
+* @param frame - Index of the frame in flight
+*/
+void vulkan_staging_ring_reclaim(vulkan_staging_ring* ring, u32 frame);
+
+/*
+* Uploads data into a buffer. The data is copied into the ring before returning,
+* the copy on the GPU runs before the commands of the current frame.
+*
+* @param context - The vulkan context
+* @param ring - The ring
+* @param dest - The buffer the data is for
+* @param offset - Offset in the destination buffer
+* @param size - Amount of bytes, uploads larger than the ring are split up
+* @param data - The data
+*/
+void vulkan_staging_upload_buffer(
+    vulkan_context* context,
+    vulkan_staging_ring* ring,
+    vulkan_buffer* dest,
+    u64 offset,
+    u64 size,
+    const void* data);
+
+/*
+* Uploads the first mip level of a 2D color image. The image ends up in
+* VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+*
+* @param context - The vulkan context
+* @param ring - The ring
+* @param image - The image, its previous contents are discarded
+* @param size - Size of the pixel data in bytes
+* @param data - Tightly packed pixel data of the whole image
+* @return b8 - TRUE if successful, FALSE if the data does not fit into the ring
+*/
+b8 vulkan_staging_upload_image(
+    vulkan_context* context,
+    vulkan_staging_ring* ring,
+    vulkan_image* image,
+    u64 size,
+    const void* data);
+
+/*
+* Ends the transfer command buffer of the current frame.
+*
+* @param context - The vulkan context
+* @param ring - The ring
+* @return vulkan_command_buffer* - The command buffer to submit ahead of the frame
+* in the same submission, 0 if nothing was uploaded
+*/
+vulkan_command_buffer* vulkan_staging_ring_end_frame(vulkan_context* context, vulkan_staging_ring* ring);
+
+/*
+* Submits the recorded uploads right away and waits for them. Needed before
+* a destination of pending uploads is destroyed, e.g. when a buffer is resized.
+*
+* @param context - The vulkan context
+* @param ring - The ring
+*/
+void vulkan_staging_ring_flush(vulkan_context* context, vulkan_staging_ring* ring);
@@ -219,7 +219,7 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* ou
         context->device.depth_format,
         VK_IMAGE_TILING_OPTIMAL,
         VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        VULKAN_MEMORY_USAGE_GPU_ONLY,
         TRUE,
         VK_IMAGE_ASPECT_DEPTH_BIT,
         &out_swapchain->depth_attachment);
@@ -0,0 +1,76 @@
+#include "vulkan_timeline.h"
+#include "vulkan_utils.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+
+b8 vulkan_timeline_create(vulkan_context* context, vulkan_timeline* out_timeline) {
+    vzero_memory(out_timeline, sizeof(vulkan_timeline));
+
+    VkSemaphoreTypeCreateInfo type_info = { VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type_info.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphore_info = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+    semaphore_info.pNext = &type_info;
+    VkResult res = vkCreateSemaphore(context->device.logical_device, &semaphore_info, context->allocator, &out_timeline->handle);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkCreateSemaphore of a timeline failed with result: %s", vulkan_result_string(res, TRUE));
+        out_timeline->handle = 0;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void vulkan_timeline_destroy(vulkan_context* context, vulkan_timeline* timeline) {
+    if (timeline->handle)
+        vkDestroySemaphore(context->device.logical_device, timeline->handle, context->allocator);
+
+    vzero_memory(timeline, sizeof(vulkan_timeline));
+}
+
+b8 vulkan_timeline_is_complete(vulkan_context* context, vulkan_timeline* timeline, u64 value) {
+    if (value <= timeline->completed_value)
+        return TRUE;
+
+    u64 current = 0;
+    VkResult res = vkGetSemaphoreCounterValue(context->device.logical_device, timeline->handle, &current);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkGetSemaphoreCounterValue failed with result: %s", vulkan_result_string(res, TRUE));
+        return FALSE;
+    }
+
+    if (current > timeline->completed_value)
+        timeline->completed_value = current;
+    return value <= timeline->completed_value;
+}
+
+b8 vulkan_timeline_wait(vulkan_context* context, vulkan_timeline* timeline, u64 value, u64 timeout_ns) {
+    if (value <= timeline->completed_value)
+        return TRUE;
+
+    VkSemaphoreWaitInfo wait_info = { VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
+    wait_info.semaphoreCount = 1;
+    wait_info.pSemaphores = &timeline->handle;
+    wait_info.pValues = &value;
+    VkResult res = vkWaitSemaphores(context->device.logical_device, &wait_info, timeout_ns);
+    if (res == VK_TIMEOUT) {
+        VWARN("vulkan_timeline_wait - Timed out waiting for %llu", value);
+        return FALSE;
+    }
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkWaitSemaphores failed with result: %s", vulkan_result_string(res, TRUE));
+        return FALSE;
+    }
+
+    timeline->completed_value = value;
+    return TRUE;
+}
+
+b8 vulkan_frame_is_complete(vulkan_context* context, u64 frame_number) {
+    return vulkan_timeline_is_complete(context, &context->frame_timeline, frame_number);
+}
+
+b8 vulkan_frame_wait(vulkan_context* context, u64 frame_number) {
+    return vulkan_timeline_wait(context, &context->frame_timeline, frame_number, UINT64_MAX);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "vulkan_types.inl"
+
+/*
+* Creates a timeline semaphore starting at 0. Needs the timelineSemaphore feature (Vulkan 1.2).
+*
+* @param context - The vulkan context
+* @param out_timeline - The timeline that will be created
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_timeline_create(vulkan_context* context, vulkan_timeline* out_timeline);
+
+/*
+* Destroys the semaphore. No pending submission may signal it.
+*
+* @param context - The vulkan context
+* @param timeline - The timeline to destroy
+*/
+void vulkan_timeline_destroy(vulkan_context* context, vulkan_timeline* timeline);
+
+/*
+* Checks whether the GPU reached a value without waiting. Values already known
+* to be reached are answered without calling into the driver. Not thread safe.
+*
+* @param context - The vulkan context
+* @param timeline - The timeline
+* @param value - The value, 0 counts as reached
+* @return b8 - TRUE if the timeline reached the value
+*/
+b8 vulkan_timeline_is_complete(vulkan_context* context, vulkan_timeline* timeline, u64 value);
+
+/*
+* Waits until the GPU reached a value.
+*
+* @param context - The vulkan context
+* @param timeline - The timeline
+* @param value - The value, it has to be signaled by a submission made before
+* @param timeout_ns - Longest wait in nanoseconds, UINT64_MAX to wait for ever
+* @return b8 - TRUE if the value was reached, FALSE on timeout or error
+*/
+b8 vulkan_timeline_wait(vulkan_context* context, vulkan_timeline* timeline, u64 value, u64 timeout_ns);
+
+/*
+* Checks whether the GPU finished a frame. Any subsystem can tag its work
+* with context->frame_number while recording and free resources once the
+* frame is complete, without fences of its own.
+*
+* @param context - The vulkan context
+* @param frame_number - The frame, 0 counts as complete
+* @return b8 - TRUE if all work submitted with the frame completed
+*/
+b8 vulkan_frame_is_complete(vulkan_context* context, u64 frame_number);
+
+/*
+* Waits until the GPU finished a frame.
+*
+* @param context - The vulkan context
+* @param frame_number - The frame, it must have been submitted
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_frame_wait(vulkan_context* context, u64 frame_number);
@@ -0,0 +1,157 @@
+#include "vulkan_timeline_check.h"
+
+// Only built into renderers configured for testing
+#if defined(VKR_ENABLE_CHECKS)
+#include "vulkan_timeline.h"
+#include "vulkan_utils.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+
+// Frames the check steps through, many times the frames in flight so every slot is reused
+#define TIMELINE_CHECK_FRAMES 64
+
+typedef struct timeline_check_state {
+    b8 failed;
+    u32 step;
+    // Counter of the semaphore read by the previous step
+    u64 last_counter;
+    // Frame number seen by each step, checked for completion once its slot came around again
+    u64 tags[TIMELINE_CHECK_FRAMES];
+    u32 checked_tag_count;
+} timeline_check_state;
+
+static timeline_check_state state;
+
+static renderer_check_status fail() {
+    state.failed = TRUE;
+    return RENDERER_CHECK_FAILED;
+}
+
+// Reads the counter from the driver, bypassing the value the timeline cached
+static b8 read_counter(vulkan_context* context, u64* out_counter) {
+    VkResult res = vkGetSemaphoreCounterValue(context->device.logical_device, context->frame_timeline.handle, out_counter);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkGetSemaphoreCounterValue failed with result: %s", vulkan_result_string(res, TRUE));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// The counter moves forward only, up to the last submitted frame, and the cached value never passes it
+static b8 check_counter(vulkan_context* context, u64 counter) {
+    u64 submitted = context->frame_number - 1;
+    if (counter < state.last_counter) {
+        VERROR("Timeline counter went back from %llu to %llu", state.last_counter, counter);
+        return FALSE;
+    }
+    if (counter > submitted) {
+        VERROR("Timeline counter %llu is ahead of the last submitted frame %llu", counter, submitted);
+        return FALSE;
+    }
+    if (context->frame_timeline.completed_value > counter) {
+        VERROR("Cached completed value %llu is ahead of the timeline counter %llu", context->frame_timeline.completed_value, counter);
+        return FALSE;
+    }
+    state.last_counter = counter;
+    return TRUE;
+}
+
+// Each slot holds a different frame, the last submitted one among them, and no slot is ahead of it
+static b8 check_slots(vulkan_context* context) {
+    u64 submitted = context->frame_number - 1;
+    u8 slot_count = context->swapchain.max_frames_in_flight;
+    u64 newest = 0;
+    for (u8 idx = 0; idx != slot_count; ++idx) {
+        u64 number = context->frame_slot_numbers[idx];
+        if (number > submitted) {
+            VERROR("Slot %u holds frame %llu, the last submitted frame is %llu", idx, number, submitted);
+            return FALSE;
+        }
+        for (u8 other = 0; other != idx; ++other) {
+            if (number && number == context->frame_slot_numbers[other]) {
+                VERROR("Slots %u and %u both hold frame %llu", other, idx, number);
+                return FALSE;
+            }
+        }
+        if (number > newest)
+            newest = number;
+    }
+    if (newest != submitted) {
+        VERROR("The newest frame of the slots is %llu, the last submitted frame is %llu", newest, submitted);
+        return FALSE;
+    }
+
+    for (u32 idx = 0; idx != context->swapchain.image_count; ++idx) {
+        if (context->image_frame_numbers[idx] > submitted) {
+            VERROR("Swapchain image %u holds frame %llu, the last submitted frame is %llu", idx, context->image_frame_numbers[idx], submitted);
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+renderer_check_status vulkan_timeline_check_step(vulkan_context* context) {
+    if (state.failed)
+        return RENDERER_CHECK_FAILED;
+
+    u8 frames_in_flight = context->swapchain.max_frames_in_flight;
+    if (state.step == 0) {
+        VINFO("Checking the frame timeline over %u frames, %u frames in flight, %u swapchain images",
+            TIMELINE_CHECK_FRAMES, frames_in_flight, context->swapchain.image_count);
+    }
+
+    u64 counter = 0;
+    if (!read_counter(context, &counter) || !check_counter(context, counter) || !check_slots(context))
+        return fail();
+
+    // begin_frame of the last submitted frame waited for the frame that used its slot before
+    u64 submitted = context->frame_number - 1;
+    if (submitted > frames_in_flight && counter < submitted - frames_in_flight) {
+        VERROR("Timeline counter %llu, more than %u frames are outstanding after frame %llu", counter, frames_in_flight, submitted);
+        return fail();
+    }
+
+    // The frame about to be recorded was never signaled
+    if (vulkan_frame_is_complete(context, context->frame_number)) {
+        VERROR("Frame %llu counts as complete before it was submitted", context->frame_number);
+        return fail();
+    }
+
+    // A tagged frame is complete once the frame reusing its slot began
+    while (state.checked_tag_count != state.step && state.tags[state.checked_tag_count] + frames_in_flight < context->frame_number) {
+        u64 tag = state.tags[state.checked_tag_count++];
+        if (!vulkan_frame_is_complete(context, tag)) {
+            VERROR("Frame %llu is not complete %u frames later", tag, (u32)(context->frame_number - tag));
+            return fail();
+        }
+    }
+
+    if (state.step != TIMELINE_CHECK_FRAMES) {
+        // A skipped frame keeps its number, it is tagged once
+        if (state.step == 0 || state.tags[state.step - 1] != context->frame_number)
+            state.tags[state.step++] = context->frame_number;
+        return RENDERER_CHECK_RUNNING;
+    }
+    if (state.tags[TIMELINE_CHECK_FRAMES - 1] == context->frame_number)
+        return RENDERER_CHECK_RUNNING;
+
+    // Waiting for the last submitted frame completes it and everything before it
+    if (!vulkan_frame_wait(context, submitted) || !read_counter(context, &counter) || !check_counter(context, counter))
+        return fail();
+    if (counter != submitted) {
+        VERROR("Timeline counter is %llu after waiting for frame %llu", counter, submitted);
+        return fail();
+    }
+    while (state.checked_tag_count != state.step) {
+        u64 tag = state.tags[state.checked_tag_count++];
+        if (!vulkan_frame_is_complete(context, tag)) {
+            VERROR("Frame %llu is not complete after waiting for frame %llu", tag, submitted);
+            return fail();
+        }
+    }
+
+    VINFO("Timeline at %llu, frames %llu to %llu checked", counter, state.tags[0], state.tags[TIMELINE_CHECK_FRAMES - 1]);
+    vzero_memory(&state, sizeof(timeline_check_state));
+    return RENDERER_CHECK_PASSED;
+}
+#endif
@@ -0,0 +1,18 @@
+#pragma once
+#include "vulkan_types.inl"
+
+#if defined(VKR_ENABLE_CHECKS)
+/*
+* Runs the next step of the self check of the frame timeline. Every step reads the
+* counter of the timeline semaphore and checks it against the frames submitted so far:
+* it never moves back, never runs ahead of the last submitted frame and at most
+* max_frames_in_flight frames are outstanding. It also checks the frame number of
+* each slot and tags the frame about to be recorded, which has to be complete once
+* the slot came around again. The last step waits for the last submitted frame.
+* Call once per frame outside of frame recording.
+*
+* @param context - The vulkan context
+* @return renderer_check_status - RUNNING until the last step, then PASSED or FAILED
+*/
+renderer_check_status vulkan_timeline_check_step(vulkan_context* context);
+#endif
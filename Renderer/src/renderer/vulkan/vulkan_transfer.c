@@ -0,0 +1,378 @@
+#include "vulkan_transfer.h"
+#include "vulkan_buffer.h"
+#include "vulkan_command_buffer.h"
+#include "vulkan_timeline.h"
+#include "vulkan_utils.h"
+#include "core/logger.h"
+#include "core/vmemory.h"
+#include "containers/darray.h"
+
+// Stages and accesses of the graphics queue that read a buffer with these usage flags
+static void buffer_consumer(VkBufferUsageFlags usage, VkPipelineStageFlags* out_stages, VkAccessFlags* out_access) {
+    VkPipelineStageFlags stages = 0;
+    VkAccessFlags access = 0;
+    if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) {
+        stages |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        access |= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    }
+    if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) {
+        stages |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        access |= VK_ACCESS_INDEX_READ_BIT;
+    }
+    if (usage & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT) {
+        stages |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+        access |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    }
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+        stages |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        access |= VK_ACCESS_UNIFORM_READ_BIT;
+    }
+    if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+        stages |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        access |= VK_ACCESS_SHADER_READ_BIT;
+    }
+
+    // Only copied from later on
+    if (stages == 0) {
+        stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        access = VK_ACCESS_TRANSFER_READ_BIT;
+    }
+
+    *out_stages = stages;
+    *out_access = access;
+}
+
+// Moves the batches the timeline reached over to the pending acquires, in submission order
+static void retire(vulkan_context* context, vulkan_transfer* transfer) {
+    while (transfer->submitted_count != 0) {
+        vulkan_transfer_batch* batch = &transfer->batches[transfer->submitted[0]];
+        if (!vulkan_timeline_is_complete(context, &transfer->timeline, batch->serial))
+            break;
+
+        u32 staging_count = (u32)darray_length(batch->staging_buffers);
+        for (u32 idx = 0; idx != staging_count; ++idx)
+            vulkan_buffer_destroy(context, &batch->staging_buffers[idx]);
+        darray_clear(batch->staging_buffers);
+
+        u32 buffer_count = (u32)darray_length(batch->buffer_acquires);
+        for (u32 idx = 0; idx != buffer_count; ++idx)
+            darray_push(transfer->buffer_acquires, batch->buffer_acquires[idx]);
+        darray_clear(batch->buffer_acquires);
+
+        u32 image_count = (u32)darray_length(batch->image_acquires);
+        for (u32 idx = 0; idx != image_count; ++idx)
+            darray_push(transfer->image_acquires, batch->image_acquires[idx]);
+        darray_clear(batch->image_acquires);
+
+        transfer->acquire_stages |= batch->acquire_stages;
+        batch->acquire_stages = 0;
+        transfer->retired_serial = batch->serial;
+        batch->serial = 0;
+
+        --transfer->submitted_count;
+        for (u32 idx = 0; idx != transfer->submitted_count; ++idx)
+            transfer->submitted[idx] = transfer->submitted[idx + 1];
+    }
+}
+
+// Returns the batch taking uploads, starts one when none is recording
+static vulkan_transfer_batch* begin_batch(vulkan_context* context, vulkan_transfer* transfer) {
+    if (transfer->recording != INVALID_ID)
+        return &transfer->batches[transfer->recording];
+
+    retire(context, transfer);
+
+    u32 slot = INVALID_ID;
+    while (slot == INVALID_ID) {
+        for (u32 idx = 0; idx != VULKAN_TRANSFER_BATCH_COUNT; ++idx) {
+            if (transfer->batches[idx].serial == 0) {
+                slot = idx;
+                break;
+            }
+        }
+
+        // Nothing is recording, so every batch is in flight
+        if (slot == INVALID_ID) {
+            ++transfer->stall_count;
+            VWARN("Every transfer batch is in flight, waiting for the oldest one");
+            vulkan_timeline_wait(context, &transfer->timeline, transfer->batches[transfer->submitted[0]].serial, UINT64_MAX);
+            retire(context, transfer);
+        }
+    }
+
+    vulkan_transfer_batch* batch = &transfer->batches[slot];
+    batch->serial = transfer->next_serial++;
+    vulkan_command_buffer_reset(&batch->command_buffer);
+    vulkan_command_buffer_begin_recording(&batch->command_buffer, TRUE, FALSE, FALSE);
+    transfer->recording = slot;
+    return batch;
+}
+
+// Copies the data into a staging buffer of its own, freed with the batch
+static b8 create_staging(vulkan_context* context, u64 size, const void* data, vulkan_buffer* out_buffer) {
+    if (!vulkan_buffer_create(context, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VULKAN_MEMORY_USAGE_STAGING, out_buffer)) {
+        VERROR("Failed to create a staging buffer of %llu bytes", size);
+        return FALSE;
+    }
+
+    vulkan_buffer_load_data(context, out_buffer, 0, size, data);
+    return TRUE;
+}
+
+b8 vulkan_transfer_create(vulkan_context* context, vulkan_transfer* out_transfer) {
+    vzero_memory(out_transfer, sizeof(vulkan_transfer));
+    out_transfer->queue = context->device.transfer_queue;
+    out_transfer->pool = context->device.transfer_command_pool;
+    out_transfer->queue_family = context->device.transfer_queue_index;
+    out_transfer->graphics_family = context->device.graphics_queue_index;
+    out_transfer->recording = INVALID_ID;
+    out_transfer->next_serial = 1;
+    out_transfer->buffer_acquires = darray_create(VkBufferMemoryBarrier);
+    out_transfer->image_acquires = darray_create(VkImageMemoryBarrier);
+
+    // Batches signal their serial, the timeline reaching it completes the batch
+    if (!vulkan_timeline_create(context, &out_transfer->timeline)) {
+        VERROR("Failed to create the timeline of the transfer queue");
+        return FALSE;
+    }
+
+    for (u32 idx = 0; idx != VULKAN_TRANSFER_BATCH_COUNT; ++idx) {
+        vulkan_transfer_batch* batch = &out_transfer->batches[idx];
+        vulkan_command_buffer_allocate(context, out_transfer->pool, TRUE, &batch->command_buffer);
+        batch->staging_buffers = darray_create(vulkan_buffer);
+        batch->buffer_acquires = darray_create(VkBufferMemoryBarrier);
+        batch->image_acquires = darray_create(VkImageMemoryBarrier);
+    }
+
+    if (out_transfer->queue_family != out_transfer->graphics_family) {
+        VINFO("Uploads run on the transfer queue family %u", out_transfer->queue_family);
+    } else {
+        VINFO("No dedicated transfer queue family, uploads share the graphics queue");
+    }
+    return TRUE;
+}
+
+void vulkan_transfer_destroy(vulkan_context* context, vulkan_transfer* transfer) {
+    for (u32 idx = 0; idx != VULKAN_TRANSFER_BATCH_COUNT; ++idx) {
+        vulkan_transfer_batch* batch = &transfer->batches[idx];
+        if (batch->staging_buffers) {
+            u32 staging_count = (u32)darray_length(batch->staging_buffers);
+            for (u32 staging = 0; staging != staging_count; ++staging)
+                vulkan_buffer_destroy(context, &batch->staging_buffers[staging]);
+            darray_destroy(batch->staging_buffers);
+        }
+        if (batch->buffer_acquires) {
+            darray_destroy(batch->buffer_acquires);
+        }
+        if (batch->image_acquires) {
+            darray_destroy(batch->image_acquires);
+        }
+        if (batch->command_buffer.handle)
+            vulkan_command_buffer_free(context, transfer->pool, &batch->command_buffer);
+    }
+    vulkan_timeline_destroy(context, &transfer->timeline);
+
+    if (transfer->buffer_acquires) {
+        darray_destroy(transfer->buffer_acquires);
+    }
+    if (transfer->image_acquires) {
+        darray_destroy(transfer->image_acquires);
+    }
+
+    VINFO("Transfer queue: %llu uploads, %.2fMiB, %u stalls",
+        transfer->upload_count, transfer->upload_bytes / 1024.f / 1024.f, transfer->stall_count);
+    vzero_memory(transfer, sizeof(vulkan_transfer));
+}
+
+b8 vulkan_transfer_upload_buffer(
+    vulkan_context* context,
+    vulkan_transfer* transfer,
+    vulkan_buffer* dest,
+    u64 offset,
+    u64 size,
+    const void* data,
+    u64* out_serial) {
+    vulkan_buffer staging;
+    if (!create_staging(context, size, data, &staging))
+        return FALSE;
+
+    vulkan_transfer_batch* batch = begin_batch(context, transfer);
+    VkBufferCopy region;
+    region.srcOffset = 0;
+    region.dstOffset = offset;
+    region.size = size;
+    vkCmdCopyBuffer(batch->command_buffer.handle, staging.handle, dest->handle, 1, &region);
+    darray_push(batch->staging_buffers, staging);
+
+    VkPipelineStageFlags stages;
+    VkAccessFlags access;
+    buffer_consumer(dest->usage, &stages, &access);
+
+    VkBufferMemoryBarrier barrier = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.buffer = dest->handle;
+    barrier.offset = offset;
+    barrier.size = size;
+    if (transfer->queue_family == transfer->graphics_family) {
+        // Same queue, a plain barrier makes the copy visible to the readers
+        barrier.dstAccessMask = access;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        vulkan_command_buffer_pipeline_barrier(&batch->command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, stages, 1, &barrier, 0, 0);
+    } else {
+        // Release the range, the graphics queue acquires it with a matching barrier once the batch completed
+        barrier.dstAccessMask = 0;
+        barrier.srcQueueFamilyIndex = transfer->queue_family;
+        barrier.dstQueueFamilyIndex = transfer->graphics_family;
+        vulkan_command_buffer_pipeline_barrier(&batch->command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1, &barrier, 0, 0);
+
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = access;
+        darray_push(batch->buffer_acquires, barrier);
+        batch->acquire_stages |= stages;
+    }
+
+    ++transfer->upload_count;
+    transfer->upload_bytes += size;
+    *out_serial = batch->serial;
+    return TRUE;
+}
+
+b8 vulkan_transfer_upload_image(
+    vulkan_context* context,
+    vulkan_transfer* transfer,
+    vulkan_image* image,
+    u64 size,
+    const void* data,
+    u64* out_serial) {
+    vulkan_buffer staging;
+    if (!create_staging(context, size, data, &staging))
+        return FALSE;
+
+    vulkan_transfer_batch* batch = begin_batch(context, transfer);
+
+    VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image->handle;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    // Contents are discarded, the transfer queue takes the image over without an ownership transfer
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vulkan_command_buffer_pipeline_barrier(&batch->command_buffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 1, &barrier);
+
+    VkBufferImageCopy region;
+    vzero_memory(&region, sizeof(VkBufferImageCopy));
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent.width = image->width;
+    region.imageExtent.height = image->height;
+    region.imageExtent.depth = 1;
+    vkCmdCopyBufferToImage(batch->command_buffer.handle, staging.handle, image->handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    darray_push(batch->staging_buffers, staging);
+
+    // The layout transition is part of the release and of the acquire, both have to name it
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    if (transfer->queue_family == transfer->graphics_family) {
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vulkan_command_buffer_pipeline_barrier(&batch->command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, 1, &barrier);
+    } else {
+        barrier.dstAccessMask = 0;
+        barrier.srcQueueFamilyIndex = transfer->queue_family;
+        barrier.dstQueueFamilyIndex = transfer->graphics_family;
+        vulkan_command_buffer_pipeline_barrier(&batch->command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, 1, &barrier);
+
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        darray_push(batch->image_acquires, barrier);
+        batch->acquire_stages |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    }
+
+    ++transfer->upload_count;
+    transfer->upload_bytes += size;
+    *out_serial = batch->serial;
+    return TRUE;
+}
+
+void vulkan_transfer_submit(vulkan_context* context, vulkan_transfer* transfer) {
+    if (transfer->recording == INVALID_ID)
+        return;
+
+    vulkan_transfer_batch* batch = &transfer->batches[transfer->recording];
+    vulkan_command_buffer_end_recording(&batch->command_buffer);
+
+    VkTimelineSemaphoreSubmitInfo timeline_info = { VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+    timeline_info.signalSemaphoreValueCount = 1;
+    timeline_info.pSignalSemaphoreValues = &batch->serial;
+
+    VkSubmitInfo submit_info = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    submit_info.pNext = &timeline_info;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &batch->command_buffer.handle;
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = &transfer->timeline.handle;
+    VkResult res = vkQueueSubmit(transfer->queue, 1, &submit_info, 0);
+    if (!vulkan_result_is_success(res)) {
+        VERROR("vkQueueSubmit of the transfer batch failed with result: %s", vulkan_result_string(res, TRUE));
+    }
+    vulkan_command_buffer_update_submit(&batch->command_buffer);
+
+    transfer->submitted[transfer->submitted_count++] = transfer->recording;
+    transfer->recording = INVALID_ID;
+}
+
+void vulkan_transfer_acquire(vulkan_context* context, vulkan_transfer* transfer, vulkan_command_buffer* command_buffer) {
+    retire(context, transfer);
+
+    // Reading the timeline on the host orders the releases before this submission
+    u32 buffer_count = (u32)darray_length(transfer->buffer_acquires);
+    u32 image_count = (u32)darray_length(transfer->image_acquires);
+    if (buffer_count || image_count) {
+        vulkan_command_buffer_pipeline_barrier(command_buffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, transfer->acquire_stages,
+            buffer_count, transfer->buffer_acquires,
+            image_count, transfer->image_acquires);
+        darray_clear(transfer->buffer_acquires);
+        darray_clear(transfer->image_acquires);
+        transfer->acquire_stages = 0;
+    }
+
+    transfer->completed_serial = transfer->retired_serial;
+}
+
+void vulkan_transfer_flush(vulkan_context* context, vulkan_transfer* transfer) {
+    vulkan_transfer_submit(context, transfer);
+    if (transfer->submitted_count != 0) {
+        vulkan_timeline_wait(context, &transfer->timeline, transfer->batches[transfer->submitted[transfer->submitted_count - 1]].serial, UINT64_MAX);
+        retire(context, transfer);
+    }
+
+    if (darray_length(transfer->buffer_acquires) == 0 && darray_length(transfer->image_acquires) == 0) {
+        transfer->completed_serial = transfer->retired_serial;
+        return;
+    }
+
+    vulkan_command_buffer command_buffer;
+    vulkan_command_buffer_allocate_begin_single_use(context, context->device.graphics_command_pool, &command_buffer);
+    vulkan_transfer_acquire(context, transfer, &command_buffer);
+    vulkan_command_buffer_end_single_use(context, context->device.graphics_command_pool, &command_buffer, context->device.graphics_queue);
+}
+
+b8 vulkan_transfer_is_complete(const vulkan_transfer* transfer, u64 serial) {
+    return serial <= transfer->completed_serial;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "vulkan_types.inl"
+
+/*
+* Creates the upload path of the transfer queue.
+*
+* @param context - The vulkan context, the device must exist
+* @param out_transfer - The transfer that will be created
+* @return b8 - TRUE if successful, FALSE otherwise
+*/
+b8 vulkan_transfer_create(vulkan_context* context, vulkan_transfer* out_transfer);
+
+/*
+* Destroys the batches and their staging buffers. The device must be idle.
+*
+* @param context - The vulkan context
+* @param transfer - The transfer to destroy
+*/
+void vulkan_transfer_destroy(vulkan_context* context, vulkan_transfer* transfer);
+
+/*
+* Uploads data into a buffer on the transfer queue. The data is copied into
+* a staging buffer before returning. The range must not be used by the
+* graphics queue until vulkan_transfer_is_complete reports the serial.
+*
+* @param context - The vulkan context
+* @param transfer - The transfer
+* @param dest - The buffer the data is for, its usage flags select who acquires it
+* @param offset - Offset in the destination buffer
+* @param size - Amount of bytes
+* @param data - The data
+* @param out_serial - Serial of the batch the upload belongs to
+* @return b8 - TRUE if successful, FALSE if no staging buffer could be created
+*/
+b8 vulkan_transfer_upload_buffer(
+    vulkan_context* context,
+    vulkan_transfer* transfer,
+    vulkan_buffer* dest,
+    u64 offset,
+    u64 size,
+    const void* data,
+    u64* out_serial);
+
+/*
+* Uploads the first mip level of a 2D color image on the transfer queue. The
+* image ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, owned by the
+* graphics queue, once vulkan_transfer_is_complete reports the serial.
+*
+* @param context - The vulkan context
+* @param transfer - The transfer
+* @param image - The image, its previous contents are discarded
+* @param size - Size of the pixel data in bytes
+* @param data - Tightly packed pixel data of the whole image
+* @param out_serial - Serial of the batch the upload belongs to
+* @return b8 - TRUE if successful, FALSE if no staging buffer could be created
+*/
+b8 vulkan_transfer_upload_image(
+    vulkan_context* context,
+    vulkan_transfer* transfer,
+    vulkan_image* image,
+    u64 size,
+    const void* data,
+    u64* out_serial);
+
+/*
+* Submits the uploads recorded since the last call to the transfer queue.
+*
+* @param context - The vulkan context
+* @param transfer - The transfer
+*/
+void vulkan_transfer_submit(vulkan_context* context, vulkan_transfer* transfer);
+
+/*
+* Retires the batches the timeline reached, without waiting for the
+* others, and records the ownership acquires of their uploads. Call at the
+* start of every frame, before anything reads the uploaded resources.
+*
+* @param context - The vulkan context
+* @param transfer - The transfer
+* @param command_buffer - A graphics command buffer that is recording, outside of a render pass
+*/
+void vulkan_transfer_acquire(vulkan_context* context, vulkan_transfer* transfer, vulkan_command_buffer* command_buffer);
+
+/*
+* Submits and waits for every upload and acquires them on the graphics queue
+* right away. Needed before a destination of pending uploads is destroyed,
+* e.g. when a buffer is resized.
+*
+* @param context - The vulkan context
+* @param transfer - The transfer
+*/
+void vulkan_transfer_flush(vulkan_context* context, vulkan_transfer* transfer);
+
+/*
+* @param transfer - The transfer
+* @param serial - Serial of an upload, 0 counts as complete
+* @return b8 - TRUE if the graphics queue may use what the upload wrote
+*/
+b8 vulkan_transfer_is_complete(const vulkan_transfer* transfer, u64 serial);
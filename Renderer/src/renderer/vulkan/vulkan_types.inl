@@ -1,6 +1,9 @@
 #pragma once
 #include "defines.h"
 #include "core/vassert.h"
+#include "renderer/renderer_types.inl"
+#include "platform/platform_thread.h"
+#include "containers/freelist.h"
 #include <vulkan/vulkan.h>
 
 /*
@@ -40,19 +43,221 @@ typedef struct vulkan_device {
     u8 graphics_queue_index;
     u8 transfer_queue_index;
     u8 present_queue_index;
-    u8 compute_queue_index; // HACK: used for now
+    // Prefers a family without graphics so compute runs alongside rendering
+    u8 compute_queue_index;
 
     // Queue handles
     VkQueue graphics_queue;
     VkQueue transfer_queue;
     VkQueue present_queue;
-    // TODO: add the compute queue when needed
+    VkQueue compute_queue;
 
     VkCommandPool graphics_command_pool;
+    // Command buffers submitted to transfer_queue
+    VkCommandPool transfer_command_pool;
+    // Command buffers submitted to compute_queue
+    VkCommandPool compute_command_pool;
 
     vulkan_swapchain_support_info swapchain_support;
 } vulkan_device;
 
+// Size of the scratch arena of each job thread for command scope driver allocations
+#define VULKAN_HOST_SCRATCH_SIZE (64 * 1024)
+// Amount of VkSystemAllocationScope values
+#define VULKAN_HOST_SCOPE_COUNT 5
+
+/*
+* Bump allocator for allocations that only live during a single Vulkan command.
+* It rewinds once everything taken from it has been returned.
+*/
+typedef struct vulkan_host_scratch {
+    u8* memory;
+    u64 offset;
+    u32 live;
+} vulkan_host_scratch;
+
+// Host memory the driver holds for one VkSystemAllocationScope
+typedef struct vulkan_host_scope_stats {
+    volatile u64 allocation_count;
+    volatile u64 bytes;
+    // Reported by the driver, allocated without the callbacks
+    volatile u64 internal_bytes;
+} vulkan_host_scope_stats;
+
+/*
+* Routes the host allocations of the driver into the engine allocator,
+* tagged as MEMORY_TAG_VULKAN, so they show up in the memory stats and
+* can be bounded by a budget.
+*/
+typedef struct vulkan_host_allocator {
+    VkAllocationCallbacks callbacks;
+    // Allocations fail once the driver would hold more than this, 0 for no bound
+    u64 budget;
+    volatile u64 total_bytes;
+    volatile u64 peak_bytes;
+    vulkan_host_scope_stats scopes[VULKAN_HOST_SCOPE_COUNT];
+    // Memory the driver allocated itself and only reported (executable memory)
+    volatile u64 internal_bytes;
+    // Command scope allocations served by a scratch arena and those that did not fit
+    volatile u64 scratch_hits;
+    volatile u64 scratch_misses;
+    // One arena per job thread
+    u32 scratch_count;
+    vulkan_host_scratch* scratch;
+} vulkan_host_allocator;
+
+// Smallest sub-allocation, requests are rounded up to a power of two of at least this size
+#define VULKAN_MEMORY_MIN_NODE_SIZE 256ull
+// Orders of the buddy tree, a block holds at most MIN_NODE_SIZE << (ORDERS - 1) bytes
+#define VULKAN_MEMORY_MAX_ORDERS 32
+
+typedef enum vulkan_memory_flag {
+    // Give the resource its own VkDeviceMemory instead of a piece of a block
+    VULKAN_MEMORY_FLAG_DEDICATED = 0x1,
+    // Keep the memory mapped, the host pointer is stored in the allocation
+    VULKAN_MEMORY_FLAG_MAPPED = 0x2,
+    // The resource is an image with optimal tiling. Those never share a block with
+    // linear resources (buffers, linear images) unless bufferImageGranularity allows it
+    VULKAN_MEMORY_FLAG_OPTIMAL = 0x4
+} vulkan_memory_flag;
+
+// What the memory of a resource is used for, picks the memory types it may live in
+typedef enum vulkan_memory_usage {
+    // Only accessed by the GPU: attachments, textures, static geometry
+    VULKAN_MEMORY_USAGE_GPU_ONLY,
+    // Written once by the CPU and copied from by the GPU. Kept out of device local
+    // memory so uploads do not eat into the small host visible VRAM window
+    VULKAN_MEMORY_USAGE_STAGING,
+    // Written by the CPU every frame and read by the GPU: uniforms, transient geometry
+    VULKAN_MEMORY_USAGE_CPU_TO_GPU,
+    // Written by the GPU and read back by the CPU
+    VULKAN_MEMORY_USAGE_GPU_TO_CPU,
+    VULKAN_MEMORY_USAGE_COUNT
+} vulkan_memory_usage;
+
+/*
+* Selects memory types by their property flags. Types without all required
+* flags never match, neither do protected or lazily allocated types unless
+* those flags are required. The matching ones are ranked by the amount of
+* preferred flags they have, then by the fewest avoided flags, then by their
+* index since drivers list faster types first.
+*/
+typedef struct vulkan_memory_type_query {
+    VkMemoryPropertyFlags required;
+    VkMemoryPropertyFlags preferred;
+    VkMemoryPropertyFlags avoided;
+} vulkan_memory_type_query;
+
+// Memory types in the order they are tried, the next one is used when a heap is full
+typedef struct vulkan_memory_type_chain {
+    u32 count;
+    u8 types[VK_MAX_MEMORY_TYPES];
+} vulkan_memory_type_chain;
+
+/*
+* A piece of device memory handed out by the memory allocator.
+* Resources are bound to memory at offset.
+*/
+typedef struct vulkan_allocation {
+    VkDeviceMemory memory;
+    VkDeviceSize offset;
+    // Requested size, the memory reserved for it may be larger
+    VkDeviceSize size;
+    // Host pointer to offset if the allocation is mapped, 0 otherwise
+    void* mapped;
+    u32 memory_type;
+    // Block the allocation lives in, INVALID_ID for dedicated allocations
+    u32 block;
+    u8 order;
+} vulkan_allocation;
+
+/*
+* Called by defragmentation to move an allocation. The owner copies the contents
+* (or recreates them), binds its resource to the new memory and stores the new
+* allocation. When it returns TRUE the old memory stays valid until the frame
+* being recorded completes, so copies recorded into that frame may read it.
+*
+* @param user_data - The user data given when the allocation was marked movable
+* @param from - Where the allocation lives now
+* @param to - Where it is moved to
+* @return b8 - TRUE if moved, FALSE to keep it where it is
+*/
+typedef b8 (*pfn_vulkan_memory_move)(void* user_data, const vulkan_allocation* from, const vulkan_allocation* to);
+
+typedef struct vulkan_memory_movable {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    u8 order;
+    pfn_vulkan_memory_move move;
+    void* user_data;
+} vulkan_memory_movable;
+
+// A node defragmentation moved an allocation out of, the GPU may still read it
+typedef struct vulkan_memory_retired {
+    u32 block;
+    VkDeviceSize offset;
+    u8 order;
+    // Frame after whose completion the node is free
+    u64 frame_number;
+} vulkan_memory_retired;
+
+/*
+* A single VkDeviceMemory of one memory type that is split up with a
+* buddy allocator. Nodes of order k are MIN_NODE_SIZE << k bytes and
+* always aligned to their size.
+*/
+typedef struct vulkan_memory_block {
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    void* mapped;
+    u32 memory_type;
+    b8 optimal;
+    u32 order_count;
+    // Offsets of the free nodes of each order (darray)
+    VkDeviceSize* free_nodes[VULKAN_MEMORY_MAX_ORDERS];
+    // Allocations defragmentation may move (darray)
+    vulkan_memory_movable* movables;
+    u32 allocation_count;
+    VkDeviceSize used;
+} vulkan_memory_block;
+
+// Usage of a memory heap
+typedef struct vulkan_memory_heap_stats {
+    u32 block_count;
+    VkDeviceSize block_bytes;
+    // Bytes of the blocks handed out, rounded up to whole nodes
+    VkDeviceSize used_bytes;
+    // Bytes asked for, the difference to used_bytes is lost to rounding
+    VkDeviceSize requested_bytes;
+    u32 allocation_count;
+    u32 dedicated_count;
+    VkDeviceSize dedicated_bytes;
+} vulkan_memory_heap_stats;
+
+/*
+* Sub-allocates device memory from large blocks per memory type so the
+* amount of vkAllocateMemory calls stays far below maxMemoryAllocationCount.
+* Large resources and those the driver wants on their own get dedicated memory.
+*/
+typedef struct vulkan_memory_allocator {
+    // Copy of the memory properties of the device, the driver is never asked again
+    VkPhysicalDeviceMemoryProperties properties;
+    // Memory types for each vulkan_memory_usage, built once on creation
+    vulkan_memory_type_chain chains[VULKAN_MEMORY_USAGE_COUNT];
+    // Size of new blocks per heap
+    VkDeviceSize block_size[VK_MAX_MEMORY_HEAPS];
+    // Linear and optimal resources may share blocks
+    b8 share_blocks;
+    // Blocks, a released block leaves a slot with a 0 memory handle (darray)
+    vulkan_memory_block* blocks;
+    // Nodes waiting for their frame to complete, they count as allocations of their block (darray)
+    vulkan_memory_retired* retired;
+    // Live VkDeviceMemory objects, blocks and dedicated allocations
+    u32 device_memory_count;
+    vulkan_memory_heap_stats heaps[VK_MAX_MEMORY_HEAPS];
+    platform_mutex mutex;
+} vulkan_memory_allocator;
+
 /*
 * Representation of a Vulkan Image. At minimal
 * we need a handel to the image, a view to the image
@@ -61,12 +266,64 @@ typedef struct vulkan_device {
 */
 typedef struct vulkan_image {
     VkImage handle;
-    VkDeviceMemory memory;
+    vulkan_allocation memory;
     VkImageView view;
     u32 width;
     u32 height;
+    // Accessed by the graphics and the compute queue without ownership transfers
+    b8 is_concurrent;
 } vulkan_image;
 
+/*
+* A buffer and its memory. Host visible buffers stay mapped for their
+* whole lifetime. Ranges of the buffer can be handed out with the freelist
+* so many resources share one buffer and one binding.
+*/
+typedef struct vulkan_buffer {
+    VkBuffer handle;
+    u64 total_size;
+    VkBufferUsageFlags usage;
+    vulkan_memory_usage memory_usage;
+    vulkan_allocation memory;
+    // TRUE between map and unmap
+    b8 is_locked;
+    // Accessed by the graphics and the compute queue without ownership transfers
+    b8 is_concurrent;
+    freelist buffer_freelist;
+} vulkan_buffer;
+
+// Maximum amount of geometries the backend holds at a time
+#define VULKAN_MAX_GEOMETRY_COUNT 16384
+// Geometry with at least this many bytes of vertices and indices is uploaded on the transfer queue
+#define VULKAN_ASYNC_UPLOAD_THRESHOLD (256 * 1024)
+
+// Where a geometry lives in the shared vertex and index buffers
+typedef struct vulkan_geometry_data {
+    // INVALID_ID while the slot is free
+    u32 id;
+    u32 generation;
+    u32 vertex_count;
+    u32 vertex_element_size;
+    u64 vertex_buffer_offset;
+    u32 index_count;
+    u32 index_element_size;
+    u64 index_buffer_offset;
+    // Serial of the asynchronous upload of the contents, 0 when uploaded through the staging ring
+    u64 upload_serial;
+} vulkan_geometry_data;
+
+// Buffer ranges of a destroyed geometry, still in use by frames in flight
+typedef struct vulkan_geometry_release {
+    u64 vertex_buffer_offset;
+    u64 vertex_size;
+    u64 index_buffer_offset;
+    u64 index_size;
+    // The transfer queue may still write the ranges until this upload completes
+    u64 upload_serial;
+    // Frame that was being recorded when the geometry was destroyed, the last one that may draw it
+    u64 frame_number;
+} vulkan_geometry_release;
+
 
 
 // Renderpass states
@@ -97,6 +354,12 @@ typedef struct vulkan_renderpass {
     vulkan_renderpass_state state;
 } vulkan_renderpass;
 
+// A graphics pipeline and its layout
+typedef struct vulkan_pipeline {
+    VkPipeline handle;
+    VkPipelineLayout layout;
+} vulkan_pipeline;
+
 typedef struct vulkan_framebuffer {
     VkFramebuffer handle;
     u32 attachment_count;
@@ -134,17 +397,223 @@ typedef enum vulkan_commmand_buffer_state {
     COMMAND_BUFFER_STATE_NOT_ALLOCATED
 } vulkan_commmand_buffer_state;
 
+// Commands recorded into a command buffer since it began recording
+typedef struct vulkan_command_counters {
+    u32 draw_calls;
+    u64 triangles;
+    u32 render_passes;
+    u32 barriers;
+    u32 descriptor_binds;
+    u32 pipeline_binds;
+    u32 dispatches;
+} vulkan_command_counters;
+
 typedef struct vulkan_command_buffer {
     VkCommandBuffer handle;
 
     vulkan_commmand_buffer_state state;
+    vulkan_command_counters counters;
+    // Stride the vertex buffer is bound with, 0 until one is bound in this recording
+    u32 vertex_stride;
 } vulkan_command_buffer;
 
-// Used for CPU-GPU synchronization
-typedef struct vulkan_fence {
-    VkFence handle;
-    b8 is_signaled;
-} vulkan_fence;
+/*
+* Command buffers one thread records for one frame in flight. The pool is
+* reset as a whole once the frame that used it completed, the command
+* buffers stay allocated and are handed out again.
+*/
+typedef struct vulkan_thread_command_pool {
+    VkCommandPool handle;
+    // Allocated command buffers, the first *_used of them are handed out this frame. darrays
+    vulkan_command_buffer** primary;
+    u32 primary_used;
+    vulkan_command_buffer** secondary;
+    u32 secondary_used;
+} vulkan_thread_command_pool;
+
+// Transient command pools of one queue family, one per frame in flight and job thread
+typedef struct vulkan_frame_pool {
+    u32 frame_count;
+    u32 thread_count;
+    // frame_count * thread_count pools, those of a frame are next to each other
+    vulkan_thread_command_pool* pools;
+} vulkan_frame_pool;
+
+// Regions gathered into a single vkCmdCopyBuffer at most
+#define VULKAN_STAGING_REGIONS_PER_COPY 32
+
+/*
+* Persistently mapped staging buffer used as a ring. Uploads take space at
+* the head and record their copies into the transfer command buffer of the
+* frame being built, which is submitted together with the frame. The space
+* goes back to the ring once that frame has completed, so
+* uploading never waits for the queue to go idle.
+*/
+typedef struct vulkan_staging_ring {
+    vulkan_buffer buffer;
+    // Positions only ever grow, the offset in the buffer is position % size
+    u64 head;
+    u64 tail;
+    // Every upload starts at a multiple of it
+    u64 alignment;
+    u32 frame_count;
+    // Head when each frame was submitted, everything before it is free once the frame completed
+    u64* frame_heads;
+    // Transfer command buffer of each frame in flight, recording while uploads come in
+    vulkan_command_buffer* command_buffers;
+    // Frame the current command buffer belongs to, INVALID_ID when none is recording
+    u32 recording_frame;
+    VkCommandPool pool;
+    VkQueue queue;
+
+    // Buffer copies not recorded yet, consecutive ones into the same buffer share a command
+    VkBuffer pending_destination;
+    u32 pending_count;
+    VkBufferCopy pending_regions[VULKAN_STAGING_REGIONS_PER_COPY];
+
+    // Totals. A stall is an upload that found the ring full and had to wait for the queue
+    u64 upload_count;
+    u64 upload_bytes;
+    u32 stall_count;
+} vulkan_staging_ring;
+
+/*
+* A timeline semaphore. Submissions signal increasing values, the host
+* checks or waits for a value instead of keeping a fence per submission.
+*/
+typedef struct vulkan_timeline {
+    VkSemaphore handle;
+    // Highest value the GPU is known to have reached, only read back when a higher one is asked for
+    u64 completed_value;
+} vulkan_timeline;
+
+// Upload batches that can be in flight on the transfer queue at once
+#define VULKAN_TRANSFER_BATCH_COUNT 4
+
+// Uploads recorded into one command buffer and submitted together to the transfer queue
+typedef struct vulkan_transfer_batch {
+    vulkan_command_buffer command_buffer;
+    // Value the batch signals on the timeline of the transfer, 0 while the slot is free
+    u64 serial;
+    // One staging buffer per upload, destroyed once the batch completed. darray
+    vulkan_buffer* staging_buffers;
+    // Ownership transfers the graphics queue has to acquire once the batch completed. darrays
+    VkBufferMemoryBarrier* buffer_acquires;
+    VkImageMemoryBarrier* image_acquires;
+    // Stages of the graphics queue reading the uploads
+    VkPipelineStageFlags acquire_stages;
+} vulkan_transfer_batch;
+
+/*
+* Uploads on the transfer queue that run alongside rendering. Batches are
+* numbered by increasing serials, which they signal on the timeline of the
+* transfer once they completed. The frame loop polls the timeline and
+* records the acquiring half of the queue family ownership transfers into
+* the frame, after which the uploaded resources may be used.
+*/
+typedef struct vulkan_transfer {
+    VkQueue queue;
+    VkCommandPool pool;
+    u32 queue_family;
+    u32 graphics_family;
+    vulkan_timeline timeline;
+    vulkan_transfer_batch batches[VULKAN_TRANSFER_BATCH_COUNT];
+    // Batch taking uploads, INVALID_ID when none is recording
+    u32 recording;
+    // Submitted batches complete in this order
+    u32 submitted[VULKAN_TRANSFER_BATCH_COUNT];
+    u32 submitted_count;
+    u64 next_serial;
+    // Completed batches whose ownership transfers are not recorded yet. darrays
+    VkBufferMemoryBarrier* buffer_acquires;
+    VkImageMemoryBarrier* image_acquires;
+    VkPipelineStageFlags acquire_stages;
+    u64 retired_serial;
+    // Uploads of batches up to this serial are usable by the graphics queue
+    u64 completed_serial;
+
+    // Totals. A stall is an upload that found every batch in flight and had to wait for one
+    u64 upload_count;
+    u64 upload_bytes;
+    u32 stall_count;
+} vulkan_transfer;
+
+// Most resources a compute pipeline binds
+#define VULKAN_COMPUTE_MAX_BINDINGS 8
+
+/*
+* A compute shader with its layout. Its resources are storage buffers and
+* storage images in descriptor set 0, one binding each in the order they
+* were described, plus an optional block of push constants.
+*/
+typedef struct vulkan_compute_pipeline {
+    VkPipeline handle;
+    VkPipelineLayout layout;
+    VkDescriptorSetLayout set_layout;
+    // Sets of the pipeline live as long as it does
+    VkDescriptorPool descriptor_pool;
+    u32 binding_count;
+    VkDescriptorType binding_types[VULKAN_COMPUTE_MAX_BINDINGS];
+    u32 push_constant_size;
+} vulkan_compute_pipeline;
+
+/*
+* Work on the compute queue that runs alongside rendering. Each frame in
+* flight records into a command buffer of its own, which is submitted
+* ahead of the frame and signals a semaphore the frame waits on.
+*/
+typedef struct vulkan_compute {
+    VkQueue queue;
+    VkCommandPool pool;
+    u32 frame_count;
+    vulkan_command_buffer* command_buffers;
+    VkSemaphore* complete_semaphores;
+    // Frame the current command buffer belongs to, INVALID_ID when none is recording
+    u32 recording_frame;
+} vulkan_compute;
+
+
+typedef enum vulkan_gpu_timestamp {
+    VULKAN_GPU_TIMESTAMP_FRAME_BEGIN = 0,
+    VULKAN_GPU_TIMESTAMP_MAIN_PASS_BEGIN,
+    VULKAN_GPU_TIMESTAMP_MAIN_PASS_END,
+    VULKAN_GPU_TIMESTAMP_FRAME_END,
+
+    VULKAN_GPU_TIMESTAMP_COUNT
+} vulkan_gpu_timestamp;
+
+/*
+* Timestamp query pool with one set of queries per frame in flight.
+* A frame's queries are read back once that frame has completed, so
+* reading them never stalls the CPU.
+*/
+typedef struct vulkan_gpu_timer {
+    VkQueryPool query_pool;
+    u32 frame_count;
+    // Indicates which frames have been submitted and wait for read back
+    b8* pending;
+    // Nanoseconds per timestamp tick
+    f64 timestamp_period;
+    // Mask of the valid bits of a timestamp on the graphics queue
+    u64 valid_mask;
+    b8 supported;
+} vulkan_gpu_timer;
+
+/*
+* Per frame workload counters. The CPU counters of a frame are stored
+* when it is submitted and, together with the optional pipeline statistics
+* query, published once that frame has completed.
+*/
+typedef struct vulkan_frame_counters {
+    VkQueryPool statistics_pool;
+    b8 statistics_supported;
+    u32 frame_count;
+    // Counters of frames waiting for read back, one per frame in flight
+    renderer_frame_counters* frames;
+    b8* pending;
+    // The most recent complete frame
+    renderer_frame_counters last;
+} vulkan_frame_counters;
 
 /* Main data structure to store the context of vulkan
 * with all of the needed handles. This context should be used
@@ -156,9 +625,12 @@ typedef struct vulkan_fence {
 typedef struct vulkan_context {
     // Essentials
     VkInstance instance;
+    // Points at the callbacks of host_allocator
     VkAllocationCallbacks* allocator;
+    vulkan_host_allocator host_allocator;
     VkSurfaceKHR surface;
     vulkan_device device;
+    vulkan_memory_allocator memory_allocator;
 
     // Surface dimensions
     u32 framebuffer_width;
@@ -176,22 +648,51 @@ typedef struct vulkan_context {
     // Rendering
     vulkan_swapchain swapchain;
     vulkan_renderpass main_renderpass;
-    vulkan_command_buffer* graphics_command_buffers; // darray
+    // Command buffers of the frames in flight come from here
+    vulkan_frame_pool graphics_frame_pool;
+    // Primary command buffer of the frame being recorded
+    vulkan_command_buffer* frame_command_buffer;
+    // The main pass begins with the first draws of the frame, inline or from draw batches
+    b8 main_pass_begun;
+    VkSubpassContents main_pass_contents;
 
     // Synchronization objects
     VkSemaphore* image_available_semaphores;
     VkSemaphore* queue_complete_semaphore;
-    u32 in_flight_fence_count;
-    vulkan_fence* in_flight_fences;
-    // Holds pointers to fences which exist and are owened elsewhere
-    vulkan_fence* images_in_flight;
+    // Frame n signals n once its work completed
+    vulkan_timeline frame_timeline;
+    // Number of the frame being recorded, counts up from 1 with every submission
+    u64 frame_number;
+    // Number of the frame last submitted from each frame slot, 0 if none yet
+    u64* frame_slot_numbers;
+    // Last frame that rendered to each swapchain image
+    u64* image_frame_numbers;
+
+    // Geometry, all of it lives in these two buffers
+    vulkan_buffer object_vertex_buffer;
+    vulkan_buffer object_index_buffer;
+    vulkan_geometry_data geometries[VULKAN_MAX_GEOMETRY_COUNT];
+    // Slot the search for a free one starts at, after the last one taken
+    u32 next_geometry_slot;
+    // Ranges to release once the frames that may draw them completed, darray
+    vulkan_geometry_release* geometry_releases;
+    // Uploads of buffer and image contents
+    vulkan_staging_ring staging_ring;
+    // Draws geometry until materials bring their own pipelines
+    vulkan_pipeline default_pipeline;
+    // Large uploads, they run on the transfer queue while frames render
+    vulkan_transfer transfer;
+    // Async compute, the results can be used by the frame it was recorded in
+    vulkan_compute compute;
+
+    // Profiling
+    vulkan_gpu_timer gpu_timer;
+    vulkan_frame_counters frame_counters;
 
     u32 image_index; // TODO: to use it
     u32 current_frame; // TODO: to use it
 
     b8 recreating_swapchain; // TODO: to use it
-
-    i32(*find_memory_index)(u32 type_filter, u32 property_flags);
 }vulkan_context;
 
 #define VK_CHECK(expr)         \
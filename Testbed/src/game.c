@@ -1,5 +1,8 @@
 #include "game.h"
 #include <core/logger.h>
+#include <core/input.h>
+#include <renderer/renderer_frontend.h>
+#include <containers/darray.h>
 
 // Initialization code of the game
 b8 game_initialize(game* game_inst) {
@@ -7,17 +10,103 @@ b8 game_initialize(game* game_inst) {
     return TRUE;
 }
 
+// Main thread work at the start of every frame, creates renderer resources
+b8 game_prepare_frame(game* game_inst, f64 delta_time) {
+    game_state* state = (game_state*)game_inst->state;
+    if (state->triangle_created)
+        return TRUE;
+
+    const f32 vertices[] = {
+        -0.5f, -0.5f, 0.0f,
+         0.5f, -0.5f, 0.0f,
+         0.0f,  0.5f, 0.0f
+    };
+    const u32 indices[] = { 0, 1, 2 };
+    if (!renderer_create_geometry(sizeof(f32) * 3, 3, vertices, 3, indices, &state->triangle)) {
+        VERROR("Failed to create the triangle geometry");
+        return FALSE;
+    }
+
+    state->triangle_created = TRUE;
+    return TRUE;
+}
+
 // Logic to update the game / simulation
 b8 game_update(game* game_inst, f64 delta_time) {
+    game_state* state = (game_state*)game_inst->state;
+
+    // Toggle dumping frame counters to CSV
+    if (input_is_key_down(KEY_C) && input_was_key_up(KEY_C)) {
+        if (state->counters_csv) {
+            fclose(state->counters_csv);
+            state->counters_csv = 0;
+            VINFO("Stopped dumping frame counters");
+        }
+        else {
+            state->counters_csv = fopen("frame_counters.csv", "w");
+            if (state->counters_csv) {
+                fprintf(state->counters_csv, "%s\n", renderer_frame_counters_csv_header());
+                VINFO("Dumping frame counters to frame_counters.csv");
+            }
+        }
+    }
+
+    renderer_frame_counters counters;
+    renderer_get_frame_counters(&counters);
+    if (counters.frame_number != state->last_counters_frame) {
+        state->last_counters_frame = counters.frame_number;
+
+        if (state->counters_csv) {
+            char line[512];
+            if (renderer_frame_counters_to_csv(&counters, line, sizeof(line)) > 0)
+                fprintf(state->counters_csv, "%s\n", line);
+        }
+    }
+
+    state->counters_print_timer += delta_time;
+    if (state->counters_print_timer >= 1.0) {
+        state->counters_print_timer = 0.0;
+        VINFO("Frame %llu: draws %u, triangles %llu, render passes %u, barriers %u, descriptor binds %u, fragments %llu",
+            counters.frame_number,
+            counters.draw_calls,
+            counters.triangles,
+            counters.render_passes,
+            counters.barriers,
+            counters.descriptor_binds,
+            counters.fragment_invocations);
+    }
+
     return TRUE;
 }
 
 // Logic to render the view of the game
-b8 game_render(game* game_inst, f64 delta_time) {
+b8 game_render(game* game_inst, f64 delta_time, f64 interpolation_alpha, render_packet* packet) {
+    game_state* state = (game_state*)game_inst->state;
+    if (state->triangle_created) {
+        geometry_render_data triangle = { &state->triangle };
+        darray_push(packet->geometries, triangle);
+    }
     return TRUE;
 }
 
 // Logic to handle window resize is window is a concept of the platform
 void game_on_resize(game* game_inst, i32 new_width, i32 new_height) {
 
+}
+
+// Releases what the game still holds when the application exits
+void game_shutdown(game* game_inst) {
+    game_state* state = (game_state*)game_inst->state;
+
+    // Flushes the rows still buffered if the dump was never toggled off
+    if (state->counters_csv) {
+        fclose(state->counters_csv);
+        state->counters_csv = 0;
+        VINFO("Stopped dumping frame counters");
+    }
+
+    if (state->triangle_created) {
+        renderer_destroy_geometry(&state->triangle);
+        state->triangle_created = FALSE;
+    }
 }
\ No newline at end of file
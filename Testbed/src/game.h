@@ -3,18 +3,36 @@
 #include <defines.h>
 #include <game_types.h>
 
+#include <stdio.h>
+
 typedef struct game_state {
     f32 delta_time;
+
+    // Seconds since the frame counters were last printed
+    f64 counters_print_timer;
+    // Open while frame counters are dumped to CSV (toggled with 'C')
+    FILE* counters_csv;
+    u64 last_counters_frame;
+
+    // A triangle in the middle of the screen, created by the first prepare_frame
+    geometry triangle;
+    b8 triangle_created;
 } game_state;
 
 // Initialization code of the game
 b8 game_initialize(game* game_inst);
 
+// Main thread work at the start of every frame, creates renderer resources
+b8 game_prepare_frame(game* game_inst, f64 delta_time);
+
 // Logic to update the game / simulation
 b8 game_update(game* game_inst, f64 delta_time);
 
 // Logic to render the view of the game
-b8 game_render(game* game_inst, f64 delta_time);
+b8 game_render(game* game_inst, f64 delta_time, f64 interpolation_alpha, render_packet* packet);
 
 // Logic to handle window resize is window is a concept of the platform
-void game_on_resize(game* game_inst, i32 new_width, i32 new_height);
\ No newline at end of file
+void game_on_resize(game* game_inst, i32 new_width, i32 new_height);
+
+// Releases what the game still holds when the application exits
+void game_shutdown(game* game_inst);
\ No newline at end of file
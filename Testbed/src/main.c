@@ -13,14 +13,18 @@ b8 create_game(game* game_out) {
         game_out->app_config.start_y = 100;
         game_out->app_config.start_width = 1200;
         game_out->app_config.start_height = 720;
+        game_out->app_config.frame_stats_log_interval = 5.0;
+        game_out->app_config.target_frame_rate = 60.0;
     }
 
     // Assign function pointers
     {
         game_out->initialize = game_initialize;
+        game_out->prepare_frame = game_prepare_frame;
         game_out->render = game_render;
         game_out->update = game_update;
         game_out->on_resize = game_on_resize;
+        game_out->shutdown = game_shutdown;
     }
     
     // Assign game state
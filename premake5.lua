@@ -32,11 +32,6 @@ project "Renderer"
 	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
 	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
 
-	postbuildcommands 
-{
-	("{COPY} %{cfg.buildtarget.directory}/%{prj.name}.dll ../bin/" .. outputdir .. "/Testbed/")
-}
-
 	files
 	{
 		"%{prj.name}/src/**.h",
@@ -50,12 +45,6 @@ project "Renderer"
 		"%{Include.VULKAN}",
 	}
 
-	links
-	{
-		"%{Library.VULKAN_lib}",
-		"%{Library.VULKAN_utils}"
-	}
-
 	defines{
 		"_CRT_SECURE_NO_WARNINGS",
 		"VNEXPORT" -- Used to build the DLL
@@ -64,18 +53,47 @@ project "Renderer"
 	filter "system:windows"
 		systemversion "latest"
 
+		postbuildcommands 
+		{
+			("{COPY} %{cfg.buildtarget.directory}/%{prj.name}.dll ../bin/" .. outputdir .. "/Testbed/"),
+			("{COPY} %{cfg.buildtarget.directory}/%{prj.name}.dll ../bin/" .. outputdir .. "/Bench/")
+		}
+
+		links
+		{
+			"%{Library.VULKAN_lib}",
+			"%{Library.VULKAN_utils}"
+		}
+
 		defines{
 			"VKR_WINDOWS_PLATFORM",
 			"VKR_ENABLE_ASSERTS",
 		}
 
+	filter "system:linux"
+		pic "On"
+
+		-- Vulkan loader and xcb come from the system packages
+		links
+		{
+			"vulkan",
+			"xcb",
+			"m"
+		}
+
+		defines{
+			"VKR_LINUX_PLATFORM",
+			"VKR_ENABLE_ASSERTS",
+		}
+
 	filter "configurations:DEBUG"
 		defines "VKR_DEBUG"
 		runtime "Debug"
 		symbols "On"
 		
 		defines{
-			"VASSERTIONS_ENABLED"
+			"VASSERTIONS_ENABLED",
+			"VKR_ENABLE_CHECKS" -- Renderer self checks run by Bench
 		}
 
 
@@ -191,3 +209,55 @@ project "Testbed"
 		optimize "Full"
 
 
+project "Bench"
+	location "Bench"
+	kind "ConsoleApp"
+	language "C"
+	cdialect "C17"
+	staticruntime "off"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files 
+	{
+		"%{prj.name}/src/**.c",
+		"%{prj.name}/src/**.h",
+		"%{prj.name}/src/**.inl"
+	}
+
+	includedirs
+	{
+		"%{wks.location}/Renderer/src",
+		"%{prj.name}/src"
+	}
+
+	dependson
+	{
+		"Renderer"
+	}
+
+	links
+	{
+		"Renderer"
+	}
+
+	filter "configurations:DEBUG"
+		defines "BN_DEBUG"
+		runtime "Debug"
+		symbols "On"
+
+		-- Must match the Renderer, the self checks are only exported from its DEBUG build
+		defines "VKR_ENABLE_CHECKS"
+
+	filter "configurations:RELEASE"
+		defines "BN_RELEASE"
+		runtime "Release"
+		optimize "On"
+
+
+	filter "configurations:DIST"
+		defines "BN_DIST"
+		runtime "Release"
+		optimize "Full"
+